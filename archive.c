@@ -0,0 +1,1395 @@
+#include "archive.h"
+#include "snapshot.h"
+#include "mappedfile.h"
+#include "ioengine.h"
+#include <errno.h>
+#include <pthread.h>
+
+#define ARCHIVE_BYTE_ORDER 0x01020304u
+#define ARCHIVE_PATH_SIZE 600
+#define ARCHIVE_AMOUNT_RAW 2        // Amount tag for a double that is stored as it is
+
+// ---------------------------------------------------------------------------
+// Varints and growable buffers
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    unsigned char* data;
+    size_t used;
+    size_t capacity;
+    int failed;
+} ByteBuffer;
+
+static void put_raw(ByteBuffer* buffer, const void* data, size_t length) {
+    if (buffer->failed) return;
+    if (buffer->used + length > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+        while (capacity < buffer->used + length) capacity *= 2;
+        unsigned char* grown = (unsigned char*)realloc(buffer->data, capacity);
+        if (!grown) {
+            buffer->failed = 1;
+            return;
+        }
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->used, data, length);
+    buffer->used += length;
+}
+
+static void put_varint(ByteBuffer* buffer, uint64_t value) {
+    unsigned char bytes[10];
+    int length = 0;
+    while (value >= 0x80) {
+        bytes[length++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    bytes[length++] = (unsigned char)value;
+    put_raw(buffer, bytes, length);
+}
+
+static uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static void put_text(ByteBuffer* buffer, const char* text, size_t length) {
+    put_varint(buffer, length);
+    put_raw(buffer, text, length);
+}
+
+static const double amount_scales[ARCHIVE_AMOUNT_RAW] = {100.0, 10000.0};
+
+// Amounts with two or four decimals become scaled integers when that gives the same double back
+static void put_amount(ByteBuffer* buffer, double value) {
+    for (int tag = 0; tag < ARCHIVE_AMOUNT_RAW; tag++) {
+        double scaled = floor(value * amount_scales[tag] + 0.5);
+        if (!(scaled > -1e15 && scaled < 1e15)) break;
+        double back = (double)(int64_t)scaled / amount_scales[tag];
+        if (memcmp(&back, &value, sizeof(double)) == 0) {
+            put_varint(buffer, zigzag((int64_t)scaled) << 2 | (uint64_t)tag);
+            return;
+        }
+    }
+    put_varint(buffer, ARCHIVE_AMOUNT_RAW);
+    put_raw(buffer, &value, sizeof(value));
+}
+
+typedef struct {
+    const unsigned char* pos;
+    const unsigned char* end;
+    int failed;
+} ByteReader;
+
+static void get_raw(ByteReader* reader, void* dest, size_t length) {
+    if (reader->failed || (size_t)(reader->end - reader->pos) < length) {
+        reader->failed = 1;
+        memset(dest, 0, length);
+        return;
+    }
+    memcpy(dest, reader->pos, length);
+    reader->pos += length;
+}
+
+static uint64_t get_varint(ByteReader* reader) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64 && !reader->failed; shift += 7) {
+        if (reader->pos == reader->end) break;
+        unsigned char byte = *reader->pos++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    reader->failed = 1;
+    return 0;
+}
+
+// Copy a string into a fixed-size field, truncating like the snapshot loader does
+static void get_text(ByteReader* reader, char* dest, size_t size) {
+    uint64_t length = get_varint(reader);
+    if (reader->failed || (uint64_t)(reader->end - reader->pos) < length) {
+        reader->failed = 1;
+        dest[0] = '\0';
+        return;
+    }
+    size_t copied = length < size ? (size_t)length : size - 1;
+    memcpy(dest, reader->pos, copied);
+    dest[copied] = '\0';
+    reader->pos += length;
+}
+
+static double get_amount(ByteReader* reader) {
+    uint64_t value = get_varint(reader);
+    int tag = (int)(value & 3);
+    if (tag == ARCHIVE_AMOUNT_RAW) {
+        double raw;
+        get_raw(reader, &raw, sizeof(raw));
+        return raw;
+    }
+    if (tag > ARCHIVE_AMOUNT_RAW) reader->failed = 1;
+    return reader->failed ? 0.0 : (double)unzigzag(value >> 2) / amount_scales[tag];
+}
+
+// ---------------------------------------------------------------------------
+// Blocks
+// ---------------------------------------------------------------------------
+
+// Encode sales (in VIN order) whose strings start at names[i] and addresses[i] in `strings`
+static void encode_block(ByteBuffer* out, const ArchivedSale* sales, const size_t* names,
+                         const size_t* addresses, int count, const ByteBuffer* strings) {
+    // The block's dictionary: every distinct name and address once
+    size_t dictionary[2 * ARCHIVE_BLOCK_RECORDS];
+    int name_refs[ARCHIVE_BLOCK_RECORDS], address_refs[ARCHIVE_BLOCK_RECORDS];
+    int dictionary_count = 0;
+    for (int i = 0; i < 2 * count; i++) {
+        const char* text = (const char*)strings->data + (i < count ? names[i] : addresses[i - count]);
+        int ref = 0;
+        while (ref < dictionary_count && strcmp((const char*)strings->data + dictionary[ref], text) != 0) {
+            ref++;
+        }
+        if (ref == dictionary_count) {
+            dictionary[dictionary_count++] = i < count ? names[i] : addresses[i - count];
+        }
+        if (i < count) name_refs[i] = ref;
+        else address_refs[i - count] = ref;
+    }
+    put_varint(out, dictionary_count);
+    for (int d = 0; d < dictionary_count; d++) {
+        const char* text = (const char*)strings->data + dictionary[d];
+        put_text(out, text, strlen(text));
+    }
+
+    const char* previous_vin = "";
+    int previous_date = 0;
+    for (int i = 0; i < count; i++) {
+        const ArchivedSale* sale = &sales[i];
+        const Customer* customer = &sale->customer;
+
+        size_t shared = 0;
+        while (previous_vin[shared] && previous_vin[shared] == customer->car_VIN[shared]) {
+            shared++;
+        }
+        put_varint(out, shared);
+        put_text(out, customer->car_VIN + shared, strlen(customer->car_VIN + shared));
+        previous_vin = customer->car_VIN;
+
+        put_varint(out, zigzag(sale->salesperson_id));
+        put_varint(out, name_refs[i]);
+        put_varint(out, address_refs[i]);
+        put_varint(out, zigzag((int64_t)customer->purchase_date - previous_date));
+        previous_date = customer->purchase_date;
+        put_text(out, customer->mobile, strlen(customer->mobile));
+        put_text(out, customer->reg_number, strlen(customer->reg_number));
+        put_amount(out, customer->actual_aoumnt_paid);
+        put_varint(out, customer->loan_months);
+
+        put_varint(out, sale->sold_car_in);
+        if (sale->sold_car_in) {
+            const SoldCar* sold_car = &sale->sold_car;
+            put_varint(out, sold_car->payment_type);
+            put_varint(out, sold_car->loan_period_months);
+            put_varint(out, sold_car->interest_rate_bps);
+            put_varint(out, zigzag(sold_car->model_id));
+            put_amount(out, sold_car->down_payment);
+            put_amount(out, sold_car->loan_amount);
+            put_amount(out, sold_car->monthly_emi);
+        }
+    }
+}
+
+// Decode a block into sales[]; the strings they point at live in `strings` until the next
+// decode into it. Returns 0 if the block is malformed.
+static int decode_block(const unsigned char* data, size_t length, uint32_t count,
+                        ArchivedSale* sales, ByteBuffer* strings) {
+    ByteReader reader = {data, data + length, 0};
+    if (count > ARCHIVE_BLOCK_RECORDS) return 0;
+
+    uint64_t dictionary_count = get_varint(&reader);
+    if (dictionary_count > 2 * ARCHIVE_BLOCK_RECORDS) return 0;
+    size_t dictionary[2 * ARCHIVE_BLOCK_RECORDS];
+    strings->used = 0;
+    for (uint64_t d = 0; d < dictionary_count && !reader.failed; d++) {
+        uint64_t text_length = get_varint(&reader);
+        if (reader.failed || (uint64_t)(reader.end - reader.pos) < text_length) return 0;
+        dictionary[d] = strings->used;
+        put_raw(strings, reader.pos, (size_t)text_length);
+        put_raw(strings, "", 1);
+        reader.pos += text_length;
+    }
+    if (strings->failed) return 0;
+
+    char previous_vin[MAX_VIN_LEN] = "";
+    int previous_date = 0;
+    for (uint32_t i = 0; i < count && !reader.failed; i++) {
+        ArchivedSale* sale = &sales[i];
+        Customer* customer = &sale->customer;
+        memset(sale, 0, sizeof(ArchivedSale));
+
+        uint64_t shared = get_varint(&reader);
+        if (shared > strlen(previous_vin)) return 0;
+        memcpy(customer->car_VIN, previous_vin, (size_t)shared);
+        get_text(&reader, customer->car_VIN + shared, MAX_VIN_LEN - (size_t)shared);
+        strcpy(previous_vin, customer->car_VIN);
+
+        sale->salesperson_id = (int)unzigzag(get_varint(&reader));
+        uint64_t name_ref = get_varint(&reader);
+        uint64_t address_ref = get_varint(&reader);
+        if (name_ref >= dictionary_count || address_ref >= dictionary_count) return 0;
+        sale->name = (const char*)strings->data + dictionary[name_ref];
+        sale->address = (const char*)strings->data + dictionary[address_ref];
+        customer->name = STRREF_EMPTY;
+        customer->address = STRREF_EMPTY;
+        customer->purchase_date = previous_date + (int)unzigzag(get_varint(&reader));
+        previous_date = customer->purchase_date;
+        get_text(&reader, customer->mobile, MAX_MOBILE_LEN);
+        get_text(&reader, customer->reg_number, MAX_REG_NUM_LEN);
+        customer->actual_aoumnt_paid = get_amount(&reader);
+        customer->loan_months = (uint8_t)get_varint(&reader);
+
+        sale->sold_car_in = (int)get_varint(&reader);
+        if (sale->sold_car_in) {
+            SoldCar* sold_car = &sale->sold_car;
+            strcpy(sold_car->VIN, customer->car_VIN);
+            sold_car->payment_type = (uint8_t)get_varint(&reader);
+            sold_car->loan_period_months = (uint8_t)get_varint(&reader);
+            sold_car->interest_rate_bps = (uint16_t)get_varint(&reader);
+            sold_car->model_id = (int32_t)unzigzag(get_varint(&reader));
+            sold_car->down_payment = get_amount(&reader);
+            sold_car->loan_amount = get_amount(&reader);
+            sold_car->monthly_emi = get_amount(&reader);
+        }
+    }
+    return !reader.failed && reader.pos == reader.end;
+}
+
+// ---------------------------------------------------------------------------
+// Bloom filters
+// ---------------------------------------------------------------------------
+
+// Bits of the filter of a run of `records` sales, a whole number of bytes
+static uint32_t bloom_size(uint32_t records) {
+    uint64_t bits = (uint64_t)records * ARCHIVE_BLOOM_BITS_PER_KEY;
+    if (bits < 64) bits = 64;
+    if (bits > ((uint64_t)1 << 31)) bits = (uint64_t)1 << 31;
+    return (uint32_t)((bits + 7) & ~(uint64_t)7);
+}
+
+// Two hashes of the VIN from one FNV-1a; probe i is at h1 + i * h2
+static void bloom_hashes(const char* vin, uint32_t* h1, uint32_t* h2) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char* c = (const unsigned char*)vin; *c; c++) {
+        hash ^= *c;
+        hash *= 1099511628211ULL;
+    }
+    *h1 = (uint32_t)hash;
+    *h2 = (uint32_t)(hash >> 32) | 1;
+}
+
+static void bloom_add(unsigned char* bloom, uint32_t bits, const char* vin) {
+    uint32_t h1, h2;
+    bloom_hashes(vin, &h1, &h2);
+    for (uint32_t i = 0; i < ARCHIVE_BLOOM_HASHES; i++) {
+        uint32_t bit = (uint32_t)(((uint64_t)h1 + (uint64_t)i * h2) % bits);
+        bloom[bit / 8] |= (unsigned char)(1u << (bit % 8));
+    }
+}
+
+// 0 if the VIN is certainly not in the filter
+static int bloom_may_contain(const unsigned char* bloom, uint32_t bits, const char* vin) {
+    uint32_t h1, h2;
+    bloom_hashes(vin, &h1, &h2);
+    for (uint32_t i = 0; i < ARCHIVE_BLOOM_HASHES; i++) {
+        uint32_t bit = (uint32_t)(((uint64_t)h1 + (uint64_t)i * h2) % bits);
+        if (!(bloom[bit / 8] & (1u << (bit % 8)))) return 0;
+    }
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Index
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint64_t offset;
+    uint32_t length;
+    uint32_t records;
+    uint32_t crc;
+    char first_VIN[MAX_VIN_LEN];
+} ArchiveBlock;
+
+// What is kept in memory of a run
+typedef struct {
+    int showroom_id;
+    uint32_t generation;
+    uint32_t record_count;
+    uint32_t block_count;
+    ArchiveBlock* blocks;
+    uint32_t month_count;
+    MonthlySales* months;
+    uint32_t bloom_bits;            // 0 for a version 1 run, which has no filter
+    unsigned char* bloom;
+} ArchiveIndex;
+
+static ArchiveIndex* indexes = NULL;
+static int index_count = 0;
+static int index_capacity = 0;
+
+static void free_index(ArchiveIndex* index) {
+    free(index->blocks);
+    free(index->months);
+    free(index->bloom);
+}
+
+// Forget the index of a run that is no longer used
+static void drop_index(int showroom_id, uint32_t generation) {
+    for (int i = 0; i < index_count; i++) {
+        if (indexes[i].showroom_id != showroom_id || indexes[i].generation != generation) continue;
+        free_index(&indexes[i]);
+        indexes[i] = indexes[--index_count];
+        return;
+    }
+}
+
+void free_archive_indexes() {
+    for (int i = 0; i < index_count; i++) {
+        free_index(&indexes[i]);
+    }
+    free(indexes);
+    indexes = NULL;
+    index_count = 0;
+    index_capacity = 0;
+}
+
+// Parse the header, trailer and index of a mapped run
+static int parse_index(const unsigned char* data, size_t size, int showroom_id, ArchiveIndex* index) {
+    if (size < ARCHIVE_HEADER_SIZE + ARCHIVE_TRAILER_SIZE || memcmp(data, ARCHIVE_MAGIC, 8) != 0) return 0;
+
+    uint32_t version, byte_order, header_crc;
+    int32_t file_showroom_id;
+    memcpy(&version, data + 8, 4);
+    memcpy(&byte_order, data + 12, 4);
+    memcpy(&file_showroom_id, data + 16, 4);
+    memcpy(&index->record_count, data + 20, 4);
+    memcpy(&index->block_count, data + 24, 4);
+    memcpy(&header_crc, data + 28, 4);
+    if (version < 1 || version > ARCHIVE_VERSION || byte_order != ARCHIVE_BYTE_ORDER || file_showroom_id != showroom_id) return 0;
+    if (crc32_update(0, data, 28) != header_crc) return 0;
+
+    uint64_t index_offset;
+    uint32_t index_length, index_crc;
+    const unsigned char* trailer = data + size - ARCHIVE_TRAILER_SIZE;
+    memcpy(&index_offset, trailer, 8);
+    memcpy(&index_length, trailer + 8, 4);
+    memcpy(&index_crc, trailer + 12, 4);
+    if (index_offset < ARCHIVE_HEADER_SIZE || index_offset + index_length != size - ARCHIVE_TRAILER_SIZE) return 0;
+    if (crc32_update(0, data + index_offset, index_length) != index_crc) return 0;
+
+    ByteReader reader = {data + index_offset, data + index_offset + index_length, 0};
+    if (index->block_count > index_length) return 0;
+    index->blocks = (ArchiveBlock*)malloc((index->block_count ? index->block_count : 1) * sizeof(ArchiveBlock));
+    if (!index->blocks) return 0;
+    for (uint32_t b = 0; b < index->block_count && !reader.failed; b++) {
+        ArchiveBlock* block = &index->blocks[b];
+        block->offset = get_varint(&reader);
+        block->length = (uint32_t)get_varint(&reader);
+        block->records = (uint32_t)get_varint(&reader);
+        get_raw(&reader, &block->crc, sizeof(block->crc));
+        get_text(&reader, block->first_VIN, MAX_VIN_LEN);
+        if (block->offset < ARCHIVE_HEADER_SIZE || block->offset + block->length > index_offset) reader.failed = 1;
+    }
+
+    index->month_count = (uint32_t)get_varint(&reader);
+    if (index->month_count > index_length) reader.failed = 1;
+    index->months = reader.failed ? NULL : (MonthlySales*)malloc((index->month_count ? index->month_count : 1) * sizeof(MonthlySales));
+    for (uint32_t m = 0; index->months && m < index->month_count && !reader.failed; m++) {
+        MonthlySales* month = &index->months[m];
+        month->year = (int)unzigzag(get_varint(&reader));
+        month->month = (int)get_varint(&reader);
+        month->sales_count = (int)get_varint(&reader);
+        get_raw(&reader, &month->sales_value, sizeof(month->sales_value));
+    }
+
+    if (version >= 2 && !reader.failed) {
+        uint64_t bits = get_varint(&reader);
+        if (bits == 0 || bits % 8 != 0 || bits / 8 > (uint64_t)(reader.end - reader.pos)) reader.failed = 1;
+        index->bloom = reader.failed ? NULL : (unsigned char*)malloc((size_t)(bits / 8));
+        if (index->bloom) {
+            index->bloom_bits = (uint32_t)bits;
+            get_raw(&reader, index->bloom, (size_t)(bits / 8));
+        } else {
+            reader.failed = 1;
+        }
+    }
+
+    if (reader.failed || !index->months || reader.pos != reader.end) {
+        free_index(index);
+        return 0;
+    }
+    return 1;
+}
+
+// The index of one of a showroom's runs, read on first use. NULL (with a message) if it is damaged.
+static ArchiveIndex* open_index(const Showroom* showroom, uint32_t generation, char* path, size_t path_size) {
+    if (!snapshot_archive_path(path, path_size, showroom->id, generation)) return NULL;
+
+    for (int i = 0; i < index_count; i++) {
+        if (indexes[i].showroom_id == showroom->id && indexes[i].generation == generation) {
+            return &indexes[i];
+        }
+    }
+
+    if (index_count == index_capacity) {
+        int capacity = index_capacity ? index_capacity * 2 : 16;
+        ArchiveIndex* grown = (ArchiveIndex*)realloc(indexes, capacity * sizeof(ArchiveIndex));
+        if (!grown) return NULL;
+        indexes = grown;
+        index_capacity = capacity;
+    }
+
+    ArchiveIndex* index = &indexes[index_count];
+    memset(index, 0, sizeof(ArchiveIndex));
+    index->showroom_id = showroom->id;
+    index->generation = generation;
+
+    MappedFile file;
+    int ok = map_file(path, &file);
+    if (ok) {
+        ok = parse_index((const unsigned char*)file.data, file.size, showroom->id, index);
+        unmap_file(&file);
+    }
+    if (!ok) {
+        out_printf("Archive %s is missing or damaged, showroom %d's archived sales are unavailable.\n", path, showroom->id);
+        return NULL;
+    }
+    index_count++;
+    return index;
+}
+
+// The paths of a showroom's runs, oldest first. 0 before any snapshot.
+static int run_paths(const Showroom* showroom, char (*paths)[ARCHIVE_PATH_SIZE]) {
+    for (int r = 0; r < showroom->archive_run_count; r++) {
+        uint32_t generation = showroom->archive_runs[showroom->archive_run_count - 1 - r];
+        if (!snapshot_archive_path(paths[r], ARCHIVE_PATH_SIZE, showroom->id, generation)) return 0;
+    }
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Writing
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    IoWriteFile* file;
+    FILE* stream;                   // Instead of `file` off the main thread, which the io engine is not for
+    char* buffer;
+    size_t used;
+    uint64_t offset;                // Bytes put so far
+    int failed;
+
+    // The block being filled, its strings copied into `strings`
+    ArchivedSale pending[ARCHIVE_BLOCK_RECORDS];
+    size_t names[ARCHIVE_BLOCK_RECORDS];
+    size_t addresses[ARCHIVE_BLOCK_RECORDS];
+    int pending_count;
+    ByteBuffer strings;
+
+    ByteBuffer block;               // Encoding of the block being written
+    ByteBuffer index;               // Block entries, written after the last block
+    uint32_t block_count;
+    uint32_t record_count;
+    MonthlySales* months;           // Sales per month of everything written, in month order
+    uint32_t month_count;
+    uint32_t month_capacity;
+    uint32_t bloom_bits;            // Filter of the VINs written
+    unsigned char* bloom;
+} ArchiveWriter;
+
+static void write_bytes(ArchiveWriter* writer, const void* data, size_t length) {
+    const char* bytes = (const char*)data;
+    writer->offset += length;
+    if (writer->stream) {
+        if (!writer->failed && fwrite(bytes, 1, length, writer->stream) != length) writer->failed = 1;
+        return;
+    }
+    while (length > 0 && !writer->failed) {
+        if (writer->used == IO_CHUNK_SIZE) {
+            io_write_submit(writer->file, writer->used);
+            writer->used = 0;
+            writer->buffer = io_write_buffer(writer->file);
+            if (!writer->buffer) {
+                writer->failed = 1;
+                return;
+            }
+        }
+        size_t chunk = IO_CHUNK_SIZE - writer->used;
+        if (chunk > length) chunk = length;
+        memcpy(writer->buffer + writer->used, bytes, chunk);
+        writer->used += chunk;
+        bytes += chunk;
+        length -= chunk;
+    }
+}
+
+static void flush_block(ArchiveWriter* writer) {
+    if (writer->pending_count == 0) return;
+
+    writer->block.used = 0;
+    encode_block(&writer->block, writer->pending, writer->names, writer->addresses,
+                 writer->pending_count, &writer->strings);
+    if (writer->block.failed || writer->strings.failed) writer->failed = 1;
+
+    uint32_t crc = crc32_update(0, writer->block.data, writer->block.used);
+    put_varint(&writer->index, writer->offset);
+    put_varint(&writer->index, writer->block.used);
+    put_varint(&writer->index, writer->pending_count);
+    put_raw(&writer->index, &crc, sizeof(crc));
+    const char* first_vin = writer->pending[0].customer.car_VIN;
+    put_text(&writer->index, first_vin, strlen(first_vin));
+    write_bytes(writer, writer->block.data, writer->block.used);
+
+    writer->block_count++;
+    writer->pending_count = 0;
+    writer->strings.used = 0;
+}
+
+// Count the sale in its month, the months kept sorted
+static void add_to_month(ArchiveWriter* writer, const Customer* customer) {
+    int day;
+    MonthlySales key = {0};
+    days_to_date(customer->purchase_date, &day, &key.month, &key.year);
+
+    uint32_t low = 0, high = writer->month_count;
+    while (low < high) {
+        uint32_t mid = (low + high) / 2;
+        if (compareMonthlySales(&writer->months[mid], &key) < 0) low = mid + 1;
+        else high = mid;
+    }
+    if (low < writer->month_count && compareMonthlySales(&writer->months[low], &key) == 0) {
+        writer->months[low].sales_count++;
+        writer->months[low].sales_value += customer->actual_aoumnt_paid;
+        return;
+    }
+
+    if (writer->month_count == writer->month_capacity) {
+        uint32_t capacity = writer->month_capacity ? writer->month_capacity * 2 : 64;
+        MonthlySales* grown = (MonthlySales*)realloc(writer->months, capacity * sizeof(MonthlySales));
+        if (!grown) {
+            writer->failed = 1;
+            return;
+        }
+        writer->months = grown;
+        writer->month_capacity = capacity;
+    }
+    memmove(&writer->months[low + 1], &writer->months[low], (writer->month_count - low) * sizeof(MonthlySales));
+    key.sales_count = 1;
+    key.sales_value = customer->actual_aoumnt_paid;
+    writer->months[low] = key;
+    writer->month_count++;
+}
+
+static void add_sale(ArchiveWriter* writer, const ArchivedSale* sale) {
+    int i = writer->pending_count++;
+    writer->pending[i] = *sale;
+    writer->names[i] = writer->strings.used;
+    put_raw(&writer->strings, sale->name, strlen(sale->name) + 1);
+    writer->addresses[i] = writer->strings.used;
+    put_raw(&writer->strings, sale->address, strlen(sale->address) + 1);
+    writer->record_count++;
+
+    add_to_month(writer, &sale->customer);
+    if (writer->bloom) bloom_add(writer->bloom, writer->bloom_bits, sale->customer.car_VIN);
+
+    if (writer->pending_count == ARCHIVE_BLOCK_RECORDS) flush_block(writer);
+}
+
+// The state every writer starts from, with a filter sized for `records` sales
+static void start_writer(ArchiveWriter* writer, uint32_t records) {
+    writer->bloom_bits = bloom_size(records);
+    writer->bloom = (unsigned char*)calloc(writer->bloom_bits / 8, 1);
+    if (!writer->bloom) writer->failed = 1;
+
+    // Counts are filled in at close
+    unsigned char header[ARCHIVE_HEADER_SIZE] = {0};
+    write_bytes(writer, header, sizeof(header));
+}
+
+// Create a new run for the showroom under a fresh generation
+static int open_archive_writer(ArchiveWriter* writer, int showroom_id, uint32_t records,
+                               char* path, size_t path_size, uint32_t* generation) {
+    memset(writer, 0, sizeof(ArchiveWriter));
+    for (int attempt = 0; attempt < 1000 && !writer->file; attempt++) {
+        *generation = snapshot_next_generation();
+        if (!snapshot_archive_path(path, path_size, showroom_id, *generation)) return 0;
+        writer->file = io_write_open(path, 1);
+        if (!writer->file && errno != EEXIST) break;
+    }
+    if (!writer->file) {
+        out_printf("Error: Could not open file for writing: %s\n", path);
+        return 0;
+    }
+    writer->buffer = io_write_buffer(writer->file);
+    writer->failed = writer->buffer == NULL;
+    start_writer(writer, records);
+    return 1;
+}
+
+// The same through stdio, for the compaction thread; 0 if the file cannot be created
+static int open_stream_writer(ArchiveWriter* writer, const char* path, uint32_t records) {
+    memset(writer, 0, sizeof(ArchiveWriter));
+    writer->stream = fopen(path, "wbx");
+    if (!writer->stream) return 0;
+    start_writer(writer, records);
+    return 1;
+}
+
+// 1 if the whole file reached the disk
+static int close_archive_writer(ArchiveWriter* writer, int showroom_id) {
+    flush_block(writer);
+
+    // Index: the blocks, the sales per month in month order, then the bloom filter
+    put_varint(&writer->index, writer->month_count);
+    for (uint32_t m = 0; m < writer->month_count; m++) {
+        MonthlySales* month = &writer->months[m];
+        put_varint(&writer->index, zigzag(month->year));
+        put_varint(&writer->index, month->month);
+        put_varint(&writer->index, month->sales_count);
+        put_raw(&writer->index, &month->sales_value, sizeof(month->sales_value));
+    }
+    put_varint(&writer->index, writer->bloom_bits);
+    if (writer->bloom) put_raw(&writer->index, writer->bloom, writer->bloom_bits / 8);
+    if (writer->index.failed) writer->failed = 1;
+
+    uint64_t index_offset = writer->offset;
+    uint32_t index_length = (uint32_t)writer->index.used;
+    uint32_t index_crc = crc32_update(0, writer->index.data, writer->index.used);
+    write_bytes(writer, writer->index.data, writer->index.used);
+    unsigned char trailer[ARCHIVE_TRAILER_SIZE];
+    memcpy(trailer, &index_offset, 8);
+    memcpy(trailer + 8, &index_length, 4);
+    memcpy(trailer + 12, &index_crc, 4);
+    write_bytes(writer, trailer, sizeof(trailer));
+
+    unsigned char header[ARCHIVE_HEADER_SIZE];
+    uint32_t version = ARCHIVE_VERSION;
+    uint32_t byte_order = ARCHIVE_BYTE_ORDER;
+    int32_t id = showroom_id;
+    memcpy(header, ARCHIVE_MAGIC, 8);
+    memcpy(header + 8, &version, 4);
+    memcpy(header + 12, &byte_order, 4);
+    memcpy(header + 16, &id, 4);
+    memcpy(header + 20, &writer->record_count, 4);
+    memcpy(header + 24, &writer->block_count, 4);
+    uint32_t header_crc = crc32_update(0, header, 28);
+    memcpy(header + 28, &header_crc, 4);
+
+    int ok;
+    if (writer->stream) {
+        if (fseek(writer->stream, 0, SEEK_SET) != 0 || fwrite(header, 1, sizeof(header), writer->stream) != sizeof(header)) {
+            writer->failed = 1;
+        }
+        ok = !writer->failed;
+        if (fclose(writer->stream) != 0) ok = 0;
+    } else {
+        io_write_patch(writer->file, 0, header, sizeof(header));
+        if (!writer->failed && writer->used > 0) io_write_submit(writer->file, writer->used);
+        ok = !writer->failed;
+        if (!io_write_close(writer->file)) ok = 0;
+    }
+
+    free(writer->months);
+    free(writer->bloom);
+    free(writer->strings.data);
+    free(writer->block.data);
+    free(writer->index.data);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Reading
+// ---------------------------------------------------------------------------
+
+// Every sale of a run in VIN order, one block decoded at a time. The cursor parses its own
+// index, so it does not touch the shared ones and can run off the main thread.
+typedef struct {
+    MappedFile file;
+    ArchiveIndex index;
+    int opened;
+    uint32_t next_block;
+    ArchivedSale sales[ARCHIVE_BLOCK_RECORDS];
+    uint32_t count;
+    uint32_t next;
+    ByteBuffer strings;
+    int quiet;                      // Failures are only flagged, not printed
+    int failed;
+} ArchiveCursor;
+
+static int open_cursor(ArchiveCursor* cursor, const char* path, int showroom_id, int quiet) {
+    memset(cursor, 0, sizeof(ArchiveCursor));
+    cursor->quiet = quiet;
+    cursor->index.showroom_id = showroom_id;
+    if (map_file(path, &cursor->file)) {
+        if (parse_index((const unsigned char*)cursor->file.data, cursor->file.size, showroom_id, &cursor->index)) {
+            cursor->opened = 1;
+            return 1;
+        }
+        unmap_file(&cursor->file);
+    }
+    if (!quiet) out_printf("Archive %s is missing or damaged, showroom %d's archived sales are unavailable.\n", path, showroom_id);
+    cursor->failed = 1;
+    return 0;
+}
+
+// The next sale, NULL at the end or when a block is damaged (cursor->failed is then set)
+static const ArchivedSale* cursor_next(ArchiveCursor* cursor) {
+    while (cursor->next == cursor->count) {
+        if (cursor->failed || cursor->next_block == cursor->index.block_count) return NULL;
+
+        ArchiveBlock* block = &cursor->index.blocks[cursor->next_block++];
+        const unsigned char* data = (const unsigned char*)cursor->file.data + block->offset;
+        if (block->offset + block->length > cursor->file.size ||
+            crc32_update(0, data, block->length) != block->crc ||
+            !decode_block(data, block->length, block->records, cursor->sales, &cursor->strings)) {
+            if (!cursor->quiet) {
+                out_printf("Archive block %u of showroom %d is damaged.\n", cursor->next_block - 1, cursor->index.showroom_id);
+            }
+            cursor->failed = 1;
+            return NULL;
+        }
+        cursor->count = block->records;
+        cursor->next = 0;
+    }
+    return &cursor->sales[cursor->next++];
+}
+
+static void close_cursor(ArchiveCursor* cursor) {
+    if (cursor->opened) {
+        free_index(&cursor->index);
+        unmap_file(&cursor->file);
+    }
+    free(cursor->strings.data);
+}
+
+// The sales of several runs merged in VIN order, equal VINs from the older run first
+typedef struct {
+    ArchiveCursor* cursors;         // Oldest run first
+    const ArchivedSale* heads[ARCHIVE_MAX_RUNS];
+    int count;
+    int taken;                      // Cursor whose head was handed out, advanced on the next call
+    uint32_t record_count;          // Sales in all the runs
+    int failed;
+} RunMerge;
+
+// 0 (nothing to close) if a run cannot be opened
+static int open_merge(RunMerge* merge, int showroom_id, char (*paths)[ARCHIVE_PATH_SIZE], int count, int quiet) {
+    memset(merge, 0, sizeof(RunMerge));
+    merge->taken = -1;
+    merge->cursors = (ArchiveCursor*)malloc((count ? count : 1) * sizeof(ArchiveCursor));
+    if (!merge->cursors) return 0;
+    for (int r = 0; r < count; r++) {
+        if (!open_cursor(&merge->cursors[r], paths[r], showroom_id, quiet)) {
+            for (int c = 0; c < r; c++) {
+                close_cursor(&merge->cursors[c]);
+            }
+            free(merge->cursors);
+            return 0;
+        }
+        merge->count++;
+        merge->record_count += merge->cursors[r].index.record_count;
+        merge->heads[r] = cursor_next(&merge->cursors[r]);
+        if (merge->cursors[r].failed) merge->failed = 1;
+    }
+    return 1;
+}
+
+// The next sale, valid until the following call; NULL at the end or when a run is damaged
+static const ArchivedSale* merge_next(RunMerge* merge) {
+    if (merge->taken >= 0) {
+        ArchiveCursor* cursor = &merge->cursors[merge->taken];
+        merge->heads[merge->taken] = cursor_next(cursor);
+        if (cursor->failed) merge->failed = 1;
+        merge->taken = -1;
+    }
+    if (merge->failed) return NULL;
+
+    for (int r = 0; r < merge->count; r++) {
+        if (!merge->heads[r]) continue;
+        if (merge->taken < 0 || strcmp(merge->heads[r]->customer.car_VIN, merge->heads[merge->taken]->customer.car_VIN) < 0) {
+            merge->taken = r;
+        }
+    }
+    return merge->taken >= 0 ? merge->heads[merge->taken] : NULL;
+}
+
+static void close_merge(RunMerge* merge) {
+    for (int r = 0; r < merge->count; r++) {
+        close_cursor(&merge->cursors[r]);
+    }
+    free(merge->cursors);
+}
+
+int archive_scan(Showroom* showroom, ArchivedSaleFunc process, void* user_data) {
+    if (showroom->archive_run_count == 0) return 0;
+
+    char paths[ARCHIVE_MAX_RUNS][ARCHIVE_PATH_SIZE];
+    RunMerge merge;
+    if (!run_paths(showroom, paths) || !open_merge(&merge, showroom->id, paths, showroom->archive_run_count, 0)) {
+        return -1;
+    }
+    int visited = 0;
+    for (const ArchivedSale* sale = merge_next(&merge); sale; sale = merge_next(&merge)) {
+        if (process) process(sale, user_data);
+        visited++;
+    }
+    int failed = merge.failed;
+    close_merge(&merge);
+    return failed ? -1 : visited;
+}
+
+// Look the VIN up in one run: the last block starting at or before it, found through the sparse index
+static int find_in_run(const ArchiveIndex* index, const char* path, const char* vin,
+                       ArchivedSaleFunc process, void* user_data) {
+    int low = 0, high = (int)index->block_count - 1, found_block = -1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (strcmp(index->blocks[mid].first_VIN, vin) <= 0) {
+            found_block = mid;
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    if (found_block < 0) return 0;
+
+    ArchiveBlock* block = &index->blocks[found_block];
+    unsigned char* data = (unsigned char*)malloc(block->length ? block->length : 1);
+    ArchivedSale* sales = (ArchivedSale*)malloc(ARCHIVE_BLOCK_RECORDS * sizeof(ArchivedSale));
+    ByteBuffer strings = {NULL, 0, 0, 0};
+    FILE* file = fopen(path, "rb");
+    int ok = data && sales && file && fseek(file, (long)block->offset, SEEK_SET) == 0 &&
+             fread(data, 1, block->length, file) == block->length &&
+             crc32_update(0, data, block->length) == block->crc &&
+             decode_block(data, block->length, block->records, sales, &strings);
+    if (file) fclose(file);
+    if (!ok && data && sales) {
+        out_printf("Archive block %d of showroom %d is damaged.\n", found_block, index->showroom_id);
+    }
+
+    int found = 0;
+    for (uint32_t i = 0; ok && i < block->records && !found; i++) {
+        if (strcmp(sales[i].customer.car_VIN, vin) != 0) continue;
+        process(&sales[i], user_data);
+        found = 1;
+    }
+    free(strings.data);
+    free(sales);
+    free(data);
+    return found;
+}
+
+int archive_find_sale(Showroom* showroom, const char* vin, ArchivedSaleFunc process, void* user_data) {
+    // Newest run first, skipping those whose filter rules the VIN out
+    for (int r = 0; r < showroom->archive_run_count; r++) {
+        char path[ARCHIVE_PATH_SIZE];
+        ArchiveIndex* index = open_index(showroom, showroom->archive_runs[r], path, sizeof(path));
+        if (!index || index->block_count == 0) continue;
+        if (index->bloom && !bloom_may_contain(index->bloom, index->bloom_bits, vin)) continue;
+        if (find_in_run(index, path, vin, process, user_data)) return 1;
+    }
+    return 0;
+}
+
+void archive_add_to_ledger(Showroom* showroom) {
+    if (!showroom->monthly_sales) return;
+
+    for (int r = 0; r < showroom->archive_run_count; r++) {
+        char path[ARCHIVE_PATH_SIZE];
+        ArchiveIndex* index = open_index(showroom, showroom->archive_runs[r], path, sizeof(path));
+        if (!index) continue;
+
+        for (uint32_t m = 0; m < index->month_count; m++) {
+            MonthlySales* month = &index->months[m];
+            MonthlySales* bucket = (MonthlySales*)bplusSearch(showroom->monthly_sales, month);
+            if (bucket) {
+                bucket->sales_count += month->sales_count;
+                bucket->sales_value += month->sales_value;
+            } else {
+                bplusInsert(showroom->monthly_sales, month);
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Archiving and restoring
+// ---------------------------------------------------------------------------
+
+static int archive_months() {
+    const char* months = getenv(ARCHIVE_MONTHS_ENV);
+    return months ? atoi(months) : 0;
+}
+
+// First day kept in memory: the start of the month `months` months back, and never inside the
+// popularity window that ends at the latest sale, so the windows come out the same after a reload
+static int archive_cutoff_day(int months) {
+    time_t t = time(NULL);
+    struct tm* current_time = localtime(&t);
+    int month = current_time->tm_mon + 1 - months;
+    int year = current_time->tm_year + 1900;
+    while (month < 1) {
+        month += 12;
+        year--;
+    }
+    int cutoff = date_to_days(1, month, year);
+
+    int latest_day = popularity_window_latest_day();
+    if (latest_day >= 0 && latest_day - POPULARITY_WINDOW_DAYS + 1 < cutoff) {
+        cutoff = latest_day - POPULARITY_WINDOW_DAYS + 1;
+    }
+    return cutoff;
+}
+
+// An old sale collected from memory, numbered so equal VINs keep their order
+typedef struct {
+    ArchivedSale sale;
+    int order;
+} OldSale;
+
+static int compare_old_sales(const void* a, const void* b) {
+    const OldSale* sale_a = (const OldSale*)a;
+    const OldSale* sale_b = (const OldSale*)b;
+    int cmp = strcmp(sale_a->sale.customer.car_VIN, sale_b->sale.customer.car_VIN);
+    if (cmp != 0) return cmp;
+    return sale_a->order - sale_b->order;
+}
+
+static BTreeNode* first_leaf(BPlusTree* tree) {
+    if (!tree || !tree->root) return NULL;
+    BTreeNode* node = tree->root;
+    while (!node->is_leaf) {
+        node = node->children[0];
+    }
+    return node;
+}
+
+// Rebuild a salesperson's customer tree without the customers bought before `cutoff`
+static void drop_old_customers(SalesPerson* sp, int cutoff) {
+    int total = 0, kept = 0;
+    for (BTreeNode* leaf = first_leaf(sp->customer_tree); leaf; leaf = leaf->leaf_link.next) {
+        total += leaf->num_keys;
+    }
+    void** customers = (void**)malloc((total ? total : 1) * sizeof(void*));
+    BPlusTree* tree = createBPlusTree(compareCustomerByEMI, printCustomer, cloneCustomer, freeCustomer);
+    if (!customers || !tree) {
+        free(customers);
+        if (tree) freeBPlusTree(tree);
+        return;
+    }
+
+    // The leaves are in key order already, so the survivors can be loaded bottom-up
+    for (BTreeNode* leaf = first_leaf(sp->customer_tree); leaf; leaf = leaf->leaf_link.next) {
+        for (int k = 0; k < leaf->num_keys; k++) {
+            Customer* customer = (Customer*)leaf->keys[k].key;
+            if (customer->purchase_date >= cutoff) customers[kept++] = cloneCustomer(customer);
+        }
+    }
+    if (!bplusBulkLoad(tree, customers, kept)) {
+        for (int i = 0; i < kept; i++) {
+            bplusInsert(tree, customers[i]);
+            freeCustomer(customers[i]);
+        }
+    }
+    freeBPlusTree(sp->customer_tree);
+    sp->customer_tree = tree;
+    free(customers);
+}
+
+// Returns the sales archived
+static int archive_showroom(Showroom* showroom, int cutoff) {
+    // A full archive waits for its compaction
+    if (showroom->archive_run_count == ARCHIVE_MAX_RUNS) return 0;
+
+    int count = 0;
+    for (BTreeNode* sp_node = first_leaf(showroom->sales_persons); sp_node; sp_node = sp_node->leaf_link.next) {
+        for (int j = 0; j < sp_node->num_keys; j++) {
+            SalesPerson* sp = (SalesPerson*)sp_node->keys[j].key;
+            for (BTreeNode* leaf = first_leaf(sp->customer_tree); leaf; leaf = leaf->leaf_link.next) {
+                for (int k = 0; k < leaf->num_keys; k++) {
+                    count += ((Customer*)leaf->keys[k].key)->purchase_date < cutoff;
+                }
+            }
+        }
+    }
+    if (count == 0) return 0;
+
+    OldSale* sales = (OldSale*)malloc(count * sizeof(OldSale));
+    ArchiveWriter* writer = (ArchiveWriter*)malloc(sizeof(ArchiveWriter));
+    if (!sales || !writer) {
+        out_printf("Memory allocation failed for archive\n");
+        free(sales);
+        free(writer);
+        return 0;
+    }
+
+    // The old sales with their sold cars, in VIN order
+    int n = 0;
+    for (BTreeNode* sp_node = first_leaf(showroom->sales_persons); sp_node; sp_node = sp_node->leaf_link.next) {
+        for (int j = 0; j < sp_node->num_keys; j++) {
+            SalesPerson* sp = (SalesPerson*)sp_node->keys[j].key;
+            for (BTreeNode* leaf = first_leaf(sp->customer_tree); leaf; leaf = leaf->leaf_link.next) {
+                for (int k = 0; k < leaf->num_keys; k++) {
+                    Customer* customer = (Customer*)leaf->keys[k].key;
+                    if (customer->purchase_date >= cutoff) continue;
+
+                    ArchivedSale* sale = &sales[n].sale;
+                    memset(sale, 0, sizeof(ArchivedSale));
+                    sales[n].order = n;
+                    sale->salesperson_id = sp->id;
+                    sale->customer = *customer;
+                    sale->name = customer_name(customer);
+                    sale->address = customer_address(customer);
+
+                    SoldCar temp_sold_car;
+                    strcpy(temp_sold_car.VIN, customer->car_VIN);
+                    SoldCar* in_showroom = (SoldCar*)bplusSearch(showroom->sold_cars, &temp_sold_car);
+                    SoldCar* in_salesperson = (SoldCar*)bplusSearch(sp->sold_car_tree, &temp_sold_car);
+                    if (in_showroom) sale->sold_car_in |= ARCHIVE_IN_SHOWROOM;
+                    if (in_salesperson) sale->sold_car_in |= ARCHIVE_IN_SALESPERSON;
+                    if (in_showroom || in_salesperson) sale->sold_car = in_showroom ? *in_showroom : *in_salesperson;
+                    n++;
+                }
+            }
+        }
+    }
+    qsort(sales, count, sizeof(OldSale), compare_old_sales);
+
+    // A new run with just these sales, the older runs are left as they are
+    char path[ARCHIVE_PATH_SIZE];
+    uint32_t generation = 0;
+    int ok = 0;
+    if (open_archive_writer(writer, showroom->id, (uint32_t)count, path, sizeof(path), &generation)) {
+        for (int i = 0; i < count; i++) {
+            add_sale(writer, &sales[i].sale);
+        }
+        ok = close_archive_writer(writer, showroom->id);
+        if (!ok) {
+            out_printf("Error: Could not write archive %s, the sales stay in memory.\n", path);
+            remove(path);
+        }
+    }
+
+    if (ok) {
+        // The indexes point into the trees about to change; the live customers go back after
+        int indexed = !(showroom->snapshot_state & SNAPSHOT_NOT_INDEXED);
+        if (indexed) customer_index_remove_showroom(showroom);
+        for (int i = 0; i < count; i++) {
+            ArchivedSale* sale = &sales[i].sale;
+            SalesPerson temp_sp;
+            temp_sp.id = sale->salesperson_id;
+            SalesPerson* sp = (SalesPerson*)bplusSearch(showroom->sales_persons, &temp_sp);
+            SoldCar temp_sold_car;
+            strcpy(temp_sold_car.VIN, sale->customer.car_VIN);
+            if (sale->sold_car_in & ARCHIVE_IN_SHOWROOM) bplusDelete(showroom->sold_cars, &temp_sold_car);
+            if (sp && (sale->sold_car_in & ARCHIVE_IN_SALESPERSON)) bplusDelete(sp->sold_car_tree, &temp_sold_car);
+        }
+        for (BTreeNode* sp_node = first_leaf(showroom->sales_persons); sp_node; sp_node = sp_node->leaf_link.next) {
+            for (int j = 0; j < sp_node->num_keys; j++) {
+                drop_old_customers((SalesPerson*)sp_node->keys[j].key, cutoff);
+            }
+        }
+        if (indexed) customer_index_add_showroom(showroom);
+
+        memmove(&showroom->archive_runs[1], &showroom->archive_runs[0], showroom->archive_run_count * sizeof(uint32_t));
+        showroom->archive_runs[0] = generation;
+        showroom->archive_run_count++;
+        showroom->dirty |= SHOWROOM_DIRTY(SHOWROOM_SALES);
+    }
+
+    free(sales);
+    free(writer);
+    return ok ? count : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Compaction
+// ---------------------------------------------------------------------------
+
+#define COMPACTION_QUEUED 0
+#define COMPACTION_RUNNING 1
+#define COMPACTION_DONE 2
+#define COMPACTION_FAILED 3
+
+// Merging all of a showroom's runs into one. Everything the thread needs is copied in when the
+// job is queued; it never looks at the showrooms.
+typedef struct {
+    int showroom_id;
+    int run_count;
+    uint32_t runs[ARCHIVE_MAX_RUNS];                    // Newest first, as the showroom had them
+    char paths[ARCHIVE_MAX_RUNS][ARCHIVE_PATH_SIZE];    // Oldest first
+    uint32_t generation;                                // Of the merged run
+    char path[ARCHIVE_PATH_SIZE];
+    int state;                                          // COMPACTION_*
+} CompactionJob;
+
+// Lock order: the state lock, then compaction_lock
+static pthread_mutex_t compaction_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t compaction_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t compaction_thread;
+static int compaction_started = 0;
+static int compaction_stopping = 0;
+static CompactionJob** jobs = NULL;
+static int job_count = 0;
+static int job_capacity = 0;
+
+// In the compaction thread: 1 if the merged run is complete at job->path
+static int compact_runs(CompactionJob* job) {
+    RunMerge merge;
+    ArchiveWriter* writer = (ArchiveWriter*)malloc(sizeof(ArchiveWriter));
+    if (!writer) return 0;
+    if (!open_merge(&merge, job->showroom_id, job->paths, job->run_count, 1)) {
+        free(writer);
+        return 0;
+    }
+
+    int ok = 0;
+    if (open_stream_writer(writer, job->path, merge.record_count)) {
+        for (const ArchivedSale* sale = merge_next(&merge); sale; sale = merge_next(&merge)) {
+            add_sale(writer, sale);
+        }
+        if (merge.failed) writer->failed = 1;
+        ok = close_archive_writer(writer, job->showroom_id);
+        if (!ok) remove(job->path);
+    }
+    close_merge(&merge);
+    free(writer);
+    return ok;
+}
+
+static void* compaction_worker(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&compaction_lock);
+    for (;;) {
+        CompactionJob* job = NULL;
+        for (int i = 0; i < job_count && !job; i++) {
+            if (jobs[i]->state == COMPACTION_QUEUED) job = jobs[i];
+        }
+        if (!job) {
+            if (compaction_stopping) break;
+            pthread_cond_wait(&compaction_cond, &compaction_lock);
+            continue;
+        }
+
+        job->state = COMPACTION_RUNNING;
+        pthread_mutex_unlock(&compaction_lock);
+        int ok = compact_runs(job);
+        pthread_mutex_lock(&compaction_lock);
+        job->state = ok ? COMPACTION_DONE : COMPACTION_FAILED;
+        pthread_cond_broadcast(&compaction_cond);
+    }
+    pthread_mutex_unlock(&compaction_lock);
+    return NULL;
+}
+
+// With compaction_lock held
+static int compaction_pending(int showroom_id) {
+    for (int i = 0; i < job_count; i++) {
+        if (jobs[i]->showroom_id == showroom_id) return 1;
+    }
+    return 0;
+}
+
+// With the state lock held
+static void queue_compaction(Showroom* showroom) {
+    CompactionJob* job = (CompactionJob*)malloc(sizeof(CompactionJob));
+    if (!job) return;
+    job->showroom_id = showroom->id;
+    job->run_count = showroom->archive_run_count;
+    memcpy(job->runs, showroom->archive_runs, sizeof(job->runs));
+    job->generation = snapshot_next_generation();
+    job->state = COMPACTION_QUEUED;
+    if (!run_paths(showroom, job->paths) ||
+        !snapshot_archive_path(job->path, sizeof(job->path), showroom->id, job->generation)) {
+        free(job);
+        return;
+    }
+
+    pthread_mutex_lock(&compaction_lock);
+    if (job_count == job_capacity) {
+        int capacity = job_capacity ? job_capacity * 2 : 16;
+        CompactionJob** grown = (CompactionJob**)realloc(jobs, capacity * sizeof(CompactionJob*));
+        if (!grown) {
+            pthread_mutex_unlock(&compaction_lock);
+            free(job);
+            return;
+        }
+        jobs = grown;
+        job_capacity = capacity;
+    }
+    if (!compaction_started) {
+        compaction_started = pthread_create(&compaction_thread, NULL, compaction_worker, NULL) == 0;
+    }
+    if (compaction_started) {
+        jobs[job_count++] = job;
+        pthread_cond_broadcast(&compaction_cond);
+    } else {
+        free(job);
+    }
+    pthread_mutex_unlock(&compaction_lock);
+}
+
+// Put a merged run in place of the runs it was made from, unless the archive changed otherwise
+// meanwhile (restored, or its showroom removed)
+static void install_compaction(const CompactionJob* job) {
+    Showroom* showroom = NULL;
+    for (BTreeNode* node = first_leaf(showroom_tree); node && !showroom; node = node->leaf_link.next) {
+        for (int i = 0; i < node->num_keys; i++) {
+            if (((Showroom*)node->keys[i].key)->id == job->showroom_id) showroom = (Showroom*)node->keys[i].key;
+        }
+    }
+
+    int present = 0;
+    for (int r = 0; showroom && r < showroom->archive_run_count; r++) {
+        for (int j = 0; j < job->run_count; j++) {
+            present += showroom->archive_runs[r] == job->runs[j];
+        }
+    }
+    if (!showroom || present != job->run_count) {
+        remove(job->path);
+        return;
+    }
+
+    // Runs archived since stay in front, the merged one is the oldest
+    int kept = 0;
+    for (int r = 0; r < showroom->archive_run_count; r++) {
+        uint32_t generation = showroom->archive_runs[r];
+        int merged = 0;
+        for (int j = 0; j < job->run_count; j++) {
+            merged |= generation == job->runs[j];
+        }
+        if (merged) {
+            drop_index(showroom->id, generation);
+            snapshot_retire_archive_run(showroom->id, generation);
+        } else {
+            showroom->archive_runs[kept++] = generation;
+        }
+    }
+    showroom->archive_runs[kept++] = job->generation;
+    showroom->archive_run_count = kept;
+}
+
+// With the state lock held: take over the finished compactions
+static void finish_compactions() {
+    pthread_mutex_lock(&compaction_lock);
+    int kept = 0;
+    for (int i = 0; i < job_count; i++) {
+        CompactionJob* job = jobs[i];
+        if (job->state == COMPACTION_DONE) {
+            install_compaction(job);
+        } else if (job->state == COMPACTION_FAILED) {
+            out_printf("Compacting showroom %d's archive failed, its runs are kept.\n", job->showroom_id);
+        }
+        if (job->state == COMPACTION_DONE || job->state == COMPACTION_FAILED) {
+            free(job);
+        } else {
+            jobs[kept++] = job;
+        }
+    }
+    job_count = kept;
+    pthread_mutex_unlock(&compaction_lock);
+}
+
+// With the state lock held: queue every archive with enough runs that is not being compacted
+static void start_compactions() {
+    for (BTreeNode* node = first_leaf(showroom_tree); node; node = node->leaf_link.next) {
+        for (int i = 0; i < node->num_keys; i++) {
+            Showroom* showroom = (Showroom*)node->keys[i].key;
+            if (showroom->archive_run_count < ARCHIVE_COMPACT_RUNS) continue;
+
+            pthread_mutex_lock(&compaction_lock);
+            int skip = compaction_stopping || compaction_pending(showroom->id);
+            pthread_mutex_unlock(&compaction_lock);
+            if (!skip) queue_compaction(showroom);
+        }
+    }
+}
+
+void archive_stop_compaction() {
+    pthread_mutex_lock(&compaction_lock);
+    compaction_stopping = 1;
+    int started = compaction_started;
+    pthread_cond_broadcast(&compaction_cond);
+    pthread_mutex_unlock(&compaction_lock);
+    if (!started) return;
+
+    // The thread leaves once every queued job is done
+    pthread_join(compaction_thread, NULL);
+    compaction_started = 0;
+    finish_compactions();
+    free(jobs);
+    jobs = NULL;
+    job_count = 0;
+    job_capacity = 0;
+}
+
+int archive_old_sales() {
+    if (!showroom_tree) return 0;
+    finish_compactions();
+
+    int months = archive_months();
+    int archived = 0;
+    if (months > 0) {
+        int cutoff = archive_cutoff_day(months);
+        for (BTreeNode* node = first_leaf(showroom_tree); node; node = node->leaf_link.next) {
+            for (int i = 0; i < node->num_keys; i++) {
+                Showroom* showroom = (Showroom*)node->keys[i].key;
+                // Showrooms on disk are left for a save after they have been read
+                if (!(showroom->snapshot_state & SNAPSHOT_TABLES_ON_DISK)) archived += archive_showroom(showroom, cutoff);
+            }
+        }
+    }
+    start_compactions();
+    return archived;
+}
+
+static void restore_sale(const ArchivedSale* sale, void* user_data) {
+    Showroom* showroom = (Showroom*)user_data;
+    SalesPerson temp_sp;
+    temp_sp.id = sale->salesperson_id;
+    SalesPerson* sp = (SalesPerson*)bplusSearch(showroom->sales_persons, &temp_sp);
+    if (!sp) {
+        out_printf("Error: Could not find salesperson with ID %d for archived sale %s\n",
+                   sale->salesperson_id, sale->customer.car_VIN);
+        return;
+    }
+
+    SoldCar* sold_car = NULL;
+    if (sale->sold_car_in & ARCHIVE_IN_SHOWROOM) sold_car = (SoldCar*)bplusInsert(showroom->sold_cars, (void*)&sale->sold_car);
+    if (sale->sold_car_in & ARCHIVE_IN_SALESPERSON) bplusInsert(sp->sold_car_tree, (void*)&sale->sold_car);
+
+    Customer customer = sale->customer;
+    customer.name = string_heap_add(sale->name);
+    customer.address = string_heap_add(sale->address);
+    Customer* stored_customer = (Customer*)bplusInsert(sp->customer_tree, &customer);
+    if (!(showroom->snapshot_state & SNAPSHOT_NOT_INDEXED)) {
+        customer_index_add(showroom, sp, stored_customer, sold_car);
+    }
+}
+
+void archive_restore_sales(Showroom* showroom) {
+    if (showroom->archive_run_count == 0 || (showroom->snapshot_state & SNAPSHOT_TABLES_ON_DISK)) return;
+
+    // Check every block first, a sale must not end up both in memory and in the archive
+    if (archive_scan(showroom, NULL, NULL) < 0) {
+        out_printf("Showroom %d's archived sales stay in the archive.\n", showroom->id);
+        return;
+    }
+    archive_scan(showroom, restore_sale, showroom);
+
+    for (int r = 0; r < showroom->archive_run_count; r++) {
+        drop_index(showroom->id, showroom->archive_runs[r]);
+        snapshot_retire_archive_run(showroom->id, showroom->archive_runs[r]);
+    }
+    showroom->archive_run_count = 0;
+    showroom->dirty |= SHOWROOM_DIRTY(SHOWROOM_SALES);
+}
@@ -0,0 +1,72 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <stdint.h>
+#include "essentialfunction.h"
+
+// Cold tier for old sales, log-structured. With SHOWROOM_ARCHIVE_MONTHS set, every save moves
+// the sales older than that many months (the customer with its sold car) out of the showroom's
+// trees, which act as the in-memory table, and writes them to a new run: an immutable file
+// sorted by VIN, kept next to the snapshot segments and named in the snapshot manifest (see
+// snapshot.h). Archiving only ever writes the new sales, never rewrites what is archived.
+// Once a showroom has ARCHIVE_COMPACT_RUNS runs, a background thread merges them into one; the
+// merged run takes their place at the next save and their files go once a manifest without
+// them is saved. A showroom that reaches ARCHIVE_MAX_RUNS keeps its old sales in memory until
+// the compaction is done.
+//
+// A run is a header, blocks of up to ARCHIVE_BLOCK_RECORDS sales, and an index:
+//   - each block has its own dictionary of customer names and addresses, VINs stored as the
+//     length shared with the previous VIN plus the rest, purchase dates as the difference from
+//     the previous sale, and integers and amounts as varints (amounts with two or four decimals
+//     as scaled integers, anything else as the raw double)
+//   - the index holds each block's offset, CRC32 and first VIN, the run's sales per month, and
+//     a bloom filter of its VINs, so a VIN lookup skips the runs that cannot hold it and reads
+//     one block of each of the others, and the sales ledger survives archiving
+//
+// What stays in memory is the ledger and the showroom's counters (sold cars, salesperson
+// totals and rankings); the customer index, the EMI index and the popularity windows cover
+// the live sales only. Sales are archived only once they are outside the popularity window.
+
+#define ARCHIVE_MAGIC "SHOWARCH"
+#define ARCHIVE_VERSION 2                   // Version 1 files have no bloom filter, they are still read
+#define ARCHIVE_HEADER_SIZE 32
+#define ARCHIVE_TRAILER_SIZE 16
+#define ARCHIVE_BLOCK_RECORDS 128
+#define ARCHIVE_COMPACT_RUNS 4              // Runs at which a showroom's archive is compacted
+#define ARCHIVE_BLOOM_BITS_PER_KEY 10       // About 1% false positives
+#define ARCHIVE_BLOOM_HASHES 7
+#define ARCHIVE_MONTHS_ENV "SHOWROOM_ARCHIVE_MONTHS"   // Unset or 0 keeps every sale in memory
+
+// ArchivedSale.sold_car_in flags, the sold-car trees that held the sale
+#define ARCHIVE_IN_SHOWROOM 1
+#define ARCHIVE_IN_SALESPERSON 2
+
+// One archived sale. The strings are only valid during the callback that receives it.
+typedef struct {
+    int salesperson_id;
+    Customer customer;              // name and address are not in the string heap, see below
+    const char* name;
+    const char* address;
+    int sold_car_in;                // ARCHIVE_IN_* flags, 0 if the sale record was missing
+    SoldCar sold_car;
+} ArchivedSale;
+
+typedef void (*ArchivedSaleFunc)(const ArchivedSale* sale, void* user_data);
+
+// Move the old sales of every showroom in memory to a new run of its archive; on the state
+// lock, before the snapshot is saved. Also takes over finished compactions and starts the ones
+// due. Returns the sales moved.
+int archive_old_sales();
+void archive_stop_compaction();     // At exit, before the last save: lets the queued compactions finish
+
+// Queries
+int archive_find_sale(Showroom* showroom, const char* vin, ArchivedSaleFunc process, void* user_data);  // 1 if found
+int archive_scan(Showroom* showroom, ArchivedSaleFunc process, void* user_data);    // In VIN order, returns the sales visited, -1 if a run is damaged
+
+// Put the showroom's archived sales back into its trees and drop its archive
+void archive_restore_sales(Showroom* showroom);
+// Add the archived sales to a showroom's ledger that was built from the live ones
+void archive_add_to_ledger(Showroom* showroom);
+void free_archive_indexes();
+
+#endif
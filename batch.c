@@ -0,0 +1,449 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include "batch.h"
+#include "essentialfunction.h"
+#include "textreader.h"
+#include "filehandling.h"
+#include "checkpoint.h"
+#include "journal.h"
+#include "snapshot.h"
+#include "parallelload.h"
+
+// One kind of command: its fields start after the command name
+typedef struct {
+    const char* name;
+    const char* fields;             // One letter per field: i whole number, n number, t text, v VIN; the
+                                    // fields after a '[' may be left out
+    int (*run)(const StrView* fields, int field_count);
+    // Queries only: whether what it reads is in memory, so it can share the state lock.
+    // NULL for commands that change the state.
+    int (*resident)(const StrView* fields, int field_count);
+    int ok;
+    int failed;
+    double seconds;
+} BatchCommand;
+
+static int run_showroom(const StrView* fields, int field_count) {
+    char name[MAX_STR_LEN], location[MAX_STR_LEN], contact[MAX_MOBILE_LEN];
+    (void)field_count;
+    view_copy(fields[2], name, sizeof(name));
+    view_copy(fields[3], location, sizeof(location));
+    view_copy(fields[4], contact, sizeof(contact));
+    return perform_add_showroom(view_to_int(fields[1]), name, location, contact);
+}
+
+// Same columns as a line of cars.txt
+static int run_stock(const StrView* fields, int field_count) {
+    Car car;
+    memset(&car, 0, sizeof(Car));
+    parse_car_fields(fields + 1, field_count - 1, &car);
+    return perform_add_stock(view_to_int(fields[1]), &car);
+}
+
+static int run_recruit(const StrView* fields, int field_count) {
+    char name[MAX_STR_LEN];
+    (void)field_count;
+    view_copy(fields[3], name, sizeof(name));
+    return perform_recruit(view_to_int(fields[1]), view_to_int(fields[2]), name, view_to_double(fields[4]));
+}
+
+static int run_purchase(const StrView* fields, int field_count) {
+    char vin[MAX_VIN_LEN], payment[MAX_STR_LEN], name[MAX_STR_LEN], mobile[MAX_MOBILE_LEN];
+    char address[MAX_STR_LEN], reg_number[MAX_REG_NUM_LEN], date[32];
+    view_copy(fields[3], vin, sizeof(vin));
+    view_copy(fields[4], payment, sizeof(payment));
+    view_copy(fields[7], name, sizeof(name));
+    view_copy(fields[8], mobile, sizeof(mobile));
+    view_copy(fields[9], address, sizeof(address));
+    view_copy(fields[10], reg_number, sizeof(reg_number));
+
+    PurchaseOrder order = {
+        view_to_int(fields[1]), view_to_int(fields[2]), vin, parse_payment_type(payment),
+        view_to_double(fields[5]), view_to_int(fields[6]), name, mobile, address, reg_number, 0
+    };
+    if (field_count > 11) {
+        int day, month, year;
+        view_copy(fields[11], date, sizeof(date));
+        if (sscanf(date, "%d/%d/%d", &day, &month, &year) != 3 || !valid_date(day, month, year)) {
+            out_printf("Invalid date %s, expected d/m/y.\n", date);
+            return 0;
+        }
+        order.purchase_date = date_to_days(day, month, year);
+    }
+    return perform_car_purchase(&order);
+}
+
+static int run_merge(const StrView* fields, int field_count) {
+    char name[MAX_STR_LEN], location[MAX_STR_LEN], contact[MAX_MOBILE_LEN];
+    (void)field_count;
+    view_copy(fields[4], name, sizeof(name));
+    view_copy(fields[5], location, sizeof(location));
+    view_copy(fields[6], contact, sizeof(contact));
+    char conflict_choice = fields[7].length ? fields[7].data[0] : 'e';
+    int delete_originals = fields[8].length && (fields[8].data[0] == 'y' || fields[8].data[0] == 'Y');
+    return perform_merge(view_to_int(fields[1]), view_to_int(fields[2]), view_to_int(fields[3]),
+                         name, location, contact, conflict_choice, delete_originals);
+}
+
+static int run_find(const StrView* fields, int field_count) {
+    char vin[MAX_VIN_LEN];
+    (void)field_count;
+    view_copy(fields[1], vin, sizeof(vin));
+    return locate_car_by_VIN(vin);
+}
+
+static int run_showrooms(const StrView* fields, int field_count) {
+    (void)fields;
+    (void)field_count;
+    display_all_showrooms();
+    return 1;
+}
+
+static int run_inventory(const StrView* fields, int field_count) {
+    (void)field_count;
+    return show_showroom_inventory(view_to_int(fields[1]));
+}
+
+static int run_incentive(const StrView* fields, int field_count) {
+    (void)field_count;
+    return award_best_salesperson_incentive(view_to_int(fields[1]));
+}
+
+static int run_predict(const StrView* fields, int field_count) {
+    (void)field_count;
+    return show_sales_prediction(view_to_int(fields[1]));
+}
+
+static int run_sales_range(const StrView* fields, int field_count) {
+    (void)field_count;
+    return show_salespersons_in_sales_range(view_to_double(fields[1]), view_to_double(fields[2]));
+}
+
+static int run_popularity(const StrView* fields, int field_count) {
+    (void)fields;
+    (void)field_count;
+    display_car_popularity();
+    return 1;
+}
+
+static int run_emi(const StrView* fields, int field_count) {
+    (void)field_count;
+    return show_customers_with_emi_months(view_to_int(fields[1]), view_to_int(fields[2]));
+}
+
+static int run_customer(const StrView* fields, int field_count) {
+    char kind[16], key[MAX_STR_LEN];
+    (void)field_count;
+    view_copy(fields[1], kind, sizeof(kind));
+    view_copy(fields[2], key, sizeof(key));
+    if (strcmp(kind, "mobile") != 0 && strcmp(kind, "reg") != 0) {
+        out_printf("Search by mobile or reg, not %s.\n", kind);
+        return 0;
+    }
+    return show_customers_by_contact(strcmp(kind, "reg") == 0, key);
+}
+
+static int run_leaderboard(const StrView* fields, int field_count) {
+    int showroom_id = view_to_int(fields[1]);
+    if (!show_sales_leaderboard(showroom_id, view_to_int(fields[2]))) return 0;
+    int salesperson_id = field_count > 3 ? view_to_int(fields[3]) : 0;
+    return salesperson_id == 0 || show_salesperson_rank(showroom_id, salesperson_id);
+}
+
+static int run_recent(const StrView* fields, int field_count) {
+    (void)field_count;
+    return show_recent_car_popularity(view_to_int(fields[1]));
+}
+
+static int run_analytics(const StrView* fields, int field_count) {
+    InventorySnapshot* snapshot = show_inventory_analytics();
+    if (!snapshot) return 0;
+    if (field_count > 1) show_cars_priced_below(snapshot, view_to_double(fields[1]));
+    return 1;
+}
+
+static int run_import(const StrView* fields, int field_count) {
+    char path[512];
+    (void)field_count;
+    view_copy(fields[1], path, sizeof(path));
+    return import_stock_feed_from(path);
+}
+
+static int run_checkpoint(const StrView* fields, int field_count) {
+    (void)fields;
+    (void)field_count;
+    save_all_data();
+    return 1;
+}
+
+// Checkpoint first, the journal must only hold changes made after the exported data
+static int run_export(const StrView* fields, int field_count) {
+    (void)fields;
+    (void)field_count;
+    save_all_data();
+    export_data_to_text();
+    return 1;
+}
+
+static int always_resident(const StrView* fields, int field_count) {
+    (void)fields;
+    (void)field_count;
+    return 1;
+}
+
+static int showroom_resident(const StrView* fields, int field_count) {
+    (void)field_count;
+    return snapshot_resident(view_to_int(fields[1]));
+}
+
+static int all_resident(const StrView* fields, int field_count) {
+    (void)fields;
+    (void)field_count;
+    return snapshot_resident(0);
+}
+
+static int inventory_resident(const StrView* fields, int field_count) {
+    (void)fields;
+    (void)field_count;
+    return snapshot_resident(0) && inventory_snapshot_current();
+}
+
+// find is not a query here: archived sales are looked up through indexes opened on first use
+static BatchCommand batch_commands[] = {
+    { "showroom", "ittt", run_showroom, NULL, 0, 0, 0 },
+    { "stock", "ivttntt", run_stock, NULL, 0, 0, 0 },
+    { "recruit", "iitn", run_recruit, NULL, 0, 0, 0 },
+    { "purchase", "iivtnitttt[t", run_purchase, NULL, 0, 0, 0 },
+    { "merge", "iiittttt", run_merge, NULL, 0, 0, 0 },
+    { "incentive", "i", run_incentive, NULL, 0, 0, 0 },
+    { "import", "t", run_import, NULL, 0, 0, 0 },
+    { "showrooms", "", run_showrooms, always_resident, 0, 0, 0 },
+    { "inventory", "i", run_inventory, showroom_resident, 0, 0, 0 },
+    { "predict", "i", run_predict, showroom_resident, 0, 0, 0 },
+    { "find", "v", run_find, NULL, 0, 0, 0 },
+    { "sales_range", "nn", run_sales_range, all_resident, 0, 0, 0 },
+    { "popularity", "", run_popularity, always_resident, 0, 0, 0 },
+    { "emi", "ii", run_emi, all_resident, 0, 0, 0 },
+    { "customer", "tt", run_customer, all_resident, 0, 0, 0 },
+    { "leaderboard", "ii[i", run_leaderboard, showroom_resident, 0, 0, 0 },
+    { "recent", "i", run_recent, showroom_resident, 0, 0, 0 },
+    { "analytics", "[n", run_analytics, inventory_resident, 0, 0, 0 },
+    { "checkpoint", "", run_checkpoint, NULL, 0, 0, 0 },
+    { "export", "", run_export, NULL, 0, 0, 0 }
+};
+
+#define BATCH_COMMAND_COUNT ((int)(sizeof(batch_commands) / sizeof(batch_commands[0])))
+
+static BatchCommand* find_batch_command(StrView name) {
+    for (int i = 0; i < BATCH_COMMAND_COUNT; i++) {
+        if (strlen(batch_commands[i].name) == name.length &&
+            memcmp(batch_commands[i].name, name.data, name.length) == 0) {
+            return &batch_commands[i];
+        }
+    }
+    return NULL;
+}
+
+// Whole numbers for 'i' fields, any finite number for 'n' ones, spaces around them allowed
+static int is_number(StrView view, int whole) {
+    char text[64];
+    char* end;
+    if (view.length >= sizeof(text)) return 0;
+    memcpy(text, view.data, view.length);
+    text[view.length] = '\0';
+
+    errno = 0;
+    if (whole) {
+        long value = strtol(text, &end, 10);
+        if (errno || value < INT_MIN || value > INT_MAX) return 0;
+    } else if (!isfinite(strtod(text, &end))) {
+        return 0;
+    }
+    if (end == text) return 0;
+    while (*end == ' ' || *end == '\t') end++;
+    return *end == '\0';
+}
+
+// Split a line and check it against its command; NULL if it is not a valid command, with the
+// reason in problem
+static BatchCommand* parse_command(const char* line, size_t length, StrView* fields, int* field_count,
+                                   char* problem, size_t problem_size) {
+    StrView view = { line, length };
+    *field_count = split_fields(view, '|', fields, TEXT_MAX_FIELDS);
+
+    BatchCommand* command = find_batch_command(fields[0]);
+    if (!command) {
+        snprintf(problem, problem_size, "unknown command %.*s", (int)fields[0].length, fields[0].data);
+        return NULL;
+    }
+
+    int required = (int)strcspn(command->fields, "[");
+    int allowed = (int)strlen(command->fields) - (command->fields[required] == '[');
+    int given = *field_count - 1;
+    if (given < required || given > allowed) {
+        if (required == allowed) {
+            snprintf(problem, problem_size, "%s needs %d fields, got %d", command->name, required, given);
+        } else {
+            snprintf(problem, problem_size, "%s needs %d to %d fields, got %d", command->name, required, allowed, given);
+        }
+        return NULL;
+    }
+
+    const char* kind = command->fields;
+    for (int i = 1; i <= given; i++, kind++) {
+        if (*kind == '[') kind++;
+        if ((*kind == 'i' || *kind == 'n') && !is_number(fields[i], *kind == 'i')) {
+            snprintf(problem, problem_size, "%s: field %d (%.*s) is not a%s number", command->name, i,
+                     (int)fields[i].length, fields[i].data, *kind == 'i' ? " whole" : "");
+            return NULL;
+        }
+        // A longer VIN would be cut to fit and could then match another car
+        if (*kind == 'v' && (fields[i].length == 0 || fields[i].length >= MAX_VIN_LEN)) {
+            snprintf(problem, problem_size, "%s: field %d (%.*s) is not a VIN of 1 to %d characters", command->name, i,
+                     (int)fields[i].length, fields[i].data, MAX_VIN_LEN - 1);
+            return NULL;
+        }
+    }
+    return command;
+}
+
+// Run one line; 0 if it could not be read as a command
+static int run_batch_line(int line_number, char* line, size_t length) {
+    StrView fields[TEXT_MAX_FIELDS];
+    int field_count;
+    char problem[160];
+    BatchCommand* command = parse_command(line, length, fields, &field_count, problem, sizeof(problem));
+    if (!command) {
+        out_printf("line %d: %s\n", line_number, problem);
+        return 0;
+    }
+
+    double start = wall_clock_seconds();
+    int ok = command->run(fields, field_count);
+    command->seconds += wall_clock_seconds() - start;
+    if (ok) {
+        command->ok++;
+    } else {
+        command->failed++;
+    }
+    out_printf("line %d: %s %s\n", line_number, command->name, ok ? "ok" : "failed");
+    return 1;
+}
+
+static void print_batch_summary(int commands, int invalid, double seconds) {
+    int ok = 0, failed = 0;
+    for (int i = 0; i < BATCH_COMMAND_COUNT; i++) {
+        ok += batch_commands[i].ok;
+        failed += batch_commands[i].failed;
+    }
+
+    out_printf("\n=== Batch Summary ===\n");
+    out_printf("Commands: %d (%d ok, %d failed), %d invalid lines\n", commands, ok, failed, invalid);
+    out_printf("Ran in %.1f ms (%.0f commands/s)\n", seconds * 1000.0, seconds > 0 ? commands / seconds : 0.0);
+    out_printf("\nCommand     Count     Failed    Avg (us)  Commands/s\n");
+    for (int i = 0; i < BATCH_COMMAND_COUNT; i++) {
+        BatchCommand* command = &batch_commands[i];
+        int count = command->ok + command->failed;
+        if (count == 0) continue;
+        out_printf("%-11s %-9d %-9d %-9.1f %.0f\n", command->name, count, command->failed,
+                   command->seconds * 1e6 / count, command->seconds > 0 ? count / command->seconds : 0.0);
+    }
+}
+
+int batch_run(const char* path) {
+    FILE* input = stdin;
+    if (path && strcmp(path, "-") != 0) {
+        input = fopen(path, "r");
+        if (!input) {
+            out_printf("Cannot open command file %s\n", path);
+            return 0;
+        }
+    }
+
+    char* line = (char*)malloc(BATCH_LINE_LEN);
+    if (!line) {
+        if (input != stdin) fclose(input);
+        return 0;
+    }
+
+    int line_number = 0, commands = 0, invalid = 0, in_group = 0;
+    double start = wall_clock_seconds();
+    checkpoint_lock_state();
+    while (fgets(line, BATCH_LINE_LEN, input)) {
+        line_number++;
+        size_t length = strlen(line);
+        if (length == BATCH_LINE_LEN - 1 && line[length - 1] != '\n') {
+            // Too long for any command: skip the rest of it
+            int c;
+            while ((c = fgetc(input)) != '\n' && c != EOF);
+            out_printf("line %d: longer than %d characters\n", line_number, BATCH_LINE_LEN - 1);
+            invalid++;
+            continue;
+        }
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) line[--length] = 0;
+        if (length == 0 || line[0] == '#') continue;
+
+        if (run_batch_line(line_number, line, length)) {
+            commands++;
+        } else {
+            invalid++;
+        }
+
+        // Let background checkpoints and reloads in between groups
+        if (++in_group == BATCH_LOCK_COMMANDS) {
+            journal_commit();
+            snapshot_trim_memory();
+            checkpoint_unlock_state();
+            checkpoint_lock_state();
+            in_group = 0;
+        }
+    }
+    journal_commit();
+    snapshot_trim_memory();
+    checkpoint_unlock_state();
+    double seconds = wall_clock_seconds() - start;
+
+    free(line);
+    if (input != stdin) fclose(input);
+    print_batch_summary(commands, invalid, seconds);
+    return 1;
+}
+
+int batch_execute(const char* line, size_t length) {
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) length--;
+    if (memchr(line, '\n', length)) {
+        out_printf("One command per request\n");
+        return BATCH_INVALID;
+    }
+
+    StrView fields[TEXT_MAX_FIELDS];
+    int field_count;
+    char problem[160];
+    BatchCommand* command = parse_command(line, length, fields, &field_count, problem, sizeof(problem));
+    if (!command) {
+        out_printf("%s\n", problem);
+        return BATCH_INVALID;
+    }
+
+    // A query whose data is all in memory only reads it, so it runs beside other queries
+    if (command->resident) {
+        checkpoint_lock_state_shared();
+        if (command->resident(fields, field_count)) {
+            int ok = command->run(fields, field_count);
+            checkpoint_unlock_state();
+            return ok ? BATCH_OK : BATCH_FAILED;
+        }
+        checkpoint_unlock_state();
+    }
+
+    checkpoint_lock_state();
+    int ok = command->run(fields, field_count);
+    journal_commit();
+    snapshot_trim_memory();
+    checkpoint_unlock_state();
+    return ok ? BATCH_OK : BATCH_FAILED;
+}
@@ -0,0 +1,53 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+// Batch mode (--batch [file], stdin without one or with "-"): runs scripted commands without
+// prompts, one per line with '|' between the fields like the data files. Blank lines and lines
+// starting with '#' are skipped.
+//   showroom|id|name|location|contact
+//   stock|showroom_id|VIN|model|color|price|fuel_type|car_type
+//   recruit|showroom_id|salesperson_id|name|target_sales
+//   purchase|showroom_id|salesperson_id|VIN|Cash or Loan|down_payment|loan_months|name|mobile|address|reg_number[|d/m/y]
+//            (down payment and months are only read for loans; the date defaults to today)
+//   merge|id1|id2|new_id|name|location|contact|e, n or m for every conflict|y to delete the originals
+//   incentive|showroom_id                  (awards the best salesperson, menu 8)
+//   import|feed path
+//   showrooms
+//   inventory|showroom_id
+//   predict|showroom_id
+//   find|VIN
+//   sales_range|min|max
+//   popularity
+//   emi|min_months|max_months
+//   customer|mobile or reg|number
+//   leaderboard|showroom_id|top_n[|salesperson_id to rank]
+//   recent|showroom_id                      (0 for all showrooms)
+//   analytics[|price threshold]
+//   checkpoint
+//   export
+// Each command goes through the same function as the menu (see essentialfunction.h), changes
+// are journaled the same way and queries print what the menu shows. A line with the wrong number
+// of fields or a number field that is not a number is rejected without running. A result line is
+// printed per command, then the throughput of the run per kind of command.
+//
+// Commands run under the state lock in groups of BATCH_LOCK_COMMANDS, so background checkpoints
+// and reloads still get in between; the journal is committed at the end of each group.
+
+#define BATCH_LINE_LEN 4096
+#define BATCH_LOCK_COMMANDS 1024
+
+// 0 if the command file cannot be opened
+int batch_run(const char* path);
+
+// Result of batch_execute
+#define BATCH_OK 1
+#define BATCH_FAILED 0
+#define BATCH_INVALID -1        // Not a valid command line, nothing was run
+
+// Run one command line on its own, for a server request (see server.h): its output, or why the
+// line is invalid, goes to the calling thread's command output. The state lock is taken just for
+// the command; a query whose data is already in memory shares it with other queries, anything
+// else holds it alone and commits the journal before letting go.
+int batch_execute(const char* line, size_t length);
+
+#endif
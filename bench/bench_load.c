@@ -0,0 +1,59 @@
+// Load and save benchmark: times load_all_data() and then save_all_data() on the data/ directory
+// it runs in, the way the program does at start-up and exit. Only those two calls are used, so
+// it builds against any revision (see run_bench.sh).
+// usage: bench_load [--cold]    --cold drops the data files from the page cache first
+// Prints "load_ms save_ms" on stderr; what the program itself prints goes to stdout.
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "essentialfunction.h"
+#include "filehandling.h"
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Every file under the directory; written pages must reach the disk before the kernel lets them go
+static void drop_from_page_cache(const char* directory) {
+    DIR* dir = opendir(directory);
+    if (!dir) return;
+    struct dirent* entry;
+    char path[512];
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+        if (entry->d_type == DT_DIR) {
+            drop_from_page_cache(path);
+            continue;
+        }
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) continue;
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+    closedir(dir);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--cold") == 0) {
+        drop_from_page_cache("data");
+    }
+
+    init_system();
+    double start = now_ms();
+    load_all_data();
+    double loaded = now_ms();
+    save_all_data();
+    double saved = now_ms();
+
+    fflush(stdout);
+    fprintf(stderr, "%.1f %.1f\n", loaded - start, saved - loaded);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#!/bin/sh
+# Time the start-up load and the exit save on a generated data set, for the working tree and any
+# git revisions given, so a change can be measured against the commit before it.
+# Each run starts from the text files alone: the first load imports them and saves (a snapshot,
+# where the revision has one), the second loads what was saved. --cold runs drop the data files
+# from the page cache before loading. Medians over RUNS runs are printed.
+# usage: bench/run_bench.sh [revision...]
+#   SHOWROOMS=100 CARS=1000 RUNS=5 COLD=1 bench/run_bench.sh 211a044^ 211a044
+cd "$(dirname "$0")/.." || exit 1
+showrooms=${SHOWROOMS:-100}
+cars=${CARS:-1000}          # Per showroom, and as many sold with a customer each
+runs=${RUNS:-5}
+cold=${COLD:-0}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# showrooms|cars|sold_cars|salespersons|customers|car_popularity, 20 salespersons a showroom
+mkdir -p "$work/data"
+awk -v showrooms="$showrooms" -v cars="$cars" -v dir="$work/data" 'BEGIN {
+    split("Toyota Fortuner|Honda City|Kia Seltos|Hyundai Creta|Tata Nexon|Mahindra XUV700|BMW 3 Series|Maruti Swift", models, "|")
+    split("Petrol|Diesel|Electric", fuels, "|")
+    split("SUV|Sedan|Hatchback", types, "|")
+    for (m = 1; m <= 8; m++) printf "%d|%s|0\n", m - 1, models[m] > (dir "/car_popularity.txt")
+    for (s = 1; s <= showrooms; s++) {
+        printf "%d|Showroom %d|City %d|98%08d|0|0\n", s, s, s % 50, s > (dir "/showrooms.txt")
+        for (p = 0; p < 20; p++) {
+            printf "%d|%d|Sales Person %d|%.2f|%.2f|%.2f\n", s, s * 100 + p, p, 40 + p, 0, 0 > (dir "/salespersons.txt")
+        }
+        for (c = 0; c < cars; c++) {
+            m = c % 8 + 1
+            price = 8 + (c * 37 % 600) / 10
+            printf "%d|VIN%05d%06d|%s|Red|%.2f|%s|%s\n", s, s, c, models[m], price, fuels[c % 3 + 1], types[c % 3 + 1] > (dir "/cars.txt")
+            printf "%d|SLD%05d%06d|Loan|%.2f|60|%.2f|8.75|%.2f|%s\n", s, s, c, price / 5, price * 4 / 5, price / 60, models[m] > (dir "/sold_cars.txt")
+            printf "%d|Customer %d|9%09d|%d Main Road|SLD%05d%06d|KA%02d%06d|%.2f|%d|%d|2025|60\n", s * 100 + c % 20, c, s * 1000000 + c, c, s, c, s % 100, c, price * 4 / 5, c % 28 + 1, c % 12 + 1 > (dir "/customers.txt")
+        }
+    }
+}'
+megabytes=$(du -k "$work/data" | awk '{ printf "%.1f", $1 / 1024 }')
+echo "data set: $showrooms showrooms, $cars cars and $cars sales each, $megabytes MB of text"
+
+median() { sort -n | awk '{ v[NR] = $1 } END { printf "%.1f", v[int((NR + 1) / 2)] }'; }
+
+bench() {   # name, source directory
+    if ! gcc -std=gnu11 -O2 -w -o "$work/bench_load" bench/bench_load.c $(ls "$2"/*.c | grep -v '/main\.c$') \
+            -I"$2" -lm -lpthread; then
+        echo "$1: build failed"
+        return
+    fi
+    flag=""
+    [ "$cold" = 1 ] && flag=--cold
+    : > "$work/first"; : > "$work/second"
+    i=0
+    while [ $i -lt "$runs" ]; do
+        rm -rf "$work/run" && mkdir -p "$work/run" && cp -r "$work/data" "$work/run/"
+        (cd "$work/run" && "$work/bench_load" $flag 2>> "$work/first" > /dev/null)
+        (cd "$work/run" && "$work/bench_load" $flag 2>> "$work/second" > /dev/null)
+        i=$((i + 1))
+    done
+    import=$(cut -d' ' -f1 < "$work/first" | median)
+    printf "%-14s import %8s ms %7s MB/s   save %8s ms   reload %8s ms   save %8s ms\n" "$1" "$import" \
+        "$(awk -v mb="$megabytes" -v ms="$import" 'BEGIN { printf "%.1f", mb * 1000 / ms }')" \
+        "$(cut -d' ' -f2 < "$work/first" | median)" "$(cut -d' ' -f1 < "$work/second" | median)" \
+        "$(cut -d' ' -f2 < "$work/second" | median)"
+}
+
+for revision in "$@"; do
+    rm -rf "$work/src" && mkdir -p "$work/src"
+    if ! git archive "$revision" | tar -x -C "$work/src"; then
+        echo "$revision: no such revision"
+        continue
+    fi
+    bench "$revision" "$work/src"
+done
+bench "working tree" .
@@ -0,0 +1,224 @@
+#include "carpopularity.h"
+#include "mappedstore.h"
+
+// Car popularity table: an open-addressing (linear probing) index over a dense entry array.
+// Slots hold only the cached hash and the entry's model_id, so probing never touches strings
+// until the hashes match, and growing the table never rehashes a model name.
+typedef struct {
+    unsigned int hash;
+    int model_id;           // -1 for an empty slot
+} PopularitySlot;
+
+static PopularitySlot* slots = NULL;
+static int slot_capacity = 0;
+
+static CarPopularityEntry* entries = NULL;
+static int entry_count = 0;
+static int entry_capacity = 0;
+
+// Models ranked by count, best first
+static int top_models[POPULARITY_TOP_K];
+static int top_count = 0;
+
+// Hash function for strings (car models)
+static unsigned int hash_model(const char* str) {
+    unsigned int hash = 0;
+    while (*str) {
+        hash = (hash * 31) + (unsigned char)(*str++);
+    }
+    // Final mix so linear probing does not cluster on similar names
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3b;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+// Allocate an empty probe table
+static int allocate_slots(int capacity) {
+    PopularitySlot* fresh = (PopularitySlot*)store_malloc(capacity * sizeof(PopularitySlot));
+    if (!fresh) {
+        out_printf("Memory allocation failed for car popularity table\n");
+        return 0;
+    }
+    for (int i = 0; i < capacity; i++) {
+        fresh[i].model_id = -1;
+    }
+    store_free(slots);
+    slots = fresh;
+    slot_capacity = capacity;
+    return 1;
+}
+
+// Place an entry in the first free slot of its probe sequence
+static void place_slot(int model_id) {
+    unsigned int mask = slot_capacity - 1;
+    unsigned int i = entries[model_id].hash & mask;
+    while (slots[i].model_id != -1) {
+        i = (i + 1) & mask;
+    }
+    slots[i].hash = entries[model_id].hash;
+    slots[i].model_id = model_id;
+}
+
+// Double the probe table, reusing the cached hashes
+static int grow_slots() {
+    if (!allocate_slots(slot_capacity ? slot_capacity * 2 : POPULARITY_INITIAL_CAPACITY)) return 0;
+    for (int id = 0; id < entry_count; id++) {
+        place_slot(id);
+    }
+    return 1;
+}
+
+// Look up a model, optionally adding it with a zero count
+static int lookup_model(const char* model_name, int create) {
+    unsigned int hash = hash_model(model_name);
+
+    if (slots) {
+        unsigned int mask = slot_capacity - 1;
+        for (unsigned int i = hash & mask; slots[i].model_id != -1; i = (i + 1) & mask) {
+            if (slots[i].hash == hash && strcmp(entries[slots[i].model_id].model_name, model_name) == 0) {
+                return slots[i].model_id;
+            }
+        }
+    }
+
+    if (!create) return -1;
+
+    // Keep the load factor under 0.7
+    if ((entry_count + 1) * 10 > slot_capacity * 7 && !grow_slots()) return -1;
+
+    if (entry_count == entry_capacity) {
+        int new_capacity = entry_capacity ? entry_capacity * 2 : POPULARITY_INITIAL_CAPACITY;
+        CarPopularityEntry* grown = (CarPopularityEntry*)store_realloc(entries, new_capacity * sizeof(CarPopularityEntry));
+        if (!grown) {
+            out_printf("Memory allocation failed for car popularity tracking\n");
+            return -1;
+        }
+        entries = grown;
+        entry_capacity = new_capacity;
+    }
+
+    char* name_copy = (char*)store_malloc(strlen(model_name) + 1);
+    if (!name_copy) {
+        out_printf("Memory allocation failed for car popularity tracking\n");
+        return -1;
+    }
+    strcpy(name_copy, model_name);
+
+    int model_id = entry_count++;
+    entries[model_id].model_name = name_copy;
+    entries[model_id].hash = hash;
+    entries[model_id].count = 0;
+    entries[model_id].top_rank = -1;
+    place_slot(model_id);
+    return model_id;
+}
+
+// Re-rank a model whose count has grown (counts never go down, so it only moves up)
+static void offer_top_model(int model_id) {
+    CarPopularityEntry* entry = &entries[model_id];
+    int pos = entry->top_rank;
+
+    if (pos < 0) {
+        if (top_count < POPULARITY_TOP_K) {
+            pos = top_count++;
+        } else if (entry->count > entries[top_models[POPULARITY_TOP_K - 1]].count) {
+            pos = POPULARITY_TOP_K - 1;
+            entries[top_models[pos]].top_rank = -1;
+        } else {
+            return;
+        }
+    }
+
+    // Bubble toward the front past every model with a lower count
+    while (pos > 0 && entries[top_models[pos - 1]].count < entry->count) {
+        top_models[pos] = top_models[pos - 1];
+        entries[top_models[pos]].top_rank = pos;
+        pos--;
+    }
+    top_models[pos] = model_id;
+    entry->top_rank = pos;
+}
+
+// Function to increment count for a car model
+void increment_car_popularity(const char* model_name) {
+    int model_id = lookup_model(model_name, 1);
+    if (model_id < 0) return;
+
+    entries[model_id].count++;
+    offer_top_model(model_id);
+}
+
+// Function to set a model's count directly (used when loading saved counts)
+void set_car_popularity(const char* model_name, int count) {
+    int model_id = lookup_model(model_name, 1);
+    if (model_id < 0) return;
+
+    if (count > entries[model_id].count) {
+        entries[model_id].count = count;
+        offer_top_model(model_id);
+    }
+}
+
+// Function to find the most popular car model
+char* find_most_popular_car(int* max_count) {
+    static char none[] = "";
+    if (top_count == 0 || entries[top_models[0]].count == 0) {
+        *max_count = 0;
+        return none;
+    }
+    *max_count = entries[top_models[0]].count;
+    return entries[top_models[0]].model_name;
+}
+
+// Function to copy out up to k of the top models, best first
+int top_car_models(int k, CarPopularityEntry** out) {
+    int n = 0;
+    while (n < k && n < top_count && entries[top_models[n]].count > 0) {
+        out[n] = &entries[top_models[n]];
+        n++;
+    }
+    return n;
+}
+
+// Function to get a model's id without counting a sale
+int intern_car_model(const char* model_name) {
+    return lookup_model(model_name, 1);
+}
+
+int find_car_model_id(const char* model_name) {
+    return lookup_model(model_name, 0);
+}
+
+int car_model_count() {
+    return entry_count;
+}
+
+CarPopularityEntry* car_popularity_entry(int model_id) {
+    if (model_id < 0 || model_id >= entry_count) return NULL;
+    return &entries[model_id];
+}
+
+// Function to free the popularity table memory
+void free_car_popularity_table() {
+    for (int i = 0; i < entry_count; i++) {
+        store_free(entries[i].model_name);
+    }
+    store_free(entries);
+    store_free(slots);
+    entries = NULL;
+    slots = NULL;
+    entry_count = entry_capacity = 0;
+    slot_capacity = 0;
+    top_count = 0;
+}
+
+void register_car_popularity_state() {
+    store_register_state(&slots, sizeof(slots));
+    store_register_state(&slot_capacity, sizeof(slot_capacity));
+    store_register_state(&entries, sizeof(entries));
+    store_register_state(&entry_count, sizeof(entry_count));
+    store_register_state(&entry_capacity, sizeof(entry_capacity));
+    store_register_state(top_models, sizeof(top_models));
+    store_register_state(&top_count, sizeof(top_count));
+}
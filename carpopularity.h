@@ -0,0 +1,31 @@
+#ifndef CAR_POPULARITY_H
+#define CAR_POPULARITY_H
+
+#include "functionpointer.h"
+
+#define POPULARITY_INITIAL_CAPACITY 128  // Slots in the probe table, always a power of two
+#define POPULARITY_TOP_K 10              // Models kept ranked for "top models" queries
+
+// One car model and how many have been sold. Entries never move, so model_id is stable.
+typedef struct {
+    char* model_name;
+    unsigned int hash;      // Cached hash of model_name
+    int count;
+    int top_rank;           // Position in the top-K list, -1 when not ranked
+} CarPopularityEntry;
+
+// Updates
+void increment_car_popularity(const char* model_name);
+void set_car_popularity(const char* model_name, int count);
+int intern_car_model(const char* model_name);                     // model_id, registering the model if new
+void free_car_popularity_table();
+void register_car_popularity_state();     // See mappedstore.h
+
+// Queries
+char* find_most_popular_car(int* max_count);                      // O(1)
+int top_car_models(int k, CarPopularityEntry** out);              // O(K), returns entries written
+int find_car_model_id(const char* model_name);                    // -1 if never seen
+int car_model_count();
+CarPopularityEntry* car_popularity_entry(int model_id);
+
+#endif
@@ -0,0 +1,263 @@
+#define _GNU_SOURCE             // PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP
+#include <pthread.h>
+#include <errno.h>
+#include <time.h>
+#include "checkpoint.h"
+#include "filehandling.h"
+#include "journal.h"
+#include "archive.h"
+#include "mappedstore.h"
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#endif
+
+// Lock order: state_lock, then checkpoint_lock. Waiting writers go first where the library
+// allows it, so a steady stream of queries does not hold off changes and checkpoints.
+#ifdef PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP
+static pthread_rwlock_t state_lock = PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP;
+#else
+static pthread_rwlock_t state_lock = PTHREAD_RWLOCK_INITIALIZER;
+#endif
+
+void checkpoint_lock_state() {
+    pthread_rwlock_wrlock(&state_lock);
+}
+
+void checkpoint_lock_state_shared() {
+    pthread_rwlock_rdlock(&state_lock);
+}
+
+void checkpoint_unlock_state() {
+    pthread_rwlock_unlock(&state_lock);
+}
+
+#ifdef _WIN32
+
+void checkpoint_start_thread() {}
+void checkpoint_stop_thread() {}
+void checkpoint_wait() {}
+
+#else
+
+static pthread_mutex_t checkpoint_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t checkpoint_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t checkpoint_thread;
+static int thread_started = 0;
+static int stopping = 0;
+static int running = 0;         // A child is saving the snapshot
+static int collected = 0;       // It has exited and its result waits to be taken over
+
+// Result of the last child, valid while `collected` is set
+static int result_ok = 0;
+static uint64_t result_lsn = 0;
+static SegmentName* result_segments = NULL;
+static int result_count = 0;
+
+static int checkpoint_interval() {
+    const char* forced = getenv(CHECKPOINT_INTERVAL_ENV);
+    return forced ? atoi(forced) : CHECKPOINT_INTERVAL_SECONDS;
+}
+
+static int write_all(int fd, const void* data, size_t length) {
+    const char* bytes = (const char*)data;
+    while (length > 0) {
+        ssize_t done = write(fd, bytes, length);
+        if (done < 0 && errno == EINTR) continue;
+        if (done <= 0) return 0;
+        bytes += done;
+        length -= (size_t)done;
+    }
+    return 1;
+}
+
+static int read_all(int fd, void* data, size_t length) {
+    char* bytes = (char*)data;
+    while (length > 0) {
+        ssize_t done = read(fd, bytes, length);
+        if (done < 0 && errno == EINTR) continue;
+        if (done <= 0) return 0;
+        bytes += done;
+        length -= (size_t)done;
+    }
+    return 1;
+}
+
+// In the child: save, send the segments written up the pipe, and leave without running exit
+// handlers or flushing the stdio buffers copied from the parent
+static void run_child(int fd, uint64_t lsn) {
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) dup2(devnull, STDOUT_FILENO);
+
+    int count = 0;
+    int ok;
+    const SegmentName* segments = NULL;
+    if (store_writes_image()) {
+        ok = store_save_image(STORE_IMAGE_FILE, lsn);   // No segments are written
+    } else {
+        ok = save_snapshot(SNAPSHOT_FILE, lsn);
+        if (ok) {
+            remove(STORE_IMAGE_FILE);
+            segments = snapshot_saved_segments(&count);
+        }
+    }
+    ok = ok && write_all(fd, &count, sizeof(count)) &&
+         (count == 0 || write_all(fd, segments, count * sizeof(SegmentName)));
+    _exit(ok ? 0 : 1);
+}
+
+// With the state lock held. Returns the child's pid and the read end of its pipe, 0 if none was started.
+static pid_t start_checkpoint(int* fd) {
+    journal_commit();
+    uint64_t lsn = journal_last_lsn();
+    if (lsn <= journal_checkpoint_lsn()) return 0;     // Nothing the snapshot lacks
+
+    // Old sales move to the archives here, the child only writes the manifest naming them
+    archive_old_sales();
+    // The child saves from memory, and spill files may be gone by the time it gets to them
+    snapshot_load_evicted_changes();
+
+    int fds[2];
+    if (pipe(fds) != 0) return 0;
+    ensure_data_directory();
+    fflush(stdout);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        run_child(fds[1], lsn);
+    }
+    close(fds[1]);
+    if (pid < 0) {
+        close(fds[0]);
+        return 0;
+    }
+
+    // An image leaves the dirty marks alone, they are for the next snapshot
+    if (!store_writes_image()) snapshot_background_started(SNAPSHOT_FILE);
+    pthread_mutex_lock(&checkpoint_lock);
+    running = 1;
+    result_lsn = lsn;
+    pthread_mutex_unlock(&checkpoint_lock);
+    *fd = fds[0];
+    return pid;
+}
+
+// Without any lock: wait for the child and keep its result for whoever holds the state lock next
+static void collect_checkpoint(pid_t pid, int fd) {
+    int count = 0;
+    SegmentName* segments = NULL;
+    int ok = read_all(fd, &count, sizeof(count)) && count >= 0;
+    if (ok && count > 0) {
+        segments = (SegmentName*)malloc(count * sizeof(SegmentName));
+        ok = segments && read_all(fd, segments, count * sizeof(SegmentName));
+    }
+    close(fd);
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+    ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (!ok) {
+        free(segments);
+        segments = NULL;
+        count = 0;
+    }
+
+    pthread_mutex_lock(&checkpoint_lock);
+    result_ok = ok;
+    result_segments = segments;
+    result_count = count;
+    running = 0;
+    collected = 1;
+    pthread_cond_broadcast(&checkpoint_cond);
+    pthread_mutex_unlock(&checkpoint_lock);
+}
+
+// With the state lock held: adopt a finished checkpoint's segments and trim the journal
+static void take_over_result() {
+    pthread_mutex_lock(&checkpoint_lock);
+    int ready = collected;
+    collected = 0;
+    pthread_mutex_unlock(&checkpoint_lock);
+    if (!ready) return;
+
+    if (!store_writes_image()) snapshot_background_finished(result_ok, result_segments, result_count);
+    if (result_ok) {
+        journal_truncate(result_lsn);
+    } else {
+        printf("\nBackground checkpoint failed, the journal keeps every change.\n");
+    }
+    free(result_segments);
+    result_segments = NULL;
+    result_count = 0;
+}
+
+static void* checkpoint_worker(void* arg) {
+    int interval = *(int*)arg;
+    free(arg);
+
+    pthread_mutex_lock(&checkpoint_lock);
+    while (!stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += interval;
+        while (!stopping && pthread_cond_timedwait(&checkpoint_cond, &checkpoint_lock, &deadline) != ETIMEDOUT) {}
+        if (stopping) break;
+        pthread_mutex_unlock(&checkpoint_lock);
+
+        // Between two commands
+        int fd = -1;
+        pthread_rwlock_wrlock(&state_lock);
+        pid_t pid = start_checkpoint(&fd);
+        pthread_rwlock_unlock(&state_lock);
+
+        if (pid > 0) {
+            collect_checkpoint(pid, fd);
+            pthread_rwlock_wrlock(&state_lock);
+            take_over_result();
+            pthread_rwlock_unlock(&state_lock);
+        }
+        pthread_mutex_lock(&checkpoint_lock);
+    }
+    pthread_mutex_unlock(&checkpoint_lock);
+    return NULL;
+}
+
+void checkpoint_start_thread() {
+    int interval = checkpoint_interval();
+    if (interval <= 0 || thread_started) return;
+
+    int* arg = (int*)malloc(sizeof(int));
+    if (!arg) return;
+    *arg = interval;
+    stopping = 0;
+    if (pthread_create(&checkpoint_thread, NULL, checkpoint_worker, arg) != 0) {
+        printf("Background checkpoints are unavailable, data is saved on exit.\n");
+        free(arg);
+        return;
+    }
+    thread_started = 1;
+}
+
+void checkpoint_stop_thread() {
+    if (!thread_started) return;
+
+    pthread_mutex_lock(&checkpoint_lock);
+    stopping = 1;
+    pthread_cond_broadcast(&checkpoint_cond);
+    pthread_mutex_unlock(&checkpoint_lock);
+    pthread_join(checkpoint_thread, NULL);
+    thread_started = 0;
+}
+
+void checkpoint_wait() {
+    pthread_mutex_lock(&checkpoint_lock);
+    while (running) {
+        pthread_cond_wait(&checkpoint_cond, &checkpoint_lock);
+    }
+    pthread_mutex_unlock(&checkpoint_lock);
+    take_over_result();
+}
+
+#endif
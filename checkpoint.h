@@ -0,0 +1,27 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// Background checkpoints. A thread wakes up every CHECKPOINT_INTERVAL_SECONDS and, if the
+// journal holds changes the snapshot does not, forks between two menu commands. The child
+// process saves the snapshot (or the memory image in mapped store mode, see mappedstore.h) from
+// its copy-on-write image of memory (the state at that moment) while the menu keeps running in
+// the parent. When the child is done the parent takes over the segments it wrote and drops the
+// journal records the new snapshot includes.
+// Without fork() (Windows) the snapshot is only saved in the foreground.
+
+#define CHECKPOINT_INTERVAL_SECONDS 300
+#define CHECKPOINT_INTERVAL_ENV "SHOWROOM_CHECKPOINT_SECONDS"     // Overrides the interval, 0 turns it off
+
+void checkpoint_start_thread();
+void checkpoint_stop_thread();      // Waits for a running checkpoint
+
+// Held by the menu while it runs a command, so a checkpoint never sees half a change. Queries
+// that only read what is already in memory may share it (see server.h); anything that changes,
+// loads or evicts state, including checkpoints, holds it alone.
+void checkpoint_lock_state();
+void checkpoint_lock_state_shared();
+void checkpoint_unlock_state();
+
+void checkpoint_wait();             // With the state lock held: let a running checkpoint finish
+
+#endif
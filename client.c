@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "client.h"
+#include "server.h"
+#include "essentialfunction.h"
+#include "functionpointer.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#define CLIENT_MAX_FIELDS 16
+#define CLIENT_LINE_LEN 1024
+
+typedef enum {
+    FIELD_TEXT,             // Anything but the field separator
+    FIELD_INT,              // Whole number
+    FIELD_NUMBER,
+    FIELD_VIN,              // 1 to MAX_VIN_LEN - 1 characters
+    FIELD_CHOICE,           // One of the field's choices
+    FIELD_PAYMENT,          // Cash or Loan: the loan fields are only asked for loans
+    FIELD_CONFIRM           // y sends the request, anything else cancels it; not sent
+} FieldKind;
+
+typedef struct {
+    FieldKind kind;
+    const char* prompt;
+    const char* choices;    // FIELD_CHOICE: the answers taken, space-separated
+    int loan_only;          // Asked for loans only, 0 is sent for cash sales
+} Field;
+
+typedef struct {
+    int choice;             // Menu number
+    const char* command;    // Batch command the answers are sent as (see batch.h)
+    Field fields[CLIENT_MAX_FIELDS];
+} CommandForm;
+
+#define TEXT(question) { .kind = FIELD_TEXT, .prompt = question }
+#define INT(question) { .kind = FIELD_INT, .prompt = question }
+#define NUMBER(question) { .kind = FIELD_NUMBER, .prompt = question }
+#define VIN(question) { .kind = FIELD_VIN, .prompt = question }
+#define CHOICE(question, answers) { .kind = FIELD_CHOICE, .prompt = question, .choices = answers }
+
+// Every menu command and the answers its batch command takes, in field order
+static const CommandForm forms[] = {
+    { 1, "showroom", { INT("Enter Showroom ID: "), TEXT("Enter Showroom Name: "), TEXT("Enter Showroom Location: "),
+                       TEXT("Enter Contact Number: ") } },
+    { .choice = 2, .command = "showrooms" },
+    { 3, "stock", { INT("Enter Showroom ID: "), VIN("Enter Vehicle Identification Number (VIN): "),
+                    TEXT("Enter Car Model Name: "), TEXT("Enter Car Color: "), NUMBER("Enter Car Price (in lakhs): "),
+                    TEXT("Enter Fuel Type (Petrol, Diesel, Electric, etc.): "),
+                    TEXT("Enter Car Type (Sedan, SUV, Hatchback, etc.): ") } },
+    { 4, "recruit", { INT("Enter Showroom ID: "), INT("Enter Sales Person ID: "), TEXT("Enter Sales Person Name: "),
+                      NUMBER("Enter Monthly Target Sales (in lakhs): ") } },
+    { 5, "purchase", { INT("Enter Showroom ID: "), INT("Enter Salesperson ID: "), VIN("Enter Car VIN to purchase: "),
+                       { .kind = FIELD_PAYMENT, .prompt = "Enter Payment Type (Cash/Loan): " },
+                       { .kind = FIELD_NUMBER, .prompt = "Enter Down Payment (in lakhs): ", .loan_only = 1 },
+                       { .kind = FIELD_CHOICE, .prompt = "Enter Loan Period in months (36, 60 or 84): ",
+                         .choices = "36 60 84", .loan_only = 1 },
+                       TEXT("Customer Name: "), TEXT("Mobile Number: "), TEXT("Address: "), TEXT("Registration Number: "),
+                       { .kind = FIELD_CONFIRM, .prompt = "Confirm car purchase (y/n): " } } },
+    { 6, "merge", { INT("Enter first showroom ID: "), INT("Enter second showroom ID: "), INT("Enter new showroom ID: "),
+                    TEXT("Enter new showroom name: "), TEXT("Enter new showroom location: "),
+                    TEXT("Enter new showroom contact: "),
+                    CHOICE("For duplicates, keep existing (e), replace with new (n), or merge data (m)? ", "e n m"),
+                    CHOICE("Delete the original showrooms? (y/n): ", "y n") } },
+    { 7, "inventory", { INT("Enter Showroom ID: ") } },
+    { 8, "incentive", { INT("Enter Showroom ID: ") } },
+    { 9, "predict", { INT("Enter Showroom ID for sales prediction: ") } },
+    { 10, "find", { VIN("Enter the VIN number: ") } },
+    { 11, "sales_range", { NUMBER("Enter minimum sales value (in lakhs): "),
+                           NUMBER("Enter maximum sales value (in lakhs): ") } },
+    { .choice = 12, .command = "popularity" },
+    { 13, "emi", { INT("Enter minimum months (inclusive): "), INT("Enter maximum months (inclusive): ") } },
+    { 14, "customer", { CHOICE("Search by mobile or reg (registration number): ", "mobile reg"),
+                        TEXT("Enter Mobile Number or Registration Number: ") } },
+    { 15, "leaderboard", { INT("Enter Showroom ID: "), INT("How many top sales persons to show: "),
+                           INT("Enter a Sales Person ID to see their rank (0 to skip): ") } },
+    { 16, "recent", { INT("Enter Showroom ID (0 for all showrooms): ") } },
+    { 17, "analytics", { NUMBER("Enter a price threshold (in lakhs): ") } },
+    { .choice = 18, .command = "export" },
+    { .choice = 19, .command = "checkpoint" },
+    { 20, "import", { TEXT("Enter feed file path (on the server): ") } }
+};
+
+static const CommandForm* find_form(int choice) {
+    for (size_t i = 0; i < sizeof(forms) / sizeof(forms[0]); i++) {
+        if (forms[i].choice == choice) return &forms[i];
+    }
+    return NULL;
+}
+
+// One line without its newline; 0 at the end of input
+static int read_answer_line(const char* prompt, char* line) {
+    printf("%s", prompt);
+    fflush(stdout);
+    if (!fgets(line, CLIENT_LINE_LEN, stdin)) return 0;
+    line[strcspn(line, "\r\n")] = 0;
+    return 1;
+}
+
+static int is_choice(const char* answer, const char* choices) {
+    size_t length = strlen(answer);
+    for (const char* choice = choices; *choice; choice += strcspn(choice, " "), choice += *choice == ' ') {
+        if (length > 0 && strncmp(choice, answer, length) == 0 && (choice[length] == ' ' || choice[length] == '\0')) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Why an answer does not fit its field, NULL if it does
+static const char* check_answer(const Field* field, const char* answer) {
+    char* end;
+    if (strchr(answer, '|')) return "Answers cannot contain '|'.";
+    switch (field->kind) {
+        case FIELD_INT:
+            strtol(answer, &end, 10);
+            if (end == answer || *end != '\0') return "Please enter a whole number.";
+            return NULL;
+        case FIELD_NUMBER:
+            strtod(answer, &end);
+            if (end == answer || *end != '\0') return "Please enter a number.";
+            return NULL;
+        case FIELD_VIN:
+            if (answer[0] == '\0' || strlen(answer) >= MAX_VIN_LEN) return "A VIN is 1 to 17 characters.";
+            return NULL;
+        case FIELD_CHOICE:
+            return is_choice(answer, field->choices) ? NULL : "Please enter one of the choices shown.";
+        case FIELD_PAYMENT:
+            return is_choice(answer, "Cash Loan") ? NULL : "Please enter Cash or Loan.";
+        default:
+            return NULL;
+    }
+}
+
+// Ask the form's questions, asking again after an answer that does not fit, and write the
+// command line into request; 1 to send it, 0 if the user cancelled, -1 at the end of input
+static int build_request(const CommandForm* form, char* request, size_t* size) {
+    char line[CLIENT_LINE_LEN];
+    int loan = 0;
+    *size = (size_t)snprintf(request, SERVER_MAX_REQUEST, "%s", form->command);
+
+    for (int i = 0; i < CLIENT_MAX_FIELDS && form->fields[i].prompt; i++) {
+        const Field* field = &form->fields[i];
+        const char* answer = line;
+        if (field->loan_only && !loan) {
+            answer = "0";
+        } else {
+            const char* problem;
+            do {
+                if (!read_answer_line(field->prompt, line)) return -1;
+                problem = check_answer(field, line);
+                if (problem) printf("%s\n", problem);
+            } while (problem);
+        }
+
+        if (field->kind == FIELD_CONFIRM) {
+            if (line[0] != 'y' && line[0] != 'Y') {
+                printf("Cancelled.\n");
+                return 0;
+            }
+            continue;
+        }
+        if (field->kind == FIELD_PAYMENT) loan = parse_payment_type(line) == PAYMENT_LOAN;
+
+        size_t length = strlen(answer);
+        if (*size + length + 1 >= SERVER_MAX_REQUEST) {
+            printf("Answers too long.\n");
+            return 0;
+        }
+        request[(*size)++] = '|';
+        memcpy(request + *size, answer, length);
+        *size += length;
+    }
+    return 1;
+}
+
+int client_run(const char* address) {
+#ifdef _WIN32
+    (void)address;
+    printf("Client mode needs a Unix system.\n");
+    return 1;
+#else
+    int fd = connect_to_server(address);
+    if (fd < 0) {
+        printf("No server listening on %s\n", address);
+        return 1;
+    }
+    printf("Car Showroom Management System (connected to %s)\n", address);
+
+    char* request = (char*)malloc(SERVER_MAX_REQUEST);
+    char line[CLIENT_LINE_LEN];
+    int result = 0;
+    while (request) {
+        print_main_menu();
+        if (!read_answer_line("Enter your choice: ", line)) break;
+        int choice = atoi(line);
+        if (choice == 0 && strcmp(line, "0") == 0) {
+            printf("Exiting...\n");
+            break;
+        }
+        if (choice < 1 || choice > MENU_LAST_CHOICE) {
+            printf("Invalid choice. Please try again.\n");
+            continue;
+        }
+
+        size_t size;
+        int built = build_request(find_form(choice), request, &size);
+        if (built < 0) {
+            printf("\n");
+            break;
+        }
+        if (built == 0) continue;
+
+        char* reply = NULL;
+        uint32_t reply_size = 0;
+        if (!send_frame(fd, request, size, NULL, 0) || !receive_frame(fd, &reply, &reply_size, SERVER_MAX_REPLY) ||
+            reply_size == 0) {
+            free(reply);
+            printf("Lost the connection to the server.\n");
+            result = 1;
+            break;
+        }
+        // Changes print nothing when they succeed, so say how it went
+        unsigned char status = (unsigned char)reply[0];
+        fwrite(reply + 1, 1, reply_size - 1, stdout);
+        if (reply_size == 1) {
+            printf("%s\n", status == SERVER_OK ? "Done." : "Failed.");
+        } else if (status == SERVER_BAD_REQUEST) {
+            printf("The server rejected the request.\n");
+        }
+        fflush(stdout);
+        free(reply);
+    }
+
+    free(request);
+    close(fd);
+    return result;
+#endif
+}
@@ -0,0 +1,12 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+// Thin terminal for server mode (see server.h): shows the menu, asks the chosen command's
+// questions locally, asking again after an answer that does not fit, sends the answers as one
+// batch command line (see batch.h) and prints the server's reply. It holds no data.
+// A feed file to import (20) is opened by the server, so its path is the server's.
+
+// Until 0 or the end of input; 1 if the server cannot be reached or the connection is lost
+int client_run(const char* address);
+
+#endif
@@ -0,0 +1,563 @@
+#include "customerindex.h"
+#include "mappedstore.h"
+
+// Hash indexes on Customer.mobile and Customer.reg_number.
+// Both tables chain the same entries, so they share one bucket count.
+static CustomerIndexEntry** mobile_buckets = NULL;
+static CustomerIndexEntry** reg_buckets = NULL;
+static unsigned int index_size = 0;
+static unsigned int index_count = 0;
+
+// Global loan index ordered by (loan_months, monthly_emi)
+static BPlusTree* emi_index = NULL;
+
+// EMI entries collected while a batch is open
+static EmiIndexEntry* pending_emi = NULL;
+static int pending_count = 0;
+static int pending_capacity = 0;
+static int batch_open = 0;
+
+// EmiIndexEntry related functions
+int compareEmiIndexEntry(const void* a, const void* b) {
+    EmiIndexEntry* entry_a = (EmiIndexEntry*)a;
+    EmiIndexEntry* entry_b = (EmiIndexEntry*)b;
+    
+    if (entry_a->loan_months != entry_b->loan_months) {
+        return entry_a->loan_months - entry_b->loan_months;
+    }
+    if (entry_a->monthly_emi != entry_b->monthly_emi) {
+        return entry_a->monthly_emi < entry_b->monthly_emi ? -1 : 1;
+    }
+    // Range bounds carry no customer; real entries tie-break on VIN, then on the record itself
+    if (entry_a->customer && entry_b->customer) {
+        int cmp = strcmp(entry_a->customer->car_VIN, entry_b->customer->car_VIN);
+        if (cmp != 0) return cmp;
+    }
+    if (entry_a->customer == entry_b->customer) return 0;
+    return entry_a->customer < entry_b->customer ? -1 : 1;
+}
+
+void printEmiIndexEntry(const void* data) {
+    EmiIndexEntry* entry = (EmiIndexEntry*)data;
+    out_printf("Months: %d, EMI: %.2f, VIN: %s", 
+               entry->loan_months, entry->monthly_emi, entry->customer ? entry->customer->car_VIN : "-");
+}
+
+void* cloneEmiIndexEntry(const void* data) {
+    EmiIndexEntry* clone = (EmiIndexEntry*)store_malloc(sizeof(EmiIndexEntry));
+    if (clone) {
+        memcpy(clone, data, sizeof(EmiIndexEntry));
+    }
+    return clone;
+}
+
+void freeEmiIndexEntry(void* data) {
+    store_free(data);
+}
+
+// Hash function for customer keys (multiplicative string hash, masked by the caller)
+static unsigned int hash_customer_key(const char* str) {
+    unsigned int hash = 0;
+    while (*str) {
+        hash = (hash * 31) + (unsigned char)(*str++);
+    }
+    return hash;
+}
+
+// Allocate both bucket arrays on first use
+static int ensure_index_allocated() {
+    if (mobile_buckets) return 1;
+
+    mobile_buckets = (CustomerIndexEntry**)store_calloc(CUSTOMER_INDEX_INITIAL_SIZE, sizeof(CustomerIndexEntry*));
+    reg_buckets = (CustomerIndexEntry**)store_calloc(CUSTOMER_INDEX_INITIAL_SIZE, sizeof(CustomerIndexEntry*));
+    if (!mobile_buckets || !reg_buckets) {
+        out_printf("Memory allocation failed for customer index\n");
+        store_free(mobile_buckets);
+        store_free(reg_buckets);
+        mobile_buckets = reg_buckets = NULL;
+        return 0;
+    }
+    index_size = CUSTOMER_INDEX_INITIAL_SIZE;
+    return 1;
+}
+
+// Double the bucket count and relink every entry using its cached hashes
+static void grow_index() {
+    unsigned int new_size = index_size * 2;
+    CustomerIndexEntry** new_mobile = (CustomerIndexEntry**)store_calloc(new_size, sizeof(CustomerIndexEntry*));
+    CustomerIndexEntry** new_reg = (CustomerIndexEntry**)store_calloc(new_size, sizeof(CustomerIndexEntry*));
+    if (!new_mobile || !new_reg) {
+        // Keep the current tables; lookups stay correct, only chains get longer
+        store_free(new_mobile);
+        store_free(new_reg);
+        return;
+    }
+
+    for (unsigned int i = 0; i < index_size; i++) {
+        CustomerIndexEntry* entry = mobile_buckets[i];
+        while (entry) {
+            CustomerIndexEntry* next = entry->next_by_mobile;
+            unsigned int slot = entry->mobile_hash & (new_size - 1);
+            entry->next_by_mobile = new_mobile[slot];
+            new_mobile[slot] = entry;
+            entry = next;
+        }
+
+        entry = reg_buckets[i];
+        while (entry) {
+            CustomerIndexEntry* next = entry->next_by_reg;
+            unsigned int slot = entry->reg_hash & (new_size - 1);
+            entry->next_by_reg = new_reg[slot];
+            new_reg[slot] = entry;
+            entry = next;
+        }
+    }
+
+    store_free(mobile_buckets);
+    store_free(reg_buckets);
+    mobile_buckets = new_mobile;
+    reg_buckets = new_reg;
+    index_size = new_size;
+}
+
+// Index one customer record under its mobile and registration numbers, and its loan by EMI
+void customer_index_add(Showroom* showroom, SalesPerson* sales_person, Customer* customer, SoldCar* sold_car) {
+    if (!customer || !ensure_index_allocated()) return;
+    
+    if (sold_car && sold_car->payment_type == PAYMENT_LOAN) {
+        if (!emi_index) {
+            emi_index = createBPlusTree(compareEmiIndexEntry, printEmiIndexEntry, cloneEmiIndexEntry, freeEmiIndexEntry);
+        }
+        
+        EmiIndexEntry emi_entry;
+        emi_entry.loan_months = customer->loan_months;
+        emi_entry.monthly_emi = sold_car->monthly_emi;
+        emi_entry.customer = customer;
+        emi_entry.sold_car = sold_car;
+        emi_entry.sales_person = sales_person;
+        emi_entry.showroom = showroom;
+        
+        if (batch_open && pending_count == pending_capacity) {
+            int new_capacity = pending_capacity ? pending_capacity * 2 : 1024;
+            EmiIndexEntry* grown = (EmiIndexEntry*)realloc(pending_emi, new_capacity * sizeof(EmiIndexEntry));
+            if (grown) {
+                pending_emi = grown;
+                pending_capacity = new_capacity;
+            }
+        }
+        if (batch_open && pending_count < pending_capacity) {
+            pending_emi[pending_count++] = emi_entry;
+        } else {
+            bplusInsert(emi_index, &emi_entry);
+        }
+    }
+
+    CustomerIndexEntry* entry = (CustomerIndexEntry*)store_malloc(sizeof(CustomerIndexEntry));
+    if (!entry) {
+        out_printf("Memory allocation failed for customer index entry\n");
+        return;
+    }
+
+    entry->customer = customer;
+    entry->sales_person = sales_person;
+    entry->showroom = showroom;
+    entry->mobile_hash = hash_customer_key(customer->mobile);
+    entry->reg_hash = hash_customer_key(customer->reg_number);
+
+    unsigned int mobile_slot = entry->mobile_hash & (index_size - 1);
+    entry->next_by_mobile = mobile_buckets[mobile_slot];
+    mobile_buckets[mobile_slot] = entry;
+
+    unsigned int reg_slot = entry->reg_hash & (index_size - 1);
+    entry->next_by_reg = reg_buckets[reg_slot];
+    reg_buckets[reg_slot] = entry;
+
+    index_count++;
+    if (index_count > index_size) {
+        grow_index();
+    }
+}
+
+// Index every customer of every salesperson in a showroom
+void customer_index_add_showroom(Showroom* showroom) {
+    if (!showroom || !showroom->sales_persons || !showroom->sales_persons->root) return;
+
+    BTreeNode* sp_node = showroom->sales_persons->root;
+    while (!sp_node->is_leaf) {
+        sp_node = sp_node->children[0];
+    }
+
+    while (sp_node) {
+        for (int i = 0; i < sp_node->num_keys; i++) {
+            SalesPerson* sp = (SalesPerson*)sp_node->keys[i].key;
+            if (!sp->customer_tree || !sp->customer_tree->root) continue;
+
+            BTreeNode* customer_node = sp->customer_tree->root;
+            while (!customer_node->is_leaf) {
+                customer_node = customer_node->children[0];
+            }
+
+            while (customer_node) {
+                for (int k = 0; k < customer_node->num_keys; k++) {
+                    Customer* customer = (Customer*)customer_node->keys[k].key;
+                    
+                    // Join the customer to the showroom's sale record once, here
+                    SoldCar* sold_car = NULL;
+                    if (showroom->sold_cars) {
+                        SoldCar temp_sold_car;
+                        strcpy(temp_sold_car.VIN, customer->car_VIN);
+                        sold_car = (SoldCar*)bplusSearch(showroom->sold_cars, &temp_sold_car);
+                    }
+                    customer_index_add(showroom, sp, customer, sold_car);
+                }
+                customer_node = customer_node->leaf_link.next;
+            }
+        }
+        sp_node = sp_node->leaf_link.next;
+    }
+}
+
+void customer_index_begin_batch(int expected_customers) {
+    batch_open = 1;
+    
+    // Size the hash tables once instead of doubling through the load
+    if (!ensure_index_allocated()) return;
+    while (index_size < index_count + (unsigned int)expected_customers) {
+        unsigned int old_size = index_size;
+        grow_index();
+        if (index_size == old_size) break;
+    }
+}
+
+// Sort key for a pending EMI entry: loan months, then the EMI's bits mapped so that
+// unsigned order matches numeric order
+typedef struct {
+    uint64_t emi_bits;
+    uint32_t loan_months;
+    int index;                      // Position in pending_emi
+} PendingEmiKey;
+
+static uint64_t ordered_double_bits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x8000000000000000ull) ? ~bits : bits | 0x8000000000000000ull;
+}
+
+// qsort adapter for positions in pending_emi
+static int compare_pending_positions(const void* a, const void* b) {
+    return compareEmiIndexEntry(&pending_emi[*(const int*)a], &pending_emi[*(const int*)b]);
+}
+
+// Stable LSD radix sort of the pending entries by (loan_months, monthly_emi), 16 bits per pass,
+// then entries that tie on both are ordered with the full index comparator.
+// Returns the sorted positions, or NULL if memory is short.
+static int* sort_pending_emi() {
+    PendingEmiKey* keys = (PendingEmiKey*)malloc((size_t)pending_count * sizeof(PendingEmiKey));
+    PendingEmiKey* scratch = (PendingEmiKey*)malloc((size_t)pending_count * sizeof(PendingEmiKey));
+    int* order = (int*)malloc((size_t)pending_count * sizeof(int));
+    unsigned int* counts = (unsigned int*)malloc(65536 * sizeof(unsigned int));
+    if (!keys || !scratch || !order || !counts) {
+        free(keys);
+        free(scratch);
+        free(order);
+        free(counts);
+        return NULL;
+    }
+
+    for (int i = 0; i < pending_count; i++) {
+        keys[i].emi_bits = ordered_double_bits(pending_emi[i].monthly_emi);
+        keys[i].loan_months = (uint32_t)pending_emi[i].loan_months;
+        keys[i].index = i;
+    }
+
+    // Four passes over the EMI bits, then one over the loan period (most significant)
+    for (int pass = 0; pass < 5; pass++) {
+        int shift = pass < 4 ? pass * 16 : 0;
+        memset(counts, 0, 65536 * sizeof(unsigned int));
+        for (int i = 0; i < pending_count; i++) {
+            uint64_t field = pass < 4 ? keys[i].emi_bits : keys[i].loan_months;
+            counts[(field >> shift) & 0xFFFF]++;
+        }
+        unsigned int total = 0;
+        for (int d = 0; d < 65536; d++) {
+            unsigned int c = counts[d];
+            counts[d] = total;
+            total += c;
+        }
+        for (int i = 0; i < pending_count; i++) {
+            uint64_t field = pass < 4 ? keys[i].emi_bits : keys[i].loan_months;
+            scratch[counts[(field >> shift) & 0xFFFF]++] = keys[i];
+        }
+        PendingEmiKey* swap = keys;
+        keys = scratch;
+        scratch = swap;
+    }
+
+    for (int i = 0; i < pending_count; i++) {
+        order[i] = keys[i].index;
+    }
+
+    // Order each run of equal (months, EMI) keys by the remaining tie-breaks
+    for (int start = 0; start < pending_count; ) {
+        int end = start + 1;
+        while (end < pending_count && keys[end].emi_bits == keys[start].emi_bits &&
+               keys[end].loan_months == keys[start].loan_months) {
+            end++;
+        }
+        if (end - start > 1) {
+            qsort(order + start, end - start, sizeof(int), compare_pending_positions);
+        }
+        start = end;
+    }
+
+    free(keys);
+    free(scratch);
+    free(counts);
+    return order;
+}
+
+void customer_index_end_batch() {
+    batch_open = 0;
+    if (pending_count <= 0) return;
+    
+    // An empty index is built bottom-up; otherwise fall back to ordinary inserts
+    int* order = emi_index->root ? NULL : sort_pending_emi();
+    void** records = order ? (void**)malloc((size_t)pending_count * sizeof(void*)) : NULL;
+    int built = 0;
+    if (records) {
+        int made = 0;
+        while (made < pending_count && (records[made] = cloneEmiIndexEntry(&pending_emi[order[made]]))) {
+            made++;
+        }
+        built = made == pending_count && bplusBulkLoad(emi_index, records, pending_count);
+        if (!built) {
+            for (int i = 0; i < made; i++) freeEmiIndexEntry(records[i]);
+        }
+        free(records);
+    }
+    free(order);
+    if (!built) {
+        for (int i = 0; i < pending_count; i++) {
+            bplusInsert(emi_index, &pending_emi[i]);
+        }
+    }
+    
+    free(pending_emi);
+    pending_emi = NULL;
+    pending_count = 0;
+    pending_capacity = 0;
+}
+
+static BTreeNode* emi_first_leaf() {
+    if (!emi_index || !emi_index->root) return NULL;
+    BTreeNode* node = emi_index->root;
+    while (!node->is_leaf) {
+        node = node->children[0];
+    }
+    return node;
+}
+
+static EmiIndexEntry* find_emi_entry_of(Showroom* showroom) {
+    for (BTreeNode* node = emi_first_leaf(); node; node = node->leaf_link.next) {
+        for (int i = 0; i < node->num_keys; i++) {
+            EmiIndexEntry* entry = (EmiIndexEntry*)node->keys[i].key;
+            if (entry->showroom == showroom) return entry;
+        }
+    }
+    return NULL;
+}
+
+// Replace the EMI index with a bottom-up copy of the `count` entries not in the showroom.
+// Returns 0 (leaving the index as it is) without memory.
+static int rebuild_emi_index_without(Showroom* showroom, int count) {
+    void** kept = (void**)malloc((count ? count : 1) * sizeof(void*));
+    BPlusTree* rebuilt = createBPlusTree(compareEmiIndexEntry, printEmiIndexEntry, cloneEmiIndexEntry, freeEmiIndexEntry);
+    int made = 0;
+    int ok = kept && rebuilt;
+    
+    // The leaves are in key order already
+    for (BTreeNode* node = ok ? emi_first_leaf() : NULL; node && ok; node = node->leaf_link.next) {
+        for (int i = 0; i < node->num_keys && ok; i++) {
+            EmiIndexEntry* entry = (EmiIndexEntry*)node->keys[i].key;
+            if (entry->showroom == showroom) continue;
+            kept[made] = cloneEmiIndexEntry(entry);
+            ok = kept[made] != NULL;
+            made += ok;
+        }
+    }
+    ok = ok && bplusBulkLoad(rebuilt, kept, made);
+    
+    if (ok) {
+        freeBPlusTree(emi_index);
+        emi_index = rebuilt;
+    } else {
+        for (int i = 0; i < made; i++) freeEmiIndexEntry(kept[i]);
+        if (rebuilt) freeBPlusTree(rebuilt);
+    }
+    free(kept);
+    return ok;
+}
+
+// Drop every entry that points into a showroom that is about to be freed
+void customer_index_remove_showroom(Showroom* showroom) {
+    if (emi_index && emi_index->root) {
+        // The index is rebuilt from the other showrooms' loans rather than deleted from: deletes
+        // leave copies of removed entries behind as separators, and the customers of those are
+        // about to be freed while comparisons still read their VINs
+        int total = 0;
+        int removed = 0;
+        for (BTreeNode* node = emi_first_leaf(); node; node = node->leaf_link.next) {
+            total += node->num_keys;
+            for (int i = 0; i < node->num_keys; i++) {
+                removed += ((EmiIndexEntry*)node->keys[i].key)->showroom == showroom;
+            }
+        }
+        
+        if (removed > 0 && !rebuild_emi_index_without(showroom, total - removed)) {
+            // Without memory for that, delete one at a time, looking the next one up afresh
+            EmiIndexEntry* entry;
+            while ((entry = find_emi_entry_of(showroom))) {
+                EmiIndexEntry doomed = *entry;
+                bplusDelete(emi_index, &doomed);
+            }
+        }
+    }
+    
+    if (!mobile_buckets) return;
+
+    // Unlink from the registration table first, the mobile pass frees the entries
+    for (unsigned int i = 0; i < index_size; i++) {
+        CustomerIndexEntry** link = &reg_buckets[i];
+        while (*link) {
+            if ((*link)->showroom == showroom) {
+                *link = (*link)->next_by_reg;
+            } else {
+                link = &(*link)->next_by_reg;
+            }
+        }
+    }
+
+    for (unsigned int i = 0; i < index_size; i++) {
+        CustomerIndexEntry** link = &mobile_buckets[i];
+        while (*link) {
+            if ((*link)->showroom == showroom) {
+                CustomerIndexEntry* removed = *link;
+                *link = removed->next_by_mobile;
+                store_free(removed);
+                index_count--;
+            } else {
+                link = &(*link)->next_by_mobile;
+            }
+        }
+    }
+}
+
+// Function to free the customer index memory
+void free_customer_index() {
+    if (emi_index) {
+        freeBPlusTree(emi_index);
+        emi_index = NULL;
+    }
+    
+    if (!mobile_buckets) return;
+
+    for (unsigned int i = 0; i < index_size; i++) {
+        CustomerIndexEntry* entry = mobile_buckets[i];
+        while (entry) {
+            CustomerIndexEntry* next = entry->next_by_mobile;
+            store_free(entry);
+            entry = next;
+        }
+    }
+
+    store_free(mobile_buckets);
+    store_free(reg_buckets);
+    mobile_buckets = reg_buckets = NULL;
+    index_size = 0;
+    index_count = 0;
+}
+
+// The open batch is transient, only the tables and the EMI index are kept
+void register_customer_index_state() {
+    store_register_state(&mobile_buckets, sizeof(mobile_buckets));
+    store_register_state(&reg_buckets, sizeof(reg_buckets));
+    store_register_state(&index_size, sizeof(index_size));
+    store_register_state(&index_count, sizeof(index_count));
+    store_register_tree(&emi_index);
+}
+
+// Matches in (showroom, salesperson, VIN) order, whatever order the showrooms were indexed in
+static int compare_entries_by_owner(const void* a, const void* b) {
+    const CustomerIndexEntry* entry_a = *(const CustomerIndexEntry* const*)a;
+    const CustomerIndexEntry* entry_b = *(const CustomerIndexEntry* const*)b;
+    if (entry_a->showroom->id != entry_b->showroom->id) {
+        return entry_a->showroom->id < entry_b->showroom->id ? -1 : 1;
+    }
+    if (entry_a->sales_person->id != entry_b->sales_person->id) {
+        return entry_a->sales_person->id < entry_b->sales_person->id ? -1 : 1;
+    }
+    return strcmp(entry_a->customer->car_VIN, entry_b->customer->car_VIN);
+}
+
+// Visit the entries of a chain that match, sorted; in chain order if memory is short
+static int visit_matches(CustomerIndexEntry* chain, int by_mobile, unsigned int hash, const char* key,
+                         ProcessCustomerFunc process, void* user_data) {
+    int matches = 0;
+    for (CustomerIndexEntry* entry = chain; entry; entry = by_mobile ? entry->next_by_mobile : entry->next_by_reg) {
+        unsigned int entry_hash = by_mobile ? entry->mobile_hash : entry->reg_hash;
+        const char* entry_key = by_mobile ? entry->customer->mobile : entry->customer->reg_number;
+        matches += entry_hash == hash && strcmp(entry_key, key) == 0;
+    }
+    if (!process || matches == 0) return matches;
+
+    CustomerIndexEntry** sorted = (CustomerIndexEntry**)malloc(matches * sizeof(CustomerIndexEntry*));
+    int n = 0;
+    for (CustomerIndexEntry* entry = chain; entry; entry = by_mobile ? entry->next_by_mobile : entry->next_by_reg) {
+        unsigned int entry_hash = by_mobile ? entry->mobile_hash : entry->reg_hash;
+        const char* entry_key = by_mobile ? entry->customer->mobile : entry->customer->reg_number;
+        if (entry_hash != hash || strcmp(entry_key, key) != 0) continue;
+        if (sorted) {
+            sorted[n++] = entry;
+        } else {
+            process(entry, user_data);
+        }
+    }
+    if (sorted) {
+        qsort(sorted, n, sizeof(CustomerIndexEntry*), compare_entries_by_owner);
+        for (int i = 0; i < n; i++) {
+            process(sorted[i], user_data);
+        }
+        free(sorted);
+    }
+    return matches;
+}
+
+// Visit every customer registered with this mobile number
+int customer_index_find_by_mobile(const char* mobile, ProcessCustomerFunc process, void* user_data) {
+    if (!mobile_buckets) return 0;
+
+    unsigned int hash = hash_customer_key(mobile);
+    return visit_matches(mobile_buckets[hash & (index_size - 1)], 1, hash, mobile, process, user_data);
+}
+
+// Visit every customer holding this registration number
+int customer_index_find_by_reg(const char* reg_number, ProcessCustomerFunc process, void* user_data) {
+    if (!reg_buckets) return 0;
+
+    unsigned int hash = hash_customer_key(reg_number);
+    return visit_matches(reg_buckets[hash & (index_size - 1)], 0, hash, reg_number, process, user_data);
+}
+
+// Visit every loan whose tenure falls in [min_months, max_months] with one range scan
+void emi_index_range_search(int min_months, int max_months, ProcessKeyFunc process, void* user_data) {
+    if (!emi_index) return;
+    
+    EmiIndexEntry lower = {0};
+    EmiIndexEntry upper = {0};
+    lower.loan_months = min_months;
+    lower.monthly_emi = -HUGE_VAL;
+    upper.loan_months = max_months;
+    upper.monthly_emi = HUGE_VAL;
+    
+    bplusRangeSearch(emi_index, &lower, &upper, process, user_data);
+}
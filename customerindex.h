@@ -0,0 +1,57 @@
+#ifndef CUSTOMER_INDEX_H
+#define CUSTOMER_INDEX_H
+
+#include "functionpointer.h"
+
+#define CUSTOMER_INDEX_INITIAL_SIZE 1024  // Starting bucket count, doubles as the index grows
+
+// One indexed customer with the salesperson and showroom that own the record
+typedef struct CustomerIndexEntry {
+    Customer* customer;
+    SalesPerson* sales_person;
+    Showroom* showroom;
+
+    // Cached hashes so the tables can grow without rehashing the strings
+    unsigned int mobile_hash;
+    unsigned int reg_hash;
+
+    struct CustomerIndexEntry* next_by_mobile;  // Chain in the mobile number table
+    struct CustomerIndexEntry* next_by_reg;     // Chain in the registration number table
+} CustomerIndexEntry;
+
+// One loan in the global EMI index, joined to its customer and sold car
+typedef struct {
+    int loan_months;
+    double monthly_emi;
+    Customer* customer;
+    SoldCar* sold_car;
+    SalesPerson* sales_person;
+    Showroom* showroom;
+} EmiIndexEntry;
+
+// EMI index callbacks
+int compareEmiIndexEntry(const void* a, const void* b);
+void printEmiIndexEntry(const void* data);
+void* cloneEmiIndexEntry(const void* data);
+void freeEmiIndexEntry(void* data);
+
+// Callback for every customer matching a lookup
+typedef void (*ProcessCustomerFunc)(CustomerIndexEntry* entry, void* user_data);
+
+// Maintenance (sold_car may be NULL when the sale record is missing)
+void customer_index_add(Showroom* showroom, SalesPerson* sales_person, Customer* customer, SoldCar* sold_car);
+void customer_index_add_showroom(Showroom* showroom);
+void customer_index_remove_showroom(Showroom* showroom);
+void customer_index_begin_batch(int expected_customers);   // Hold EMI entries back during bulk loads...
+void customer_index_end_batch();        // ...then sort them and build the EMI index in one pass
+void free_customer_index();
+void register_customer_index_state();     // See mappedstore.h
+
+// Lookups, returning the number of matches; visited in showroom, salesperson, then VIN order
+int customer_index_find_by_mobile(const char* mobile, ProcessCustomerFunc process, void* user_data);
+int customer_index_find_by_reg(const char* reg_number, ProcessCustomerFunc process, void* user_data);
+
+// Visit every loan with min_months <= loan_months <= max_months, ordered by tenure then EMI
+void emi_index_range_search(int min_months, int max_months, ProcessKeyFunc process, void* user_data);
+
+#endif
@@ -1,455 +1,751 @@
-#include "functionpointer.h"
-#include "essentialfunction.h"
-
-// Global variables
-BPlusTree* showroom_tree = NULL;
-
-
-
-// Helper functions for loan calculation
-double calculate_interest_rate(int months) {
-    if (months <= 36) {
-        return 8.50;
-    } else if (months <= 60) {
-        return 8.75;
-    } else {
-        return 9.00;  // For 84 months
-    }
-}
-
-double calculate_emi(double loan_amount, double interest_rate, int months) {
-    double monthly_rate = interest_rate / (12 * 100);
-    double emi = loan_amount * monthly_rate * pow(1 + monthly_rate, months) / (pow(1 + monthly_rate, months) - 1);
-    return emi;
-}
-
-// Initialize the showroom management system
-void init_system() {
-    showroom_tree = createBPlusTree(compareShowroomID, printShowroom, cloneShowroom, freeShowroom);
-}
-
-// Function to add a new showroom to the system
-void add_showroom() {
-    int id;
-    char name[MAX_STR_LEN];
-    char location[MAX_STR_LEN];
-    char contact[MAX_MOBILE_LEN];
-    
-    printf("\n=== Add New Showroom ===\n");
-    
-    printf("Enter Showroom ID: ");
-    scanf("%d", &id);
-    getchar(); // Clear input buffer
-    
-    printf("Enter Showroom Name: ");
-    fgets(name, MAX_STR_LEN, stdin);
-    name[strcspn(name, "\n")] = 0; // Remove newline character
-    
-    printf("Enter Showroom Location: ");
-    fgets(location, MAX_STR_LEN, stdin);
-    location[strcspn(location, "\n")] = 0; // Remove newline character
-    
-    printf("Enter Contact Number: ");
-    fgets(contact, MAX_MOBILE_LEN, stdin);
-    contact[strcspn(contact, "\n")] = 0; // Remove newline character
-    
-    // Create a new showroom
-    Showroom* showroom = (Showroom*)malloc(sizeof(Showroom));
-    if (!showroom) {
-        printf("Memory allocation failed for showroom\n");
-        return;
-    }
-    
-    showroom->id = id;
-    strcpy(showroom->name, name);
-    strcpy(showroom->location, location);
-    strcpy(showroom->contact, contact);
-    showroom->total_available_cars = 0;
-    showroom->total_sold_cars = 0;
-    
-    // Initialize the B+ trees for the showroom
-    showroom->available_cars = createBPlusTree(compareVIN, printCar, cloneCar, freeCar);
-    showroom->sold_cars = createBPlusTree(compareVIN, printCar, cloneCar, freeCar);
-    showroom->sales_persons = createBPlusTree(compareSalesPersonID, printSalesPerson, cloneSalesPerson, freeSalesPerson);
-    
-    // Add the showroom to the global tree
-    if (!showroom_tree) {
-        init_system();
-    }
-    
-    // Check if showroom with same ID already exists
-    Showroom* existing = (Showroom*)bplusSearch(showroom_tree, showroom);
-    if (existing) {
-        printf("A showroom with ID %d already exists.\n", id);
-        freeShowroom(showroom);  // Free the memory as we won't use this showroom
-        return;
-    }
-    
-    // Insert the showroom into the B+ tree
-    bplusInsert(showroom_tree, showroom);
-    
-    printf("Showroom '%s' added successfully with ID %d.\n", name, id);
-    freeShowroom(showroom);  // Free memory as B+ tree has cloned the data
-}
-
-// Function to add a new car to a showroom's available cars
-void add_new_stock() {
-    int showroom_id;
-    Car car;
-    
-    printf("\n=== Add New Car Stock ===\n");
-    
-    // Get showroom ID
-    printf("Enter Showroom ID: ");
-    scanf("%d", &showroom_id);
-    getchar(); // Clear input buffer
-    
-    // Create a temporary showroom object to search the tree
-    Showroom temp;
-    temp.id = showroom_id;
-    
-    // Search for the showroom
-    Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp);
-    if (!showroom) {
-        printf("Showroom with ID %d not found.\n", showroom_id);
-        return;
-    }
-    
-    // Get car details
-    printf("Enter Vehicle Identification Number (VIN): ");
-    fgets(car.VIN, MAX_VIN_LEN, stdin);
-    car.VIN[strcspn(car.VIN, "\n")] = 0; // Remove newline
-    
-    // Check if car with this VIN already exists
-    Car* existing_car = (Car*)bplusSearch(showroom->available_cars, &car);
-    if (existing_car) {
-        printf("Car with VIN %s already exists in this showroom.\n", car.VIN);
-        return;
-    }
-    
-    printf("Enter Car Model Name: ");
-    fgets(car.name, MAX_STR_LEN, stdin);
-    car.name[strcspn(car.name, "\n")] = 0;
-    
-    printf("Enter Car Color: ");
-    fgets(car.color, MAX_STR_LEN, stdin);
-    car.color[strcspn(car.color, "\n")] = 0;
-    
-    printf("Enter Car Price (in lakhs): ");
-    scanf("%lf", &car.price);
-    getchar(); // Clear input buffer
-    
-    printf("Enter Fuel Type (Petrol, Diesel, Electric, etc.): ");
-    fgets(car.fuel_type, MAX_STR_LEN, stdin);
-    car.fuel_type[strcspn(car.fuel_type, "\n")] = 0;
-    
-    printf("Enter Car Type (Sedan, SUV, Hatchback, etc.): ");
-    fgets(car.car_type, MAX_STR_LEN, stdin);
-    car.car_type[strcspn(car.car_type, "\n")] = 0;
-    
-    // Add the car to the showroom's available cars
-    bplusInsert(showroom->available_cars, &car);
-    showroom->total_available_cars++;
-    
-    printf("Car with VIN %s added successfully to showroom %d.\n", car.VIN, showroom_id);
-    
-    // Display the added car
-    printf("\nCar Details:\n");
-    printf("VIN: %s\n", car.VIN);
-    printf("Model: %s\n", car.name);
-    printf("Color: %s\n", car.color);
-    printf("Price: %.2f lakhs\n", car.price);
-    printf("Fuel Type: %s\n", car.fuel_type);
-    printf("Car Type: %s\n", car.car_type);
-}
-
-// Function to recruit a salesperson for a specific showroom
-void recruit_salesperson() {
-    int showroom_id;
-    SalesPerson sales_person;
-    
-    printf("\n=== Recruit New Sales Person ===\n");
-    
-    // Get showroom ID
-    printf("Enter Showroom ID: ");
-    scanf("%d", &showroom_id);
-    getchar(); // Clear input buffer
-    
-    // Create a temporary showroom object to search the tree
-    Showroom temp;
-    temp.id = showroom_id;
-    
-    // Search for the showroom
-    Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp);
-    if (!showroom) {
-        printf("Showroom with ID %d not found.\n", showroom_id);
-        return;
-    }
-    
-    // Get salesperson details
-    printf("Enter Sales Person ID: ");
-    scanf("%d", &sales_person.id);
-    getchar(); // Clear input buffer
-    
-    // Check if salesperson with this ID already exists
-    SalesPerson* existing_sp = (SalesPerson*)bplusSearch(showroom->sales_persons, &sales_person);
-    if (existing_sp) {
-        printf("Sales Person with ID %d already exists in this showroom.\n", sales_person.id);
-        return;
-    }
-    
-    printf("Enter Sales Person Name: ");
-    fgets(sales_person.name, MAX_STR_LEN, stdin);
-    sales_person.name[strcspn(sales_person.name, "\n")] = 0;
-    
-    printf("Enter Monthly Target Sales (in lakhs): ");
-    scanf("%lf", &sales_person.target_sales);
-    getchar(); // Clear input buffer
-    
-    // Initialize other fields
-    sales_person.achieved_sales = 0.0;
-    sales_person.commission = 0.0;
-    
-    // Initialize B+ trees for the sales person
-    sales_person.customer_tree = createBPlusTree(compareCustomerByEMI, printCustomer, cloneCustomer, freeCustomer);
-    sales_person.sold_car_tree = createBPlusTree(compareVIN, printSoldCar, cloneSoldCar, freeSoldCar);
-    
-    // Add the salesperson to the showroom
-    bplusInsert(showroom->sales_persons, &sales_person);
-    
-    printf("Sales Person '%s' with ID %d recruited successfully for showroom %d.\n", 
-           sales_person.name, sales_person.id, showroom_id);
-    
-    // Display the added salesperson
-    printf("\nSales Person Details:\n");
-    printf("ID: %d\n", sales_person.id);
-    printf("Name: %s\n", sales_person.name);
-    printf("Target Sales: %.2f lakhs\n", sales_person.target_sales);
-    printf("Achieved Sales: %.2f lakhs\n", sales_person.achieved_sales);
-    printf("Commission: %.2f lakhs\n", sales_person.commission);
-    
-    // Free the trees as they've been cloned during insertion
-    freeBPlusTree(sales_person.customer_tree);
-    freeBPlusTree(sales_person.sold_car_tree);
-}
-
-// Function to handle car purchase by a customer
-void car_purchase() {
-    int showroom_id, salesperson_id;
-    char car_vin[MAX_VIN_LEN];
-    char payment_type[MAX_STR_LEN];
-    
-    printf("\n=== Car Purchase ===\n");
-    
-    // Get showroom ID
-    printf("Enter Showroom ID: ");
-    scanf("%d", &showroom_id);
-    getchar(); // Clear input buffer
-    
-    // Create a temporary showroom object to search the tree
-    Showroom temp_showroom;
-    temp_showroom.id = showroom_id;
-    
-    // Search for the showroom
-    Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp_showroom);
-    if (!showroom) {
-        printf("Showroom with ID %d not found.\n", showroom_id);
-        return;
-    }
-    
-    // Get salesperson ID
-    printf("Enter Salesperson ID: ");
-    scanf("%d", &salesperson_id);
-    getchar(); // Clear input buffer
-    
-    // Create a temporary salesperson object to search in the showroom's salesperson tree
-    SalesPerson temp_salesperson;
-    temp_salesperson.id = salesperson_id;
-    
-    // Search for the salesperson in the showroom
-    SalesPerson* salesperson = (SalesPerson*)bplusSearch(showroom->sales_persons, &temp_salesperson);
-    if (!salesperson) {
-        printf("Salesperson with ID %d not found in this showroom.\n", salesperson_id);
-        return;
-    }
-    
-    // Get car VIN
-    printf("Enter Car VIN to purchase: ");
-    fgets(car_vin, MAX_VIN_LEN, stdin);
-    car_vin[strcspn(car_vin, "\n")] = 0; // Remove newline
-    
-    // Create a temporary car object to search
-    Car temp_car;
-    strcpy(temp_car.VIN, car_vin);
-    
-    // Search for the car in the showroom's available cars
-    Car* car = (Car*)bplusSearch(showroom->available_cars, &temp_car);
-    if (!car) {
-        printf("Car with VIN %s not found in this showroom's available cars.\n", car_vin);
-        return;
-    }
-    
-    // Display car details for confirmation
-    printf("\nCar Details:\n");
-    printf("VIN: %s\n", car->VIN);
-    printf("Model: %s\n", car->name);
-    printf("Color: %s\n", car->color);
-    printf("Price: %.2f lakhs\n", car->price);
-    printf("Fuel Type: %s\n", car->fuel_type);
-    printf("Car Type: %s\n", car->car_type);
-    
-    // Get payment details
-    printf("\nEnter Payment Type (Cash/Loan): ");
-    fgets(payment_type, MAX_STR_LEN, stdin);
-    payment_type[strcspn(payment_type, "\n")] = 0; // Remove newline
-    
-    // Create a sold car record
-    SoldCar sold_car;
-    strcpy(sold_car.VIN, car_vin);
-    strcpy(sold_car.payment_type, payment_type);
-
-    
-    // If payment is through loan, get loan details
-    if (strcmp(payment_type, "Loan") == 0) {
-        double min_down_payment = car->price * (MIN_DOWN_PAYMENT_PERCENT / 100.0);
-        printf("Minimum down payment required (%.2f%%): %.2f lakhs\n", 
-               MIN_DOWN_PAYMENT_PERCENT, min_down_payment);
-        
-        do {
-            printf("Enter Down Payment (in lakhs): ");
-            scanf("%lf", &sold_car.down_payment);
-            getchar(); // Clear input buffer
-            
-            
-            if (sold_car.down_payment < min_down_payment) {
-                printf("Down payment must be at least %.2f lakhs (%.2f%% of car price).\n",
-                       min_down_payment, MIN_DOWN_PAYMENT_PERCENT);
-            }
-        } while (sold_car.down_payment < min_down_payment);
-        
-        int valid_loan_periods[3] = {36, 60, 84}; // 3, 5, or 7 years
-        int period_choice;
-        
-        printf("Select Loan Period:\n");
-        printf("1. 36 months (3 years) - Interest Rate: 8.50%%\n");
-        printf("2. 60 months (5 years) - Interest Rate: 8.75%%\n");
-        printf("3. 84 months (7 years) - Interest Rate: 9.00%%\n");
-        printf("Enter choice (1-3): ");
-        scanf("%d", &period_choice);
-        getchar(); // Clear input buffer
-        
-        if (period_choice < 1 || period_choice > 3) {
-            period_choice = 1; // Default to 36 months if invalid choice
-            printf("Invalid choice. Defaulting to 36 months.\n");
-        }
-        
-        // Set loan period based on user choice
-        sold_car.loan_period_months = valid_loan_periods[period_choice - 1];
-        
-        // Calculate loan amount (car price - down payment)
-        sold_car.loan_amount = car->price - sold_car.down_payment;
-        
-        // Calculate interest rate based on loan period
-        sold_car.interest_rate = calculate_interest_rate(sold_car.loan_period_months);
-        
-        // Calculate EMI
-        sold_car.monthly_emi = calculate_emi(sold_car.loan_amount, sold_car.interest_rate, sold_car.loan_period_months);
-        
-        printf("\nLoan Details:\n");
-        printf("Loan Amount: %.2f lakhs\n", sold_car.loan_amount);
-        printf("Interest Rate: %.2f%%\n", sold_car.interest_rate);
-        printf("Loan Period: %d months\n", sold_car.loan_period_months);
-        printf("Monthly EMI: %.2f\n", sold_car.monthly_emi);
-    } else {
-        // For cash payment, set loan-related fields to 0
-        sold_car.down_payment = car->price; // Full amount is paid
-        sold_car.loan_amount = 0;
-        sold_car.loan_period_months = 0;
-        sold_car.interest_rate = 0;
-        sold_car.monthly_emi = 0;
-    }
-    
-    // Now get customer details
-    Customer customer;
-    strcpy(customer.car_VIN, car_vin);
-    customer.actual_aoumnt_paid=car->price;
-    customer.loan_months=sold_car.loan_period_months;
-    
-    printf("\nEnter Customer Details:\n");
-    printf("Name: ");
-    fgets(customer.name, MAX_STR_LEN, stdin);
-    customer.name[strcspn(customer.name, "\n")] = 0; // Remove newline
-    
-    printf("Mobile Number: ");
-    fgets(customer.mobile, MAX_MOBILE_LEN, stdin);
-    customer.mobile[strcspn(customer.mobile, "\n")] = 0; // Remove newline
-    
-    printf("Address: ");
-    fgets(customer.address, MAX_STR_LEN, stdin);
-    customer.address[strcspn(customer.address, "\n")] = 0; // Remove newline
-    
-    printf("Registration Number: ");
-    fgets(customer.reg_number, MAX_REG_NUM_LEN, stdin);
-    customer.reg_number[strcspn(customer.reg_number, "\n")] = 0; // Remove newline
-
-    // Add current date information
-    time_t t = time(NULL);
-    struct tm* current_time = localtime(&t);
-    customer.purchase_day = current_time->tm_mday;
-    customer.purchase_month = current_time->tm_mon + 1; // tm_mon is 0-11
-    customer.purchase_year = current_time->tm_year + 1900;
-
-    
-    // Confirm purchase
-    char confirm;
-    printf("\nConfirm car purchase (y/n): ");
-    scanf("%c", &confirm);
-    getchar(); // Clear input buffer
-    
-    if (confirm != 'y' && confirm != 'Y') {
-        printf("Purchase cancelled.\n");
-        return;
-    }
-    
-    // Add sold car to salesperson's sold_car_tree
-    bplusInsert(salesperson->sold_car_tree, &sold_car);
-
-    //Add sold car to showroom data 
-    bplusInsert(showroom->sold_cars,&sold_car);
-    
-    // Add customer to salesperson's customer_tree
-    bplusInsert(salesperson->customer_tree, &customer);
-    
-    // Update car popularity hashtable with the sold car's model
-    increment_car_popularity(car->name);
-    
-    // Update salesperson's achieved sales
-    salesperson->achieved_sales += car->price;
-    
-    // Calculate commission (assuming 2% of car price)
-    double commission = car->price * 0.02;
-    salesperson->commission += commission;
-    
-    // Remove car from available cars
-    bplusDelete(showroom->available_cars, &temp_car);
-    
-    // Update showroom statistics
-    showroom->total_available_cars--;
-    showroom->total_sold_cars++;
-    
-    printf("\nCar purchase successful!\n");
-    printf("Car: %s %s\n", car->name, car->color);
-    printf("Customer: %s\n", customer.name);
-    printf("Salesperson: %s (ID: %d)\n", salesperson->name, salesperson->id);
-    printf("Total Price: %.2f lakhs\n", car->price);
-    printf("Payment Method: %s\n", payment_type);
-    
-    if (strcmp(payment_type, "Loan") == 0) {
-        printf("Down Payment: %.2f lakhs\n", sold_car.down_payment);
-        printf("Loan Amount: %.2f lakhs\n", sold_car.loan_amount);
-        printf("Monthly EMI: %.2f for %d months\n", sold_car.monthly_emi, sold_car.loan_period_months);
-    }
-    
-    printf("Registration Number: %s\n", customer.reg_number);
-    printf("Salesperson Commission: %.2f lakhs\n", commission);
-}
\ No newline at end of file
+#include "functionpointer.h"
+#include "essentialfunction.h"
+#include "journal.h"
+#include "snapshot.h"
+
+// Global variables
+BPlusTree* showroom_tree = NULL;
+
+
+
+// Read a VIN typed on its own line; 0 (after saying why) if it is empty or too long to store
+static int read_vin(char* vin) {
+    char line[VIN_INPUT_LEN];
+    if (!fgets(line, sizeof(line), stdin)) return 0;
+    size_t length = strcspn(line, "\n");
+    if (line[length] != '\n' && !feof(stdin)) {
+        // Longer than the line buffer: drop the rest so the next prompt starts on the next line
+        int c;
+        while ((c = getchar()) != '\n' && c != EOF) {}
+        length = sizeof(line);
+    }
+    if (length == 0 || length >= MAX_VIN_LEN) {
+        out_printf("A VIN is 1 to %d characters.\n", MAX_VIN_LEN - 1);
+        return 0;
+    }
+    memcpy(vin, line, length);
+    vin[length] = '\0';
+    return 1;
+}
+
+// Helper functions for loan calculation
+double calculate_interest_rate(int months) {
+    if (months <= 36) {
+        return 8.50;
+    } else if (months <= 60) {
+        return 8.75;
+    } else {
+        return 9.00;  // For 84 months
+    }
+}
+
+double calculate_emi(double loan_amount, double interest_rate, int months) {
+    double monthly_rate = interest_rate / (12 * 100);
+    double emi = loan_amount * monthly_rate * pow(1 + monthly_rate, months) / (pow(1 + monthly_rate, months) - 1);
+    return emi;
+}
+
+// Add one sale (date as days since epoch) to the showroom's per-month sales ledger
+void record_monthly_sale(Showroom* showroom, int purchase_date, double value) {
+    if (!showroom || !showroom->monthly_sales) return;
+    
+    int day;
+    MonthlySales key = {0};
+    days_to_date(purchase_date, &day, &key.month, &key.year);
+    
+    // Update the month in place if it already has a bucket
+    MonthlySales* bucket = (MonthlySales*)bplusSearch(showroom->monthly_sales, &key);
+    if (bucket) {
+        bucket->sales_count++;
+        bucket->sales_value += value;
+        return;
+    }
+    
+    key.sales_count = 1;
+    key.sales_value = value;
+    bplusInsert(showroom->monthly_sales, &key);
+}
+
+// Rebuild the sales ledger from every customer of every salesperson in the showroom
+void rebuild_monthly_sales(Showroom* showroom) {
+    if (!showroom) return;
+    
+    if (showroom->monthly_sales) {
+        freeBPlusTree(showroom->monthly_sales);
+    }
+    showroom->monthly_sales = createBPlusTree(compareMonthlySales, printMonthlySales, cloneMonthlySales, freeMonthlySales);
+    
+    if (!showroom->sales_persons || !showroom->sales_persons->root) return;
+    
+    BTreeNode* sp_node = showroom->sales_persons->root;
+    while (!sp_node->is_leaf) {
+        sp_node = sp_node->children[0];
+    }
+    
+    while (sp_node) {
+        for (int i = 0; i < sp_node->num_keys; i++) {
+            SalesPerson* sp = (SalesPerson*)sp_node->keys[i].key;
+            if (!sp->customer_tree || !sp->customer_tree->root) continue;
+            
+            BTreeNode* customer_node = sp->customer_tree->root;
+            while (!customer_node->is_leaf) {
+                customer_node = customer_node->children[0];
+            }
+            
+            while (customer_node) {
+                for (int k = 0; k < customer_node->num_keys; k++) {
+                    Customer* customer = (Customer*)customer_node->keys[k].key;
+                    record_monthly_sale(showroom, customer->purchase_date, customer->actual_aoumnt_paid);
+                }
+                customer_node = customer_node->leaf_link.next;
+            }
+        }
+        sp_node = sp_node->leaf_link.next;
+    }
+}
+
+// Initialize the showroom management system
+void init_system() {
+    showroom_tree = createBPlusTree(compareShowroomID, printShowroom, cloneShowroom, freeShowroom);
+}
+
+// Function to add a new showroom to the system
+void add_showroom() {
+    int id;
+    char name[MAX_STR_LEN];
+    char location[MAX_STR_LEN];
+    char contact[MAX_MOBILE_LEN];
+    
+    out_printf("\n=== Add New Showroom ===\n");
+    
+    out_printf("Enter Showroom ID: ");
+    scanf("%d", &id);
+    getchar(); // Clear input buffer
+    
+    out_printf("Enter Showroom Name: ");
+    fgets(name, MAX_STR_LEN, stdin);
+    name[strcspn(name, "\n")] = 0; // Remove newline character
+    
+    out_printf("Enter Showroom Location: ");
+    fgets(location, MAX_STR_LEN, stdin);
+    location[strcspn(location, "\n")] = 0; // Remove newline character
+    
+    out_printf("Enter Contact Number: ");
+    fgets(contact, MAX_MOBILE_LEN, stdin);
+    contact[strcspn(contact, "\n")] = 0; // Remove newline character
+    
+    if (!perform_add_showroom(id, name, location, contact)) return;
+    
+    out_printf("Showroom '%s' added successfully with ID %d.\n", name, id);
+}
+
+int perform_add_showroom(int id, const char* name, const char* location, const char* contact) {
+    // Check if showroom with same ID already exists
+    Showroom temp;
+    temp.id = id;
+    if (showroom_tree && bplusSearch(showroom_tree, &temp)) {
+        out_printf("A showroom with ID %d already exists.\n", id);
+        return 0;
+    }
+    
+    Showroom* showroom = create_showroom(id, name, location, contact);
+    if (!showroom) return 0;
+    journal_log_add_showroom(showroom);
+    return 1;
+}
+
+// Create a showroom with empty trees and add it to the global tree.
+// Returns the stored showroom, NULL if the ID is already taken.
+Showroom* create_showroom(int id, const char* name, const char* location, const char* contact) {
+    if (!showroom_tree) {
+        init_system();
+    }
+    
+    Showroom showroom;
+    memset(&showroom, 0, sizeof(Showroom));
+    showroom.id = id;
+    if (bplusSearch(showroom_tree, &showroom)) return NULL;
+    
+    strcpy(showroom.name, name);
+    strcpy(showroom.location, location);
+    strcpy(showroom.contact, contact);
+    
+    // Insert first, then give the stored copy its trees (nothing to clone that way)
+    Showroom* stored = (Showroom*)bplusInsert(showroom_tree, &showroom);
+    if (!stored) {
+        out_printf("Memory allocation failed for showroom\n");
+        return NULL;
+    }
+    stored->available_cars = createBPlusTree(compareVIN, printCar, cloneCar, freeCar);
+    stored->sold_cars = createBPlusTree(compareVIN, printSoldCar, cloneSoldCar, freeSoldCar);
+    stored->sales_persons = createBPlusTree(compareSalesPersonID, printSalesPerson, cloneSalesPerson, freeSalesPerson);
+    stored->monthly_sales = createBPlusTree(compareMonthlySales, printMonthlySales, cloneMonthlySales, freeMonthlySales);
+    stored->dirty = SHOWROOM_DIRTY_ALL;
+    return stored;
+}
+
+void clear_input_line() {
+    int c;
+    while ((c = getchar()) != '\n' && c != EOF);
+}
+
+// Function to add a new car to a showroom's available cars
+void add_new_stock() {
+    int showroom_id;
+    Car car;
+    
+    out_printf("\n=== Add New Car Stock ===\n");
+    
+    // Get showroom ID
+    out_printf("Enter Showroom ID: ");
+    scanf("%d", &showroom_id);
+    getchar(); // Clear input buffer
+    
+    // Create a temporary showroom object to search the tree
+    Showroom temp;
+    temp.id = showroom_id;
+    
+    // Search for the showroom
+    Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp);
+    if (!showroom) {
+        out_printf("Showroom with ID %d not found.\n", showroom_id);
+        return;
+    }
+    
+    // Get car details
+    out_printf("Enter Vehicle Identification Number (VIN): ");
+    if (!read_vin(car.VIN)) return;
+    
+    // Check if car with this VIN already exists
+    Car* existing_car = (Car*)bplusSearch(showroom->available_cars, &car);
+    if (existing_car) {
+        out_printf("Car with VIN %s already exists in this showroom.\n", car.VIN);
+        return;
+    }
+    
+    out_printf("Enter Car Model Name: ");
+    fgets(car.name, MAX_STR_LEN, stdin);
+    car.name[strcspn(car.name, "\n")] = 0;
+    
+    out_printf("Enter Car Color: ");
+    fgets(car.color, MAX_STR_LEN, stdin);
+    car.color[strcspn(car.color, "\n")] = 0;
+    
+    out_printf("Enter Car Price (in lakhs): ");
+    scanf("%lf", &car.price);
+    getchar(); // Clear input buffer
+    
+    out_printf("Enter Fuel Type (Petrol, Diesel, Electric, etc.): ");
+    fgets(car.fuel_type, MAX_STR_LEN, stdin);
+    car.fuel_type[strcspn(car.fuel_type, "\n")] = 0;
+    
+    out_printf("Enter Car Type (Sedan, SUV, Hatchback, etc.): ");
+    fgets(car.car_type, MAX_STR_LEN, stdin);
+    car.car_type[strcspn(car.car_type, "\n")] = 0;
+    
+    // Add the car to the showroom's available cars
+    if (!perform_add_stock(showroom_id, &car)) return;
+    
+    out_printf("Car with VIN %s added successfully to showroom %d.\n", car.VIN, showroom_id);
+    
+    // Display the added car
+    out_printf("\nCar Details:\n");
+    out_printf("VIN: %s\n", car.VIN);
+    out_printf("Model: %s\n", car.name);
+    out_printf("Color: %s\n", car.color);
+    out_printf("Price: %.2f lakhs\n", car.price);
+    out_printf("Fuel Type: %s\n", car.fuel_type);
+    out_printf("Car Type: %s\n", car.car_type);
+}
+
+int perform_add_stock(int showroom_id, const Car* car) {
+    Showroom temp;
+    temp.id = showroom_id;
+    Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp);
+    if (!showroom) {
+        out_printf("Showroom with ID %d not found.\n", showroom_id);
+        return 0;
+    }
+    
+    Car stocked = *car;
+    if (!stock_car(showroom, &stocked)) {
+        out_printf("Car with VIN %s already exists in this showroom.\n", car->VIN);
+        return 0;
+    }
+    journal_log_add_car(showroom->id, &stocked);
+    return 1;
+}
+
+// Add a car to a showroom's stock; 0 if the VIN is already there
+int stock_car(Showroom* showroom, Car* car) {
+    if (bplusSearch(showroom->available_cars, car)) return 0;
+    
+    bplusInsert(showroom->available_cars, car);
+    showroom->total_available_cars++;
+    showroom->dirty |= SHOWROOM_DIRTY(SHOWROOM_CARS);
+    inventory_changed();
+    return 1;
+}
+
+int update_stocked_car(Showroom* showroom, const Car* car) {
+    Car* stored = (Car*)bplusSearch(showroom->available_cars, (void*)car);
+    if (!stored) return 0;
+    
+    memcpy(stored, car, sizeof(Car));
+    showroom->dirty |= SHOWROOM_DIRTY(SHOWROOM_CARS);
+    inventory_changed();
+    return 1;
+}
+
+int unstock_car(Showroom* showroom, const char* vin) {
+    Car temp_car;
+    strcpy(temp_car.VIN, vin);
+    if (!bplusSearch(showroom->available_cars, &temp_car)) return 0;
+    
+    bplusDelete(showroom->available_cars, &temp_car);
+    showroom->total_available_cars--;
+    showroom->dirty |= SHOWROOM_DIRTY(SHOWROOM_CARS);
+    inventory_changed();
+    return 1;
+}
+
+// Function to recruit a salesperson for a specific showroom
+void recruit_salesperson() {
+    int showroom_id;
+    SalesPerson sales_person;
+    
+    out_printf("\n=== Recruit New Sales Person ===\n");
+    
+    // Get showroom ID
+    out_printf("Enter Showroom ID: ");
+    scanf("%d", &showroom_id);
+    getchar(); // Clear input buffer
+    
+    // Create a temporary showroom object to search the tree
+    Showroom temp;
+    temp.id = showroom_id;
+    
+    // Search for the showroom
+    Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp);
+    if (!showroom) {
+        out_printf("Showroom with ID %d not found.\n", showroom_id);
+        return;
+    }
+    
+    // Get salesperson details
+    out_printf("Enter Sales Person ID: ");
+    scanf("%d", &sales_person.id);
+    getchar(); // Clear input buffer
+    
+    // Check if salesperson with this ID already exists
+    SalesPerson* existing_sp = (SalesPerson*)bplusSearch(showroom->sales_persons, &sales_person);
+    if (existing_sp) {
+        out_printf("Sales Person with ID %d already exists in this showroom.\n", sales_person.id);
+        return;
+    }
+    
+    out_printf("Enter Sales Person Name: ");
+    fgets(sales_person.name, MAX_STR_LEN, stdin);
+    sales_person.name[strcspn(sales_person.name, "\n")] = 0;
+    
+    out_printf("Enter Monthly Target Sales (in lakhs): ");
+    scanf("%lf", &sales_person.target_sales);
+    getchar(); // Clear input buffer
+    
+    // Initialize other fields
+    sales_person.achieved_sales = 0.0;
+    sales_person.commission = 0.0;
+    
+    // Add the salesperson to the showroom and its leaderboard
+    if (!perform_recruit(showroom_id, sales_person.id, sales_person.name, sales_person.target_sales)) return;
+    
+    out_printf("Sales Person '%s' with ID %d recruited successfully for showroom %d.\n", 
+               sales_person.name, sales_person.id, showroom_id);
+    
+    // Display the added salesperson
+    out_printf("\nSales Person Details:\n");
+    out_printf("ID: %d\n", sales_person.id);
+    out_printf("Name: %s\n", sales_person.name);
+    out_printf("Target Sales: %.2f lakhs\n", sales_person.target_sales);
+    out_printf("Achieved Sales: %.2f lakhs\n", sales_person.achieved_sales);
+    out_printf("Commission: %.2f lakhs\n", sales_person.commission);
+}
+
+int perform_recruit(int showroom_id, int id, const char* name, double target_sales) {
+    Showroom temp;
+    temp.id = showroom_id;
+    Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp);
+    if (!showroom) {
+        out_printf("Showroom with ID %d not found.\n", showroom_id);
+        return 0;
+    }
+    
+    if (!hire_salesperson(showroom, id, name, target_sales)) {
+        out_printf("Sales Person with ID %d already exists in this showroom.\n", id);
+        return 0;
+    }
+    journal_log_recruit(showroom->id, id, name, target_sales);
+    return 1;
+}
+
+// Add a salesperson with no sales yet to a showroom and its leaderboard.
+// Returns the stored salesperson, NULL if the ID is already taken in this showroom.
+SalesPerson* hire_salesperson(Showroom* showroom, int id, const char* name, double target_sales) {
+    SalesPerson sales_person;
+    memset(&sales_person, 0, sizeof(SalesPerson));
+    sales_person.id = id;
+    if (bplusSearch(showroom->sales_persons, &sales_person)) return NULL;
+    
+    strcpy(sales_person.name, name);
+    sales_person.target_sales = target_sales;
+    
+    // Insert first, then give the stored copy its trees
+    SalesPerson* stored_sp = (SalesPerson*)bplusInsert(showroom->sales_persons, &sales_person);
+    if (!stored_sp) return NULL;
+    stored_sp->customer_tree = createBPlusTree(compareCustomerByEMI, printCustomer, cloneCustomer, freeCustomer);
+    stored_sp->sold_car_tree = createBPlusTree(compareVIN, printSoldCar, cloneSoldCar, freeSoldCar);
+    leaderboard_add(showroom, stored_sp);
+    showroom->dirty |= SHOWROOM_DIRTY(SHOWROOM_SALESPERSONS);
+    return stored_sp;
+}
+
+// Achieved sales and commission come from the sales and are left as they are
+int update_salesperson(Showroom* showroom, int id, const char* name, double target_sales) {
+    SalesPerson temp;
+    temp.id = id;
+    SalesPerson* stored = (SalesPerson*)bplusSearch(showroom->sales_persons, &temp);
+    if (!stored) return 0;
+    
+    strcpy(stored->name, name);
+    stored->target_sales = target_sales;
+    showroom->dirty |= SHOWROOM_DIRTY(SHOWROOM_SALESPERSONS);
+    return 1;
+}
+
+// Function to handle car purchase by a customer
+void car_purchase() {
+    int showroom_id, salesperson_id;
+    char car_vin[MAX_VIN_LEN];
+    char payment_type[MAX_STR_LEN];
+    
+    out_printf("\n=== Car Purchase ===\n");
+    
+    // Get showroom ID
+    out_printf("Enter Showroom ID: ");
+    scanf("%d", &showroom_id);
+    getchar(); // Clear input buffer
+    
+    // Create a temporary showroom object to search the tree
+    Showroom temp_showroom;
+    temp_showroom.id = showroom_id;
+    
+    // Search for the showroom
+    Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp_showroom);
+    if (!showroom) {
+        out_printf("Showroom with ID %d not found.\n", showroom_id);
+        return;
+    }
+    
+    // Get salesperson ID
+    out_printf("Enter Salesperson ID: ");
+    scanf("%d", &salesperson_id);
+    getchar(); // Clear input buffer
+    
+    // Create a temporary salesperson object to search in the showroom's salesperson tree
+    SalesPerson temp_salesperson;
+    temp_salesperson.id = salesperson_id;
+    
+    // Search for the salesperson in the showroom
+    SalesPerson* salesperson = (SalesPerson*)bplusSearch(showroom->sales_persons, &temp_salesperson);
+    if (!salesperson) {
+        out_printf("Salesperson with ID %d not found in this showroom.\n", salesperson_id);
+        return;
+    }
+    
+    // Get car VIN
+    out_printf("Enter Car VIN to purchase: ");
+    if (!read_vin(car_vin)) return;
+    
+    // Create a temporary car object to search
+    Car temp_car;
+    strcpy(temp_car.VIN, car_vin);
+    
+    // Search for the car in the showroom's available cars
+    Car* car = (Car*)bplusSearch(showroom->available_cars, &temp_car);
+    if (!car) {
+        out_printf("Car with VIN %s not found in this showroom's available cars.\n", car_vin);
+        return;
+    }
+    
+    // Display car details for confirmation
+    out_printf("\nCar Details:\n");
+    out_printf("VIN: %s\n", car->VIN);
+    out_printf("Model: %s\n", car->name);
+    out_printf("Color: %s\n", car->color);
+    out_printf("Price: %.2f lakhs\n", car->price);
+    out_printf("Fuel Type: %s\n", car->fuel_type);
+    out_printf("Car Type: %s\n", car->car_type);
+    
+    // Get payment details
+    out_printf("\nEnter Payment Type (Cash/Loan): ");
+    fgets(payment_type, MAX_STR_LEN, stdin);
+    payment_type[strcspn(payment_type, "\n")] = 0; // Remove newline
+    
+    // Create a sold car record
+    SoldCar sold_car;
+    strcpy(sold_car.VIN, car_vin);
+    sold_car.model_id = -1;     // Set when the sale is completed
+    sold_car.payment_type = parse_payment_type(payment_type);
+
+    
+    // If payment is through loan, get loan details
+    if (sold_car.payment_type == PAYMENT_LOAN) {
+        double min_down_payment = car->price * (MIN_DOWN_PAYMENT_PERCENT / 100.0);
+        out_printf("Minimum down payment required (%.2f%%): %.2f lakhs\n", 
+                   MIN_DOWN_PAYMENT_PERCENT, min_down_payment);
+        
+        do {
+            out_printf("Enter Down Payment (in lakhs): ");
+            if (scanf("%lf", &sold_car.down_payment) != 1) {
+                out_printf("Invalid input.\n");
+                clear_input_line();
+                return;
+            }
+            getchar(); // Clear input buffer
+            
+            
+            if (sold_car.down_payment < min_down_payment) {
+                out_printf("Down payment must be at least %.2f lakhs (%.2f%% of car price).\n",
+                           min_down_payment, MIN_DOWN_PAYMENT_PERCENT);
+            }
+        } while (sold_car.down_payment < min_down_payment);
+        
+        int valid_loan_periods[3] = {36, 60, 84}; // 3, 5, or 7 years
+        int period_choice;
+        
+        out_printf("Select Loan Period:\n");
+        out_printf("1. 36 months (3 years) - Interest Rate: 8.50%%\n");
+        out_printf("2. 60 months (5 years) - Interest Rate: 8.75%%\n");
+        out_printf("3. 84 months (7 years) - Interest Rate: 9.00%%\n");
+        out_printf("Enter choice (1-3): ");
+        scanf("%d", &period_choice);
+        getchar(); // Clear input buffer
+        
+        if (period_choice < 1 || period_choice > 3) {
+            period_choice = 1; // Default to 36 months if invalid choice
+            out_printf("Invalid choice. Defaulting to 36 months.\n");
+        }
+        
+        // Set loan period based on user choice
+        set_payment_terms(&sold_car, car->price, PAYMENT_LOAN, sold_car.down_payment,
+                          valid_loan_periods[period_choice - 1]);
+        double interest_rate = calculate_interest_rate(sold_car.loan_period_months);
+        
+        out_printf("\nLoan Details:\n");
+        out_printf("Loan Amount: %.2f lakhs\n", sold_car.loan_amount);
+        out_printf("Interest Rate: %.2f%%\n", interest_rate);
+        out_printf("Loan Period: %d months\n", sold_car.loan_period_months);
+        out_printf("Monthly EMI: %.2f\n", sold_car.monthly_emi);
+    } else {
+        set_payment_terms(&sold_car, car->price, PAYMENT_CASH, 0, 0);
+    }
+    
+    // Now get customer details
+    Customer customer;
+    char customer_name_input[MAX_STR_LEN];
+    char customer_address_input[MAX_STR_LEN];
+    
+    out_printf("\nEnter Customer Details:\n");
+    out_printf("Name: ");
+    fgets(customer_name_input, MAX_STR_LEN, stdin);
+    customer_name_input[strcspn(customer_name_input, "\n")] = 0; // Remove newline
+    
+    out_printf("Mobile Number: ");
+    fgets(customer.mobile, MAX_MOBILE_LEN, stdin);
+    customer.mobile[strcspn(customer.mobile, "\n")] = 0; // Remove newline
+    
+    out_printf("Address: ");
+    fgets(customer_address_input, MAX_STR_LEN, stdin);
+    customer_address_input[strcspn(customer_address_input, "\n")] = 0; // Remove newline
+    
+    out_printf("Registration Number: ");
+    fgets(customer.reg_number, MAX_REG_NUM_LEN, stdin);
+    customer.reg_number[strcspn(customer.reg_number, "\n")] = 0; // Remove newline
+    
+    // Confirm purchase
+    char confirm;
+    out_printf("\nConfirm car purchase (y/n): ");
+    scanf("%c", &confirm);
+    getchar(); // Clear input buffer
+    
+    if (confirm != 'y' && confirm != 'Y') {
+        out_printf("Purchase cancelled.\n");
+        return;
+    }
+    
+    // Keep a copy for the receipt, the sale takes the car out of stock
+    Car purchased = *car;
+    car = &purchased;
+    
+    PurchaseOrder order = {
+        showroom_id, salesperson_id, car_vin, sold_car.payment_type, sold_car.down_payment,
+        sold_car.loan_period_months, customer_name_input, customer.mobile, customer_address_input,
+        customer.reg_number, 0
+    };
+    if (!perform_car_purchase(&order)) return;
+    double commission = car->price * 0.02;
+    
+    out_printf("\nCar purchase successful!\n");
+    out_printf("Car: %s %s\n", car->name, car->color);
+    out_printf("Customer: %s\n", customer_name_input);
+    out_printf("Salesperson: %s (ID: %d)\n", salesperson->name, salesperson->id);
+    out_printf("Total Price: %.2f lakhs\n", car->price);
+    out_printf("Payment Method: %s\n", payment_type);
+    
+    if (sold_car.payment_type == PAYMENT_LOAN) {
+        out_printf("Down Payment: %.2f lakhs\n", sold_car.down_payment);
+        out_printf("Loan Amount: %.2f lakhs\n", sold_car.loan_amount);
+        out_printf("Monthly EMI: %.2f for %d months\n", sold_car.monthly_emi, sold_car.loan_period_months);
+    }
+    
+    out_printf("Registration Number: %s\n", customer.reg_number);
+    out_printf("Salesperson Commission: %.2f lakhs\n", commission);
+}
+
+// Down payment, loan, interest and EMI of a sale; a cash sale pays the whole price up front
+void set_payment_terms(SoldCar* sold_car, double price, int payment_type, double down_payment,
+                       int loan_period_months) {
+    sold_car->payment_type = (uint8_t)payment_type;
+    if (payment_type != PAYMENT_LOAN) {
+        sold_car->down_payment = price;
+        sold_car->loan_amount = 0;
+        sold_car->loan_period_months = 0;
+        sold_car->interest_rate_bps = 0;
+        sold_car->monthly_emi = 0;
+        return;
+    }
+    
+    sold_car->down_payment = down_payment;
+    sold_car->loan_period_months = (uint8_t)loan_period_months;
+    sold_car->loan_amount = price - down_payment;
+    double interest_rate = calculate_interest_rate(loan_period_months);
+    sold_car->interest_rate_bps = (uint16_t)(interest_rate * 100 + 0.5);
+    sold_car->monthly_emi = calculate_emi(sold_car->loan_amount, interest_rate, loan_period_months);
+}
+
+int perform_car_purchase(const PurchaseOrder* order) {
+    Showroom temp_showroom;
+    temp_showroom.id = order->showroom_id;
+    Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp_showroom);
+    if (!showroom) {
+        out_printf("Showroom with ID %d not found.\n", order->showroom_id);
+        return 0;
+    }
+    
+    SalesPerson temp_salesperson;
+    temp_salesperson.id = order->salesperson_id;
+    SalesPerson* salesperson = (SalesPerson*)bplusSearch(showroom->sales_persons, &temp_salesperson);
+    if (!salesperson) {
+        out_printf("Salesperson with ID %d not found in this showroom.\n", order->salesperson_id);
+        return 0;
+    }
+    
+    Car temp_car;
+    snprintf(temp_car.VIN, sizeof(temp_car.VIN), "%s", order->vin);
+    Car* car = (Car*)bplusSearch(showroom->available_cars, &temp_car);
+    if (!car) {
+        out_printf("Car with VIN %s not found in this showroom's available cars.\n", order->vin);
+        return 0;
+    }
+    
+    if (order->payment_type == PAYMENT_LOAN) {
+        double min_down_payment = car->price * (MIN_DOWN_PAYMENT_PERCENT / 100.0);
+        if (order->down_payment < min_down_payment) {
+            out_printf("Down payment must be at least %.2f lakhs (%.2f%% of car price).\n",
+                       min_down_payment, MIN_DOWN_PAYMENT_PERCENT);
+            return 0;
+        }
+        if (order->loan_period_months != 36 && order->loan_period_months != 60 && order->loan_period_months != 84) {
+            out_printf("Loan period must be 36, 60 or 84 months.\n");
+            return 0;
+        }
+    }
+    
+    SoldCar sold_car;
+    memset(&sold_car, 0, sizeof(SoldCar));
+    strcpy(sold_car.VIN, car->VIN);
+    sold_car.model_id = -1;     // Set when the sale is completed
+    set_payment_terms(&sold_car, car->price, order->payment_type, order->down_payment, order->loan_period_months);
+    
+    Customer customer;
+    memset(&customer, 0, sizeof(Customer));
+    strcpy(customer.car_VIN, car->VIN);
+    snprintf(customer.mobile, sizeof(customer.mobile), "%s", order->mobile);
+    snprintf(customer.reg_number, sizeof(customer.reg_number), "%s", order->reg_number);
+    customer.actual_aoumnt_paid = car->price;
+    customer.loan_months = sold_car.loan_period_months;
+    customer.purchase_date = order->purchase_date;
+    if (!customer.purchase_date) {
+        customer.purchase_date = today_days();
+    }
+    
+    if (!complete_car_purchase(showroom, salesperson, &sold_car, &customer, order->name, order->address)) {
+        out_printf("Car with VIN %s is no longer in stock.\n", order->vin);
+        return 0;
+    }
+    journal_log_purchase(showroom->id, salesperson->id, &sold_car, &customer, order->name, order->address);
+    return 1;
+}
+
+// Record a confirmed sale: the car leaves stock, the sale and the customer are filed under the
+// salesperson, and the ledgers, rankings and indexes are updated. 0 if the car is not in stock.
+int complete_car_purchase(Showroom* showroom, SalesPerson* salesperson, SoldCar* sold_car,
+                          Customer* customer, const char* name, const char* address) {
+    // The sale goes into the shared indexes with the showroom's saved ones; other showrooms stay unread
+    snapshot_index_showroom(showroom);
+    
+    Car temp_car;
+    strcpy(temp_car.VIN, sold_car->VIN);
+    Car* car = (Car*)bplusSearch(showroom->available_cars, &temp_car);
+    if (!car) return 0;
+    
+    // The model, name and address are registered only once the sale is confirmed
+    sold_car->model_id = intern_car_model(car->name);
+    customer->name = string_heap_add(name);
+    customer->address = string_heap_add(address);
+    
+    // Add sold car to salesperson's sold_car_tree
+    bplusInsert(salesperson->sold_car_tree, sold_car);
+
+    //Add sold car to showroom data 
+    SoldCar* stored_sold_car = (SoldCar*)bplusInsert(showroom->sold_cars, sold_car);
+    
+    // Add customer to salesperson's customer_tree and the front-desk lookup index
+    Customer* stored_customer = (Customer*)bplusInsert(salesperson->customer_tree, customer);
+    customer_index_add(showroom, salesperson, stored_customer, stored_sold_car);
+    
+    // Update car popularity hashtable with the sold car's model
+    increment_car_popularity(car->name);
+    
+    // Update salesperson's achieved sales and their place on the leaderboard
+    double previous_sales = salesperson->achieved_sales;
+    salesperson->achieved_sales += car->price;
+    leaderboard_update(showroom, salesperson, previous_sales);
+    
+    // Calculate commission (assuming 2% of car price)
+    salesperson->commission += car->price * 0.02;
+    
+    // Remove car from available cars
+    bplusDelete(showroom->available_cars, &temp_car);
+    inventory_changed();
+    
+    // Update showroom statistics
+    showroom->total_available_cars--;
+    showroom->total_sold_cars++;
+    showroom->dirty |= SHOWROOM_DIRTY_ALL;
+    
+    // Record the sale in the showroom's monthly sales ledger
+    record_monthly_sale(showroom, customer->purchase_date, customer->actual_aoumnt_paid);
+    record_model_sale(showroom, sold_car->model_id, customer->purchase_date);
+    return 1;
+}
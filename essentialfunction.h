@@ -1,45 +1,120 @@
-#ifndef ESS_FUN_H
-#define ESS_FUN_H
-
-#include "functionpointer.h"
-
-extern BPlusTree* showroom_tree;
-extern CarPopularityEntry* car_popularity_table[HASH_SIZE];
-
-typedef struct {
-    int month;
-    int year;
-    int sales_count;
-    double sales_value;
-} MonthlySales;
-
-
-double calculate_interest_rate(int months);
-double calculate_emi(double loan_amount, double interest_rate, int months);
-void init_system();
-void add_showroom();
-void add_new_stock();
-void recruit_salesperson();   //markB
-void car_purchase();          //markE
- 
-
-void merge_showrooms();
-void display_showroom_inventory();
-void find_most_successful_SP();
-void predict_next_month_sales();
-void find_car_by_VIN();
-void search_salespersons_by_sales_range();
-void increment_car_popularity(const char* model_name);
-char* find_most_popular_car(int* max_count);
-void display_car_popularity();
-void free_car_popularity_table();
-void list_customers_with_emi_in_range();
-
-//helper
-int count_nodes_in_tree(BTreeNode* node);
-unsigned int hash_model(const char* str);
-
-
-
-
+#ifndef ESS_FUN_H
+#define ESS_FUN_H
+
+#include "functionpointer.h"
+#include "customerindex.h"
+#include "leaderboard.h"
+#include "carpopularity.h"
+#include "popularitywindow.h"
+#include "inventorysnapshot.h"
+
+extern BPlusTree* showroom_tree;
+
+
+double calculate_interest_rate(int months);
+double calculate_emi(double loan_amount, double interest_rate, int months);
+void init_system();
+void add_showroom();
+void add_new_stock();
+void recruit_salesperson();   //markB
+void car_purchase();          //markE
+ 
+
+void merge_showrooms();
+void display_showroom_inventory();
+void find_most_successful_SP();
+void predict_next_month_sales();
+void find_car_by_VIN();
+void search_salespersons_by_sales_range();
+void display_car_popularity();
+void list_customers_with_emi_in_range();
+void find_customer_by_contact();
+void display_sales_leaderboard();
+void display_recent_car_popularity();
+void display_inventory_analytics();
+void import_stock_feed();
+void display_all_showrooms();
+
+// Main menu, shared by the terminal loop and the client (see client.h)
+#define MENU_LAST_CHOICE 20
+void print_main_menu();
+void run_menu_command(int choice);
+void clear_input_line();        // Skip the rest of a rejected answer, stops at end of input
+void set_merge_conflict_choice(char choice);    // Answer every merge conflict with this instead of asking, 0 to ask again
+
+// Salesperson ID conflicts settled during a merge: 'e' keep existing, 'n' replace with new,
+// 'm' merge the two. Recorded as the user answers so the journal can replay the same merge.
+typedef struct {
+    char* choices;      // In the order the conflicts came up
+    int count;
+    int capacity;
+    int next;           // Next choice to replay
+    int replaying;      // Take choices from the list instead of asking (and list nothing)
+} MergeDecisions;
+
+// A sale with every answer given (see perform_car_purchase)
+typedef struct {
+    int showroom_id;
+    int salesperson_id;
+    const char* vin;
+    int payment_type;           // PaymentType
+    double down_payment;        // Loans only, at least MIN_DOWN_PAYMENT_PERCENT of the price
+    int loan_period_months;     // Loans only: 36, 60 or 84
+    const char* name;
+    const char* mobile;
+    const char* address;
+    const char* reg_number;
+    int purchase_date;          // Days, see date_to_days(); 0 for today
+} PurchaseOrder;
+
+// The menu's changes with their answers given, used by the menu functions and batch mode
+// (see batch.h). Each checks its arguments, says why it refuses, then applies and journals
+// the change; 1 on success. Nothing is printed on success, the callers report it.
+int perform_add_showroom(int id, const char* name, const char* location, const char* contact);
+int perform_add_stock(int showroom_id, const Car* car);
+int perform_recruit(int showroom_id, int id, const char* name, double target_sales);
+int perform_car_purchase(const PurchaseOrder* order);
+int perform_merge(int id1, int id2, int new_id, const char* name, const char* location, const char* contact,
+                  char conflict_choice, int delete_originals);
+int locate_car_by_VIN(const char* vin);         // Prints where the car is; 0 if nowhere
+void set_payment_terms(SoldCar* sold_car, double price, int payment_type, double down_payment,
+                       int loan_period_months);
+
+// The menu's other commands with their answers given, for the menu functions and batch mode.
+// Each prints what the menu shows after its questions; 0 if the showroom is unknown, the
+// answers are invalid or a lookup finds nothing, having said why.
+int award_best_salesperson_incentive(int showroom_id);     // Journaled like the changes above
+int import_stock_feed_from(const char* path);               // File or pipe
+int show_showroom_inventory(int showroom_id);
+int show_sales_prediction(int showroom_id);
+int show_salespersons_in_sales_range(double min_sales, double max_sales);
+int show_customers_with_emi_months(int min_months, int max_months);
+int show_customers_by_contact(int by_registration, const char* key);    // Mobile number otherwise
+int show_sales_leaderboard(int showroom_id, int top_n);                 // The number shown
+int show_salesperson_rank(int showroom_id, int salesperson_id);
+int show_recent_car_popularity(int showroom_id);                        // 0 for all showrooms
+InventorySnapshot* show_inventory_analytics();  // The snapshot shown, NULL if no cars
+void show_cars_priced_below(InventorySnapshot* snapshot, double threshold);
+
+// State changes behind the menu functions, also used to replay the journal
+Showroom* create_showroom(int id, const char* name, const char* location, const char* contact);
+int stock_car(Showroom* showroom, Car* car);
+int update_stocked_car(Showroom* showroom, const Car* car);     // Same VIN, new details; 0 if not in stock
+int unstock_car(Showroom* showroom, const char* vin);           // Drop an available car without a sale
+SalesPerson* hire_salesperson(Showroom* showroom, int id, const char* name, double target_sales);
+int update_salesperson(Showroom* showroom, int id, const char* name, double target_sales);
+int complete_car_purchase(Showroom* showroom, SalesPerson* salesperson, SoldCar* sold_car,
+                          Customer* customer, const char* name, const char* address);
+Showroom* merge_showroom_pair(Showroom* showroom1, Showroom* showroom2, int new_id, const char* name,
+                              const char* location, const char* contact, MergeDecisions* decisions);
+void remove_showroom(int showroom_id);
+
+//helper
+int count_nodes_in_tree(BTreeNode* node);
+void record_monthly_sale(Showroom* showroom, int purchase_date, double value);
+void rebuild_monthly_sales(Showroom* showroom);
+
+
+
+
 #endif
\ No newline at end of file
@@ -1,753 +1,737 @@
-#include "filehandling.h"
-#include <sys/stat.h>
-#include <sys/types.h>
-#ifdef _WIN32
-#include <direct.h>
-#endif
-
-// Field separator for data files
-#define FIELD_SEP "|"
-
-// Helper function to ensure data directory exists
-void ensure_data_directory() {
-    #ifdef _WIN32
-    mkdir("data");
-    #else
-    mkdir("data", 0777);
-    #endif
-}
-
-// Helper function to save a showroom
-void save_showroom(Showroom* showroom, FILE* file) {
-    fprintf(file, "%d%s%s%s%s%s%s%s%d%s%d\n", 
-            showroom->id, FIELD_SEP,
-            showroom->name, FIELD_SEP,
-            showroom->location, FIELD_SEP,
-            showroom->contact, FIELD_SEP,
-            showroom->total_available_cars, FIELD_SEP,
-            showroom->total_sold_cars);
-}
-
-// Helper function to process and save each showroom
-void process_showroom_save(void* key, void* user_data) {
-    Showroom* showroom = (Showroom*)key;
-    FILE* file = (FILE*)user_data;
-    
-    save_showroom(showroom, file);
-    
-    // Save all cars in this showroom
-    if (showroom->available_cars && showroom->available_cars->root) {
-        save_cars_to_file(showroom, file);
-    }
-    
-    // Save all sold cars in this showroom
-    if (showroom->sold_cars && showroom->sold_cars->root) {
-        save_sold_cars_to_file(showroom, file);
-    }
-    
-    // Save all salespersons in this showroom
-    if (showroom->sales_persons && showroom->sales_persons->root) {
-        save_salespersons_to_file(showroom, file);
-    }
-}
-
-// Save all showrooms to file
-void save_showrooms_to_file() {
-    ensure_data_directory();
-    FILE* file = fopen(SHOWROOMS_FILE, "w");
-    if (!file) {
-        printf("Error: Could not open file for writing: %s\n", SHOWROOMS_FILE);
-        return;
-    }
-    
-    if (showroom_tree && showroom_tree->root) {
-        // Find the leftmost leaf node (first showroom)
-        BTreeNode* node = showroom_tree->root;
-        while (!node->is_leaf) {
-            node = node->children[0];
-        }
-        
-        // Traverse all leaf nodes to save all showrooms
-        while (node) {
-            for (int i = 0; i < node->num_keys; i++) {
-                process_showroom_save(node->keys[i].key, file);
-            }
-            node = node->leaf_link.next;
-        }
-    }
-    
-    fclose(file);
-}
-
-// Save cars for a specific showroom
-void save_cars_to_file(Showroom* showroom, FILE* file) {
-    FILE* car_file = fopen(CARS_FILE, "a");
-    if (!car_file) {
-        printf("Error: Could not open file for writing: %s\n", CARS_FILE);
-        return;
-    }
-    
-    // Process all cars
-    if (showroom->available_cars && showroom->available_cars->root) {
-        BTreeNode* node = showroom->available_cars->root;
-        while (!node->is_leaf) {
-            node = node->children[0];
-        }
-        
-        while (node) {
-            for (int i = 0; i < node->num_keys; i++) {
-                Car* car = (Car*)node->keys[i].key;
-                fprintf(car_file, "%d%s%s%s%s%s%s%s%.2f%s%s%s%s\n", 
-                        showroom->id, FIELD_SEP,
-                        car->VIN, FIELD_SEP,
-                        car->name, FIELD_SEP,
-                        car->color, FIELD_SEP,
-                        car->price, FIELD_SEP,
-                        car->fuel_type, FIELD_SEP,
-                        car->car_type);
-            }
-            node = node->leaf_link.next;
-        }
-    }
-    
-    fclose(car_file);
-}
-
-// Save sold cars for a specific showroom
-void save_sold_cars_to_file(Showroom* showroom, FILE* file) {
-    FILE* sold_car_file = fopen(SOLD_CARS_FILE, "a");
-    if (!sold_car_file) {
-        printf("Error: Could not open file for writing: %s\n", SOLD_CARS_FILE);
-        return;
-    }
-    
-    // Process all sold cars
-    if (showroom->sold_cars && showroom->sold_cars->root) {
-        BTreeNode* node = showroom->sold_cars->root;
-        while (!node->is_leaf) {
-            node = node->children[0];
-        }
-        
-        while (node) {
-            for (int i = 0; i < node->num_keys; i++) {
-                SoldCar* sold_car = (SoldCar*)node->keys[i].key;
-                fprintf(sold_car_file, "%d%s%s%s%s%s%.2f%s%d%s%.2f%s%.2f%s%.2f\n", 
-                        showroom->id, FIELD_SEP,
-                        sold_car->VIN, FIELD_SEP,
-                        sold_car->payment_type, FIELD_SEP,
-                        sold_car->down_payment, FIELD_SEP,
-                        sold_car->loan_period_months, FIELD_SEP,
-                        sold_car->loan_amount, FIELD_SEP,
-                        sold_car->interest_rate, FIELD_SEP,
-                        sold_car->monthly_emi);
-            }
-            node = node->leaf_link.next;
-        }
-    }
-    
-    fclose(sold_car_file);
-}
-
-// Save salespersons for a specific showroom
-void save_salespersons_to_file(Showroom* showroom, FILE* file) {
-    FILE* sp_file = fopen(SALESPERSONS_FILE, "a");
-    if (!sp_file) {
-        printf("Error: Could not open file for writing: %s\n", SALESPERSONS_FILE);
-        return;
-    }
-    
-    // Process all salespersons
-    if (showroom->sales_persons && showroom->sales_persons->root) {
-        BTreeNode* node = showroom->sales_persons->root;
-        while (!node->is_leaf) {
-            node = node->children[0];
-        }
-        
-        while (node) {
-            for (int i = 0; i < node->num_keys; i++) {
-                SalesPerson* sp = (SalesPerson*)node->keys[i].key;
-                fprintf(sp_file, "%d%s%d%s%s%s%.2f%s%.2f%s%.2f\n", 
-                        showroom->id, FIELD_SEP,
-                        sp->id, FIELD_SEP,
-                        sp->name, FIELD_SEP,
-                        sp->target_sales, FIELD_SEP,
-                        sp->achieved_sales, FIELD_SEP,
-                        sp->commission);
-                
-                // Save customers for this salesperson
-                save_customers_to_file(sp, sp_file);
-            }
-            node = node->leaf_link.next;
-        }
-    }
-    
-    fclose(sp_file);
-}
-
-// Save customers for a salesperson
-void save_customers_to_file(SalesPerson* salesperson, FILE* file) {
-    FILE* customer_file = fopen(CUSTOMERS_FILE, "a");
-    if (!customer_file) {
-        printf("Error: Could not open file for writing: %s\n", CUSTOMERS_FILE);
-        return;
-    }
-    
-    // Process all customers
-    if (salesperson->customer_tree && salesperson->customer_tree->root) {
-        BTreeNode* node = salesperson->customer_tree->root;
-        while (!node->is_leaf) {
-            node = node->children[0];
-        }
-        
-        while (node) {
-            for (int i = 0; i < node->num_keys; i++) {
-                Customer* customer = (Customer*)node->keys[i].key;
-                fprintf(customer_file, "%d%s%s%s%s%s%s%s%s%s%s%s%.2f%s%d%s%d%s%d%s%d\n", 
-                        salesperson->id, FIELD_SEP,
-                        customer->name, FIELD_SEP,
-                        customer->mobile, FIELD_SEP,
-                        customer->address, FIELD_SEP,
-                        customer->car_VIN, FIELD_SEP,
-                        customer->reg_number, FIELD_SEP,
-                        customer->actual_aoumnt_paid, FIELD_SEP,
-                        customer->purchase_day, FIELD_SEP,
-                        customer->purchase_month, FIELD_SEP,
-                        customer->purchase_year, FIELD_SEP,
-                        customer->loan_months);
-            }
-            node = node->leaf_link.next;
-        }
-    }
-    
-    fclose(customer_file);
-}
-
-// Helper function to process a line from showrooms file
-void process_showroom_line(char* line) {
-    Showroom* showroom = (Showroom*)malloc(sizeof(Showroom));
-    if (!showroom) return;
-    
-    // Parse the line
-    char* token = strtok(line, FIELD_SEP);
-    showroom->id = atoi(token);
-    
-    token = strtok(NULL, FIELD_SEP);
-    strncpy(showroom->name, token, MAX_STR_LEN);
-    
-    token = strtok(NULL, FIELD_SEP);
-    strncpy(showroom->location, token, MAX_STR_LEN);
-    
-    token = strtok(NULL, FIELD_SEP);
-    strncpy(showroom->contact, token, MAX_MOBILE_LEN);
-    
-    token = strtok(NULL, FIELD_SEP);
-    showroom->total_available_cars = atoi(token);
-    
-    token = strtok(NULL, FIELD_SEP);
-    showroom->total_sold_cars = atoi(token);
-    
-    // Initialize trees
-    showroom->available_cars = createBPlusTree(compareVIN, printCar, cloneCar, freeCar);
-    showroom->sold_cars = createBPlusTree(compareVIN, printSoldCar, cloneSoldCar, freeSoldCar);
-    showroom->sales_persons = createBPlusTree(compareSalesPersonID, printSalesPerson, cloneSalesPerson, freeSalesPerson);
-    
-    // Add to showroom tree
-    bplusInsert(showroom_tree, showroom);
-}
-
-// Helper function to process a line from cars file
-void process_car_line(char* line) {
-    int showroom_id;
-    Car* car = (Car*)malloc(sizeof(Car));
-    if (!car) return;
-    
-    // Parse the line with null checks
-    char* token = strtok(line, FIELD_SEP);
-    if (!token) { free(car); return; }
-    showroom_id = atoi(token);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(car); return; }
-    strncpy(car->VIN, token, MAX_VIN_LEN);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(car); return; }
-    strncpy(car->name, token, MAX_STR_LEN);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(car); return; }
-    strncpy(car->color, token, MAX_STR_LEN);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(car); return; }
-    car->price = atof(token);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(car); return; }
-    strncpy(car->fuel_type, token, MAX_STR_LEN);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(car); return; }
-    strncpy(car->car_type, token, MAX_STR_LEN);
-    
-    // Find the showroom
-    Showroom temp_showroom;
-    temp_showroom.id = showroom_id;
-    Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp_showroom);
-    
-    if (showroom) {
-        // Ensure available_cars tree exists
-        if (!showroom->available_cars) {
-            showroom->available_cars = createBPlusTree(
-                compareVIN, printCar, cloneCar, freeCar
-            );
-        }
-        
-        // Add car to showroom
-        bplusInsert(showroom->available_cars, car);
-        showroom->total_available_cars++; // Increment car count
-        printf("Car %s added to showroom %d\n", car->VIN, showroom_id);
-    } else {
-        // Showroom not found, free car
-        printf("Error: Could not find showroom with ID %d for car %s\n", 
-               showroom_id, car->VIN);
-        free(car);
-    }
-}
-
-
-// Helper function to process a line from sold cars file
-void process_sold_car_line(char* line) {
-    int showroom_id;
-    SoldCar* sold_car = (SoldCar*)malloc(sizeof(SoldCar));
-    if (!sold_car) return;
-    
-    // Parse the line with null checks
-    char* token = strtok(line, FIELD_SEP);
-    if (!token) { free(sold_car); return; }
-    showroom_id = atoi(token);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(sold_car); return; }
-    strncpy(sold_car->VIN, token, MAX_VIN_LEN);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(sold_car); return; }
-    strncpy(sold_car->payment_type, token, MAX_STR_LEN);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(sold_car); return; }
-    sold_car->down_payment = atof(token);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(sold_car); return; }
-    sold_car->loan_period_months = atoi(token);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(sold_car); return; }
-    sold_car->loan_amount = atof(token);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(sold_car); return; }
-    sold_car->interest_rate = atof(token);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(sold_car); return; }
-    sold_car->monthly_emi = atof(token);
-    
-    // Find the showroom
-    Showroom temp_showroom;
-    temp_showroom.id = showroom_id;
-    Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp_showroom);
-    
-    if (showroom) {
-        // Ensure sold_cars tree exists
-        if (!showroom->sold_cars) {
-            showroom->sold_cars = createBPlusTree(
-                compareVIN, printSoldCar, cloneSoldCar, freeSoldCar
-            );
-        }
-        
-        // Add sold car to showroom
-        bplusInsert(showroom->sold_cars, sold_car);
-        showroom->total_sold_cars++; // Increment sold car count
-        printf("Sold car %s added to showroom %d\n", sold_car->VIN, showroom_id);
-    } else {
-        // Showroom not found, free sold car
-        printf("Error: Could not find showroom with ID %d for sold car %s\n", 
-               showroom_id, sold_car->VIN);
-        free(sold_car);
-    }
-}
-
-// Helper function to process a line from salespersons file
-void process_salesperson_line(char* line) {
-    int showroom_id;
-    SalesPerson* sp = (SalesPerson*)malloc(sizeof(SalesPerson));
-    if (!sp) return;
-    
-    // Parse the line with null checks
-    char* token = strtok(line, FIELD_SEP);
-    if (!token) { free(sp); return; }
-    showroom_id = atoi(token);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(sp); return; }
-    sp->id = atoi(token);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(sp); return; }
-    strncpy(sp->name, token, MAX_STR_LEN);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(sp); return; }
-    sp->target_sales = atof(token);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(sp); return; }
-    sp->achieved_sales = atof(token);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(sp); return; }
-    sp->commission = atof(token);
-    
-    // Initialize trees
-    sp->customer_tree = createBPlusTree(compareCustomerByEMI, printCustomer, cloneCustomer, freeCustomer);
-    sp->sold_car_tree = createBPlusTree(compareVIN, printSoldCar, cloneSoldCar, freeSoldCar);
-    
-    // Find the showroom
-    Showroom temp_showroom;
-    temp_showroom.id = showroom_id;
-    Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp_showroom);
-    
-    if (showroom) {
-        // Ensure sales_persons tree exists
-        if (!showroom->sales_persons) {
-            showroom->sales_persons = createBPlusTree(
-                compareSalesPersonID, printSalesPerson, cloneSalesPerson, freeSalesPerson
-            );
-        }
-        
-        // Add salesperson to showroom
-        bplusInsert(showroom->sales_persons, sp);
-        printf("Salesperson %d added to showroom %d\n", sp->id, showroom_id);
-    } else {
-        // Free trees first to prevent memory leaks
-        freeBPlusTree(sp->customer_tree);
-        freeBPlusTree(sp->sold_car_tree);
-        
-        // Showroom not found, free salesperson
-        printf("Error: Could not find showroom with ID %d for salesperson %d\n", 
-               showroom_id, sp->id);
-        free(sp);
-    }
-}
-
-// Helper function to process a line from customers file
-void process_customer_line(char* line) {
-    int salesperson_id;
-    Customer* customer = (Customer*)malloc(sizeof(Customer));
-    if (!customer) return;
-    
-    // Parse the line
-    char* token = strtok(line, FIELD_SEP);
-    salesperson_id = atoi(token);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(customer); return; } // Prevent NULL dereference
-    strncpy(customer->name, token, MAX_STR_LEN);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(customer); return; }
-    strncpy(customer->mobile, token, MAX_MOBILE_LEN);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(customer); return; }
-    strncpy(customer->address, token, MAX_STR_LEN);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(customer); return; }
-    strncpy(customer->car_VIN, token, MAX_VIN_LEN);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(customer); return; }
-    strncpy(customer->reg_number, token, MAX_REG_NUM_LEN);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(customer); return; }
-    customer->actual_aoumnt_paid = atof(token);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(customer); return; }
-    customer->purchase_day = atoi(token);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(customer); return; }
-    customer->purchase_month = atoi(token);
-    
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(customer); return; }
-    customer->purchase_year = atoi(token);
-
-    token = strtok(NULL, FIELD_SEP);
-    if (!token) { free(customer); return; }
-    customer->loan_months = atoi(token);
-    
-    // Find the salesperson in all showrooms - improved algorithm
-    SalesPerson* found_sp = NULL;
-    
-    // Use leaf node traversal for efficient searching through showrooms
-    if (showroom_tree && showroom_tree->root) {
-        BTreeNode* node = showroom_tree->root;
-        while (!node->is_leaf) {
-            node = node->children[0]; // Get to leftmost leaf
-        }
-        
-        // Now traverse all showrooms via leaf nodes
-        while (node && !found_sp) {
-            for (int i = 0; i < node->num_keys; i++) {
-                Showroom* showroom = (Showroom*)node->keys[i].key;
-                
-                if (showroom && showroom->sales_persons && showroom->sales_persons->root) {
-                    // Create temp salesperson with target ID
-                    SalesPerson temp_sp;
-                    temp_sp.id = salesperson_id;
-                    
-                    // Search for this salesperson in current showroom
-                    found_sp = (SalesPerson*)bplusSearch(showroom->sales_persons, &temp_sp);
-                    
-                    if (found_sp) {
-                        // Initialize customer tree if needed
-                        if (!found_sp->customer_tree) {
-                            found_sp->customer_tree = createBPlusTree(
-                                compareCustomerByEMI, 
-                                printCustomer, 
-                                cloneCustomer, 
-                                freeCustomer
-                            );
-                        }
-                        
-                        // Add customer to salesperson
-                        bplusInsert(found_sp->customer_tree, customer);
-                        printf("Customer %s added to salesperson %d\n", customer->name, salesperson_id);
-                        return;
-                    }
-                }
-            }
-            node = node->leaf_link.next; // Move to next leaf node
-        }
-    }
-    
-    // Salesperson not found, free customer and report error
-    printf("Error: Could not find salesperson with ID %d for customer %s\n", 
-           salesperson_id, customer->name);
-    free(customer);
-}
-
-// Load showrooms from file
-void load_showrooms_from_file() {
-    FILE* file = fopen(SHOWROOMS_FILE, "r");
-    if (!file) {
-        printf("No showrooms data file found. Starting with empty database.\n");
-        return;
-    }
-    
-    char line[512];
-    while (fgets(line, sizeof(line), file)) {
-        // Remove newline character
-        line[strcspn(line, "\n")] = 0;
-        process_showroom_line(line);
-    }
-    
-    fclose(file);
-}
-
-// Load cars from file
-void load_cars_from_file() {
-    FILE* file = fopen(CARS_FILE, "r");
-    if (!file) {
-        printf("No cars data file found.\n");
-        return;
-    }
-    
-    char line[512];
-    while (fgets(line, sizeof(line), file)) {
-        // Remove newline character
-        line[strcspn(line, "\n")] = 0;
-        process_car_line(line);
-    }
-    
-    fclose(file);
-}
-
-// Load sold cars from file
-void load_sold_cars_from_file() {
-    FILE* file = fopen(SOLD_CARS_FILE, "r");
-    if (!file) {
-        printf("No sold cars data file found.\n");
-        return;
-    }
-    
-    char line[512];
-    while (fgets(line, sizeof(line), file)) {
-        // Remove newline character
-        line[strcspn(line, "\n")] = 0;
-        process_sold_car_line(line);
-    }
-    
-    fclose(file);
-}
-
-// Load salespersons from file
-void load_salespersons_from_file() {
-    FILE* file = fopen(SALESPERSONS_FILE, "r");
-    if (!file) {
-        printf("No salespersons data file found.\n");
-        return;
-    }
-    
-    char line[512];
-    while (fgets(line, sizeof(line), file)) {
-        // Remove newline character
-        line[strcspn(line, "\n")] = 0;
-        process_salesperson_line(line);
-    }
-    
-    fclose(file);
-}
-
-// Load customers from file
-void load_customers_from_file() {
-    FILE* file = fopen(CUSTOMERS_FILE, "r");
-    if (!file) {
-        printf("No customers data file found.\n");
-        return;
-    }
-    
-    char line[512];
-    while (fgets(line, sizeof(line), file)) {
-        // Remove newline character
-        line[strcspn(line, "\n")] = 0;
-        process_customer_line(line);
-    }
-    
-    fclose(file);
-}
-
-// Save car popularity data to file
-void save_car_popularity_to_file() {
-    FILE* file = fopen(CAR_POPULARITY_FILE, "w");
-    if (!file) {
-        printf("Error: Could not open file for writing: %s\n", CAR_POPULARITY_FILE);
-        return;
-    }
-
-    int id = 1; // Starting ID for entries
-    
-    // Loop through the entire hash table
-    for (int i = 0; i < HASH_SIZE; i++) {
-        CarPopularityEntry* entry = car_popularity_table[i];
-        while (entry) {
-            // Write each entry as: id|model_name|count
-            fprintf(file, "%d%s%s%s%d\n", 
-                   id++, FIELD_SEP, entry->model_name, FIELD_SEP, entry->count);
-            entry = entry->next;
-        }
-    }
-    
-    fclose(file);
-    printf("Car popularity data saved successfully.\n");
-}
-
-// Load car popularity data from file
-void load_car_popularity_from_file() {
-    // First clear any existing data
-    free_car_popularity_table();
-    
-    FILE* file = fopen(CAR_POPULARITY_FILE, "r");
-    if (!file) {
-        printf("No car popularity data file found. Starting with empty popularity data.\n");
-        return;
-    }
-    
-    char line[512];
-    while (fgets(line, sizeof(line), file)) {
-        // Remove newline character
-        line[strcspn(line, "\n")] = 0;
-        
-        // Parse the line: id|model_name|popularity_count
-        char* token = strtok(line, FIELD_SEP);
-        if (!token) continue; // Skip ID
-        
-        token = strtok(NULL, FIELD_SEP);
-        if (!token) continue; // Get model name
-        
-        char model_name[MAX_STR_LEN];
-        strncpy(model_name, token, MAX_STR_LEN - 1);
-        model_name[MAX_STR_LEN - 1] = '\0'; // Ensure null-termination
-        
-        token = strtok(NULL, FIELD_SEP);
-        if (!token) continue; // Get count
-        int count = atoi(token);
-        
-        // Create entry directly (more efficient than calling increment_car_popularity multiple times)
-        unsigned int index = hash_model(model_name);
-        
-        CarPopularityEntry* new_entry = (CarPopularityEntry*)malloc(sizeof(CarPopularityEntry));
-        if (!new_entry) {
-            printf("Memory allocation failed while loading car popularity data\n");
-            continue;
-        }
-        
-        strncpy(new_entry->model_name, model_name, MAX_STR_LEN - 1);
-        new_entry->model_name[MAX_STR_LEN - 1] = '\0';
-        new_entry->count = count;
-        new_entry->next = car_popularity_table[index];
-        car_popularity_table[index] = new_entry;
-    }
-    
-    fclose(file);
-    printf("Car popularity data loaded successfully.\n");
-}
-
-// Save all data to files
-void save_all_data() {
-    printf("Saving data...\n");
-    
-    // Create empty files first to avoid appending to old data
-    ensure_data_directory();
-    FILE* f;
-    f = fopen(CARS_FILE, "w"); fclose(f);
-    f = fopen(SOLD_CARS_FILE, "w"); fclose(f);
-    f = fopen(SALESPERSONS_FILE, "w"); fclose(f);
-    f = fopen(CUSTOMERS_FILE, "w"); fclose(f);
-    
-    // Now save all data
-    save_showrooms_to_file();
-    save_car_popularity_to_file();
-    
-    printf("Data saved successfully.\n");
-}
-
-// Load all data from files
-void load_all_data() {
-    printf("Loading data...\n");
-    
-    // First load showrooms as the base structure
-    load_showrooms_from_file();
-    
-    // Next load salespersons as they're directly connected to showrooms
-    load_salespersons_from_file();
-    
-    // Then load cars (both available and sold)
-    load_cars_from_file();
-    load_sold_cars_from_file();
-    
-    // Finally load customers as they depend on salespersons
-    load_customers_from_file();
-    
-    // Load car popularity data
-    load_car_popularity_from_file();
-    
-    printf("Data loaded successfully.\n");
-}
\ No newline at end of file
+#include "filehandling.h"
+#include "parallelload.h"
+#include "journal.h"
+#include "checkpoint.h"
+#include "archive.h"
+#include "mappedstore.h"
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+// Helper function to ensure data directory exists
+void ensure_data_directory() {
+    #ifdef _WIN32
+    mkdir("data");
+    #else
+    mkdir("data", 0777);
+    #endif
+}
+
+// Helper function to save a showroom
+void save_showroom(Showroom* showroom, TextWriter* out) {
+    text_write_int(out, showroom->id);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_str(out, showroom->name);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_str(out, showroom->location);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_str(out, showroom->contact);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_int(out, showroom->total_available_cars);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_int(out, showroom->total_sold_cars);
+    text_write_char(out, '\n');
+}
+
+// Save cars for a specific showroom
+void save_cars_to_file(Showroom* showroom, TextWriter* out) {
+    if (!showroom->available_cars || !showroom->available_cars->root) return;
+    
+    BTreeNode* node = showroom->available_cars->root;
+    while (!node->is_leaf) {
+        node = node->children[0];
+    }
+    
+    while (node) {
+        for (int i = 0; i < node->num_keys; i++) {
+            Car* car = (Car*)node->keys[i].key;
+            text_write_int(out, showroom->id);
+            text_write_char(out, FIELD_SEP[0]);
+            text_write_str(out, car->VIN);
+            text_write_char(out, FIELD_SEP[0]);
+            text_write_str(out, car->name);
+            text_write_char(out, FIELD_SEP[0]);
+            text_write_str(out, car->color);
+            text_write_char(out, FIELD_SEP[0]);
+            text_write_fixed2(out, car->price);
+            text_write_char(out, FIELD_SEP[0]);
+            text_write_str(out, car->fuel_type);
+            text_write_char(out, FIELD_SEP[0]);
+            text_write_str(out, car->car_type);
+            text_write_char(out, '\n');
+        }
+        node = node->leaf_link.next;
+    }
+}
+
+// showroom_id|VIN|payment|down|months|loan|rate|emi|model
+static void write_sold_car_row(TextWriter* out, int showroom_id, const SoldCar* sold_car) {
+    text_write_int(out, showroom_id);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_str(out, sold_car->VIN);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_str(out, payment_type_name(sold_car->payment_type));
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_fixed2(out, sold_car->down_payment);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_int(out, sold_car->loan_period_months);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_fixed2(out, sold_car->loan_amount);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_fixed2(out, sold_car->interest_rate_bps / 100.0);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_fixed2(out, sold_car->monthly_emi);
+    
+    // Optional trailing model name, older files end at the EMI column
+    CarPopularityEntry* model = car_popularity_entry(sold_car->model_id);
+    if (model) {
+        text_write_char(out, FIELD_SEP[0]);
+        text_write_str(out, model->model_name);
+    }
+    text_write_char(out, '\n');
+}
+
+// salesperson_id|name|mobile|address|VIN|reg|amount|day|month|year|loan_months
+static void write_customer_row(TextWriter* out, int salesperson_id, const Customer* customer,
+                               const char* name, const char* address) {
+    int day, month, year;
+    days_to_date(customer->purchase_date, &day, &month, &year);
+    text_write_int(out, salesperson_id);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_str(out, name);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_str(out, customer->mobile);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_str(out, address);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_str(out, customer->car_VIN);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_str(out, customer->reg_number);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_fixed2(out, customer->actual_aoumnt_paid);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_int(out, day);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_int(out, month);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_int(out, year);
+    text_write_char(out, FIELD_SEP[0]);
+    text_write_int(out, customer->loan_months);
+    text_write_char(out, '\n');
+}
+
+// Save sold cars for a specific showroom
+void save_sold_cars_to_file(Showroom* showroom, TextWriter* out) {
+    if (!showroom->sold_cars || !showroom->sold_cars->root) return;
+    
+    BTreeNode* node = showroom->sold_cars->root;
+    while (!node->is_leaf) {
+        node = node->children[0];
+    }
+    
+    while (node) {
+        for (int i = 0; i < node->num_keys; i++) {
+            write_sold_car_row(out, showroom->id, (SoldCar*)node->keys[i].key);
+        }
+        node = node->leaf_link.next;
+    }
+}
+
+// Save salespersons for a specific showroom, and each salesperson's customers
+void save_salespersons_to_file(Showroom* showroom, TextWriter* out, TextWriter* customer_out) {
+    if (!showroom->sales_persons || !showroom->sales_persons->root) return;
+    
+    BTreeNode* node = showroom->sales_persons->root;
+    while (!node->is_leaf) {
+        node = node->children[0];
+    }
+    
+    while (node) {
+        for (int i = 0; i < node->num_keys; i++) {
+            SalesPerson* sp = (SalesPerson*)node->keys[i].key;
+            text_write_int(out, showroom->id);
+            text_write_char(out, FIELD_SEP[0]);
+            text_write_int(out, sp->id);
+            text_write_char(out, FIELD_SEP[0]);
+            text_write_str(out, sp->name);
+            text_write_char(out, FIELD_SEP[0]);
+            text_write_fixed2(out, sp->target_sales);
+            text_write_char(out, FIELD_SEP[0]);
+            text_write_fixed2(out, sp->achieved_sales);
+            text_write_char(out, FIELD_SEP[0]);
+            text_write_fixed2(out, sp->commission);
+            text_write_char(out, '\n');
+            
+            // Save customers for this salesperson
+            save_customers_to_file(sp, customer_out);
+        }
+        node = node->leaf_link.next;
+    }
+}
+
+// Save customers for a salesperson
+void save_customers_to_file(SalesPerson* salesperson, TextWriter* out) {
+    if (!salesperson->customer_tree || !salesperson->customer_tree->root) return;
+    
+    BTreeNode* node = salesperson->customer_tree->root;
+    while (!node->is_leaf) {
+        node = node->children[0];
+    }
+    
+    while (node) {
+        for (int i = 0; i < node->num_keys; i++) {
+            Customer* customer = (Customer*)node->keys[i].key;
+            write_customer_row(out, salesperson->id, customer, customer_name(customer), customer_address(customer));
+        }
+        node = node->leaf_link.next;
+    }
+}
+
+// Writers for a showroom's archived sales, which follow its live ones in the text files
+typedef struct {
+    int showroom_id;
+    TextWriter* sold_car_out;
+    TextWriter* customer_out;
+} ArchiveExport;
+
+static void export_archived_sale(const ArchivedSale* sale, void* user_data) {
+    ArchiveExport* export = (ArchiveExport*)user_data;
+    if (sale->sold_car_in & ARCHIVE_IN_SHOWROOM) {
+        write_sold_car_row(export->sold_car_out, export->showroom_id, &sale->sold_car);
+    }
+    write_customer_row(export->customer_out, sale->salesperson_id, &sale->customer, sale->name, sale->address);
+}
+
+// Parse one data file line by line, handing each record's fields to `process`.
+// Prints a single summary line for the file. Returns the bytes read (0 if the file is missing).
+size_t load_text_file(const char* path, const char* what, ProcessRecordFunc process) {
+    TextReader reader;
+    if (!text_reader_open(&reader, path)) {
+        out_printf("No %s data file found.\n", what);
+        return 0;
+    }
+    
+    StrView line;
+    StrView fields[TEXT_MAX_FIELDS];
+    int loaded = 0, skipped = 0;
+    while (text_reader_next_line(&reader, &line)) {
+        if (line.length == 0) continue;
+        
+        int field_count = split_fields(line, FIELD_SEP[0], fields, TEXT_MAX_FIELDS);
+        if (process(fields, field_count)) {
+            loaded++;
+        } else {
+            skipped++;
+        }
+    }
+    
+    size_t bytes = reader.file.size;
+    text_reader_close(&reader);
+    
+    out_printf("Loaded %d %s from %s", loaded, what, path);
+    if (skipped > 0) {
+        out_printf(" (%d skipped: malformed or referring to a missing record)", skipped);
+    }
+    out_printf("\n");
+    return bytes;
+}
+
+// Helper function to find a showroom by ID
+Showroom* find_loaded_showroom(int showroom_id) {
+    Showroom temp_showroom;
+    temp_showroom.id = showroom_id;
+    return (Showroom*)bplusSearch(showroom_tree, &temp_showroom);
+}
+
+// id|name|location|contact|available|sold
+int process_showroom_record(const StrView* fields, int field_count) {
+    if (field_count < 6) return 0;
+    
+    Showroom showroom;
+    memset(&showroom, 0, sizeof(Showroom));
+    showroom.id = view_to_int(fields[0]);
+    view_copy(fields[1], showroom.name, MAX_STR_LEN);
+    view_copy(fields[2], showroom.location, MAX_STR_LEN);
+    view_copy(fields[3], showroom.contact, MAX_MOBILE_LEN);
+    showroom.total_available_cars = view_to_int(fields[4]);
+    showroom.total_sold_cars = view_to_int(fields[5]);
+    
+    // Insert first, then give the stored copy its trees (nothing to clone that way)
+    Showroom* stored = (Showroom*)bplusInsert(showroom_tree, &showroom);
+    if (!stored) return 0;
+    
+    stored->available_cars = createBPlusTree(compareVIN, printCar, cloneCar, freeCar);
+    stored->sold_cars = createBPlusTree(compareVIN, printSoldCar, cloneSoldCar, freeSoldCar);
+    stored->sales_persons = createBPlusTree(compareSalesPersonID, printSalesPerson, cloneSalesPerson, freeSalesPerson);
+    stored->monthly_sales = createBPlusTree(compareMonthlySales, printMonthlySales, cloneMonthlySales, freeMonthlySales);
+    stored->dirty = SHOWROOM_DIRTY_ALL;     // Nothing of it is in the snapshot yet
+    return 1;
+}
+
+// showroom_id|VIN|name|color|price|fuel|type; 0 for a VIN longer than MAX_VIN_LEN holds
+int parse_car_fields(const StrView* fields, int field_count, Car* car) {
+    if (field_count < 7 || fields[1].length == 0 || fields[1].length >= MAX_VIN_LEN) return 0;
+    
+    view_copy(fields[1], car->VIN, MAX_VIN_LEN);
+    view_copy(fields[2], car->name, MAX_STR_LEN);
+    view_copy(fields[3], car->color, MAX_STR_LEN);
+    car->price = view_to_double(fields[4]);
+    view_copy(fields[5], car->fuel_type, MAX_STR_LEN);
+    view_copy(fields[6], car->car_type, MAX_STR_LEN);
+    return 1;
+}
+
+// Add a parsed car to its showroom (touches nothing outside the showroom)
+void add_loaded_car(Showroom* showroom, Car* car) {
+    // Ensure available_cars tree exists
+    if (!showroom->available_cars) {
+        showroom->available_cars = createBPlusTree(compareVIN, printCar, cloneCar, freeCar);
+    }
+    
+    bplusInsert(showroom->available_cars, car);
+    showroom->total_available_cars++; // Increment car count
+}
+
+int process_car_record(const StrView* fields, int field_count) {
+    Car car;
+    if (!parse_car_fields(fields, field_count, &car)) return 0;
+    
+    Showroom* showroom = find_loaded_showroom(view_to_int(fields[0]));
+    if (!showroom) return 0;
+    
+    add_loaded_car(showroom, &car);
+    inventory_changed();
+    return 1;
+}
+
+// showroom_id|VIN|payment|down_payment|months|loan_amount|rate|emi[|model]
+// The model column is left to the caller; model_id is set to -1.
+int parse_sold_car_fields(const StrView* fields, int field_count, SoldCar* sold_car) {
+    if (field_count < 8 || fields[1].length == 0 || fields[1].length >= MAX_VIN_LEN) return 0;
+    
+    char payment[MAX_STR_LEN];
+    memset(sold_car, 0, sizeof(SoldCar));
+    view_copy(fields[1], sold_car->VIN, MAX_VIN_LEN);
+    view_copy(fields[2], payment, MAX_STR_LEN);
+    sold_car->payment_type = parse_payment_type(payment);
+    sold_car->down_payment = view_to_double(fields[3]);
+    sold_car->loan_period_months = view_to_int(fields[4]);
+    sold_car->loan_amount = view_to_double(fields[5]);
+    sold_car->interest_rate_bps = (uint16_t)(view_to_double(fields[6]) * 100 + 0.5);
+    sold_car->monthly_emi = view_to_double(fields[7]);
+    sold_car->model_id = -1;
+    return 1;
+}
+
+// Model id for the optional model column, files written before it was tracked stop at the EMI
+int intern_sold_car_model(const StrView* fields, int field_count) {
+    if (field_count <= 8 || fields[8].length == 0) return -1;
+    
+    char model_name[MAX_STR_LEN];
+    view_copy(fields[8], model_name, MAX_STR_LEN);
+    return intern_car_model(model_name);
+}
+
+void add_loaded_sold_car(Showroom* showroom, SoldCar* sold_car) {
+    // Ensure sold_cars tree exists
+    if (!showroom->sold_cars) {
+        showroom->sold_cars = createBPlusTree(compareVIN, printSoldCar, cloneSoldCar, freeSoldCar);
+    }
+    
+    bplusInsert(showroom->sold_cars, sold_car);
+    showroom->total_sold_cars++; // Increment sold car count
+}
+
+int process_sold_car_record(const StrView* fields, int field_count) {
+    SoldCar sold_car;
+    if (!parse_sold_car_fields(fields, field_count, &sold_car)) return 0;
+    
+    Showroom* showroom = find_loaded_showroom(view_to_int(fields[0]));
+    if (!showroom) return 0;
+    
+    sold_car.model_id = intern_sold_car_model(fields, field_count);
+    add_loaded_sold_car(showroom, &sold_car);
+    return 1;
+}
+
+// showroom_id|id|name|target|achieved|commission
+int parse_salesperson_fields(const StrView* fields, int field_count, SalesPerson* sp) {
+    if (field_count < 6) return 0;
+    
+    memset(sp, 0, sizeof(SalesPerson));
+    sp->id = view_to_int(fields[1]);
+    view_copy(fields[2], sp->name, MAX_STR_LEN);
+    sp->target_sales = view_to_double(fields[3]);
+    sp->achieved_sales = view_to_double(fields[4]);
+    sp->commission = view_to_double(fields[5]);
+    return 1;
+}
+
+SalesPerson* add_loaded_salesperson(Showroom* showroom, SalesPerson* sp) {
+    // Ensure sales_persons tree exists
+    if (!showroom->sales_persons) {
+        showroom->sales_persons = createBPlusTree(
+            compareSalesPersonID, printSalesPerson, cloneSalesPerson, freeSalesPerson
+        );
+    }
+    
+    // Add salesperson to showroom and its leaderboard; the stored copy gets the trees
+    SalesPerson* stored_sp = (SalesPerson*)bplusInsert(showroom->sales_persons, sp);
+    if (!stored_sp) return NULL;
+    stored_sp->customer_tree = createBPlusTree(compareCustomerByEMI, printCustomer, cloneCustomer, freeCustomer);
+    stored_sp->sold_car_tree = createBPlusTree(compareVIN, printSoldCar, cloneSoldCar, freeSoldCar);
+    leaderboard_add(showroom, stored_sp);
+    return stored_sp;
+}
+
+int process_salesperson_record(const StrView* fields, int field_count) {
+    SalesPerson sp;
+    if (!parse_salesperson_fields(fields, field_count, &sp)) return 0;
+    
+    Showroom* showroom = find_loaded_showroom(view_to_int(fields[0]));
+    if (!showroom) return 0;
+    
+    return add_loaded_salesperson(showroom, &sp) != NULL;
+}
+
+// Customers are written grouped by salesperson, so remember the last match
+static Showroom* last_customer_showroom = NULL;
+static SalesPerson* last_customer_sp = NULL;
+
+// Find a salesperson by ID in any showroom (the customers file does not name the showroom)
+SalesPerson* find_loaded_salesperson(int salesperson_id, Showroom** showroom_out) {
+    if (last_customer_sp && last_customer_sp->id == salesperson_id) {
+        *showroom_out = last_customer_showroom;
+        return last_customer_sp;
+    }
+    
+    if (showroom_tree && showroom_tree->root) {
+        BTreeNode* node = showroom_tree->root;
+        while (!node->is_leaf) {
+            node = node->children[0]; // Get to leftmost leaf
+        }
+        
+        // Now traverse all showrooms via leaf nodes
+        SalesPerson temp_sp;
+        temp_sp.id = salesperson_id;
+        while (node) {
+            for (int i = 0; i < node->num_keys; i++) {
+                Showroom* showroom = (Showroom*)node->keys[i].key;
+                if (!showroom || !showroom->sales_persons || !showroom->sales_persons->root) continue;
+                
+                SalesPerson* found_sp = (SalesPerson*)bplusSearch(showroom->sales_persons, &temp_sp);
+                if (found_sp) {
+                    last_customer_showroom = showroom;
+                    last_customer_sp = found_sp;
+                    *showroom_out = showroom;
+                    return found_sp;
+                }
+            }
+            node = node->leaf_link.next; // Move to next leaf node
+        }
+    }
+    return NULL;
+}
+
+// sp_id|name|mobile|address|VIN|reg|paid|day|month|year|loan_months
+// Name and address are left to the caller (the string heap is not shared between threads).
+int parse_customer_fields(const StrView* fields, int field_count, Customer* customer) {
+    if (field_count < 11 || fields[4].length >= MAX_VIN_LEN) return 0;
+    int day = view_to_int(fields[7]), month = view_to_int(fields[8]), year = view_to_int(fields[9]);
+    if (!valid_date(day, month, year)) return 0;
+    
+    memset(customer, 0, sizeof(Customer));
+    view_copy(fields[2], customer->mobile, MAX_MOBILE_LEN);
+    view_copy(fields[4], customer->car_VIN, MAX_VIN_LEN);
+    view_copy(fields[5], customer->reg_number, MAX_REG_NUM_LEN);
+    customer->actual_aoumnt_paid = view_to_double(fields[6]);
+    customer->purchase_date = date_to_days(day, month, year);
+    customer->loan_months = view_to_int(fields[10]);
+    return 1;
+}
+
+void set_customer_strings(Customer* customer, const StrView* fields) {
+    char text[MAX_STR_LEN];
+    view_copy(fields[1], text, MAX_STR_LEN);
+    customer->name = string_heap_add(text);
+    view_copy(fields[3], text, MAX_STR_LEN);
+    customer->address = string_heap_add(text);
+}
+
+// Add a parsed customer to the salesperson and the showroom's own ledgers.
+// Returns the stored record; *sold_car_out is its sale, NULL if not on record.
+Customer* add_loaded_customer(Showroom* showroom, SalesPerson* sp, Customer* customer, SoldCar** sold_car_out) {
+    // Initialize customer tree if needed
+    if (!sp->customer_tree) {
+        sp->customer_tree = createBPlusTree(compareCustomerByEMI, printCustomer, cloneCustomer, freeCustomer);
+    }
+    
+    // Add customer to salesperson
+    Customer* stored_customer = (Customer*)bplusInsert(sp->customer_tree, customer);
+    
+    // Join the customer to its sale record for the EMI index
+    SoldCar temp_sold_car;
+    strcpy(temp_sold_car.VIN, customer->car_VIN);
+    SoldCar* sold_car = showroom->sold_cars ? 
+                        (SoldCar*)bplusSearch(showroom->sold_cars, &temp_sold_car) : NULL;
+    record_monthly_sale(showroom, customer->purchase_date, customer->actual_aoumnt_paid);
+    if (sold_car) {
+        record_showroom_model_sale(showroom, sold_car->model_id, customer->purchase_date);
+    }
+    
+    *sold_car_out = sold_car;
+    return stored_customer;
+}
+
+int process_customer_record(const StrView* fields, int field_count) {
+    Customer customer;
+    if (!parse_customer_fields(fields, field_count, &customer)) return 0;
+    
+    Showroom* showroom = NULL;
+    SalesPerson* found_sp = find_loaded_salesperson(view_to_int(fields[0]), &showroom);
+    if (!found_sp) return 0;
+    
+    set_customer_strings(&customer, fields);
+    
+    SoldCar* sold_car;
+    Customer* stored_customer = add_loaded_customer(showroom, found_sp, &customer, &sold_car);
+    customer_index_add(showroom, found_sp, stored_customer, sold_car);
+    if (sold_car) {
+        record_national_model_sale(sold_car->model_id, customer.purchase_date);
+    }
+    return 1;
+}
+
+// id|model_name|count, in model id order
+int process_car_popularity_record(const StrView* fields, int field_count) {
+    if (field_count < 3) return 0;
+    
+    char model_name[MAX_STR_LEN];
+    view_copy(fields[1], model_name, MAX_STR_LEN);
+    
+    // Set the count directly (more efficient than calling increment_car_popularity multiple times)
+    set_car_popularity(model_name, view_to_int(fields[2]));
+    return 1;
+}
+
+// Load showrooms from file
+size_t load_showrooms_from_file() {
+    return load_text_file(SHOWROOMS_FILE, "showrooms", process_showroom_record);
+}
+
+// Load cars from file
+size_t load_cars_from_file() {
+    return load_text_file(CARS_FILE, "cars", process_car_record);
+}
+
+// Load sold cars from file
+size_t load_sold_cars_from_file() {
+    return load_text_file(SOLD_CARS_FILE, "sold cars", process_sold_car_record);
+}
+
+// Load salespersons from file
+size_t load_salespersons_from_file() {
+    return load_text_file(SALESPERSONS_FILE, "salespersons", process_salesperson_record);
+}
+
+// Load customers from file
+size_t load_customers_from_file() {
+    last_customer_showroom = NULL;
+    last_customer_sp = NULL;
+    return load_text_file(CUSTOMERS_FILE, "customers", process_customer_record);
+}
+
+// Save car popularity data to file
+void save_car_popularity_to_file(TextWriter* out) {
+    // Write each entry as: id|model_name|count, ids follow the table's model ids
+    int total_models = car_model_count();
+    for (int i = 0; i < total_models; i++) {
+        CarPopularityEntry* entry = car_popularity_entry(i);
+        text_write_int(out, i + 1);
+        text_write_char(out, FIELD_SEP[0]);
+        text_write_str(out, entry->model_name);
+        text_write_char(out, FIELD_SEP[0]);
+        text_write_int(out, entry->count);
+        text_write_char(out, '\n');
+    }
+}
+
+// Load car popularity data from file
+size_t load_car_popularity_from_file() {
+    // First clear any existing data
+    free_car_popularity_table();
+    return load_text_file(CAR_POPULARITY_FILE, "car models", process_car_popularity_record);
+}
+
+// Write every table to the pipe-delimited text files in one pass over the showrooms,
+// each file through its own buffered writer
+void export_data_to_text() {
+    double start = wall_clock_seconds();
+    ensure_data_directory();
+    snapshot_load_all_showrooms();
+    
+    const char* paths[] = {SHOWROOMS_FILE, CARS_FILE, SOLD_CARS_FILE, SALESPERSONS_FILE,
+                           CUSTOMERS_FILE, CAR_POPULARITY_FILE};
+    enum { OUT_SHOWROOMS, OUT_CARS, OUT_SOLD_CARS, OUT_SALESPERSONS, OUT_CUSTOMERS, OUT_POPULARITY, OUT_COUNT };
+    TextWriter out[OUT_COUNT];
+    for (int i = 0; i < OUT_COUNT; i++) {
+        if (!text_writer_open(&out[i], paths[i])) {
+            out_printf("Error: Could not open file for writing: %s\n", paths[i]);
+            while (i-- > 0) text_writer_close(&out[i]);
+            return;
+        }
+    }
+    
+    if (showroom_tree && showroom_tree->root) {
+        // Find the leftmost leaf node (first showroom)
+        BTreeNode* node = showroom_tree->root;
+        while (!node->is_leaf) {
+            node = node->children[0];
+        }
+        
+        // Traverse all leaf nodes to save all showrooms
+        while (node) {
+            for (int i = 0; i < node->num_keys; i++) {
+                Showroom* showroom = (Showroom*)node->keys[i].key;
+                save_showroom(showroom, &out[OUT_SHOWROOMS]);
+                save_cars_to_file(showroom, &out[OUT_CARS]);
+                save_sold_cars_to_file(showroom, &out[OUT_SOLD_CARS]);
+                save_salespersons_to_file(showroom, &out[OUT_SALESPERSONS], &out[OUT_CUSTOMERS]);
+                ArchiveExport export = {showroom->id, &out[OUT_SOLD_CARS], &out[OUT_CUSTOMERS]};
+                archive_scan(showroom, export_archived_sale, &export);
+            }
+            node = node->leaf_link.next;
+        }
+    }
+    save_car_popularity_to_file(&out[OUT_POPULARITY]);
+    
+    size_t bytes = 0;
+    for (int i = 0; i < OUT_COUNT; i++) {
+        bytes += out[i].bytes;
+        if (!text_writer_close(&out[i])) {
+            out_printf("Error: Could not write %s\n", paths[i]);
+        }
+    }
+    
+    double seconds = wall_clock_seconds() - start;
+    double megabytes = bytes / (1024.0 * 1024.0);
+    out_printf("Exported %.2f MB of text in %.1f ms", megabytes, seconds * 1000.0);
+    if (seconds > 0) {
+        out_printf(" (%.1f MB/s)", megabytes / seconds);
+    }
+    out_printf("\n");
+}
+
+// Rebuild everything from the pipe-delimited text files
+void import_data_from_text() {
+    double start = wall_clock_seconds();
+    
+    // Salespersons, cars, sold cars and customers are built per showroom on worker threads
+    size_t bytes = parallel_import_text_files();
+    
+    double seconds = wall_clock_seconds() - start;
+    double megabytes = bytes / (1024.0 * 1024.0);
+    out_printf("Imported %.2f MB of text in %.1f ms", megabytes, seconds * 1000.0);
+    if (seconds > 0) {
+        out_printf(" (%.1f MB/s)", megabytes / seconds);
+    }
+    out_printf("\n");
+}
+
+// Checkpoint: save all data to the binary snapshot (or the text files if it cannot be written),
+// then empty the journal, whose changes the saved files now hold
+void save_all_data() {
+    checkpoint_wait();
+    out_printf("Saving data...\n");
+    ensure_data_directory();
+    int archived = archive_old_sales();
+    if (archived > 0) {
+        out_printf("Archived %d old sales\n", archived);
+    }
+    
+    journal_commit();
+    uint64_t journal_lsn = journal_last_lsn();
+    // In mapped store mode the memory image, otherwise the snapshot, which makes any image
+    // left from that mode out of date
+    int saved = store_writes_image() && store_save_image(STORE_IMAGE_FILE, journal_lsn);
+    if (!saved && save_snapshot(SNAPSHOT_FILE, journal_lsn)) {
+        remove(STORE_IMAGE_FILE);
+        saved = 1;
+    }
+    if (!saved) {
+        // Text files carry no journal position, a crash before the truncation below replays twice
+        out_printf("Saving to text files instead.\n");
+        export_data_to_text();
+    }
+    journal_truncate(journal_lsn);
+    
+    out_printf("Data saved successfully.\n");
+}
+
+// 1 if a text file has been changed since the saved file `what` was written
+static int text_file_newer_than(const struct stat* saved_stat, const char* what) {
+    struct stat text_stat;
+    const char* text_files[] = {SHOWROOMS_FILE, CARS_FILE, SOLD_CARS_FILE,
+                                SALESPERSONS_FILE, CUSTOMERS_FILE, CAR_POPULARITY_FILE};
+    for (int i = 0; i < (int)(sizeof(text_files) / sizeof(text_files[0])); i++) {
+        if (stat(text_files[i], &text_stat) == 0 && text_stat.st_mtime > saved_stat->st_mtime) {
+            out_printf("%s is newer than the %s, importing text files.\n", text_files[i], what);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// The snapshot is used unless a text file has been changed since it was written
+int snapshot_is_current() {
+    struct stat snapshot_stat;
+    return stat(SNAPSHOT_FILE, &snapshot_stat) == 0 && !text_file_newer_than(&snapshot_stat, "snapshot");
+}
+
+// Load all data from the memory image or the snapshot, or from the text files when there is
+// neither, then replay the journal of changes made since
+void load_all_data() {
+    out_printf("Loading data...\n");
+    
+    // Text files carry no journal position, so every journaled change is replayed on top of them
+    uint64_t journal_lsn = 0;
+    
+    // An image is only on disk while it is the latest save (see save_all_data)
+    struct stat image_stat;
+    int text_changed = 0;
+    int mapped = 0;
+    BPlusTree* empty_tree = showroom_tree;
+    if (stat(STORE_IMAGE_FILE, &image_stat) == 0) {
+        text_changed = text_file_newer_than(&image_stat, "memory image");
+        mapped = !text_changed && store_load_image(STORE_IMAGE_FILE, &journal_lsn);
+    }
+    
+    if (mapped) {
+        freeBPlusTree(empty_tree);      // The image brings its own
+    } else {
+        // Everything loaded from here on goes into the store
+        if (store_requested() && store_start()) {
+            freeBPlusTree(showroom_tree);
+            init_system();
+        }
+        if (text_changed || !snapshot_is_current() || !load_snapshot(SNAPSHOT_FILE, &journal_lsn)) {
+            import_data_from_text();
+            journal_lsn = 0;
+        }
+        // An image holds every showroom in memory
+        if (store_active()) {
+            snapshot_load_all_showrooms();
+        }
+    }
+    
+    ensure_data_directory();
+    const char* budget = getenv(SNAPSHOT_MEMORY_BUDGET_ENV);
+    if (budget && atol(budget) > 0 && !store_active()) {
+        snapshot_set_memory_budget((size_t)atol(budget) << 20, SPILL_DIRECTORY);
+    }
+    journal_open(JOURNAL_FILE, journal_lsn);
+    
+    out_printf("Data loaded successfully.\n");
+}
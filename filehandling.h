@@ -2,6 +2,9 @@
 #define FILE_HANDLING_H
 
 #include "essentialfunction.h"
+#include "snapshot.h"
+#include "textreader.h"
+#include "textwriter.h"
 
 // File paths
 #define SHOWROOMS_FILE "data/showrooms.txt"
@@ -10,28 +13,65 @@
 #define SALESPERSONS_FILE "data/salespersons.txt"
 #define CUSTOMERS_FILE "data/customers.txt"
 #define CAR_POPULARITY_FILE "data/car_popularity.txt"
+#define SNAPSHOT_FILE "data/showroom.snap"
+#define JOURNAL_FILE "data/showroom.journal"
+#define STORE_IMAGE_FILE "data/showroom.image"     // Memory image of the mapped store (see mappedstore.h)
+#define SPILL_DIRECTORY "data/showroom.spill"     // Tables evicted under a memory budget
+
+// Field separator for data files
+#define FIELD_SEP "|"
 
 // Function to ensure data directory exists
 void ensure_data_directory();
 
-// Save functions
-void save_showrooms_to_file();
-void save_cars_to_file(Showroom* showroom, FILE* file);
-void save_sold_cars_to_file(Showroom* showroom, FILE* file);
-void save_salespersons_to_file(Showroom* showroom, FILE* file);
-void save_customers_to_file(SalesPerson* salesperson, FILE* file);
-void save_car_popularity_to_file();
-
-// Load functions
-void load_showrooms_from_file();
-void load_cars_from_file();
-void load_sold_cars_from_file();
-void load_salespersons_from_file();
-void load_customers_from_file();
-void load_car_popularity_from_file();
+// Save functions, each appending its records to an open writer
+void save_showroom(Showroom* showroom, TextWriter* out);
+void save_cars_to_file(Showroom* showroom, TextWriter* out);
+void save_sold_cars_to_file(Showroom* showroom, TextWriter* out);
+void save_salespersons_to_file(Showroom* showroom, TextWriter* out, TextWriter* customer_out);
+void save_customers_to_file(SalesPerson* salesperson, TextWriter* out);
+void save_car_popularity_to_file(TextWriter* out);
+
+// Load functions (each returns the bytes read)
+typedef int (*ProcessRecordFunc)(const StrView* fields, int field_count);   // 1 if the record was added
+size_t load_text_file(const char* path, const char* what, ProcessRecordFunc process);
+size_t load_showrooms_from_file();
+size_t load_cars_from_file();
+size_t load_sold_cars_from_file();
+size_t load_salespersons_from_file();
+size_t load_customers_from_file();
+size_t load_car_popularity_from_file();
+
+// Record parsers for load_text_file()
+int process_showroom_record(const StrView* fields, int field_count);
+int process_car_record(const StrView* fields, int field_count);
+int process_sold_car_record(const StrView* fields, int field_count);
+int process_salesperson_record(const StrView* fields, int field_count);
+int process_customer_record(const StrView* fields, int field_count);
+int process_car_popularity_record(const StrView* fields, int field_count);
+Showroom* find_loaded_showroom(int showroom_id);
+SalesPerson* find_loaded_salesperson(int salesperson_id, Showroom** showroom_out);
+
+// Field parsing and per-showroom inserts, shared with the parallel loader.
+// The parse functions return 0 for a malformed record; the add functions only touch the given showroom.
+int parse_car_fields(const StrView* fields, int field_count, Car* car);
+int parse_sold_car_fields(const StrView* fields, int field_count, SoldCar* sold_car);
+int parse_salesperson_fields(const StrView* fields, int field_count, SalesPerson* sp);
+int parse_customer_fields(const StrView* fields, int field_count, Customer* customer);
+int intern_sold_car_model(const StrView* fields, int field_count);     // -1 if the record has no model
+void set_customer_strings(Customer* customer, const StrView* fields);  // Uses the string heap
+void add_loaded_car(Showroom* showroom, Car* car);
+void add_loaded_sold_car(Showroom* showroom, SoldCar* sold_car);
+SalesPerson* add_loaded_salesperson(Showroom* showroom, SalesPerson* sp);
+Customer* add_loaded_customer(Showroom* showroom, SalesPerson* sp, Customer* customer, SoldCar** sold_car_out);
+
+// Text import/export
+void export_data_to_text();
+void import_data_from_text();
+int snapshot_is_current();
 
 // Main file handling functions (added explicit declaration here)
-void save_all_data();
-void load_all_data();
+void save_all_data();     // Also the journal checkpoint
+void load_all_data();     // Replays the journal on top of what was loaded
 
 #endif
\ No newline at end of file
@@ -1,128 +1,206 @@
-#ifndef FUNCTION_POINTER_H
-#define FUNCTION_POINTER_H
-
-#include "b+treetemplate.h"
-
-#define MAX_STR_LEN 100
-#define MAX_VIN_LEN 20
-#define MAX_REG_NUM_LEN 15
-#define MAX_MOBILE_LEN 15
-#define MIN_DOWN_PAYMENT_PERCENT 20.0
-#define HASH_SIZE 101  
-
-typedef struct CarPopularityEntry {
-    char model_name[MAX_STR_LEN];
-    int count;
-    struct CarPopularityEntry* next;  // For collision handling 
-} CarPopularityEntry;
-
-
-// Structure for Car
-typedef struct {
-    char VIN[MAX_VIN_LEN];          // Vehicle Identification Number (Primary Key)
-    char name[MAX_STR_LEN];         // Car Model Name
-    char color[MAX_STR_LEN];        // Color of Car
-    double price;                   // Price in lakhs of rupees
-    char fuel_type[MAX_STR_LEN];    // Petrol, Diesel, Electric, etc.
-    char car_type[MAX_STR_LEN];     // Type of car 
-} Car;
-
-// Structure for Sold Car
-typedef struct {
-    char VIN[MAX_VIN_LEN];
-    char payment_type[MAX_STR_LEN];     // Cash or Loan
-    
-    // Loan details
-    double down_payment;
-    int loan_period_months;
-    double loan_amount;
-    double interest_rate;
-    double monthly_emi;
-} SoldCar;
-
-// Structure for Customer
-typedef struct {
-    char name[MAX_STR_LEN];
-    char mobile[MAX_MOBILE_LEN];
-    char address[MAX_STR_LEN];
-    char car_VIN[MAX_VIN_LEN];
-    char reg_number[MAX_REG_NUM_LEN];
-    double actual_aoumnt_paid;
-    //date fields
-    int purchase_day;
-    int purchase_month;
-    int purchase_year;
-    //EMI field for range search
-    int loan_months;
-} Customer;
-
-// Structure for Sales Person
-typedef struct {
-    int id;
-    char name[MAX_STR_LEN];
-    double target_sales;          // Monthly target in lakhs
-    double achieved_sales;        // Achieved in lakhs
-    double commission;            // Calculated commission
-    
-    // Trees for customers and sold cars for this sales person
-    BPlusTree* customer_tree;
-    BPlusTree* sold_car_tree;
-} SalesPerson;
-
-// Structure for Showroom
-typedef struct {
-    int id;                         // Unique Showroom ID
-    char name[MAX_STR_LEN];
-    char location[MAX_STR_LEN];
-    char contact[MAX_MOBILE_LEN];
-    
-    // Trees
-    BPlusTree* available_cars;
-    BPlusTree* sold_cars;
-    BPlusTree* sales_persons;
-    
-    int total_available_cars;
-    int total_sold_cars;
-} Showroom;
-
-// Function prototypes for B+ tree operations
-int compareInt(const void* a, const void* b);
-int compareStr(const void* a, const void* b);
-void printInt(const void* data);
-void printStr(const void* data);
-void* cloneInt(const void* data);
-void* cloneStr(const void* data);
-void freeInt(void* data);
-void freeStr(void* data);
-
-// Car related functions
-int compareVIN(const void* a, const void* b);
-void printCar(const void* data);
-void* cloneCar(const void* data);
-void freeCar(void* data);
-
-// SoldCar related functions
-void printSoldCar(const void* data);
-void* cloneSoldCar(const void* data);
-void freeSoldCar(void* data);
-
-// Customer related functions
-int compareCustomerByEMI(const void* a, const void* b); //need compare
-void printCustomer(const void* data);
-void* cloneCustomer(const void* data);
-void freeCustomer(void* data);
-
-// SalesPerson related functions
-int compareSalesPersonID(const void* a, const void* b);
-void printSalesPerson(const void* data);
-void* cloneSalesPerson(const void* data);
-void freeSalesPerson(void* data);
-
-// Showroom related functions
-int compareShowroomID(const void* a, const void* b);
-void printShowroom(const void* data);
-void* cloneShowroom(const void* data);
-void freeShowroom(void* data);
-
-
+#ifndef FUNCTION_POINTER_H
+#define FUNCTION_POINTER_H
+
+#include "b+treetemplate.h"
+#include "stringheap.h"
+
+#define MAX_STR_LEN 100
+#define MAX_VIN_LEN 18           // 17-character VIN plus terminator
+#define VIN_INPUT_LEN 64         // Line a VIN is typed on, so a longer one is seen and refused
+#define MAX_REG_NUM_LEN 15
+#define MAX_MOBILE_LEN 15
+#define MIN_DOWN_PAYMENT_PERCENT 20.0
+
+// Structure for Car
+typedef struct {
+    char VIN[MAX_VIN_LEN];          // Vehicle Identification Number (Primary Key)
+    char name[MAX_STR_LEN];         // Car Model Name
+    char color[MAX_STR_LEN];        // Color of Car
+    double price;                   // Price in lakhs of rupees
+    char fuel_type[MAX_STR_LEN];    // Petrol, Diesel, Electric, etc.
+    char car_type[MAX_STR_LEN];     // Type of car 
+} Car;
+
+// How a sold car was paid for
+typedef enum {
+    PAYMENT_CASH = 0,
+    PAYMENT_LOAN = 1
+} PaymentType;
+
+// Structure for Sold Car (56 bytes)
+typedef struct {
+    char VIN[MAX_VIN_LEN];
+    uint8_t payment_type;               // PaymentType
+    uint8_t loan_period_months;         // 36, 60 or 84 (0 for cash)
+    uint16_t interest_rate_bps;         // Annual rate in basis points (875 = 8.75%)
+    int32_t model_id;                   // Car model (see carpopularity.h), -1 if unknown
+    
+    // Loan details
+    double down_payment;
+    double loan_amount;
+    double monthly_emi;
+} SoldCar;
+
+// Structure for Customer (72 bytes, name and address live in the string heap)
+typedef struct {
+    double actual_aoumnt_paid;
+    StrRef name;                        // See customer_name()
+    StrRef address;                     // See customer_address()
+    int32_t purchase_date;              // Days since 1970-01-01, see date_to_days()
+    char car_VIN[MAX_VIN_LEN];
+    char mobile[MAX_MOBILE_LEN];
+    char reg_number[MAX_REG_NUM_LEN];
+    //EMI field for range search
+    uint8_t loan_months;
+} Customer;
+
+// Structure for Sales Person
+typedef struct {
+    int id;
+    char name[MAX_STR_LEN];
+    double target_sales;          // Monthly target in lakhs
+    double achieved_sales;        // Achieved in lakhs
+    double commission;            // Calculated commission
+    
+    // Trees for customers and sold cars for this sales person
+    BPlusTree* customer_tree;
+    BPlusTree* sold_car_tree;
+} SalesPerson;
+
+// Structure for one month of showroom sales (ledger bucket)
+typedef struct {
+    int month;
+    int year;
+    int sales_count;
+    double sales_value;
+} MonthlySales;
+
+// Space-Saving counter for one car model inside a day's sketch
+typedef struct {
+    int model_id;
+    int count;                      // Estimated sales, never below the true count
+    int error;                      // How much of count may belong to evicted models
+} HeavyHitter;
+
+#define POPULARITY_WINDOW_DAYS 30
+#define POPULARITY_SKETCH_SIZE 16    // Counters kept per day
+
+// One day of sales as a Space-Saving heavy-hitter summary
+typedef struct {
+    int day;                        // Days since 1970-01-01, -1 while unused
+    int used;
+    HeavyHitter counters[POPULARITY_SKETCH_SIZE];
+} DaySketch;
+
+// Ring buffer of the last POPULARITY_WINDOW_DAYS day sketches
+typedef struct {
+    int latest_day;
+    DaySketch days[POPULARITY_WINDOW_DAYS];
+} PopularityWindow;
+
+// Tables of a showroom, each saved to its own snapshot segment (see snapshot.h)
+#define SHOWROOM_SALESPERSONS 0
+#define SHOWROOM_CARS 1
+#define SHOWROOM_SALES 2                // Sold cars, each salesperson's sales and customers
+#define SHOWROOM_TABLE_COUNT 3
+#define SHOWROOM_DIRTY(table) (1u << (table))
+#define SHOWROOM_DIRTY_ALL ((1u << SHOWROOM_TABLE_COUNT) - 1)
+#define ARCHIVE_MAX_RUNS 8              // Archive runs a showroom can have (see archive.h)
+
+// Structure for Showroom
+typedef struct {
+    int id;                         // Unique Showroom ID
+    char name[MAX_STR_LEN];
+    char location[MAX_STR_LEN];
+    char contact[MAX_MOBILE_LEN];
+    
+    // Trees
+    BPlusTree* available_cars;
+    BPlusTree* sold_cars;
+    BPlusTree* sales_persons;
+    BPlusTree* monthly_sales;       // Sales ledger keyed by (year, month)
+    
+    // Salespersons ranked by achieved sales (see leaderboard.h)
+    SalesPerson** leaderboard;
+    int leaderboard_count;
+    int leaderboard_capacity;
+    
+    // Recent model popularity (see popularitywindow.h), NULL until the first sale
+    PopularityWindow* popularity_window;
+    
+    int total_available_cars;
+    int total_sold_cars;
+    
+    // Tables changed since the last save, and the segment each table was last saved to
+    unsigned int dirty;
+    uint32_t segment_generation[SHOWROOM_TABLE_COUNT];
+    uint32_t archive_runs[ARCHIVE_MAX_RUNS];   // Segments holding its archived sales, newest first (see archive.h)
+    int archive_run_count;
+    int snapshot_state;             // SNAPSHOT_* flags for what is not loaded yet, 0 once loaded (see snapshot.h)
+    unsigned int spilled;           // Tables written to the spill directory when evicted (SHOWROOM_DIRTY bits)
+    unsigned long last_used;        // Lookup count at the last lookup, for eviction
+} Showroom;
+
+// Function prototypes for B+ tree operations
+int compareInt(const void* a, const void* b);
+int compareStr(const void* a, const void* b);
+void printInt(const void* data);
+void printStr(const void* data);
+void* cloneInt(const void* data);
+void* cloneStr(const void* data);
+void freeInt(void* data);
+void freeStr(void* data);
+
+// Car related functions
+int compareVIN(const void* a, const void* b);
+void printCar(const void* data);
+void* cloneCar(const void* data);
+void freeCar(void* data);
+
+// SoldCar related functions
+void printSoldCar(const void* data);
+void* cloneSoldCar(const void* data);
+void freeSoldCar(void* data);
+
+// Customer related functions
+int compareCustomerByEMI(const void* a, const void* b); //need compare
+void printCustomer(const void* data);
+void* cloneCustomer(const void* data);
+void freeCustomer(void* data);
+
+// Compact record helpers
+const char* customer_name(const Customer* customer);
+const char* customer_address(const Customer* customer);
+const char* payment_type_name(int payment_type);
+int parse_payment_type(const char* text);
+int date_to_days(int day, int month, int year);
+int valid_date(int day, int month, int year);    // 0 before 1970, after 9999 or impossible
+void days_to_date(int days, int* day, int* month, int* year);
+int today_days();                       // Local date, in days like date_to_days()
+
+// Command output: everything a command prints goes through out_printf, to stdout or, on a server
+// worker, into the reply of the request it runs (see server.h). Set per thread, so background
+// threads always print to stdout.
+int out_printf(const char* format, ...);
+void set_command_output(FILE* output);  // For the calling thread, NULL for stdout
+
+// SalesPerson related functions
+int compareSalesPersonID(const void* a, const void* b);
+void printSalesPerson(const void* data);
+void* cloneSalesPerson(const void* data);
+void freeSalesPerson(void* data);
+
+// MonthlySales related functions
+int compareMonthlySales(const void* a, const void* b);
+void printMonthlySales(const void* data);
+void* cloneMonthlySales(const void* data);
+void freeMonthlySales(void* data);
+
+// Showroom related functions
+int compareShowroomID(const void* a, const void* b);
+void printShowroom(const void* data);
+void* cloneShowroom(const void* data);
+void freeShowroom(void* data);
+
+
 #endif
\ No newline at end of file
@@ -0,0 +1,378 @@
+#include "inventorysnapshot.h"
+#include "essentialfunction.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define INVENTORY_USE_SSE2 1
+#endif
+
+#define INVENTORY_MAX_IDS 65536          // Ids must fit in uint16_t
+#define DICTIONARY_INITIAL_SLOTS 64
+
+// Bumped on every inventory change; the snapshot is stale when its version differs
+static unsigned long inventory_version = 1;
+static InventorySnapshot* snapshot = NULL;
+
+void inventory_changed() {
+    inventory_version++;
+}
+
+// Hash function for dictionary strings
+static unsigned int hash_value(const char* str) {
+    unsigned int hash = 0;
+    while (*str) {
+        hash = (hash * 31) + (unsigned char)(*str++);
+    }
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3b;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+static void dictionary_free(StringDictionary* dict) {
+    for (int i = 0; i < dict->count; i++) {
+        free(dict->values[i]);
+    }
+    free(dict->values);
+    free(dict->hashes);
+    free(dict->slots);
+    memset(dict, 0, sizeof(StringDictionary));
+}
+
+// Rebuild the probe table at a new size from the cached hashes
+static int dictionary_resize(StringDictionary* dict, int slot_capacity) {
+    int* slots = (int*)malloc(slot_capacity * sizeof(int));
+    if (!slots) return 0;
+    for (int i = 0; i < slot_capacity; i++) {
+        slots[i] = -1;
+    }
+    for (int id = 0; id < dict->count; id++) {
+        unsigned int i = dict->hashes[id] & (slot_capacity - 1);
+        while (slots[i] != -1) {
+            i = (i + 1) & (slot_capacity - 1);
+        }
+        slots[i] = id;
+    }
+    free(dict->slots);
+    dict->slots = slots;
+    dict->slot_capacity = slot_capacity;
+    return 1;
+}
+
+// Return the id of a value, adding it if new; -1 (reported) when it cannot be added
+static int dictionary_intern(StringDictionary* dict, const char* value) {
+    unsigned int hash = hash_value(value);
+
+    if (dict->slots) {
+        unsigned int mask = dict->slot_capacity - 1;
+        for (unsigned int i = hash & mask; dict->slots[i] != -1; i = (i + 1) & mask) {
+            int id = dict->slots[i];
+            if (dict->hashes[id] == hash && strcmp(dict->values[id], value) == 0) {
+                return id;
+            }
+        }
+    }
+
+    if (dict->count >= INVENTORY_MAX_IDS) {
+        out_printf("Inventory snapshot: more than %d distinct values in one column\n", INVENTORY_MAX_IDS);
+        return -1;
+    }
+
+    if ((dict->count + 1) * 10 > dict->slot_capacity * 7 &&
+        !dictionary_resize(dict, dict->slot_capacity ? dict->slot_capacity * 2 : DICTIONARY_INITIAL_SLOTS)) {
+        out_printf("Memory allocation failed for inventory snapshot\n");
+        return -1;
+    }
+
+    if (dict->count == dict->capacity) {
+        int new_capacity = dict->capacity ? dict->capacity * 2 : DICTIONARY_INITIAL_SLOTS;
+        char** values = (char**)realloc(dict->values, new_capacity * sizeof(char*));
+        if (values) dict->values = values;
+        unsigned int* hashes = (unsigned int*)realloc(dict->hashes, new_capacity * sizeof(unsigned int));
+        if (hashes) dict->hashes = hashes;
+        if (!values || !hashes) {
+            out_printf("Memory allocation failed for inventory snapshot\n");
+            return -1;
+        }
+        dict->capacity = new_capacity;
+    }
+
+    char* copy = (char*)malloc(strlen(value) + 1);
+    if (!copy) {
+        out_printf("Memory allocation failed for inventory snapshot\n");
+        return -1;
+    }
+    strcpy(copy, value);
+
+    int id = dict->count++;
+    dict->values[id] = copy;
+    dict->hashes[id] = hash;
+
+    unsigned int mask = dict->slot_capacity - 1;
+    unsigned int i = hash & mask;
+    while (dict->slots[i] != -1) {
+        i = (i + 1) & mask;
+    }
+    dict->slots[i] = id;
+    return id;
+}
+
+// Grow every column to hold at least one more row
+static int ensure_rows(InventorySnapshot* snap) {
+    if (snap->count < snap->capacity) return 1;
+
+    int new_capacity = snap->capacity ? snap->capacity * 2 : 256;
+    double* price = (double*)realloc(snap->price, new_capacity * sizeof(double));
+    if (price) snap->price = price;
+    uint16_t* fuel_id = (uint16_t*)realloc(snap->fuel_id, new_capacity * sizeof(uint16_t));
+    if (fuel_id) snap->fuel_id = fuel_id;
+    uint16_t* type_id = (uint16_t*)realloc(snap->type_id, new_capacity * sizeof(uint16_t));
+    if (type_id) snap->type_id = type_id;
+    uint16_t* model_id = (uint16_t*)realloc(snap->model_id, new_capacity * sizeof(uint16_t));
+    if (model_id) snap->model_id = model_id;
+    int* showroom_id = (int*)realloc(snap->showroom_id, new_capacity * sizeof(int));
+    if (showroom_id) snap->showroom_id = showroom_id;
+    char (*vin)[MAX_VIN_LEN] = (char (*)[MAX_VIN_LEN])realloc(snap->vin, new_capacity * sizeof(*vin));
+    if (vin) snap->vin = vin;
+
+    if (!price || !fuel_id || !type_id || !model_id || !showroom_id || !vin) {
+        out_printf("Memory allocation failed for inventory snapshot\n");
+        return 0;
+    }
+    snap->capacity = new_capacity;
+    return 1;
+}
+
+// 0 if the row could not be added
+static int append_car(InventorySnapshot* snap, int showroom_id, const Car* car) {
+    if (!ensure_rows(snap)) return 0;
+
+    int fuel_id = dictionary_intern(&snap->fuels, car->fuel_type);
+    int type_id = dictionary_intern(&snap->types, car->car_type);
+    int model_id = dictionary_intern(&snap->models, car->name);
+    if (fuel_id < 0 || type_id < 0 || model_id < 0) return 0;
+
+    int row = snap->count++;
+    snap->price[row] = car->price;
+    snap->fuel_id[row] = (uint16_t)fuel_id;
+    snap->type_id[row] = (uint16_t)type_id;
+    snap->model_id[row] = (uint16_t)model_id;
+    snap->showroom_id[row] = showroom_id;
+    memcpy(snap->vin[row], car->VIN, MAX_VIN_LEN);
+    return 1;
+}
+
+// Walk every showroom's available cars into fresh columns; 0 if a car could not be added
+static int rebuild_snapshot(InventorySnapshot* snap) {
+    snap->count = 0;
+    dictionary_free(&snap->fuels);
+    dictionary_free(&snap->types);
+    dictionary_free(&snap->models);
+
+    if (showroom_tree && showroom_tree->root) {
+        BTreeNode* showroom_node = showroom_tree->root;
+        while (!showroom_node->is_leaf) {
+            showroom_node = showroom_node->children[0];
+        }
+
+        while (showroom_node) {
+            for (int i = 0; i < showroom_node->num_keys; i++) {
+                Showroom* showroom = (Showroom*)showroom_node->keys[i].key;
+                if (!showroom->available_cars || !showroom->available_cars->root) continue;
+
+                BTreeNode* car_node = showroom->available_cars->root;
+                while (!car_node->is_leaf) {
+                    car_node = car_node->children[0];
+                }
+
+                while (car_node) {
+                    for (int k = 0; k < car_node->num_keys; k++) {
+                        if (!append_car(snap, showroom->id, (Car*)car_node->keys[k].key)) return 0;
+                    }
+                    car_node = car_node->leaf_link.next;
+                }
+            }
+            showroom_node = showroom_node->leaf_link.next;
+        }
+    }
+
+    snap->version = inventory_version;
+    return 1;
+}
+
+InventorySnapshot* inventory_snapshot() {
+    if (!snapshot) {
+        snapshot = (InventorySnapshot*)calloc(1, sizeof(InventorySnapshot));
+        if (!snapshot) {
+            out_printf("Memory allocation failed for inventory snapshot\n");
+            return NULL;
+        }
+    }
+    // A failed rebuild leaves the snapshot stale, the next call tries again
+    if (snapshot->version != inventory_version && !rebuild_snapshot(snapshot)) {
+        out_printf("Inventory snapshot could not be built.\n");
+        return NULL;
+    }
+    return snapshot;
+}
+
+int inventory_snapshot_current() {
+    return snapshot && snapshot->version == inventory_version;
+}
+
+// Function to free the inventory snapshot memory
+void free_inventory_snapshot() {
+    if (!snapshot) return;
+    free(snapshot->price);
+    free(snapshot->fuel_id);
+    free(snapshot->type_id);
+    free(snapshot->model_id);
+    free(snapshot->showroom_id);
+    free(snapshot->vin);
+    dictionary_free(&snapshot->fuels);
+    dictionary_free(&snapshot->types);
+    dictionary_free(&snapshot->models);
+    free(snapshot);
+    snapshot = NULL;
+}
+
+// Number of cars priced strictly below threshold
+int inventory_count_price_below(const InventorySnapshot* snap, double threshold) {
+    const double* price = snap->price;
+    int n = snap->count;
+    int i = 0;
+    long long total = 0;
+
+#ifdef INVENTORY_USE_SSE2
+    __m128d limit = _mm_set1_pd(threshold);
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+
+    // A true comparison lane is all ones (-1), so subtracting it counts the match
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_sub_epi64(acc0, _mm_castpd_si128(_mm_cmplt_pd(_mm_loadu_pd(price + i), limit)));
+        acc1 = _mm_sub_epi64(acc1, _mm_castpd_si128(_mm_cmplt_pd(_mm_loadu_pd(price + i + 2), limit)));
+    }
+
+    long long lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, _mm_add_epi64(acc0, acc1));
+    total = lanes[0] + lanes[1];
+#endif
+
+    for (; i < n; i++) {
+        total += price[i] < threshold;
+    }
+    return (int)total;
+}
+
+// Sum of prices over rows whose id column equals id; *matched gets the row count
+double inventory_sum_price_where(const InventorySnapshot* snap, const uint16_t* ids, uint16_t id, int* matched) {
+    const double* price = snap->price;
+    int n = snap->count;
+    int i = 0;
+    double sum = 0;
+    long long count = 0;
+
+#ifdef INVENTORY_USE_SSE2
+    __m128i target = _mm_set1_epi16((short)id);
+    __m128d sum_lo = _mm_setzero_pd();
+    __m128d sum_hi = _mm_setzero_pd();
+    __m128i count_acc = _mm_setzero_si128();
+
+    // Compare 8 ids at once, then widen each 16-bit mask lane to cover one 64-bit price
+    for (; i + 8 <= n; i += 8) {
+        __m128i eq = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)(ids + i)), target);
+        if (_mm_movemask_epi8(eq) == 0) continue;
+
+        __m128i eq32_lo = _mm_unpacklo_epi16(eq, eq);
+        __m128i eq32_hi = _mm_unpackhi_epi16(eq, eq);
+        __m128i masks[4] = {
+            _mm_unpacklo_epi32(eq32_lo, eq32_lo),
+            _mm_unpackhi_epi32(eq32_lo, eq32_lo),
+            _mm_unpacklo_epi32(eq32_hi, eq32_hi),
+            _mm_unpackhi_epi32(eq32_hi, eq32_hi)
+        };
+
+        sum_lo = _mm_add_pd(sum_lo, _mm_and_pd(_mm_castsi128_pd(masks[0]), _mm_loadu_pd(price + i)));
+        sum_hi = _mm_add_pd(sum_hi, _mm_and_pd(_mm_castsi128_pd(masks[1]), _mm_loadu_pd(price + i + 2)));
+        sum_lo = _mm_add_pd(sum_lo, _mm_and_pd(_mm_castsi128_pd(masks[2]), _mm_loadu_pd(price + i + 4)));
+        sum_hi = _mm_add_pd(sum_hi, _mm_and_pd(_mm_castsi128_pd(masks[3]), _mm_loadu_pd(price + i + 6)));
+
+        for (int m = 0; m < 4; m++) {
+            count_acc = _mm_sub_epi64(count_acc, masks[m]);
+        }
+    }
+
+    double sums[2];
+    long long counts[2];
+    _mm_storeu_pd(sums, _mm_add_pd(sum_lo, sum_hi));
+    _mm_storeu_si128((__m128i*)counts, count_acc);
+    sum = sums[0] + sums[1];
+    count = counts[0] + counts[1];
+#endif
+
+    for (; i < n; i++) {
+        if (ids[i] == id) {
+            sum += price[i];
+            count++;
+        }
+    }
+
+    if (matched) *matched = (int)count;
+    return sum;
+}
+
+// Row of the cheapest car (first one on ties)
+int inventory_min_price_row(const InventorySnapshot* snap) {
+    const double* price = snap->price;
+    int n = snap->count;
+    if (n == 0) return -1;
+
+    int i = 0;
+    double lowest = price[0];
+
+#ifdef INVENTORY_USE_SSE2
+    if (n >= 4) {
+        __m128d min0 = _mm_loadu_pd(price);
+        __m128d min1 = _mm_loadu_pd(price + 2);
+        for (i = 4; i + 4 <= n; i += 4) {
+            min0 = _mm_min_pd(min0, _mm_loadu_pd(price + i));
+            min1 = _mm_min_pd(min1, _mm_loadu_pd(price + i + 2));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_min_pd(min0, min1));
+        lowest = lanes[0] < lanes[1] ? lanes[0] : lanes[1];
+    }
+#endif
+
+    for (; i < n; i++) {
+        if (price[i] < lowest) lowest = price[i];
+    }
+
+    for (i = 0; i < n; i++) {
+        if (price[i] == lowest) return i;
+    }
+    return 0;
+}
+
+// Per-group price totals and counts for an id column with `groups` distinct ids
+void inventory_group_price_by(const InventorySnapshot* snap, const uint16_t* ids, int groups,
+                              double* sums, int* counts) {
+    for (int g = 0; g < groups; g++) {
+        sums[g] = 0;
+        counts[g] = 0;
+    }
+
+    // Few groups: one vector pass per group beats scattered updates
+    if (groups <= 8) {
+        for (int g = 0; g < groups; g++) {
+            sums[g] = inventory_sum_price_where(snap, ids, (uint16_t)g, &counts[g]);
+        }
+        return;
+    }
+
+    for (int i = 0; i < snap->count; i++) {
+        sums[ids[i]] += snap->price[i];
+        counts[ids[i]]++;
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef INVENTORY_SNAPSHOT_H
+#define INVENTORY_SNAPSHOT_H
+
+#include <stdint.h>
+#include "functionpointer.h"
+
+// Column-wise copy of every available car across all showrooms, for fleet analytics.
+// Row i of every column describes the same car. The snapshot is rebuilt on demand
+// whenever inventory_changed() has been called since the last build.
+
+// Interned strings for one categorical column; ids are dense and start at 0
+typedef struct {
+    char** values;
+    unsigned int* hashes;
+    int count;
+    int capacity;
+    int* slots;                 // Open-addressing table of ids, -1 for empty
+    int slot_capacity;
+} StringDictionary;
+
+typedef struct {
+    int count;
+    int capacity;
+
+    // Columns
+    double* price;
+    uint16_t* fuel_id;
+    uint16_t* type_id;
+    uint16_t* model_id;
+    int* showroom_id;
+    char (*vin)[MAX_VIN_LEN];   // Fixed-width VIN keys
+
+    // Dictionaries behind the id columns
+    StringDictionary fuels;
+    StringDictionary types;
+    StringDictionary models;
+
+    unsigned long version;      // inventory_version this snapshot was built from
+} InventorySnapshot;
+
+// Maintenance
+void inventory_changed();                              // Call after any change to an available_cars tree
+InventorySnapshot* inventory_snapshot();               // Current snapshot, rebuilt if stale
+int inventory_snapshot_current();                      // Whether inventory_snapshot() needs no rebuild
+void free_inventory_snapshot();
+
+// Kernels (SSE2 when available, scalar otherwise)
+int inventory_count_price_below(const InventorySnapshot* snapshot, double threshold);
+double inventory_sum_price_where(const InventorySnapshot* snapshot, const uint16_t* ids, uint16_t id, int* matched);
+int inventory_min_price_row(const InventorySnapshot* snapshot);     // -1 when empty
+void inventory_group_price_by(const InventorySnapshot* snapshot, const uint16_t* ids, int groups,
+                              double* sums, int* counts);
+
+#endif
@@ -0,0 +1,681 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "ioengine.h"
+#ifdef _WIN32
+#include <io.h>
+#define IO_OPEN_FLAGS _O_BINARY
+#else
+#include <pthread.h>
+#include <unistd.h>
+#define IO_OPEN_FLAGS 0
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#ifdef __NR_io_uring_setup
+#define IO_HAVE_URING 1
+#endif
+#endif
+#endif
+
+#define IO_ENGINE_SYNC    0
+#define IO_ENGINE_THREADS 1
+#define IO_ENGINE_URING   2
+
+// ---------------------------------------------------------------------------
+// Requests
+// ---------------------------------------------------------------------------
+
+typedef struct IoRequest IoRequest;
+typedef void (*IoCompleteFunc)(IoRequest* request);
+
+// One read or write of `length` bytes at `offset`; short transfers are continued until it is
+// all done. `complete` runs on the waiting thread with `result` 0 or a negative errno.
+struct IoRequest {
+    int fd;
+    int write;
+    char* buffer;
+    size_t length;
+    uint64_t offset;
+    size_t done;
+    int result;
+    IoCompleteFunc complete;
+    void* owner;
+    IoRequest* next;
+#ifdef IO_HAVE_URING
+    struct iovec vector;
+#endif
+};
+
+// A FIFO of requests linked through `next`
+typedef struct {
+    IoRequest* head;
+    IoRequest* tail;
+} RequestQueue;
+
+static void push_request(RequestQueue* queue, IoRequest* request) {
+    request->next = NULL;
+    if (queue->tail) {
+        queue->tail->next = request;
+    } else {
+        queue->head = request;
+    }
+    queue->tail = request;
+}
+
+static IoRequest* pop_request(RequestQueue* queue) {
+    IoRequest* request = queue->head;
+    if (request) {
+        queue->head = request->next;
+        if (!queue->head) queue->tail = NULL;
+    }
+    return request;
+}
+
+// Run the rest of a request with blocking calls
+static void transfer_sync(IoRequest* request) {
+    while (request->done < request->length) {
+        size_t length = request->length - request->done;
+        char* buffer = request->buffer + request->done;
+        uint64_t offset = request->offset + request->done;
+        long moved;
+#ifdef _WIN32
+        if (length > 0x40000000) length = 0x40000000;
+        if (_lseeki64(request->fd, (__int64)offset, SEEK_SET) < 0) {
+            moved = -1;
+        } else {
+            moved = request->write ? _write(request->fd, buffer, (unsigned int)length)
+                                   : _read(request->fd, buffer, (unsigned int)length);
+        }
+#else
+        moved = request->write ? (long)pwrite(request->fd, buffer, length, (off_t)offset)
+                               : (long)pread(request->fd, buffer, length, (off_t)offset);
+#endif
+        if (moved < 0 && errno == EINTR) continue;
+        if (moved <= 0) {
+            request->result = moved < 0 ? -errno : -EIO;     // 0: the file is shorter than expected
+            return;
+        }
+        request->done += (size_t)moved;
+    }
+    request->result = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Engine: requests are submitted, and completed one at a time by engine_reap()
+// ---------------------------------------------------------------------------
+
+static int engine_kind = -1;
+static long engine_pid = 0;
+static int in_flight = 0;              // Submitted and not yet completed
+static RequestQueue finished = {NULL, NULL};    // Completed here rather than in the ring or the pool
+
+#ifndef _WIN32
+static pthread_mutex_t pool_lock;
+static pthread_cond_t pool_work;
+static pthread_cond_t pool_done;
+static RequestQueue pool_queue;
+static RequestQueue pool_finished;
+
+static void* pool_worker(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&pool_lock);
+    for (;;) {
+        IoRequest* request;
+        while (!(request = pop_request(&pool_queue))) {
+            pthread_cond_wait(&pool_work, &pool_lock);
+        }
+        pthread_mutex_unlock(&pool_lock);
+        transfer_sync(request);
+        pthread_mutex_lock(&pool_lock);
+        push_request(&pool_finished, request);
+        pthread_cond_signal(&pool_done);
+    }
+    return NULL;
+}
+
+static int start_pool() {
+    pthread_mutex_init(&pool_lock, NULL);
+    pthread_cond_init(&pool_work, NULL);
+    pthread_cond_init(&pool_done, NULL);
+    pool_queue.head = pool_queue.tail = NULL;
+    pool_finished.head = pool_finished.tail = NULL;
+
+    // The workers live as long as the process; waiting for work they hold nothing
+    int started = 0;
+    for (int i = 0; i < IO_THREADS; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, pool_worker, NULL) != 0) break;
+        pthread_detach(thread);
+        started++;
+    }
+    return started > 0;
+}
+#endif
+
+#ifdef IO_HAVE_URING
+static struct {
+    int fd;
+    unsigned entries;
+    unsigned in_kernel;                 // Requests the kernel holds
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    struct io_uring_sqe* sqes;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+    RequestQueue waiting;               // Submitted while the ring was full
+} ring;
+
+static int start_ring() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, IO_QUEUE_DEPTH, &params);
+    if (fd < 0) return 0;
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    size_t sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    int single_map = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_map && cq_size > sq_size) sq_size = cq_size;
+
+    char* sq = (char*)mmap(NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    char* cq = single_map ? sq : (char*)mmap(NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                             fd, IORING_OFF_CQ_RING);
+    void* sqes = mmap(NULL, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED) {
+        if (sq != MAP_FAILED) munmap(sq, sq_size);
+        if (!single_map && cq != MAP_FAILED) munmap(cq, cq_size);
+        if (sqes != MAP_FAILED) munmap(sqes, sqes_size);
+        close(fd);
+        return 0;
+    }
+
+    ring.fd = fd;
+    ring.entries = params.sq_entries;
+    ring.in_kernel = 0;
+    ring.sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring.sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring.sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring.sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring.sqes = (struct io_uring_sqe*)sqes;
+    ring.cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring.cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring.cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    ring.waiting.head = ring.waiting.tail = NULL;
+    return 1;
+}
+
+// Move waiting requests into the ring, as many as it has room for
+static void ring_submit() {
+    unsigned tail = *ring.sq_tail;
+    unsigned queued = 0;
+    while (ring.in_kernel + queued < ring.entries && ring.waiting.head) {
+        IoRequest* request = pop_request(&ring.waiting);
+        unsigned index = (tail + queued) & *ring.sq_mask;
+        struct io_uring_sqe* sqe = &ring.sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        request->vector.iov_base = request->buffer + request->done;
+        request->vector.iov_len = request->length - request->done;
+        sqe->opcode = request->write ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe->fd = request->fd;
+        sqe->addr = (uint64_t)(uintptr_t)&request->vector;
+        sqe->len = 1;
+        sqe->off = request->offset + request->done;
+        sqe->user_data = (uint64_t)(uintptr_t)request;
+        ring.sq_array[index] = index;
+        queued++;
+    }
+    if (queued == 0) return;
+    __atomic_store_n(ring.sq_tail, tail + queued, __ATOMIC_RELEASE);
+
+    while (queued > 0) {
+        int taken = (int)syscall(__NR_io_uring_enter, ring.fd, queued, 0, 0, NULL, 0);
+        if (taken < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY)) continue;
+        if (taken <= 0) break;
+        ring.in_kernel += (unsigned)taken;
+        queued -= (unsigned)taken;
+    }
+
+    // The kernel refused the rest: take them back and run them here
+    while (queued > 0) {
+        unsigned last = (*ring.sq_tail - 1) & *ring.sq_mask;
+        IoRequest* request = (IoRequest*)(uintptr_t)ring.sqes[last].user_data;
+        __atomic_store_n(ring.sq_tail, *ring.sq_tail - 1, __ATOMIC_RELEASE);
+        transfer_sync(request);
+        push_request(&finished, request);
+        queued--;
+    }
+}
+
+// Wait for one request to leave the kernel; returns it with the kernel's result
+static IoRequest* ring_wait(int* result) {
+    for (;;) {
+        unsigned head = *ring.cq_head;
+        if (head != __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE)) {
+            struct io_uring_cqe* cqe = &ring.cqes[head & *ring.cq_mask];
+            IoRequest* request = (IoRequest*)(uintptr_t)cqe->user_data;
+            *result = cqe->res;
+            __atomic_store_n(ring.cq_head, head + 1, __ATOMIC_RELEASE);
+            ring.in_kernel--;
+            return request;
+        }
+        syscall(__NR_io_uring_enter, ring.fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+    }
+}
+#endif
+
+// A forked child shares the parent's ring and has none of its threads: it starts over
+static void engine_start() {
+#ifdef _WIN32
+    engine_kind = IO_ENGINE_SYNC;
+#else
+    long pid = (long)getpid();
+    if (engine_kind >= 0 && engine_pid == pid) return;
+    engine_pid = pid;
+    in_flight = 0;
+    finished.head = finished.tail = NULL;
+
+    const char* forced = getenv(IO_ENGINE_ENV);
+    int threads_only = forced && strcmp(forced, "threads") == 0;
+    engine_kind = IO_ENGINE_SYNC;
+#ifdef IO_HAVE_URING
+    if (!threads_only && start_ring()) {
+        engine_kind = IO_ENGINE_URING;
+        return;
+    }
+#endif
+    (void)threads_only;
+    if (start_pool()) engine_kind = IO_ENGINE_THREADS;
+#endif
+}
+
+const char* io_engine_name() {
+    engine_start();
+    if (engine_kind == IO_ENGINE_URING) return "io_uring";
+    if (engine_kind == IO_ENGINE_THREADS) return "threads";
+    return "sync";
+}
+
+static void engine_submit(IoRequest* request) {
+    engine_start();
+    request->done = 0;
+    request->result = 0;
+    in_flight++;
+
+#ifdef IO_HAVE_URING
+    if (engine_kind == IO_ENGINE_URING) {
+        push_request(&ring.waiting, request);
+        ring_submit();
+        return;
+    }
+#endif
+#ifndef _WIN32
+    if (engine_kind == IO_ENGINE_THREADS) {
+        pthread_mutex_lock(&pool_lock);
+        push_request(&pool_queue, request);
+        pthread_cond_signal(&pool_work);
+        pthread_mutex_unlock(&pool_lock);
+        return;
+    }
+#endif
+    transfer_sync(request);
+    push_request(&finished, request);
+}
+
+// Complete one request, waiting for it if need be; 0 if none is in flight
+static int engine_reap() {
+    if (in_flight == 0) return 0;
+
+    IoRequest* request = pop_request(&finished);
+#ifdef IO_HAVE_URING
+    while (!request && engine_kind == IO_ENGINE_URING) {
+        int result;
+        request = ring_wait(&result);
+        if (result > 0) {
+            request->done += (size_t)result;
+            if (request->done < request->length) {
+                push_request(&ring.waiting, request);     // Short transfer: the rest goes back in
+                request = NULL;
+            }
+        } else if (result == -EINVAL || result == -EOPNOTSUPP) {
+            transfer_sync(request);                     // The kernel cannot run it, this thread can
+        } else if (result == -EINTR || result == -EAGAIN) {
+            push_request(&ring.waiting, request);
+            request = NULL;
+        } else {
+            request->result = result < 0 ? result : -EIO;
+        }
+        ring_submit();
+        if (!request) request = pop_request(&finished);
+    }
+#endif
+#ifndef _WIN32
+    if (!request && engine_kind == IO_ENGINE_THREADS) {
+        pthread_mutex_lock(&pool_lock);
+        while (!(request = pop_request(&pool_finished))) {
+            pthread_cond_wait(&pool_done, &pool_lock);
+        }
+        pthread_mutex_unlock(&pool_lock);
+    }
+#endif
+    if (!request) return 0;
+
+    in_flight--;
+    request->complete(request);     // May free the request
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Reading whole files
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    IoReadBatch* batch;
+    const char* path;
+    int fd;
+    char* data;
+    size_t size;
+    IoRequest* requests;
+    size_t read_ahead;      // What the file adds to the batch's unclaimed bytes
+    int chunks_left;
+    int failed;
+    int handed_out;
+} ReadFile;
+
+struct IoReadBatch {
+    ReadFile* files;
+    int count;
+    int next_open;          // Files before this one have been started
+    int open_files;         // Started and not yet complete
+    size_t unclaimed;       // Bytes of started files not handed out yet
+    int* ready;             // Complete files in completion order
+    int ready_head;
+    int ready_tail;
+};
+
+static void file_ready(ReadFile* file) {
+    IoReadBatch* batch = file->batch;
+    batch->ready[batch->ready_tail++] = (int)(file - batch->files);
+}
+
+static void read_chunk_done(IoRequest* request) {
+    ReadFile* file = (ReadFile*)request->owner;
+    if (request->result != 0) file->failed = 1;
+    if (--file->chunks_left > 0) return;
+
+    close(file->fd);
+    free(file->requests);
+    file->requests = NULL;
+    file->batch->open_files--;
+    file_ready(file);
+}
+
+// Open a file and queue reads for all of it; a file that cannot be read is ready at once
+static void start_file(IoReadBatch* batch, ReadFile* file) {
+    struct stat file_stat;
+    file->fd = open(file->path, O_RDONLY | IO_OPEN_FLAGS);
+    if (file->fd < 0 || fstat(file->fd, &file_stat) != 0) {
+        if (file->fd >= 0) close(file->fd);
+        file->failed = 1;
+        file_ready(file);
+        return;
+    }
+
+    file->size = (size_t)file_stat.st_size;
+    int chunks = (int)((file->size + IO_CHUNK_SIZE - 1) / IO_CHUNK_SIZE);
+    file->data = (char*)malloc(file->size ? file->size : 1);
+    file->requests = chunks ? (IoRequest*)calloc(chunks, sizeof(IoRequest)) : NULL;
+    if (!file->data || (chunks && !file->requests)) {
+        close(file->fd);
+        free(file->requests);
+        file->requests = NULL;
+        file->failed = 1;
+        file_ready(file);
+        return;
+    }
+    if (chunks == 0) {
+        close(file->fd);
+        file_ready(file);
+        return;
+    }
+
+    file->read_ahead = file->size;
+    batch->unclaimed += file->size;
+    batch->open_files++;
+    file->chunks_left = chunks;
+    for (int i = 0; i < chunks; i++) {
+        IoRequest* request = &file->requests[i];
+        size_t offset = (size_t)i * IO_CHUNK_SIZE;
+        request->fd = file->fd;
+        request->write = 0;
+        request->buffer = file->data + offset;
+        request->length = file->size - offset < IO_CHUNK_SIZE ? file->size - offset : IO_CHUNK_SIZE;
+        request->offset = offset;
+        request->complete = read_chunk_done;
+        request->owner = file;
+        engine_submit(request);
+    }
+}
+
+// Start files while there is room, but always keep at least one going
+static void start_more_files(IoReadBatch* batch) {
+    while (batch->next_open < batch->count &&
+           (batch->open_files == 0 ||
+            (batch->open_files < IO_OPEN_FILES && batch->unclaimed < IO_READ_AHEAD))) {
+        start_file(batch, &batch->files[batch->next_open++]);
+    }
+}
+
+IoReadBatch* io_read_files(const char* const* paths, int count) {
+    IoReadBatch* batch = (IoReadBatch*)calloc(1, sizeof(IoReadBatch));
+    if (!batch) return NULL;
+    batch->files = (ReadFile*)calloc(count > 0 ? count : 1, sizeof(ReadFile));
+    batch->ready = (int*)malloc((count > 0 ? count : 1) * sizeof(int));
+    if (!batch->files || !batch->ready) {
+        free(batch->files);
+        free(batch->ready);
+        free(batch);
+        return NULL;
+    }
+
+    batch->count = count;
+    for (int i = 0; i < count; i++) {
+        batch->files[i].batch = batch;
+        batch->files[i].path = paths[i];
+        batch->files[i].fd = -1;
+    }
+    engine_start();
+    start_more_files(batch);
+    return batch;
+}
+
+int io_next_file(IoReadBatch* batch, MappedFile* file) {
+    file->data = NULL;
+    file->size = 0;
+    file->mapped = 0;
+
+    start_more_files(batch);
+    while (batch->ready_head == batch->ready_tail) {
+        if (batch->open_files == 0 && batch->next_open == batch->count) return -1;
+        engine_reap();
+        start_more_files(batch);
+    }
+
+    int index = batch->ready[batch->ready_head++];
+    ReadFile* read = &batch->files[index];
+    batch->unclaimed -= read->read_ahead;
+    if (read->failed) {
+        free(read->data);
+    } else {
+        file->data = read->data;
+        file->size = read->size;
+    }
+    read->data = NULL;
+    read->handed_out = 1;
+    return index;
+}
+
+void io_read_finish(IoReadBatch* batch) {
+    if (!batch) return;
+    while (batch->open_files > 0) {
+        engine_reap();
+    }
+    for (int i = 0; i < batch->count; i++) {
+        free(batch->files[i].data);
+    }
+    free(batch->files);
+    free(batch->ready);
+    free(batch);
+}
+
+// ---------------------------------------------------------------------------
+// Writing files front to back
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint64_t offset;
+    size_t length;
+    unsigned char bytes[32];
+} WritePatch;
+
+typedef struct {
+    IoRequest request;
+    char* buffer;
+    int busy;
+} WriteSlot;
+
+struct IoWriteFile {
+    int fd;
+    uint64_t offset;                    // Where the next submitted buffer goes
+    WriteSlot slots[IO_WRITE_BUFFERS];
+    int current;                        // Slot being filled
+    int failed;
+    WritePatch* patches;
+    int patch_count;
+    int patch_capacity;
+};
+
+static void write_done(IoRequest* request) {
+    IoWriteFile* file = (IoWriteFile*)request->owner;
+    WriteSlot* slot = (WriteSlot*)request;     // The request is the slot's first member
+    if (request->result != 0) file->failed = 1;
+    slot->busy = 0;
+}
+
+IoWriteFile* io_write_open(const char* path, int exclusive) {
+    engine_start();
+    IoWriteFile* file = (IoWriteFile*)calloc(1, sizeof(IoWriteFile));
+    if (!file) return NULL;
+
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | IO_OPEN_FLAGS;
+    if (exclusive) flags |= O_EXCL;
+    file->fd = open(path, flags, 0666);
+    if (file->fd < 0) {
+        int error = errno;
+        free(file);
+        errno = error;
+        return NULL;
+    }
+    return file;
+}
+
+char* io_write_buffer(IoWriteFile* file) {
+    WriteSlot* slot = &file->slots[file->current];
+    while (slot->busy) {
+        engine_reap();
+    }
+    if (!slot->buffer) slot->buffer = (char*)malloc(IO_CHUNK_SIZE);
+
+    // Without memory for another buffer, wait for one already in use
+    for (int i = 0; !slot->buffer && i < IO_WRITE_BUFFERS; i++) {
+        WriteSlot* other = &file->slots[i];
+        if (!other->buffer) continue;
+        while (other->busy) {
+            engine_reap();
+        }
+        slot->buffer = other->buffer;
+        other->buffer = NULL;
+    }
+    return slot->buffer;
+}
+
+void io_write_submit(IoWriteFile* file, size_t used) {
+    if (used == 0) return;
+    WriteSlot* slot = &file->slots[file->current];
+    IoRequest* request = &slot->request;
+    request->fd = file->fd;
+    request->write = 1;
+    request->buffer = slot->buffer;
+    request->length = used;
+    request->offset = file->offset;
+    request->complete = write_done;
+    request->owner = file;
+    slot->busy = 1;
+    file->offset += used;
+    file->current = (file->current + 1) % IO_WRITE_BUFFERS;
+    engine_submit(request);
+}
+
+void io_write_patch(IoWriteFile* file, uint64_t offset, const void* data, size_t length) {
+    if (length > sizeof(file->patches[0].bytes)) {
+        file->failed = 1;
+        return;
+    }
+    if (file->patch_count == file->patch_capacity) {
+        int capacity = file->patch_capacity ? file->patch_capacity * 2 : 8;
+        WritePatch* grown = (WritePatch*)realloc(file->patches, capacity * sizeof(WritePatch));
+        if (!grown) {
+            file->failed = 1;
+            return;
+        }
+        file->patches = grown;
+        file->patch_capacity = capacity;
+    }
+    WritePatch* patch = &file->patches[file->patch_count++];
+    patch->offset = offset;
+    patch->length = length;
+    memcpy(patch->bytes, data, length);
+}
+
+int io_write_close(IoWriteFile* file) {
+    for (int i = 0; i < IO_WRITE_BUFFERS; i++) {
+        while (file->slots[i].busy) {
+            engine_reap();
+        }
+    }
+
+    // Every write has landed, nothing can overwrite the patches any more
+    for (int i = 0; i < file->patch_count && !file->failed; i++) {
+        IoRequest request;
+        memset(&request, 0, sizeof(request));
+        request.fd = file->fd;
+        request.write = 1;
+        request.buffer = (char*)file->patches[i].bytes;
+        request.length = file->patches[i].length;
+        request.offset = file->patches[i].offset;
+        transfer_sync(&request);
+        if (request.result != 0) file->failed = 1;
+    }
+
+    int ok = !file->failed;
+    if (close(file->fd) != 0) ok = 0;
+    for (int i = 0; i < IO_WRITE_BUFFERS; i++) {
+        free(file->slots[i].buffer);
+    }
+    free(file->patches);
+    free(file);
+    return ok;
+}
@@ -0,0 +1,47 @@
+#ifndef IO_ENGINE_H
+#define IO_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mappedfile.h"
+
+// Asynchronous file I/O for loading and saving. On Linux requests go through an io_uring
+// (plain system calls, no liburing); where the kernel has none, or refuses one, a small pool
+// of threads runs them with pread/pwrite. Many large reads or writes are in flight at once,
+// so the disk stays busy while the caller parses or serializes. Without pread (Windows)
+// every request simply runs when it is submitted.
+//
+// Completions are handled on the calling thread while it waits, so the engine must only be
+// used from one thread at a time: the main thread, or a checkpoint child, which starts its own.
+
+#define IO_CHUNK_SIZE (1 << 20)         // Reads and writes are issued in pieces of this size
+#define IO_QUEUE_DEPTH 32               // Requests in the ring at once
+#define IO_THREADS 4                    // Size of the fallback pool
+#define IO_WRITE_BUFFERS 4              // Buffers per file being written, one filling while the others are written
+#define IO_OPEN_FILES 64                // Files a batch reads at once
+#define IO_READ_AHEAD (64 << 20)        // Bytes a batch reads ahead of the caller
+#define IO_ENGINE_ENV "SHOWROOM_IO_ENGINE"  // "threads" skips the io_uring
+
+const char* io_engine_name();           // "io_uring", "threads" or "sync"
+
+// Whole files read in the background and handed back as each one completes, in any order.
+// The paths must stay valid until io_read_finish().
+typedef struct IoReadBatch IoReadBatch;
+
+IoReadBatch* io_read_files(const char* const* paths, int count);   // NULL without memory
+// Index of the next complete file, -1 when every file has been handed out. The caller owns
+// the file (release it with unmap_file); its data is NULL if it could not be read.
+int io_next_file(IoReadBatch* batch, MappedFile* file);
+void io_read_finish(IoReadBatch* batch);    // Drops the files not handed out
+
+// A file written front to back in the background: fill the buffer, submit it, fill the next
+typedef struct IoWriteFile IoWriteFile;
+
+IoWriteFile* io_write_open(const char* path, int exclusive);   // NULL (errno set) if it cannot be created
+char* io_write_buffer(IoWriteFile* file);                      // IO_CHUNK_SIZE bytes to fill; NULL only the first time, without memory
+void io_write_submit(IoWriteFile* file, size_t used);          // Queue the filled buffer
+// Bytes to put over ones already submitted (a header filled in afterwards); written at close
+void io_write_patch(IoWriteFile* file, uint64_t offset, const void* data, size_t length);
+int io_write_close(IoWriteFile* file);                         // 1 if every byte reached the file
+
+#endif
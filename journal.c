@@ -0,0 +1,639 @@
+#include "journal.h"
+#include "snapshot.h"
+#include "mappedfile.h"
+#ifdef _WIN32
+#include <io.h>
+#define fsync _commit
+#else
+#include <unistd.h>
+#endif
+
+#define JOURNAL_HEADER_SIZE 32
+#define JOURNAL_RECORD_HEADER_SIZE 17      // length, crc, lsn, type
+#define JOURNAL_BYTE_ORDER 0x01020304u
+
+static FILE* journal_file = NULL;
+static char journal_path[512];
+static uint64_t last_lsn = 0;
+static uint64_t checkpoint_lsn_current = 0;    // Last record the snapshot on disk includes
+
+// Records appended since the last commit
+static unsigned char* pending = NULL;
+static size_t pending_size = 0;
+static size_t pending_capacity = 0;
+static int pending_records = 0;
+static size_t record_start = 0;
+static int write_failed = 0;
+
+// ---------------------------------------------------------------------------
+// Writing
+// ---------------------------------------------------------------------------
+
+static void put_bytes(const void* data, size_t length) {
+    if (length == 0) return;
+    if (pending_size + length > pending_capacity) {
+        size_t capacity = pending_capacity ? pending_capacity : 4096;
+        while (capacity < pending_size + length) capacity *= 2;
+        unsigned char* grown = (unsigned char*)realloc(pending, capacity);
+        if (!grown) {
+            write_failed = 1;
+            return;
+        }
+        pending = grown;
+        pending_capacity = capacity;
+    }
+    memcpy(pending + pending_size, data, length);
+    pending_size += length;
+}
+
+static void put_u8(uint8_t value) { put_bytes(&value, sizeof(value)); }
+static void put_u16(uint16_t value) { put_bytes(&value, sizeof(value)); }
+static void put_u32(uint32_t value) { put_bytes(&value, sizeof(value)); }
+static void put_i32(int32_t value) { put_bytes(&value, sizeof(value)); }
+static void put_f64(double value) { put_bytes(&value, sizeof(value)); }
+
+// Strings are a 16-bit length followed by the bytes, as in the snapshot
+static void put_str(const char* str) {
+    size_t length = strlen(str);
+    if (length > 0xFFFF) length = 0xFFFF;
+    put_u16((uint16_t)length);
+    put_bytes(str, length);
+}
+
+// A record starts with a placeholder header that end_record() fills in
+static void begin_record(uint8_t type) {
+    unsigned char header[JOURNAL_RECORD_HEADER_SIZE] = {0};
+    uint64_t lsn = last_lsn + 1;
+    memcpy(header + 8, &lsn, 8);
+    header[16] = type;
+    record_start = pending_size;
+    put_bytes(header, sizeof(header));
+}
+
+static void end_record() {
+    if (write_failed) {
+        out_printf("Error: Memory allocation failed for journal record, the change is not journaled\n");
+        pending_size = record_start;
+        write_failed = 0;
+        return;
+    }
+
+    // The CRC covers the LSN, the type and the payload
+    unsigned char* header = pending + record_start;
+    uint32_t length = (uint32_t)(pending_size - record_start - JOURNAL_RECORD_HEADER_SIZE);
+    uint32_t crc = crc32_update(0, header + 8, pending_size - record_start - 8);
+    memcpy(header, &length, 4);
+    memcpy(header + 4, &crc, 4);
+    last_lsn++;
+    pending_records++;
+
+    // Group commit: a full group goes out without waiting for the caller
+    if (pending_records >= JOURNAL_GROUP_RECORDS || pending_size >= JOURNAL_GROUP_BYTES) {
+        journal_commit();
+    }
+}
+
+int journal_commit() {
+    if (!journal_file || pending_size == 0) return 1;
+
+    int ok = fwrite(pending, 1, pending_size, journal_file) == pending_size &&
+             fflush(journal_file) == 0 &&
+             fsync(fileno(journal_file)) == 0;
+    if (!ok) {
+        out_printf("Error: Could not write journal %s, recent changes are not durable\n", journal_path);
+    }
+    pending_size = 0;
+    pending_records = 0;
+    return ok;
+}
+
+uint64_t journal_last_lsn() {
+    return last_lsn;
+}
+
+static void make_header(unsigned char* header, uint64_t base_lsn) {
+    uint32_t version = JOURNAL_VERSION;
+    uint32_t byte_order = JOURNAL_BYTE_ORDER;
+    memset(header, 0, JOURNAL_HEADER_SIZE);
+    memcpy(header, JOURNAL_MAGIC, 8);
+    memcpy(header + 8, &version, 4);
+    memcpy(header + 12, &byte_order, 4);
+    memcpy(header + 16, &base_lsn, 8);
+    uint32_t header_crc = crc32_update(0, header, 24);
+    memcpy(header + 24, &header_crc, 4);
+}
+
+// Replace the journal with a header and the given records, through a temporary file so a
+// crash leaves either the old journal or the new one
+static int rewrite_journal(uint64_t base_lsn, const unsigned char* records, size_t length) {
+    char temp_path[520];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", journal_path);
+
+    FILE* file = fopen(temp_path, "wb");
+    if (!file) {
+        out_printf("Error: Could not open file for writing: %s\n", temp_path);
+        return 0;
+    }
+
+    unsigned char header[JOURNAL_HEADER_SIZE];
+    make_header(header, base_lsn);
+    int ok = fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+             (length == 0 || fwrite(records, 1, length, file) == length) &&
+             fflush(file) == 0 &&
+             fsync(fileno(file)) == 0;
+    if (fclose(file) != 0) ok = 0;
+    if (!ok) {
+        out_printf("Error: Could not write journal %s\n", temp_path);
+        remove(temp_path);
+        return 0;
+    }
+
+    if (journal_file) {
+        fclose(journal_file);
+        journal_file = NULL;
+    }
+    #ifdef _WIN32
+    remove(journal_path);   // rename() does not replace an existing file here
+    #endif
+    if (rename(temp_path, journal_path) != 0) {
+        out_printf("Error: Could not replace journal %s\n", journal_path);
+        remove(temp_path);
+        return 0;
+    }
+    return 1;
+}
+
+static int reopen_for_append() {
+    journal_file = fopen(journal_path, "ab");
+    if (!journal_file) {
+        out_printf("Error: Could not open journal %s, changes will not be journaled\n", journal_path);
+        return 0;
+    }
+    return 1;
+}
+
+uint64_t journal_checkpoint_lsn() {
+    return checkpoint_lsn_current;
+}
+
+// Offset of the first record after `lsn` (the end if there is none, or the journal is damaged there)
+static size_t find_records_after(const unsigned char* data, size_t size, uint64_t lsn) {
+    size_t offset = JOURNAL_HEADER_SIZE;
+    while (offset < size && size - offset >= JOURNAL_RECORD_HEADER_SIZE) {
+        uint32_t length;
+        uint64_t record_lsn;
+        memcpy(&length, data + offset, 4);
+        memcpy(&record_lsn, data + offset + 8, 8);
+        if (record_lsn > lsn) return offset;
+        if (length > size - offset - JOURNAL_RECORD_HEADER_SIZE) break;
+        offset += JOURNAL_RECORD_HEADER_SIZE + length;
+    }
+    return size;
+}
+
+int journal_truncate(uint64_t checkpoint_lsn) {
+    if (!journal_file) return 0;
+
+    journal_commit();
+    if (checkpoint_lsn > last_lsn) last_lsn = checkpoint_lsn;
+
+    // Records made after the checkpoint (while a background checkpoint ran) stay in the journal
+    MappedFile file;
+    const unsigned char* records = NULL;
+    size_t length = 0;
+    int mapped = checkpoint_lsn < last_lsn && map_file(journal_path, &file);
+    if (mapped && file.size > JOURNAL_HEADER_SIZE) {
+        const unsigned char* data = (const unsigned char*)file.data;
+        size_t offset = find_records_after(data, file.size, checkpoint_lsn);
+        records = data + offset;
+        length = file.size - offset;
+    }
+    int ok = rewrite_journal(checkpoint_lsn, records, length);
+    if (mapped) unmap_file(&file);
+    if (ok) checkpoint_lsn_current = checkpoint_lsn;
+    return reopen_for_append() && ok;
+}
+
+void journal_close() {
+    if (!journal_file) return;
+
+    journal_commit();
+    fclose(journal_file);
+    journal_file = NULL;
+    free(pending);
+    pending = NULL;
+    pending_capacity = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Logging
+// ---------------------------------------------------------------------------
+
+void journal_log_add_showroom(const Showroom* showroom) {
+    if (!journal_file) return;
+
+    begin_record(JOURNAL_ADD_SHOWROOM);
+    put_i32(showroom->id);
+    put_str(showroom->name);
+    put_str(showroom->location);
+    put_str(showroom->contact);
+    end_record();
+}
+
+static void log_car(uint8_t type, int showroom_id, const Car* car) {
+    begin_record(type);
+    put_i32(showroom_id);
+    put_str(car->VIN);
+    put_str(car->name);
+    put_str(car->color);
+    put_f64(car->price);
+    put_str(car->fuel_type);
+    put_str(car->car_type);
+    end_record();
+}
+
+void journal_log_add_car(int showroom_id, const Car* car) {
+    if (!journal_file) return;
+    log_car(JOURNAL_ADD_CAR, showroom_id, car);
+}
+
+void journal_log_update_car(int showroom_id, const Car* car) {
+    if (!journal_file) return;
+    log_car(JOURNAL_UPDATE_CAR, showroom_id, car);
+}
+
+void journal_log_remove_car(int showroom_id, const char* vin) {
+    if (!journal_file) return;
+
+    begin_record(JOURNAL_REMOVE_CAR);
+    put_i32(showroom_id);
+    put_str(vin);
+    end_record();
+}
+
+void journal_log_recruit(int showroom_id, int salesperson_id, const char* name, double target_sales) {
+    if (!journal_file) return;
+
+    begin_record(JOURNAL_RECRUIT);
+    put_i32(showroom_id);
+    put_i32(salesperson_id);
+    put_str(name);
+    put_f64(target_sales);
+    end_record();
+}
+
+// The model id is not logged: replay registers the model again from the car it sells
+void journal_log_purchase(int showroom_id, int salesperson_id, const SoldCar* sold_car,
+                          const Customer* customer, const char* name, const char* address) {
+    if (!journal_file) return;
+
+    begin_record(JOURNAL_PURCHASE);
+    put_i32(showroom_id);
+    put_i32(salesperson_id);
+    put_str(sold_car->VIN);
+    put_u8(sold_car->payment_type);
+    put_u8(sold_car->loan_period_months);
+    put_u16(sold_car->interest_rate_bps);
+    put_f64(sold_car->down_payment);
+    put_f64(sold_car->loan_amount);
+    put_f64(sold_car->monthly_emi);
+    put_f64(customer->actual_aoumnt_paid);
+    put_i32(customer->purchase_date);
+    put_str(customer->mobile);
+    put_str(customer->reg_number);
+    put_u8(customer->loan_months);
+    put_str(name);
+    put_str(address);
+    end_record();
+}
+
+void journal_log_merge(int id1, int id2, int new_id, const char* name, const char* location,
+                       const char* contact, const MergeDecisions* decisions, int delete_originals) {
+    if (!journal_file) return;
+
+    begin_record(JOURNAL_MERGE);
+    put_i32(id1);
+    put_i32(id2);
+    put_i32(new_id);
+    put_str(name);
+    put_str(location);
+    put_str(contact);
+    put_u32((uint32_t)decisions->count);
+    put_bytes(decisions->choices, (size_t)decisions->count);
+    put_u8((uint8_t)(delete_originals != 0));
+    end_record();
+}
+
+void journal_log_incentive(int showroom_id, int salesperson_id, double incentive) {
+    if (!journal_file) return;
+
+    begin_record(JOURNAL_INCENTIVE);
+    put_i32(showroom_id);
+    put_i32(salesperson_id);
+    put_f64(incentive);
+    end_record();
+}
+
+void journal_log_update_salesperson(int showroom_id, int salesperson_id, const char* name, double target_sales) {
+    if (!journal_file) return;
+
+    begin_record(JOURNAL_UPDATE_SALESPERSON);
+    put_i32(showroom_id);
+    put_i32(salesperson_id);
+    put_str(name);
+    put_f64(target_sales);
+    end_record();
+}
+
+// ---------------------------------------------------------------------------
+// Replay
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const unsigned char* pos;
+    const unsigned char* end;
+    int failed;
+} JournalReader;
+
+static void get_bytes(JournalReader* reader, void* dest, size_t length) {
+    if (reader->failed || (size_t)(reader->end - reader->pos) < length) {
+        reader->failed = 1;
+        memset(dest, 0, length);
+        return;
+    }
+    memcpy(dest, reader->pos, length);
+    reader->pos += length;
+}
+
+static uint8_t get_u8(JournalReader* reader) { uint8_t value; get_bytes(reader, &value, sizeof(value)); return value; }
+static uint16_t get_u16(JournalReader* reader) { uint16_t value; get_bytes(reader, &value, sizeof(value)); return value; }
+static uint32_t get_u32(JournalReader* reader) { uint32_t value; get_bytes(reader, &value, sizeof(value)); return value; }
+static int32_t get_i32(JournalReader* reader) { int32_t value; get_bytes(reader, &value, sizeof(value)); return value; }
+static double get_f64(JournalReader* reader) { double value; get_bytes(reader, &value, sizeof(value)); return value; }
+
+static void get_str(JournalReader* reader, char* dest, size_t size) {
+    size_t length = get_u16(reader);
+    if (reader->failed || (size_t)(reader->end - reader->pos) < length) {
+        reader->failed = 1;
+        dest[0] = '\0';
+        return;
+    }
+    size_t copied = length < size ? length : size - 1;
+    memcpy(dest, reader->pos, copied);
+    dest[copied] = '\0';
+    reader->pos += length;
+}
+
+static Showroom* find_showroom(int showroom_id) {
+    if (!showroom_tree) return NULL;
+    Showroom temp;
+    temp.id = showroom_id;
+    return (Showroom*)bplusSearch(showroom_tree, &temp);
+}
+
+static SalesPerson* find_salesperson(Showroom* showroom, int salesperson_id) {
+    if (!showroom || !showroom->sales_persons) return NULL;
+    SalesPerson temp;
+    temp.id = salesperson_id;
+    return (SalesPerson*)bplusSearch(showroom->sales_persons, &temp);
+}
+
+static int replay_add_showroom(JournalReader* reader) {
+    int id = get_i32(reader);
+    char name[MAX_STR_LEN], location[MAX_STR_LEN], contact[MAX_MOBILE_LEN];
+    get_str(reader, name, sizeof(name));
+    get_str(reader, location, sizeof(location));
+    get_str(reader, contact, sizeof(contact));
+    return !reader->failed && create_showroom(id, name, location, contact) != NULL;
+}
+
+static void get_car(JournalReader* reader, Car* car) {
+    memset(car, 0, sizeof(Car));
+    get_str(reader, car->VIN, MAX_VIN_LEN);
+    get_str(reader, car->name, MAX_STR_LEN);
+    get_str(reader, car->color, MAX_STR_LEN);
+    car->price = get_f64(reader);
+    get_str(reader, car->fuel_type, MAX_STR_LEN);
+    get_str(reader, car->car_type, MAX_STR_LEN);
+}
+
+static int replay_add_car(JournalReader* reader) {
+    Showroom* showroom = find_showroom(get_i32(reader));
+    Car car;
+    get_car(reader, &car);
+    return !reader->failed && showroom && stock_car(showroom, &car);
+}
+
+static int replay_update_car(JournalReader* reader) {
+    Showroom* showroom = find_showroom(get_i32(reader));
+    Car car;
+    get_car(reader, &car);
+    return !reader->failed && showroom && update_stocked_car(showroom, &car);
+}
+
+static int replay_remove_car(JournalReader* reader) {
+    Showroom* showroom = find_showroom(get_i32(reader));
+    char vin[MAX_VIN_LEN];
+    get_str(reader, vin, sizeof(vin));
+    return !reader->failed && showroom && unstock_car(showroom, vin);
+}
+
+static int replay_recruit(JournalReader* reader) {
+    Showroom* showroom = find_showroom(get_i32(reader));
+    int id = get_i32(reader);
+    char name[MAX_STR_LEN];
+    get_str(reader, name, sizeof(name));
+    double target_sales = get_f64(reader);
+    return !reader->failed && showroom && hire_salesperson(showroom, id, name, target_sales) != NULL;
+}
+
+static int replay_purchase(JournalReader* reader) {
+    Showroom* showroom = find_showroom(get_i32(reader));
+    SalesPerson* salesperson = find_salesperson(showroom, get_i32(reader));
+
+    SoldCar sold_car;
+    memset(&sold_car, 0, sizeof(SoldCar));
+    get_str(reader, sold_car.VIN, MAX_VIN_LEN);
+    sold_car.payment_type = get_u8(reader);
+    sold_car.loan_period_months = get_u8(reader);
+    sold_car.interest_rate_bps = get_u16(reader);
+    sold_car.down_payment = get_f64(reader);
+    sold_car.loan_amount = get_f64(reader);
+    sold_car.monthly_emi = get_f64(reader);
+    sold_car.model_id = -1;
+
+    Customer customer;
+    memset(&customer, 0, sizeof(Customer));
+    strcpy(customer.car_VIN, sold_car.VIN);
+    customer.actual_aoumnt_paid = get_f64(reader);
+    customer.purchase_date = get_i32(reader);
+    get_str(reader, customer.mobile, MAX_MOBILE_LEN);
+    get_str(reader, customer.reg_number, MAX_REG_NUM_LEN);
+    customer.loan_months = get_u8(reader);
+
+    char name[MAX_STR_LEN], address[MAX_STR_LEN];
+    get_str(reader, name, sizeof(name));
+    get_str(reader, address, sizeof(address));
+
+    return !reader->failed && salesperson &&
+           complete_car_purchase(showroom, salesperson, &sold_car, &customer, name, address);
+}
+
+static int replay_merge(JournalReader* reader) {
+    Showroom* showroom1 = find_showroom(get_i32(reader));
+    Showroom* showroom2 = find_showroom(get_i32(reader));
+    int new_id = get_i32(reader);
+    char name[MAX_STR_LEN], location[MAX_STR_LEN], contact[MAX_MOBILE_LEN];
+    get_str(reader, name, sizeof(name));
+    get_str(reader, location, sizeof(location));
+    get_str(reader, contact, sizeof(contact));
+
+    MergeDecisions decisions;
+    memset(&decisions, 0, sizeof(decisions));
+    decisions.replaying = 1;
+    decisions.count = (int)get_u32(reader);
+    if (reader->failed || decisions.count < 0 || (size_t)(reader->end - reader->pos) < (size_t)decisions.count) {
+        return 0;
+    }
+    decisions.choices = (char*)reader->pos;     // Only read while replaying
+    reader->pos += decisions.count;
+    int delete_originals = get_u8(reader);
+
+    if (reader->failed || !showroom1 || !showroom2 || find_showroom(new_id)) return 0;
+
+    int id1 = showroom1->id, id2 = showroom2->id;
+    if (!merge_showroom_pair(showroom1, showroom2, new_id, name, location, contact, &decisions)) return 0;
+    if (delete_originals) {
+        remove_showroom(id1);
+        remove_showroom(id2);
+    }
+    return 1;
+}
+
+static int replay_incentive(JournalReader* reader) {
+    Showroom* showroom = find_showroom(get_i32(reader));
+    SalesPerson* salesperson = find_salesperson(showroom, get_i32(reader));
+    double incentive = get_f64(reader);
+    if (reader->failed || !salesperson) return 0;
+
+    salesperson->commission += incentive;
+    showroom->dirty |= SHOWROOM_DIRTY(SHOWROOM_SALESPERSONS);
+    return 1;
+}
+
+static int replay_update_salesperson(JournalReader* reader) {
+    Showroom* showroom = find_showroom(get_i32(reader));
+    int id = get_i32(reader);
+    char name[MAX_STR_LEN];
+    get_str(reader, name, sizeof(name));
+    double target_sales = get_f64(reader);
+    return !reader->failed && showroom && update_salesperson(showroom, id, name, target_sales);
+}
+
+static int replay_record(uint8_t type, JournalReader* reader) {
+    switch (type) {
+        case JOURNAL_ADD_SHOWROOM: return replay_add_showroom(reader);
+        case JOURNAL_ADD_CAR:      return replay_add_car(reader);
+        case JOURNAL_RECRUIT:      return replay_recruit(reader);
+        case JOURNAL_PURCHASE:     return replay_purchase(reader);
+        case JOURNAL_MERGE:        return replay_merge(reader);
+        case JOURNAL_INCENTIVE:    return replay_incentive(reader);
+        case JOURNAL_UPDATE_CAR:   return replay_update_car(reader);
+        case JOURNAL_REMOVE_CAR:   return replay_remove_car(reader);
+        case JOURNAL_UPDATE_SALESPERSON: return replay_update_salesperson(reader);
+        default:                   return 0;
+    }
+}
+
+static int valid_header(const unsigned char* data, size_t size, uint64_t* base_lsn) {
+    if (size < JOURNAL_HEADER_SIZE || memcmp(data, JOURNAL_MAGIC, 8) != 0) return 0;
+
+    uint32_t version, byte_order, header_crc;
+    memcpy(&version, data + 8, 4);
+    memcpy(&byte_order, data + 12, 4);
+    memcpy(base_lsn, data + 16, 8);
+    memcpy(&header_crc, data + 24, 4);
+    return version == JOURNAL_VERSION && byte_order == JOURNAL_BYTE_ORDER &&
+           crc32_update(0, data, 24) == header_crc;
+}
+
+int journal_open(const char* path, uint64_t checkpoint_lsn) {
+    journal_close();
+    snprintf(journal_path, sizeof(journal_path), "%s", path);
+    last_lsn = checkpoint_lsn;
+    checkpoint_lsn_current = checkpoint_lsn;
+
+    MappedFile file;
+    if (!map_file(path, &file)) {
+        // No journal yet: start one after the checkpoint
+        if (!rewrite_journal(checkpoint_lsn, NULL, 0)) return -1;
+        return reopen_for_append() ? 0 : -1;
+    }
+
+    const unsigned char* data = (const unsigned char*)file.data;
+    size_t size = file.size;
+    uint64_t base_lsn;
+    if (!valid_header(data, size, &base_lsn)) {
+        // Keep the damaged file for inspection rather than writing over it
+        char damaged_path[520];
+        snprintf(damaged_path, sizeof(damaged_path), "%s.damaged", path);
+        unmap_file(&file);
+        remove(damaged_path);
+        rename(path, damaged_path);
+        out_printf("Journal %s is damaged or from another version, moved it to %s.\n", path, damaged_path);
+        if (!rewrite_journal(checkpoint_lsn, NULL, 0)) return -1;
+        return reopen_for_append() ? 0 : -1;
+    }
+    if (base_lsn > last_lsn) last_lsn = base_lsn;
+
+    int replayed = 0, skipped = 0, failed = 0;
+    size_t offset = JOURNAL_HEADER_SIZE;
+    uint64_t previous_lsn = base_lsn;
+    while (size - offset >= JOURNAL_RECORD_HEADER_SIZE) {
+        const unsigned char* header = data + offset;
+        uint32_t length, crc;
+        uint64_t lsn;
+        memcpy(&length, header, 4);
+        memcpy(&crc, header + 4, 4);
+        memcpy(&lsn, header + 8, 8);
+
+        // A torn or damaged record ends the journal
+        if (length > size - offset - JOURNAL_RECORD_HEADER_SIZE) break;
+        if (crc32_update(0, header + 8, JOURNAL_RECORD_HEADER_SIZE - 8 + length) != crc) break;
+        if (lsn <= previous_lsn) break;
+        previous_lsn = lsn;
+        offset += JOURNAL_RECORD_HEADER_SIZE + length;
+
+        if (lsn <= checkpoint_lsn) {
+            skipped++;      // Already in the snapshot
+            continue;
+        }
+
+        JournalReader reader = {header + JOURNAL_RECORD_HEADER_SIZE, header + JOURNAL_RECORD_HEADER_SIZE + length, 0};
+        if (replay_record(header[16], &reader)) {
+            replayed++;
+        } else {
+            failed++;
+            out_printf("Journal record %llu (type %u) could not be applied, skipping it.\n",
+                       (unsigned long long)lsn, header[16]);
+        }
+        if (lsn > last_lsn) last_lsn = lsn;
+    }
+
+    int ok = 1;
+    if (offset < size) {
+        // Cut the damaged tail off so new records follow the last good one
+        out_printf("Journal %s: discarding %lu damaged bytes at the end.\n", path, (unsigned long)(size - offset));
+        ok = rewrite_journal(base_lsn, data + JOURNAL_HEADER_SIZE, offset - JOURNAL_HEADER_SIZE);
+    } else if (skipped > 0 && replayed + failed == 0) {
+        // The checkpoint got as far as the snapshot but not the truncation, finish it
+        ok = rewrite_journal(checkpoint_lsn, NULL, 0);
+    }
+    unmap_file(&file);
+
+    if (replayed + failed > 0) {
+        out_printf("Replayed %d journal records from %s\n", replayed, path);
+    }
+    if (!ok || !reopen_for_append()) return -1;
+    return replayed;
+}
@@ -0,0 +1,55 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include "essentialfunction.h"
+
+// Append-only journal of the changes made since the last checkpoint (full save).
+//
+// A record holds the final values of one operation rather than the input that produced them,
+// so replaying it on top of the checkpoint rebuilds the same state. Every record carries a
+// sequence number (LSN) and a CRC32; replay stops at the first torn or damaged record and that
+// tail is cut off. The snapshot stores the LSN it includes, so records it already holds are skipped.
+//
+// Appends are buffered and made durable as a group by journal_commit(): one write and one fsync
+// however many records are waiting. The menu loop commits after every command.
+
+#define JOURNAL_MAGIC "SHOWJRNL"
+#define JOURNAL_VERSION 1
+
+// Record types
+#define JOURNAL_ADD_SHOWROOM 1
+#define JOURNAL_ADD_CAR      2
+#define JOURNAL_RECRUIT      3
+#define JOURNAL_PURCHASE     4
+#define JOURNAL_MERGE        5
+#define JOURNAL_INCENTIVE    6
+#define JOURNAL_UPDATE_CAR   7     // Data file reloads (see livereload.h)
+#define JOURNAL_REMOVE_CAR   8
+#define JOURNAL_UPDATE_SALESPERSON 9
+
+// A group is committed early once it holds this many records or bytes
+#define JOURNAL_GROUP_RECORDS 64
+#define JOURNAL_GROUP_BYTES 65536
+
+int journal_open(const char* path, uint64_t checkpoint_lsn);   // Replays records after checkpoint_lsn, returns how many (-1 if it cannot be opened)
+int journal_commit();                                          // 1 once every appended record is on disk
+uint64_t journal_last_lsn();
+uint64_t journal_checkpoint_lsn();                              // Last record the saved snapshot includes
+int journal_truncate(uint64_t checkpoint_lsn);                 // Drop the records a checkpoint includes, keep later ones
+void journal_close();
+
+// Logging, a no-op while no journal is open
+void journal_log_add_showroom(const Showroom* showroom);
+void journal_log_add_car(int showroom_id, const Car* car);
+void journal_log_recruit(int showroom_id, int salesperson_id, const char* name, double target_sales);
+void journal_log_purchase(int showroom_id, int salesperson_id, const SoldCar* sold_car,
+                          const Customer* customer, const char* name, const char* address);
+void journal_log_merge(int id1, int id2, int new_id, const char* name, const char* location,
+                       const char* contact, const MergeDecisions* decisions, int delete_originals);
+void journal_log_incentive(int showroom_id, int salesperson_id, double incentive);
+void journal_log_update_car(int showroom_id, const Car* car);
+void journal_log_remove_car(int showroom_id, const char* vin);
+void journal_log_update_salesperson(int showroom_id, int salesperson_id, const char* name, double target_sales);
+
+#endif
@@ -0,0 +1,128 @@
+#include "leaderboard.h"
+#include "mappedstore.h"
+
+// Ordering of the leaderboard: higher achieved sales first, then lower ID
+static int rank_before(double sales_a, int id_a, double sales_b, int id_b) {
+    if (sales_a != sales_b) return sales_a > sales_b;
+    return id_a < id_b;
+}
+
+// Binary search for the slot a (sales, id) pair occupies or would be inserted at
+static int find_rank_slot(Showroom* showroom, double sales, int id) {
+    int low = 0;
+    int high = showroom->leaderboard_count;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        SalesPerson* sp = showroom->leaderboard[mid];
+        if (rank_before(sp->achieved_sales, sp->id, sales, id)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Make room for one more entry
+static int ensure_capacity(Showroom* showroom) {
+    if (showroom->leaderboard_count < showroom->leaderboard_capacity) return 1;
+
+    int new_capacity = showroom->leaderboard_capacity ? showroom->leaderboard_capacity * 2 : 8;
+    SalesPerson** grown = (SalesPerson**)store_realloc(showroom->leaderboard, new_capacity * sizeof(SalesPerson*));
+    if (!grown) {
+        out_printf("Memory allocation failed for salesperson leaderboard\n");
+        return 0;
+    }
+    showroom->leaderboard = grown;
+    showroom->leaderboard_capacity = new_capacity;
+    return 1;
+}
+
+// Insert a salesperson at its ranked position
+void leaderboard_add(Showroom* showroom, SalesPerson* sales_person) {
+    if (!showroom || !sales_person || !ensure_capacity(showroom)) return;
+
+    int pos = find_rank_slot(showroom, sales_person->achieved_sales, sales_person->id);
+    memmove(&showroom->leaderboard[pos + 1], &showroom->leaderboard[pos],
+            (showroom->leaderboard_count - pos) * sizeof(SalesPerson*));
+    showroom->leaderboard[pos] = sales_person;
+    showroom->leaderboard_count++;
+}
+
+// Move a salesperson to its new position after achieved_sales changed
+void leaderboard_update(Showroom* showroom, SalesPerson* sales_person, double old_achieved_sales) {
+    if (!showroom || !sales_person || showroom->leaderboard_count == 0) return;
+
+    // Locate the entry by the key it was ranked under
+    int pos = find_rank_slot(showroom, old_achieved_sales, sales_person->id);
+    if (pos >= showroom->leaderboard_count || showroom->leaderboard[pos] != sales_person) {
+        // Not ranked under the old key, fall back to a full re-sort
+        leaderboard_rebuild(showroom);
+        return;
+    }
+
+    // Bubble toward the front or back; only the entries it passes move
+    while (pos > 0 && rank_before(sales_person->achieved_sales, sales_person->id,
+                                  showroom->leaderboard[pos - 1]->achieved_sales, showroom->leaderboard[pos - 1]->id)) {
+        showroom->leaderboard[pos] = showroom->leaderboard[pos - 1];
+        pos--;
+    }
+    while (pos < showroom->leaderboard_count - 1 &&
+           rank_before(showroom->leaderboard[pos + 1]->achieved_sales, showroom->leaderboard[pos + 1]->id,
+                       sales_person->achieved_sales, sales_person->id)) {
+        showroom->leaderboard[pos] = showroom->leaderboard[pos + 1];
+        pos++;
+    }
+    showroom->leaderboard[pos] = sales_person;
+}
+
+// Rebuild the leaderboard from the showroom's salesperson tree
+void leaderboard_rebuild(Showroom* showroom) {
+    if (!showroom) return;
+
+    showroom->leaderboard_count = 0;
+    if (!showroom->sales_persons || !showroom->sales_persons->root) return;
+
+    BTreeNode* node = showroom->sales_persons->root;
+    while (!node->is_leaf) {
+        node = node->children[0];
+    }
+
+    while (node) {
+        for (int i = 0; i < node->num_keys; i++) {
+            leaderboard_add(showroom, (SalesPerson*)node->keys[i].key);
+        }
+        node = node->leaf_link.next;
+    }
+}
+
+// Function to free the leaderboard memory
+void leaderboard_free(Showroom* showroom) {
+    if (!showroom) return;
+    store_free(showroom->leaderboard);
+    showroom->leaderboard = NULL;
+    showroom->leaderboard_count = 0;
+    showroom->leaderboard_capacity = 0;
+}
+
+SalesPerson* leaderboard_best(Showroom* showroom) {
+    if (!showroom || showroom->leaderboard_count == 0) return NULL;
+    return showroom->leaderboard[0];
+}
+
+SalesPerson** leaderboard_top(Showroom* showroom, int n, int* count) {
+    *count = 0;
+    if (!showroom || n <= 0) return NULL;
+    *count = n < showroom->leaderboard_count ? n : showroom->leaderboard_count;
+    return showroom->leaderboard;
+}
+
+int leaderboard_rank(Showroom* showroom, SalesPerson* sales_person) {
+    if (!showroom || !sales_person) return 0;
+
+    int pos = find_rank_slot(showroom, sales_person->achieved_sales, sales_person->id);
+    if (pos < showroom->leaderboard_count && showroom->leaderboard[pos] == sales_person) {
+        return pos + 1;
+    }
+    return 0;
+}
@@ -0,0 +1,20 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include "functionpointer.h"
+
+// Per-showroom salesperson ranking, kept sorted by achieved_sales (best first, ties by lower ID).
+// Entries point at the records inside showroom->sales_persons.
+
+// Maintenance
+void leaderboard_add(Showroom* showroom, SalesPerson* sales_person);
+void leaderboard_update(Showroom* showroom, SalesPerson* sales_person, double old_achieved_sales);
+void leaderboard_rebuild(Showroom* showroom);
+void leaderboard_free(Showroom* showroom);
+
+// Queries
+SalesPerson* leaderboard_best(Showroom* showroom);                  // O(1)
+SalesPerson** leaderboard_top(Showroom* showroom, int n, int* count); // O(1), first *count entries
+int leaderboard_rank(Showroom* showroom, SalesPerson* sales_person); // O(log n), 1-based, 0 if absent
+
+#endif
@@ -0,0 +1,474 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "livereload.h"
+#include "filehandling.h"
+#include "checkpoint.h"
+#include "journal.h"
+#include "archive.h"
+#include "parallelload.h"
+
+#ifdef __linux__
+
+#include <pthread.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+
+// Tables reloaded, one bit each in the pending mask
+#define RELOAD_CARS 0
+#define RELOAD_SALESPERSONS 1
+#define RELOAD_TABLE_COUNT 2
+
+static const char* const reload_paths[RELOAD_TABLE_COUNT] = { CARS_FILE, SALESPERSONS_FILE };
+
+// One line of a data file; the key is (showroom_id, VIN) or (showroom_id, salesperson id)
+typedef struct {
+    int showroom_id;
+    int line;
+    union {
+        Car car;
+        SalesPerson salesperson;
+    } record;
+} ReloadRow;
+
+typedef struct {
+    int added;
+    int changed;
+    int removed;
+    int skipped;                // Malformed, repeated, unknown showroom or already sold
+} ReloadCounts;
+
+// Growable list of rows or records of one showroom, reused from one showroom to the next
+typedef struct {
+    void** items;
+    int count;
+    int capacity;
+} ChangeList;
+
+static pthread_t reload_thread;
+static int thread_started = 0;
+static int inotify_fd = -1;
+static int stop_pipe[2] = { -1, -1 };
+
+static int change_list_add(ChangeList* list, void* item) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 64;
+        void** grown = (void**)realloc(list->items, (size_t)capacity * sizeof(void*));
+        if (!grown) return 0;
+        list->items = grown;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = item;
+    return 1;
+}
+
+static BTreeNode* first_leaf(BPlusTree* tree) {
+    if (!tree || !tree->root) return NULL;
+    BTreeNode* node = tree->root;
+    while (!node->is_leaf) node = node->children[0];
+    return node;
+}
+
+// Amounts as the text files hold them
+static int same_amount(double a, double b) {
+    if (a == b) return 1;
+    char formatted_a[352], formatted_b[352];
+    snprintf(formatted_a, sizeof(formatted_a), "%.2f", a);
+    snprintf(formatted_b, sizeof(formatted_b), "%.2f", b);
+    return strcmp(formatted_a, formatted_b) == 0;
+}
+
+static int same_car(const Car* a, const Car* b) {
+    return strcmp(a->name, b->name) == 0 && strcmp(a->color, b->color) == 0 &&
+           strcmp(a->fuel_type, b->fuel_type) == 0 && strcmp(a->car_type, b->car_type) == 0 &&
+           same_amount(a->price, b->price);
+}
+
+static int compare_keys(const ReloadRow* a, const ReloadRow* b, int table) {
+    if (a->showroom_id != b->showroom_id) return (a->showroom_id > b->showroom_id) - (a->showroom_id < b->showroom_id);
+    if (table == RELOAD_CARS) return strcmp(a->record.car.VIN, b->record.car.VIN);
+    int id_a = a->record.salesperson.id, id_b = b->record.salesperson.id;
+    return (id_a > id_b) - (id_a < id_b);
+}
+
+static int compare_car_rows(const void* a, const void* b) {
+    const ReloadRow* row_a = (const ReloadRow*)a;
+    const ReloadRow* row_b = (const ReloadRow*)b;
+    int result = compare_keys(row_a, row_b, RELOAD_CARS);
+    return result ? result : (row_a->line > row_b->line) - (row_a->line < row_b->line);
+}
+
+static int compare_salesperson_rows(const void* a, const void* b) {
+    const ReloadRow* row_a = (const ReloadRow*)a;
+    const ReloadRow* row_b = (const ReloadRow*)b;
+    int result = compare_keys(row_a, row_b, RELOAD_SALESPERSONS);
+    return result ? result : (row_a->line > row_b->line) - (row_a->line < row_b->line);
+}
+
+// Read into a heap buffer rather than a mapping: the file may be rewritten meanwhile
+static int read_whole_file(const char* path, MappedFile* file) {
+    memset(file, 0, sizeof(MappedFile));
+    FILE* in = fopen(path, "rb");
+    if (!in) return 0;
+
+    size_t capacity = 1 << 20, size = 0;
+    char* data = (char*)malloc(capacity);
+    while (data) {
+        size_t got = fread(data + size, 1, capacity - size, in);
+        size += got;
+        if (got == 0) break;
+        if (size == capacity) {
+            char* grown = (char*)realloc(data, capacity * 2);
+            if (!grown) {
+                free(data);
+                data = NULL;
+                break;
+            }
+            data = grown;
+            capacity *= 2;
+        }
+    }
+    int failed = ferror(in);
+    fclose(in);
+    if (!data || failed) {
+        free(data);
+        return 0;
+    }
+    file->data = data;
+    file->size = size;
+    return 1;
+}
+
+// The file's rows sorted by key, each key once (the first line wins); 0 if it cannot be read
+static int read_rows(int table, ReloadRow** rows_out, int* row_count, ReloadCounts* counts) {
+    TextReader reader;
+    if (!read_whole_file(reload_paths[table], &reader.file)) return 0;
+    reader.offset = 0;
+
+    ReloadRow* rows = NULL;
+    int count = 0, capacity = 0, line_number = 0;
+    StrView line;
+    while (text_reader_next_line(&reader, &line)) {
+        line_number++;
+        if (line.length == 0) continue;
+
+        if (count == capacity) {
+            int new_capacity = capacity ? capacity * 2 : 1024;
+            ReloadRow* grown = (ReloadRow*)realloc(rows, (size_t)new_capacity * sizeof(ReloadRow));
+            if (!grown) {
+                free(rows);
+                text_reader_close(&reader);
+                return 0;
+            }
+            rows = grown;
+            capacity = new_capacity;
+        }
+
+        StrView fields[TEXT_MAX_FIELDS];
+        int field_count = split_fields(line, '|', fields, TEXT_MAX_FIELDS);
+        ReloadRow* row = &rows[count];
+        memset(row, 0, sizeof(ReloadRow));
+        int parsed = table == RELOAD_CARS ? parse_car_fields(fields, field_count, &row->record.car)
+                                          : parse_salesperson_fields(fields, field_count, &row->record.salesperson);
+        if (!parsed) {
+            counts->skipped++;
+            continue;
+        }
+        row->showroom_id = view_to_int(fields[0]);
+        row->line = line_number;
+        count++;
+    }
+    text_reader_close(&reader);
+
+    qsort(rows, count, sizeof(ReloadRow), table == RELOAD_CARS ? compare_car_rows : compare_salesperson_rows);
+    int unique = 0;
+    for (int i = 0; i < count; i++) {
+        if (unique > 0 && compare_keys(&rows[unique - 1], &rows[i], table) == 0) {
+            counts->skipped++;
+        } else {
+            rows[unique++] = rows[i];
+        }
+    }
+    *rows_out = rows;
+    *row_count = unique;
+    return 1;
+}
+
+static void ignore_sale(const ArchivedSale* sale, void* user_data) {
+    (void)sale;
+    (void)user_data;
+}
+
+static int already_sold(Showroom* showroom, const Car* car) {
+    if (showroom->sold_cars && bplusSearch(showroom->sold_cars, (void*)car)) return 1;
+    return showroom->archive_run_count > 0 && archive_find_sale(showroom, car->VIN, ignore_sale, NULL);
+}
+
+// Stock new cars, in VIN order, with one bulk merge
+static void stock_new_cars(Showroom* showroom, ChangeList* added, ReloadCounts* counts) {
+    if (added->count == 0) return;
+    if (!showroom->available_cars) {
+        showroom->available_cars = createBPlusTree(compareVIN, printCar, cloneCar, freeCar);
+    }
+
+    void** keys = (void**)malloc((size_t)added->count * sizeof(void*));
+    int cloned = 0;
+    if (keys) {
+        while (cloned < added->count && (keys[cloned] = cloneCar(&((ReloadRow*)added->items[cloned])->record.car))) cloned++;
+    }
+    if (!keys || cloned < added->count || !bplusBulkMerge(showroom->available_cars, keys, added->count)) {
+        for (int i = 0; i < cloned; i++) freeCar(keys[i]);
+        for (int i = 0; i < added->count; i++) {
+            bplusInsert(showroom->available_cars, &((ReloadRow*)added->items[i])->record.car);
+        }
+    }
+    free(keys);
+
+    for (int i = 0; i < added->count; i++) {
+        journal_log_add_car(showroom->id, &((ReloadRow*)added->items[i])->record.car);
+    }
+    showroom->total_available_cars += added->count;
+    showroom->dirty |= SHOWROOM_DIRTY(SHOWROOM_CARS);
+    counts->added += added->count;
+}
+
+// Merge one showroom's rows against its available cars, both in VIN order
+static void diff_showroom_cars(Showroom* showroom, ReloadRow* rows, int count, ChangeList* added,
+                               ChangeList* removed, ReloadCounts* counts) {
+    added->count = 0;
+    removed->count = 0;
+    int r = 0;
+    for (BTreeNode* leaf = first_leaf(showroom->available_cars); leaf; leaf = leaf->leaf_link.next) {
+        for (int k = 0; k < leaf->num_keys; k++) {
+            Car* stored = (Car*)leaf->keys[k].key;
+            while (r < count && strcmp(rows[r].record.car.VIN, stored->VIN) < 0) {
+                change_list_add(added, &rows[r++]);
+            }
+            if (r < count && strcmp(rows[r].record.car.VIN, stored->VIN) == 0) {
+                // Same key, so the record can be changed where it is
+                if (!same_car(stored, &rows[r].record.car)) {
+                    memcpy(stored, &rows[r].record.car, sizeof(Car));
+                    journal_log_update_car(showroom->id, stored);
+                    showroom->dirty |= SHOWROOM_DIRTY(SHOWROOM_CARS);
+                    counts->changed++;
+                }
+                r++;
+            } else {
+                change_list_add(removed, stored);
+            }
+        }
+    }
+    while (r < count) change_list_add(added, &rows[r++]);
+
+    for (int i = 0; i < removed->count; i++) {
+        Car* stored = (Car*)removed->items[i];
+        journal_log_remove_car(showroom->id, stored->VIN);
+        unstock_car(showroom, stored->VIN);
+        counts->removed++;
+    }
+
+    int kept = 0;
+    for (int i = 0; i < added->count; i++) {
+        if (already_sold(showroom, &((ReloadRow*)added->items[i])->record.car)) {
+            counts->skipped++;
+        } else {
+            added->items[kept++] = added->items[i];
+        }
+    }
+    added->count = kept;
+    stock_new_cars(showroom, added, counts);
+}
+
+// Merge one showroom's rows against its salespersons, both in id order
+static void diff_showroom_salespersons(Showroom* showroom, ReloadRow* rows, int count, ChangeList* added,
+                                       ReloadCounts* counts) {
+    added->count = 0;
+    int r = 0;
+    for (BTreeNode* leaf = first_leaf(showroom->sales_persons); leaf; leaf = leaf->leaf_link.next) {
+        for (int k = 0; k < leaf->num_keys; k++) {
+            SalesPerson* stored = (SalesPerson*)leaf->keys[k].key;
+            while (r < count && rows[r].record.salesperson.id < stored->id) {
+                change_list_add(added, &rows[r++]);
+            }
+            if (r < count && rows[r].record.salesperson.id == stored->id) {
+                SalesPerson* row = &rows[r].record.salesperson;
+                if (strcmp(stored->name, row->name) != 0 || !same_amount(stored->target_sales, row->target_sales)) {
+                    strcpy(stored->name, row->name);
+                    stored->target_sales = row->target_sales;
+                    journal_log_update_salesperson(showroom->id, stored->id, stored->name, stored->target_sales);
+                    showroom->dirty |= SHOWROOM_DIRTY(SHOWROOM_SALESPERSONS);
+                    counts->changed++;
+                }
+                r++;
+            }
+        }
+    }
+    while (r < count) change_list_add(added, &rows[r++]);
+
+    // Recruited after the walk, the inserts reshape the tree
+    for (int i = 0; i < added->count; i++) {
+        SalesPerson* row = &((ReloadRow*)added->items[i])->record.salesperson;
+        if (hire_salesperson(showroom, row->id, row->name, row->target_sales)) {
+            journal_log_recruit(showroom->id, row->id, row->name, row->target_sales);
+            counts->added++;
+        } else {
+            counts->skipped++;
+        }
+    }
+}
+
+// With the state lock held: walk the showrooms in id order beside the rows
+static void apply_rows(int table, ReloadRow* rows, int count, ReloadCounts* counts) {
+    ChangeList added = { NULL, 0, 0 };
+    ChangeList removed = { NULL, 0, 0 };
+    int r = 0;
+    for (BTreeNode* node = first_leaf(showroom_tree); node; node = node->leaf_link.next) {
+        for (int i = 0; i < node->num_keys; i++) {
+            Showroom* showroom = (Showroom*)node->keys[i].key;
+            while (r < count && rows[r].showroom_id < showroom->id) {
+                counts->skipped++;
+                r++;
+            }
+            int first = r;
+            while (r < count && rows[r].showroom_id == showroom->id) r++;
+
+            if (table == RELOAD_CARS) {
+                diff_showroom_cars(showroom, rows + first, r - first, &added, &removed, counts);
+            } else {
+                diff_showroom_salespersons(showroom, rows + first, r - first, &added, counts);
+            }
+        }
+    }
+    counts->skipped += count - r;
+    if (table == RELOAD_CARS && (counts->added || counts->changed || counts->removed)) inventory_changed();
+    free(added.items);
+    free(removed.items);
+}
+
+static void reload_table(int table) {
+    ReloadCounts counts = { 0, 0, 0, 0 };
+    double start = wall_clock_seconds();
+    ReloadRow* rows = NULL;
+    int count = 0;
+    if (!read_rows(table, &rows, &count, &counts) || count == 0) {
+        // Gone, unreadable or empty: more likely being replaced than meant to empty the table,
+        // the next event brings it back
+        free(rows);
+        return;
+    }
+    double read_seconds = wall_clock_seconds() - start;
+
+    checkpoint_lock_state();
+    snapshot_load_all_showrooms();
+    start = wall_clock_seconds();
+    apply_rows(table, rows, count, &counts);
+    double apply_seconds = wall_clock_seconds() - start;
+    journal_commit();
+
+    if (counts.added || counts.changed || counts.removed || counts.skipped) {
+        printf("\nReloaded %s: %d added, %d changed, %d removed, %d skipped "
+               "(read in %.1f ms, applied in %.1f ms)\n", reload_paths[table], counts.added,
+               counts.changed, counts.removed, counts.skipped, read_seconds * 1000.0, apply_seconds * 1000.0);
+    }
+    if (counts.added || counts.changed || counts.removed) {
+        // Save so the file is no longer newer than the snapshot, or a restart would import it
+        // again under the journal that already holds these changes
+        save_all_data();
+    }
+    fflush(stdout);
+    snapshot_trim_memory();
+    checkpoint_unlock_state();
+    free(rows);
+}
+
+// Pending-table bits for the events waiting on the inotify descriptor
+static unsigned int read_events() {
+    unsigned int pending = 0;
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for (;;) {
+        ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+        if (length <= 0) break;
+        for (char* pos = buffer; pos < buffer + length;) {
+            struct inotify_event* event = (struct inotify_event*)pos;
+            if (event->mask & IN_Q_OVERFLOW) pending = (1u << RELOAD_TABLE_COUNT) - 1;
+            for (int t = 0; event->len > 0 && t < RELOAD_TABLE_COUNT; t++) {
+                const char* name = strrchr(reload_paths[t], '/');
+                if (strcmp(event->name, name ? name + 1 : reload_paths[t]) == 0) pending |= 1u << t;
+            }
+            pos += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    return pending;
+}
+
+static void* reload_worker(void* arg) {
+    (void)arg;
+    unsigned int pending = 0;
+    for (;;) {
+        struct pollfd fds[2] = { { inotify_fd, POLLIN, 0 }, { stop_pipe[0], POLLIN, 0 } };
+        int ready = poll(fds, 2, pending ? LIVE_RELOAD_SETTLE_MS : -1);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready < 0 || fds[1].revents) break;
+
+        if (ready == 0) {
+            // Quiet for a while: the writers are done
+            for (int t = 0; t < RELOAD_TABLE_COUNT; t++) {
+                if (pending & (1u << t)) reload_table(t);
+            }
+            pending = 0;
+        } else if (fds[0].revents) {
+            pending |= read_events();
+        }
+    }
+    return NULL;
+}
+
+void live_reload_start() {
+    const char* requested = getenv(LIVE_RELOAD_ENV);
+    if (!requested || atoi(requested) <= 0 || thread_started) return;
+
+    char directory[512];
+    const char* slash = strrchr(CARS_FILE, '/');
+    snprintf(directory, sizeof(directory), "%.*s", slash ? (int)(slash - CARS_FILE) : 1, slash ? CARS_FILE : ".");
+
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0 || inotify_add_watch(inotify_fd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0 ||
+        pipe(stop_pipe) != 0 || pthread_create(&reload_thread, NULL, reload_worker, NULL) != 0) {
+        printf("Live reload is unavailable, data files are only read at startup.\n");
+        if (inotify_fd >= 0) close(inotify_fd);
+        if (stop_pipe[0] >= 0) close(stop_pipe[0]);
+        if (stop_pipe[1] >= 0) close(stop_pipe[1]);
+        inotify_fd = stop_pipe[0] = stop_pipe[1] = -1;
+        return;
+    }
+    thread_started = 1;
+    printf("Watching %s for changed data files.\n", directory);
+}
+
+void live_reload_stop() {
+    if (!thread_started) return;
+
+    ssize_t written;
+    do {
+        written = write(stop_pipe[1], "x", 1);
+    } while (written < 0 && errno == EINTR);
+    pthread_join(reload_thread, NULL);
+    close(inotify_fd);
+    close(stop_pipe[0]);
+    close(stop_pipe[1]);
+    inotify_fd = stop_pipe[0] = stop_pipe[1] = -1;
+    thread_started = 0;
+}
+
+#else
+
+void live_reload_start() {
+    if (getenv(LIVE_RELOAD_ENV)) printf("Live reload needs inotify (Linux), data files are only read at startup.\n");
+}
+
+void live_reload_stop() {}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef LIVE_RELOAD_H
+#define LIVE_RELOAD_H
+
+// Live reload of data files other systems drop into data/. With SHOWROOM_LIVE_RELOAD set, a
+// thread watches the directory (inotify, Linux only) and, once a watched file has been written
+// and nothing else changed for LIVE_RELOAD_SETTLE_MS, reads it into rows sorted by primary key
+// without holding the state lock. It then takes the lock between two menu commands and merges
+// the rows against the trees, which are walked in the same order, to find the changed rows;
+// only those are applied and journaled. The menu does not wait for the file to be read.
+//
+// The file is taken as the whole table:
+//   - cars.txt (showroom id, VIN): new cars are stocked, changed details replace the stocked
+//     ones, cars missing from the file leave the showroom's stock. A VIN this showroom has
+//     already sold is not stocked again.
+//   - salespersons.txt (showroom id, salesperson id): new salespersons are recruited, names
+//     and targets are updated. Achieved sales and commission come from the sales and are not
+//     read; salespersons missing from the file keep their sales and stay.
+// Amounts are compared as they are written (two decimals), so reloading a file the menu just
+// exported changes nothing. Rows for showrooms that do not exist are skipped.
+
+#define LIVE_RELOAD_ENV "SHOWROOM_LIVE_RELOAD"     // 1 to watch data/
+#define LIVE_RELOAD_SETTLE_MS 200
+
+void live_reload_start();
+void live_reload_stop();        // Waits for a reload in progress
+
+#endif
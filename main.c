@@ -1,119 +1,94 @@
-#include "essentialfunction.h"
-#include "filehandling.h"
-
-// Main function with menu for testing
-int main() {
-    int choice;
-    
-    // Initialize the system
-    init_system();
-    
-    // Load data from files
-    load_all_data();
-    
-    printf("Car Showroom Management System\n");
-    
-    do {
-        printf("\n=== Main Menu ===\n");
-        printf("1. Add Showroom\n");
-        printf("2. Display All Showrooms\n");
-        printf("3. Add New Car Stock\n");
-        printf("4. Recruit Sales Person\n");
-        printf("5. Car Purchase\n");
-        printf("6. Merge Showrooms\n");
-        printf("7. Display Showroom Inventory\n");
-        printf("8. Find Most Successful Sales Person\n");
-        printf("9. Predict Next Month's Sales\n");
-        printf("10. Find Car by VIN\n");
-        printf("11. Search Sales Persons by Sales Range\n");
-        printf("12. Display Car Popularity Statistics\n");
-        printf("13. Display the details of cars within given EMI plan\n");
-        printf("0. Exit\n");
-        printf("Enter your choice: ");
-        scanf("%d", &choice);
-        
-        switch (choice) {
-            case 1:
-                add_showroom();
-                break;
-            case 2:
-                printf("\n=== All Showrooms ===\n");
-                if (!showroom_tree || !showroom_tree->root) {
-                    printf("No showrooms have been added yet.\n");
-                } else {
-                    // Find the leftmost leaf node (first showroom)
-                    BTreeNode* node = showroom_tree->root;
-                    while (!node->is_leaf) {
-                        node = node->children[0];
-                    }
-                    
-                    // Traverse all leaf nodes to print all showrooms
-                    int count = 0;
-                    while (node) {
-                        for (int i = 0; i < node->num_keys; i++) {
-                            count++;
-                            printf("%d. ", count);
-                            showroom_tree->print(node->keys[i].key);
-                            printf("\n");
-                        }
-                        node = node->leaf_link.next;
-                    }
-                    
-                    if (count == 0) {
-                        printf("No showrooms have been added yet.\n");
-                    }
-                }
-                break;
-            case 3:
-                add_new_stock();
-                break;
-            case 4:
-                recruit_salesperson();
-                break;
-            case 5:
-                car_purchase();
-                break;
-            case 6:
-                merge_showrooms();
-                break;
-            case 7:
-                display_showroom_inventory();
-                break;
-            case 8:
-                find_most_successful_SP();
-                break;
-            case 9:
-                predict_next_month_sales();
-                break;
-            case 10:
-                find_car_by_VIN();
-                break;
-            case 11:
-                search_salespersons_by_sales_range();
-                break;
-            case 12:
-                display_car_popularity();
-                break;
-            case 13:
-                list_customers_with_emi_in_range();
-                break;
-            case 0:
-                printf("Exiting...\n");
-                break;
-            default:
-                printf("Invalid choice. Please try again.\n");
-        }
-    } while (choice != 0);
-    
-    // Save data to files before exiting
-    save_all_data();
-    
-    // Free memory before exiting
-    if (showroom_tree) {
-        freeBPlusTree(showroom_tree);
-    }
-
-    free_car_popularity_table();
-    
-    return 0;
+#include "essentialfunction.h"
+#include "filehandling.h"
+#include "journal.h"
+#include "checkpoint.h"
+#include "archive.h"
+#include "mappedstore.h"
+#include "livereload.h"
+#include "server.h"
+#include "client.h"
+#include "batch.h"
+
+// Main function with menu for testing. --serve [address] runs command lines sent by terminals
+// started with --connect [address] instead of reading the menu here (see server.h); --batch
+// [file] runs a command file, or stdin, without the menu (see batch.h).
+int main(int argc, char** argv) {
+    int choice = -1;
+    const char* serve_address = NULL;
+    int batch = 0;
+    
+    if (argc > 1 && strcmp(argv[1], "--connect") == 0) {
+        return client_run(argc > 2 ? argv[2] : SERVER_DEFAULT_ADDRESS);
+    }
+    if (argc > 1 && strcmp(argv[1], "--serve") == 0) {
+        serve_address = argc > 2 ? argv[2] : SERVER_DEFAULT_ADDRESS;
+    }
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0) {
+        batch = 1;
+    }
+    
+    // Initialize the system
+    init_system();
+    
+    // Load data from files
+    load_all_data();
+    
+    printf("Car Showroom Management System\n");
+    
+    // Commands run with the state lock held, background checkpoints only start between them
+    checkpoint_start_thread();
+    live_reload_start();
+    if (serve_address) {
+        server_run(serve_address);
+        choice = 0;
+    } else if (batch) {
+        batch_run(argc > 2 ? argv[2] : NULL);
+        choice = 0;
+    }
+    checkpoint_lock_state();
+    while (choice != 0) {
+        print_main_menu();
+        printf("Enter your choice: ");
+        fflush(stdout);
+        checkpoint_unlock_state();
+        if (scanf("%d", &choice) != 1) {
+            // Leave at the end of input rather than repeat the last command
+            choice = feof(stdin) ? 0 : -1;
+            clear_input_line();
+        }
+        checkpoint_lock_state();
+        
+        run_menu_command(choice);
+        
+        // Make the command's journal records durable before the next prompt
+        journal_commit();
+        snapshot_trim_memory();
+    }
+    checkpoint_unlock_state();
+    live_reload_stop();
+    checkpoint_stop_thread();
+    archive_stop_compaction();
+    
+    // Save data to files before exiting
+    save_all_data();
+    journal_close();
+    snapshot_remove_spill_files();
+    
+    // Free memory before exiting; the mapped store goes as a whole, without touching its pages
+    if (store_active()) {
+        store_close();
+    } else {
+        if (showroom_tree) {
+            freeBPlusTree(showroom_tree);
+        }
+
+        free_car_popularity_table();
+        free_national_popularity_window();
+        free_customer_index();
+        free_string_heap();
+    }
+    free_inventory_snapshot();
+    free_archive_indexes();
+    
+    return 0;
 }
\ No newline at end of file
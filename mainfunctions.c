@@ -1,1186 +1,1632 @@
-#include "essentialfunction.h"
-
-// Function to display showroom inventory details
-void display_showroom_inventory() {
-    int showroom_id;
-    
-    printf("\n=== Display Showroom Inventory ===\n");
-    
-    // Get showroom ID
-    printf("Enter Showroom ID: ");
-    scanf("%d", &showroom_id);
-    getchar(); // Clear input buffer
-    
-    // Create a temporary showroom object to search the tree
-    Showroom temp;
-    temp.id = showroom_id;
-    
-    // Search for the showroom
-    Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp);
-    if (!showroom) {
-        printf("Showroom with ID %d not found.\n", showroom_id);
-        return;
-    }
-    
-    // Display showroom details
-    printf("\nShowroom Details:\n");
-    printf("ID: %d\n", showroom->id);
-    printf("Name: %s\n", showroom->name);
-    printf("Location: %s\n", showroom->location);
-    printf("Contact: %s\n", showroom->contact);
-    printf("Available Cars: %d\n", showroom->total_available_cars);
-    printf("Sold Cars: %d\n", showroom->total_sold_cars);
-    
-    // Display available cars
-    printf("\nAvailable Cars:\n");
-    if (!showroom->available_cars || !showroom->available_cars->root) {
-        printf("No available cars in this showroom.\n");
-    } else {
-        // Find the leftmost leaf node (first car)
-        BTreeNode* node = showroom->available_cars->root;
-        while (!node->is_leaf) {
-            node = node->children[0];
-        }
-        
-        // Traverse all leaf nodes to print all cars
-        int count = 0;
-        while (node) {
-            for (int i = 0; i < node->num_keys; i++) {
-                count++;
-                printf("%d. ", count);
-                showroom->available_cars->print(node->keys[i].key);
-                printf("\n");
-            }
-            node = node->leaf_link.next;
-        }
-        
-        if (count == 0) {
-            printf("No available cars in this showroom.\n");
-        }
-    }
-    
-    // Display sales personnel
-    printf("\nSales Personnel:\n");
-    if (!showroom->sales_persons || !showroom->sales_persons->root) {
-        printf("No sales personnel in this showroom.\n");
-    } else {
-        // Find the leftmost leaf node (first salesperson)
-        BTreeNode* node = showroom->sales_persons->root;
-        while (!node->is_leaf) {
-            node = node->children[0];
-        }
-        
-        // Traverse all leaf nodes to print all salespeople
-        int count = 0;
-        while (node) {
-            for (int i = 0; i < node->num_keys; i++) {
-                count++;
-                printf("%d. ", count);
-                showroom->sales_persons->print(node->keys[i].key);
-                printf("\n");
-            }
-            node = node->leaf_link.next;
-        }
-        
-        if (count == 0) {
-            printf("No sales personnel in this showroom.\n");
-        }
-    }
-}
-
-
-
-
-// Helper function to count total nodes in a B+ tree
-int count_tree_nodes(BPlusTree* tree) {
-    if (!tree || !tree->root) {
-        return 0;
-    }
-    
-    int count = 0;
-    
-    // Find the leftmost leaf node
-    BTreeNode* node = tree->root;
-    while (!node->is_leaf) {
-        node = node->children[0];
-    }
-    
-    // Traverse all leaf nodes to count all keys
-    while (node) {
-        count += node->num_keys;
-        node = node->leaf_link.next;
-    }
-    
-    return count;
-}
-
-// Helper function to get all keys from a B+ tree with deep copy cloning
-void** getAllKeysInTree(BPlusTree* tree, int* count) {
-    if (!tree || !tree->root) {
-        *count = 0;
-        return NULL;
-    }
-    
-    // First, count all keys in the tree
-    int total_keys = count_tree_nodes(tree);
-    *count = total_keys;
-    
-    if (total_keys == 0) {
-        return NULL;
-    }
-    
-    // Allocate memory for all keys
-    void** keys = (void**)malloc(total_keys * sizeof(void*));
-    if (!keys) {
-        printf("Memory allocation failed for keys array\n");
-        *count = 0;
-        return NULL;
-    }
-    
-    // Find the leftmost leaf node
-    BTreeNode* node = tree->root;
-    while (!node->is_leaf) {
-        node = node->children[0];
-    }
-    
-    // Traverse all leaf nodes to collect all keys
-    // Using the clone function to create deep copies
-    int index = 0;
-    while (node && index < total_keys) {
-        for (int i = 0; i < node->num_keys && index < total_keys; i++) {
-            // Create a deep copy of each key using the tree's clone function
-            keys[index++] = tree->clone(node->keys[i].key);
-        }
-        node = node->leaf_link.next;
-    }
-    
-    return keys;
-}
-
-// Helper function to merge B+ trees with proper count tracking
-void merge_tree(BPlusTree *dest, BPlusTree *src, int *count) {
-    if (!src || !src->root) return;
-    if (!dest) return;
-    
-    // Get all items from source tree with deep copies
-    int item_count = 0;
-    void** items = getAllKeysInTree(src, &item_count);
-    
-    if (!items) return;
-    
-    // Insert each item into destination tree if not already present
-    int added = 0;
-    for (int i = 0; i < item_count; i++) {
-        void* key = items[i];
-        // Check if key already exists in destination tree
-        if (!bplusSearch(dest, key)) {
-            bplusInsert(dest, key);
-            added++;
-        }
-        // Free the temporary copy since bplusInsert makes its own copy
-        dest->free_func(key);
-    }
-    
-    // Update count if provided
-    if (count) {
-        *count += added;
-    }
-    
-    // Free the temporary array
-    free(items);
-}
-
-// Updated helper function to merge car trees
-void merge_car_tree(BPlusTree *dest, BPlusTree *src, int *count) {
-    if (!src || !src->root) return;
-    if (!dest) return;
-    
-    // Get all cars from source tree with deep copies
-    int car_count = 0;
-    Car** cars = (Car**)getAllKeysInTree(src, &car_count);
-    
-    if (!cars) return;
-    
-    // Insert each car into destination tree if not already present
-    int added = 0;
-    for (int i = 0; i < car_count; i++) {
-        Car* car = cars[i];
-        // Check if car already exists in destination tree
-        if (!bplusSearch(dest, car)) {
-            bplusInsert(dest, car);
-            added++;
-            printf("  Added car with VIN: %s\n", car->VIN);
-        } else {
-            printf("  Car with VIN %s already exists, skipping.\n", car->VIN);
-        }
-        // Free the temporary copy
-        freeCar(car);
-    }
-    
-    // Update count if provided
-    if (count) {
-        *count += added;
-    }
-    
-    // Free the temporary array
-    free(cars);
-}
-
-// Enhanced version of merge_sales_persons function with better conflict handling
-void merge_sales_persons(BPlusTree *dest, BPlusTree *src) {
-    if (!src || !src->root) return;
-    if (!dest) return;
-    
-    // Get all sales persons from source tree with deep copies
-    int sp_count = 0;
-    SalesPerson** sales_persons = (SalesPerson**)getAllKeysInTree(src, &sp_count);
-    
-    if (!sales_persons) return;
-    
-    // Insert each sales person into destination tree if not already present
-    for (int i = 0; i < sp_count; i++) {
-        SalesPerson* sp_src = sales_persons[i];
-        SalesPerson temp;
-        temp.id = sp_src->id;
-        
-        // Check if sales person ID already exists
-        SalesPerson* existing = (SalesPerson*)bplusSearch(dest, &temp);
-        if (!existing) {
-            // Simply insert the new sales person
-            bplusInsert(dest, sp_src);
-            printf("  Added sales person ID: %d - %s\n", sp_src->id, sp_src->name);
-        } else {
-            // Handle conflict by showing details and asking for resolution
-            printf("  Conflict: Sales Person ID %d already exists.\n", sp_src->id);
-            printf("  Existing: %s, Target: %.2f, Achieved: %.2f\n", 
-                   existing->name, existing->target_sales, existing->achieved_sales);
-            printf("  New: %s, Target: %.2f, Achieved: %.2f\n", 
-                   sp_src->name, sp_src->target_sales, sp_src->achieved_sales);
-            
-            char choice;
-            printf("  Keep existing (e), replace with new (n), or merge data (m)? ");
-            scanf(" %c", &choice);  // Note the space before %c to skip whitespace
-            getchar(); // Clear input buffer
-            
-            if (choice == 'n' || choice == 'N') {
-                // Replace existing with new - need to delete first
-                bplusDelete(dest, &temp);
-                bplusInsert(dest, sp_src);
-                printf("  Replaced with new sales person.\n");
-            } else if (choice == 'm' || choice == 'M') {
-                // Create a merged sales person
-                SalesPerson* merged = (SalesPerson*)malloc(sizeof(SalesPerson));
-                if (!merged) {
-                    printf("  Memory allocation failed for merged sales person.\n");
-                    continue;
-                }
-                
-                // Copy basic information
-                merged->id = sp_src->id;
-                strcpy(merged->name, sp_src->name);
-                
-                // Combine targets and achievements
-                merged->target_sales = existing->target_sales + sp_src->target_sales;
-                merged->achieved_sales = existing->achieved_sales + sp_src->achieved_sales;
-                merged->commission = existing->commission + sp_src->commission;
-                
-                // Create new trees for the merged sales person
-                merged->customer_tree = createBPlusTree(compareCustomerByEMI, printCustomer, cloneCustomer, freeCustomer);
-                merged->sold_car_tree = createBPlusTree(compareVIN, printSoldCar, cloneSoldCar, freeSoldCar);
-                
-                if (!merged->customer_tree || !merged->sold_car_tree) {
-                    printf("  Memory allocation failed for merged sales person trees.\n");
-                    if (merged->customer_tree) freeBPlusTree(merged->customer_tree);
-                    if (merged->sold_car_tree) freeBPlusTree(merged->sold_car_tree);
-                    free(merged);
-                    continue;
-                }
-                
-                // First delete the existing entry before inserting merged one to avoid ID conflicts
-                bplusDelete(dest, &temp);
-                
-                // Merge customer trees if they exist
-                if (existing->customer_tree)
-                    merge_tree(merged->customer_tree, existing->customer_tree, NULL);
-                if (sp_src->customer_tree)
-                    merge_tree(merged->customer_tree, sp_src->customer_tree, NULL);
-                
-                // Merge sold car trees if they exist
-                if (existing->sold_car_tree)
-                    merge_tree(merged->sold_car_tree, existing->sold_car_tree, NULL);
-                if (sp_src->sold_car_tree)
-                    merge_tree(merged->sold_car_tree, sp_src->sold_car_tree, NULL);
-                
-                // Insert the merged sales person
-                bplusInsert(dest, merged);
-                
-                // Free the temporary object (clone was made during insertion)
-                freeSalesPerson(merged);
-                
-                printf("  Merged sales person data successfully.\n");
-            } else {
-                printf("  Keeping existing sales person.\n");
-            }
-        }
-        
-        // Free the temporary copy
-        freeSalesPerson(sp_src);
-    }
-    
-    // Free the temporary array
-    free(sales_persons);
-}
-
-// Function to merge two showrooms based on user-provided IDs
-void merge_showrooms() {
-    int id1, id2, new_id;
-    char name[MAX_STR_LEN], location[MAX_STR_LEN], contact[MAX_MOBILE_LEN];
-    
-    printf("\n=== Merge Showrooms ===\n");
-    
-    // Get the IDs of the showrooms to merge
-    printf("Enter first showroom ID: ");
-    scanf("%d", &id1);
-    getchar(); // Clear input buffer
-    
-    printf("Enter second showroom ID: ");
-    scanf("%d", &id2);
-    getchar();
-    
-    // Create temporary showrooms for searching
-    Showroom temp1 = { .id = id1 };
-    Showroom temp2 = { .id = id2 };
-    
-    // Search for the showrooms in the global tree
-    Showroom* showroom1 = (Showroom*)bplusSearch(showroom_tree, &temp1);
-    Showroom* showroom2 = (Showroom*)bplusSearch(showroom_tree, &temp2);
-    
-    if (!showroom1 || !showroom2) {
-        printf("Error: One or both showrooms not found.\n");
-        return;
-    }
-    
-    // Get details for the new merged showroom
-    printf("\nEnter details for the merged showroom:\n");
-    printf("New Showroom ID: ");
-    scanf("%d", &new_id);
-    getchar();
-    
-    // Check if new ID already exists
-    Showroom temp_new = { .id = new_id };
-    if (bplusSearch(showroom_tree, &temp_new)) {
-        printf("Error: Showroom ID %d already exists.\n", new_id);
-        return;
-    }
-    
-    printf("New Showroom Name: ");
-    fgets(name, MAX_STR_LEN, stdin);
-    name[strcspn(name, "\n")] = 0;
-    
-    printf("New Showroom Location: ");
-    fgets(location, MAX_STR_LEN, stdin);
-    location[strcspn(location, "\n")] = 0;
-    
-    printf("New Showroom Contact Number: ");
-    fgets(contact, MAX_MOBILE_LEN, stdin);
-    contact[strcspn(contact, "\n")] = 0;
-    
-    // Create the new merged showroom
-    Showroom* new_showroom = (Showroom*)malloc(sizeof(Showroom));
-    if (!new_showroom) {
-        printf("Memory allocation failed for new showroom\n");
-        return;
-    }
-    
-    // Initialize the new showroom
-    new_showroom->id = new_id;
-    strcpy(new_showroom->name, name);
-    strcpy(new_showroom->location, location);
-    strcpy(new_showroom->contact, contact);
-    new_showroom->total_available_cars = 0;
-    new_showroom->total_sold_cars = 0;
-    
-    // Initialize B+ trees for the new showroom
-    new_showroom->available_cars = createBPlusTree(compareVIN, printCar, cloneCar, freeCar);
-    new_showroom->sold_cars = createBPlusTree(compareVIN, printCar, cloneCar, freeCar);
-    new_showroom->sales_persons = createBPlusTree(compareSalesPersonID, printSalesPerson, cloneSalesPerson, freeSalesPerson);
-    
-    if (!new_showroom->available_cars || !new_showroom->sold_cars || !new_showroom->sales_persons) {
-        printf("Memory allocation failed for B+ trees\n");
-        if (new_showroom->available_cars) freeBPlusTree(new_showroom->available_cars);
-        if (new_showroom->sold_cars) freeBPlusTree(new_showroom->sold_cars);
-        if (new_showroom->sales_persons) freeBPlusTree(new_showroom->sales_persons);
-        free(new_showroom);
-        return;
-    }
-    
-    // Merge available cars
-    printf("Merging available cars...\n");
-    if (showroom1->available_cars)
-        merge_car_tree(new_showroom->available_cars, showroom1->available_cars, &new_showroom->total_available_cars);
-    if (showroom2->available_cars)
-        merge_car_tree(new_showroom->available_cars, showroom2->available_cars, &new_showroom->total_available_cars);
-    
-    // Merge sold cars
-    printf("Merging sold cars...\n");
-    if (showroom1->sold_cars)
-        merge_car_tree(new_showroom->sold_cars, showroom1->sold_cars, &new_showroom->total_sold_cars);
-    if (showroom2->sold_cars)
-        merge_car_tree(new_showroom->sold_cars, showroom2->sold_cars, &new_showroom->total_sold_cars);
-    
-    // Merge sales persons (handling potential ID conflicts)
-    printf("Merging sales personnel...\n");
-    if (showroom1->sales_persons)
-        merge_sales_persons(new_showroom->sales_persons, showroom1->sales_persons);
-    if (showroom2->sales_persons)
-        merge_sales_persons(new_showroom->sales_persons, showroom2->sales_persons);
-    
-    // Insert the new showroom into the global tree
-    bplusInsert(showroom_tree, new_showroom);
-    
-    // Print summary of the merge
-    printf("\nMerge Summary:\n");
-    printf("New Showroom ID: %d\n", new_showroom->id);
-    printf("Name: %s\n", new_showroom->name);
-    printf("Location: %s\n", new_showroom->location);
-    printf("Available Cars: %d\n", new_showroom->total_available_cars);
-    printf("Sold Cars: %d\n", new_showroom->total_sold_cars);
-    
-    // Count sales persons
-    int sales_person_count = count_tree_nodes(new_showroom->sales_persons);
-    printf("Sales Personnel: %d\n", sales_person_count);
-    
-    printf("\nShowrooms %d and %d successfully merged into new showroom %d.\n", id1, id2, new_id);
-    
-    // Option to delete original showrooms
-    char delete_original;
-    printf("\nDo you want to delete the original showrooms? (y/n): ");
-    scanf(" %c", &delete_original);  // Note the space before %c to skip whitespace
-    getchar(); // Clear input buffer
-    
-    if (delete_original == 'y' || delete_original == 'Y') {
-        // Delete original showrooms from the global tree
-        bplusDelete(showroom_tree, &temp1);
-        bplusDelete(showroom_tree, &temp2);
-        printf("Original showrooms deleted.\n");
-    }
-
-    // Display updated inventory
-    printf("\nDisplaying merged showroom inventory:\n");
-    temp_new.id = new_id;  // Set to display the new showroom
-    Showroom* merged_showroom = (Showroom*)bplusSearch(showroom_tree, &temp_new);
-    if (merged_showroom) {
-        // Display the new showroom details
-        printf("\nShowroom Details:\n");
-        printf("ID: %d\n", merged_showroom->id);
-        printf("Name: %s\n", merged_showroom->name);
-        printf("Location: %s\n", merged_showroom->location);
-        printf("Contact: %s\n", merged_showroom->contact);
-        printf("Available Cars: %d\n", merged_showroom->total_available_cars);
-        printf("Sold Cars: %d\n", merged_showroom->total_sold_cars);
-        
-            
-    } else {
-        printf("Error: Could not find newly created showroom for display.\n");
-    }
-    
-    // No need to free new_showroom here as it's now owned by the tree
-    // The bplusInsert function has already made a copy of it
-}
-
-
-// Global hash table
-CarPopularityEntry* car_popularity_table[HASH_SIZE] = {NULL};
-
-// Hash function for strings (car models)
-unsigned int hash_model(const char* str) {
-    unsigned int hash = 0;
-    while (*str) {
-        hash = (hash * 31) + (*str++);
-    }
-    return hash % HASH_SIZE;
-}
-
-// Function to increment count for a car model in hashtable
-void increment_car_popularity(const char* model_name) {
-    unsigned int index = hash_model(model_name);
-    
-    // Check if model already exists in table
-    CarPopularityEntry* entry = car_popularity_table[index];
-    while (entry) {
-        if (strcmp(entry->model_name, model_name) == 0) {
-            // Found the model, increment count
-            entry->count++;
-            return;
-        }
-        entry = entry->next;
-    }
-    
-    // Model not found, create new entry
-    CarPopularityEntry* new_entry = (CarPopularityEntry*)malloc(sizeof(CarPopularityEntry));
-    if (!new_entry) {
-        printf("Memory allocation failed for car popularity tracking\n");
-        return;
-    }
-    
-    strncpy(new_entry->model_name, model_name, MAX_STR_LEN - 1);
-    new_entry->model_name[MAX_STR_LEN - 1] = '\0';  // Ensure null-termination
-    new_entry->count = 1;
-    new_entry->next = car_popularity_table[index];
-    car_popularity_table[index] = new_entry;
-}
-
-// Function to find the most popular car model
-char* find_most_popular_car(int* max_count) {
-    static char most_popular[MAX_STR_LEN] = "";
-    *max_count = 0;
-    
-    for (int i = 0; i < HASH_SIZE; i++) {
-        CarPopularityEntry* entry = car_popularity_table[i];
-        while (entry) {
-            if (entry->count > *max_count) {
-                *max_count = entry->count;
-                strncpy(most_popular, entry->model_name, MAX_STR_LEN - 1);
-                most_popular[MAX_STR_LEN - 1] = '\0';  // Ensure null-termination
-            }
-            entry = entry->next;
-        }
-    }
-    
-    return most_popular;
-}
-
-// Function to free the hashtable memory
-void free_car_popularity_table() {
-    for (int i = 0; i < HASH_SIZE; i++) {
-        CarPopularityEntry* current = car_popularity_table[i];
-        while (current != NULL) {
-            CarPopularityEntry* temp = current;
-            current = current->next;
-            free(temp);
-        }
-        car_popularity_table[i] = NULL;
-    }
-}
-
-// Function to display all car models and their popularity
-void display_car_popularity() {
-    printf("\n=== Car Popularity Statistics ===\n");
-    int total_models = 0;
-    
-    for (int i = 0; i < HASH_SIZE; i++) {
-        CarPopularityEntry* entry = car_popularity_table[i];
-        while (entry) {
-            printf("Model: %-20s | Sold: %d\n", entry->model_name, entry->count);
-            total_models++;
-            entry = entry->next;
-        }
-    }
-    
-    if (total_models == 0) {
-        printf("No cars have been sold yet.\n");
-    } else {
-        int max_count;
-        char* most_popular = find_most_popular_car(&max_count);
-        printf("\nMost Popular Model: %s (Sold: %d)\n", most_popular, max_count);
-    }
-}
-
-
-
-
-
-
-// Function to find the most successful salesperson in a specific showroom
-void find_most_successful_SP() {
-    if (!showroom_tree || !showroom_tree->root) {
-        printf("No showrooms registered in the system.\n");
-        return;
-    }
-    
-    // Get showroom ID from user
-    int showroom_id;
-    printf("\nEnter Showroom ID: ");
-    scanf("%d", &showroom_id);
-    
-    // Create temporary showroom for search
-    Showroom temp_showroom;
-    temp_showroom.id = showroom_id;
-    
-    // Search for the showroom
-    Showroom* target_showroom = (Showroom*)bplusSearch(showroom_tree, &temp_showroom);
-    if (!target_showroom) {
-        printf("Showroom with ID %d not found.\n", showroom_id);
-        return;
-    }
-    
-    // Check if this showroom has any salespeople
-    if (!target_showroom->sales_persons || !target_showroom->sales_persons->root) {
-        printf("No sales persons found in Showroom %d: %s.\n", target_showroom->id, target_showroom->name);
-        return;
-    }
-    
-    SalesPerson* best_sp = NULL;
-    double highest_sales = -1;
-    
-    // Start with the leftmost leaf node in the salesperson tree
-    BTreeNode* sp_node = target_showroom->sales_persons->root;
-    while (!sp_node->is_leaf) {
-        sp_node = sp_node->children[0];
-    }
-    
-    // Traverse all salespeople in this showroom
-    while (sp_node) {
-        for (int j = 0; j < sp_node->num_keys; j++) {
-            SalesPerson* current_sp = (SalesPerson*)sp_node->keys[j].key;
-            
-            // Check if this salesperson has higher sales
-            if (current_sp->achieved_sales > highest_sales) {
-                highest_sales = current_sp->achieved_sales;
-                best_sp = current_sp;
-            }
-        }
-        sp_node = sp_node->leaf_link.next;
-    }
-    
-    // Print results and award incentive
-    if (best_sp) {
-        double incentive = best_sp->achieved_sales * 0.01; // 1% of achieved sales
-        
-        printf("\n=== Most Successful Sales Person in %s (ID: %d) ===\n", 
-               target_showroom->name, target_showroom->id);
-        printf("ID: %d\n", best_sp->id);
-        printf("Name: %s\n", best_sp->name);
-        printf("Target Sales: %.2f lakhs\n", best_sp->target_sales);
-        printf("Achieved Sales: %.2f lakhs\n", best_sp->achieved_sales);
-        printf("Current Commission: %.2f lakhs\n", best_sp->commission);
-        printf("\n");
-        printf("--- Awarding Additional Incentive ---\n");
-        printf("Additional Incentive (1%%): %.2f lakhs\n", incentive);
-        printf("Total Earnings: %.2f lakhs\n", best_sp->commission + incentive);
-        
-        // Update the salesperson's commission
-        best_sp->commission += incentive;
-        printf("\nIncentive awarded successfully!\n");
-    } else {
-        printf("No sales persons found in Showroom %d: %s.\n", 
-               target_showroom->id, target_showroom->name);
-    }
-}
-
-
-
-
-
-
-// Helper structure to track monthly sales
-void predict_next_month_sales() {
-    if (!showroom_tree || !showroom_tree->root) {
-        printf("No showrooms registered in the system.\n");
-        return;
-    }
-    
-    // Get showroom ID from user
-    int showroom_ID;
-    printf("Enter Showroom ID for sales prediction: ");
-    scanf("%d", &showroom_ID);
-    
-    // Create a temporary showroom to search for the specific ID
-    Showroom temp_showroom = {0};
-    temp_showroom.id = showroom_ID;
-    
-    // Search for the specific showroom
-    Showroom* target_showroom = (Showroom*)bplusSearch(showroom_tree, &temp_showroom);
-    if (!target_showroom) {
-        printf("Showroom with ID %d not found.\n", showroom_ID);
-        return;
-    }
-    
-    // Get current date
-    time_t t = time(NULL);
-    struct tm* current_time = localtime(&t);
-    int current_month = current_time->tm_mon + 1; // tm_mon is 0-11
-    int current_year = current_time->tm_year + 1900;
-    
-    // Prepare array to store last 6 months of sales (or fewer if not enough data)
-    MonthlySales sales_history[6] = {0};
-    
-    // Initialize the sales history array with the last 6 months
-    for (int i = 0; i < 6; i++) {
-        sales_history[i].month = current_month - i;
-        sales_history[i].year = current_year;
-        
-        // Adjust year if we go back to previous year
-        if (sales_history[i].month <= 0) {
-            sales_history[i].month += 12;
-            sales_history[i].year--;
-        }
-    }
-    
-    // Process each salesperson in the target showroom
-    if (target_showroom->sales_persons && target_showroom->sales_persons->root) {
-        BTreeNode* sp_node = target_showroom->sales_persons->root;
-        while (!sp_node->is_leaf) {
-            sp_node = sp_node->children[0];
-        }
-        
-        // Traverse all salespeople in this showroom
-        while (sp_node) {
-            for (int j = 0; j < sp_node->num_keys; j++) {
-                SalesPerson* current_sp = (SalesPerson*)sp_node->keys[j].key;
-                
-                // Process all customers of this salesperson to get sales data
-                if (current_sp->customer_tree && current_sp->customer_tree->root) {
-                    BTreeNode* customer_node = current_sp->customer_tree->root;
-                    while (!customer_node->is_leaf) {
-                        customer_node = customer_node->children[0];
-                    }
-                    
-                    // Traverse all customers
-                    while (customer_node) {
-                        for (int k = 0; k < customer_node->num_keys; k++) {
-                            Customer* current_customer = (Customer*)customer_node->keys[k].key;
-                            
-                            // Check purchase date to see if it falls within our 6 month window
-                            for (int m = 0; m < 6; m++) {
-                                if (current_customer->purchase_month == sales_history[m].month && 
-                                    current_customer->purchase_year == sales_history[m].year) {
-                                    sales_history[m].sales_count++;
-                                    
-                                    // Add the customer's actual_amount_paid to the sales value
-                                    sales_history[m].sales_value += current_customer->actual_aoumnt_paid;
-                                    
-                                    // We've found a match, no need to check other months
-                                    break;
-                                }
-                            }
-                        }
-                        customer_node = customer_node->leaf_link.next;
-                    }
-                }
-            }
-            sp_node = sp_node->leaf_link.next;
-        }
-    }
-    
-    // Display the sales history for this showroom
-    printf("\n=== Sales History for Showroom ID %d ===\n", showroom_ID);
-    printf("Month\tYear\tUnits Sold\tValue \n");
-    for (int i = 5; i >= 0; i--) {
-        printf("%d\t%d\t%d\t\t%.2f\n", 
-               sales_history[i].month, sales_history[i].year, 
-               sales_history[i].sales_count, sales_history[i].sales_value);
-    }
-    
-    // Calculate simple average 
-    double total_units = 0;
-    double total_value = 0;
-    int months_with_data = 0;
-    
-    for (int i = 0; i < 6; i++) {
-        total_units += sales_history[i].sales_count;
-        total_value += sales_history[i].sales_value;
-        if (sales_history[i].sales_count > 0) {
-            months_with_data++;
-        }
-    }
-    
-    // Calculate next month and year
-    int next_month = current_month + 1;
-    int next_year = current_year;
-    if (next_month > 12) {
-        next_month = 1;
-        next_year++;
-    }
-    
-    // Calculate prediction - even if no cars were sold
-    double predicted_units = 0;
-    double predicted_value = 0;
-    
-    // If we have data, calculate average, otherwise predict zero
-    if (months_with_data > 0) {
-        predicted_units = total_units / 6.0; // Always divide by 6 months, even if some months had zero sales
-        predicted_value = total_value / 6.0;
-    }
-    
-    // Display prediction
-    printf("\n=== Sales Prediction for %d/%d (Showroom ID %d) ===\n", next_month, next_year, showroom_ID);
-    printf("Predicted Units: %.1f\n", predicted_units);
-    printf("Predicted Value: %.2f \n", predicted_value);
-    if (predicted_units > 0) {
-        printf("Average Price Per Unit: %.2f \n", predicted_value / predicted_units);
-    } else {
-        printf("Average Price Per Unit: 0.00 \n");
-    }
-}
-
-
-
-
-
-
-
-void find_car_by_VIN() {
-    char target_VIN[MAX_VIN_LEN];
-    int found = 0;
-    
-    printf("\n=== Find Car by VIN ===\n");
-    printf("Enter the VIN number: ");
-    scanf("%s", target_VIN);
-    
-    // Check if showroom_tree is initialized
-    if (!showroom_tree || !showroom_tree->root) {
-        printf("No showrooms have been added yet.\n");
-        return;
-    }
-    
-    // Find the leftmost leaf node (first showroom)
-    BTreeNode* node = showroom_tree->root;
-    while (!node->is_leaf) {
-        node = node->children[0];
-    }
-    
-    // Traverse all showrooms
-    while (node) {
-        for (int i = 0; i < node->num_keys; i++) {
-            Showroom* showroom = (Showroom*)node->keys[i].key;
-            
-            // Check available cars
-            if (showroom->available_cars && showroom->available_cars->root) {
-                Car* car = (Car*)bplusSearch(showroom->available_cars, &target_VIN);
-                if (car) {
-                    printf("\nCAR FOUND IN STOCK at %s showroom:\n", showroom->name);
-                    printf("VIN: %s\n", car->VIN);
-                    printf("Model: %s\n", car->name);
-                    printf("Color: %s\n", car->color);
-                    printf("Price: %.2f lakhs\n", car->price);
-                    printf("Fuel Type: %s\n", car->fuel_type);
-                    printf("Car Type: %s\n", car->car_type);
-                    printf("Status: Available for purchase\n");
-                    found = 1;
-                }
-            }
-            
-            // Check sold cars
-            if (showroom->sold_cars && showroom->sold_cars->root) {
-                SoldCar* sold_car = (SoldCar*)bplusSearch(showroom->sold_cars, &target_VIN);
-                if (sold_car) {
-                    printf("\nCAR FOUND (SOLD) at %s showroom:\n", showroom->name);
-                    printf("VIN: %s\n", sold_car->VIN);
-                    printf("Payment Type: %s\n", sold_car->payment_type);
-                    
-                    if (strcmp(sold_car->payment_type, "Loan") == 0) {
-                        printf("Down Payment: %.2f lakhs\n", sold_car->down_payment);
-                        printf("Loan Period: %d months\n", sold_car->loan_period_months);
-                        printf("Loan Amount: %.2f lakhs\n", sold_car->loan_amount);
-                        printf("Interest Rate: %.2f%%\n", sold_car->interest_rate);
-                        printf("Monthly EMI: %.2f\n", sold_car->monthly_emi);
-                    }
-                    
-                    // Look for customer information via sales persons
-                    if (showroom->sales_persons && showroom->sales_persons->root) {
-                        BTreeNode* sp_node = showroom->sales_persons->root;
-                        while (!sp_node->is_leaf) {
-                            sp_node = sp_node->children[0];
-                        }
-                        
-                        int customer_found = 0;
-                        while (sp_node && !customer_found) {
-                            for (int j = 0; j < sp_node->num_keys && !customer_found; j++) {
-                                SalesPerson* sp = (SalesPerson*)sp_node->keys[j].key;
-                                
-                                if (sp->customer_tree && sp->customer_tree->root) {
-                                    // Look for customer with this VIN
-                                    BTreeNode* cust_node = sp->customer_tree->root;
-                                    while (!cust_node->is_leaf) {
-                                        cust_node = cust_node->children[0];
-                                    }
-                                    
-                                    while (cust_node && !customer_found) {
-                                        for (int k = 0; k < cust_node->num_keys; k++) {
-                                            Customer* customer = (Customer*)cust_node->keys[k].key;
-                                            if (strcmp(customer->car_VIN, target_VIN) == 0) {
-                                                printf("\nCustomer Details:\n");
-                                                printf("Name: %s\n", customer->name);
-                                                printf("Mobile: %s\n", customer->mobile);
-                                                printf("Address: %s\n", customer->address);
-                                                printf("Registration Number: %s\n", customer->reg_number);
-                                                printf("Amount Paid: %.2f lakhs\n", customer->actual_aoumnt_paid);
-                                                printf("Purchase Date: %d/%d/%d\n", 
-                                                       customer->purchase_day,
-                                                       customer->purchase_month,
-                                                       customer->purchase_year);
-                                                printf("Sales Person: %s (ID: %d)\n", sp->name, sp->id);
-                                                customer_found = 1;
-                                                break;
-                                            }
-                                        }
-                                        cust_node = cust_node->leaf_link.next;
-                                    }
-                                }
-                            }
-                            sp_node = sp_node->leaf_link.next;
-                        }
-                    }
-                    found = 1;
-                }
-            }
-        }
-        node = node->leaf_link.next;
-    }
-    
-    if (!found) {
-        printf("\nNo car found with VIN: %s\n", target_VIN);
-    }
-}
-
-
-
-
-
-
-int count_nodes_in_tree(BTreeNode* node) {
-    if (!node) return 0;
-    
-    int count = 0;
-    if (node->is_leaf) {
-        count = node->num_keys;
-    } else {
-        for (int i = 0; i <= node->num_keys; i++) {
-            count += count_nodes_in_tree(node->children[i]);
-        }
-    }
-    return count;
-}
-
-void search_salespersons_by_sales_range() {
-    double min_sales, max_sales;
-    int found = 0;
-    
-    printf("\n=== Search Sales Persons by Sales Range ===\n");
-    printf("Enter minimum sales value (in lakhs): ");
-    scanf("%lf", &min_sales);
-    printf("Enter maximum sales value (in lakhs): ");
-    scanf("%lf", &max_sales);
-    
-    printf("\nSales Persons with achieved sales between %.2f and %.2f lakhs:\n", min_sales, max_sales);
-    printf("----------------------------------------------------------------\n");
-    
-    // Check if showroom_tree is initialized
-    if (!showroom_tree || !showroom_tree->root) {
-        printf("No showrooms have been added yet.\n");
-        return;
-    }
-    
-    // Find the leftmost leaf node (first showroom)
-    BTreeNode* node = showroom_tree->root;
-    while (!node->is_leaf) {
-        node = node->children[0];
-    }
-    
-    // Traverse all showrooms
-    while (node) {
-        for (int i = 0; i < node->num_keys; i++) {
-            Showroom* showroom = (Showroom*)node->keys[i].key;
-            
-            if (showroom->sales_persons && showroom->sales_persons->root) {
-                // Find the leftmost leaf node of sales persons
-                BTreeNode* sp_node = showroom->sales_persons->root;
-                while (!sp_node->is_leaf) {
-                    sp_node = sp_node->children[0];
-                }
-                
-                // Traverse all sales persons in this showroom
-                while (sp_node) {
-                    for (int j = 0; j < sp_node->num_keys; j++) {
-                        SalesPerson* sp = (SalesPerson*)sp_node->keys[j].key;
-                        
-                        // Check if this sales person is within the range
-                        if (sp->achieved_sales >= min_sales && sp->achieved_sales <= max_sales) {
-                            found++;
-                            printf("ID: %d, Name: %s, Showroom: %s\n", sp->id, sp->name, showroom->name);
-                            printf("   Target: %.2f lakhs, Achieved: %.2f lakhs, Commission: %.2f\n", 
-                                  sp->target_sales, sp->achieved_sales, sp->commission);
-                            printf("   Cars Sold: %d\n", 
-                                  sp->sold_car_tree && sp->sold_car_tree->root ? 
-                                  count_nodes_in_tree(sp->sold_car_tree->root) : 0);
-                            printf("----------------------------------------------------------------\n");
-                        }
-                    }
-                    sp_node = sp_node->leaf_link.next;
-                }
-            }
-        }
-        node = node->leaf_link.next;
-    }
-    
-    if (!found) {
-        printf("No sales persons found within the specified sales range.\n");
-    } else {
-        printf("Total %d sales persons found within the specified range.\n", found);
-    }
-}
-
-
-
-
-
-// Process function for customer range search - defined outside the main function
-void process_customer_in_range(void* key, void* user_data) {
-    Customer* customer = (Customer*)key;
-    
-    // This struct holds all necessary context for processing
-    typedef struct {
-        int* count;           // Pointer to total count
-        int* showroom_matches; // Pointer to showroom count
-        Showroom* showroom;    // Current showroom
-    } RangeSearchContext;
-    
-    RangeSearchContext* context = (RangeSearchContext*)user_data;
-    SoldCar* sold_car = NULL;
-    
-    // Find the sold car in the showroom's sold_cars tree
-    if (context->showroom->sold_cars && context->showroom->sold_cars->root) {
-        sold_car = (SoldCar*)bplusSearch(context->showroom->sold_cars, customer->car_VIN);
-    }
-    
-    if (sold_car && strcmp(sold_car->payment_type, "Loan") == 0) {
-        (*context->count)++;
-        (*context->showroom_matches)++;
-        
-        printf("Customer: %s\n", customer->name);
-        printf("  Mobile: %s\n", customer->mobile);
-        printf("  Car VIN: %s\n", customer->car_VIN);
-        printf("  EMI Period: %d months\n", sold_car->loan_period_months);
-        printf("  Monthly EMI: %.2f\n", sold_car->monthly_emi);
-        printf("  Down Payment: %.2f\n", sold_car->down_payment);
-        printf("  Loan Amount: %.2f\n", sold_car->loan_amount);
-        printf("  Interest Rate: %.2f%%\n\n", sold_car->interest_rate);
-    }
-}
-
-// Main function to list customers with EMI plans within a user-specified range
-void list_customers_with_emi_in_range() {
-    // Get range from user
-    int min_months, max_months;
-    
-    printf("\n=== Search Customers by EMI Plan Duration ===\n");
-    printf("Enter minimum months (inclusive): ");
-    if (scanf("%d", &min_months) != 1) {
-        printf("Invalid input. Please enter a valid number.\n");
-        // Clear input buffer
-        while (getchar() != '\n');
-        return;
-    }
-    
-    printf("Enter maximum months (inclusive): ");
-    if (scanf("%d", &max_months) != 1) {
-        printf("Invalid input. Please enter a valid number.\n");
-        // Clear input buffer
-        while (getchar() != '\n');
-        return;
-    }
-    
-    // Validate input
-    if (min_months > max_months) {
-        printf("Error: Maximum months must be greater than or equal to minimum months.\n");
-        return;
-    }
-    
-    printf("\n=== Customers with EMI Plans Between %d-%d Months ===\n", 
-           min_months, max_months);
-    
-    if (!showroom_tree || !showroom_tree->root) {
-        printf("No showrooms available.\n");
-        return;
-    }
-    
-    int customer_count = 0;
-    
-    // Find the leftmost leaf node (first showroom)
-    BTreeNode* showroom_node = showroom_tree->root;
-    while (!showroom_node->is_leaf) {
-        showroom_node = showroom_node->children[0];
-    }
-    
-    // Traverse all showrooms
-    while (showroom_node) {
-        for (int i = 0; i < showroom_node->num_keys; i++) {
-            Showroom* showroom = (Showroom*)showroom_node->keys[i].key;
-            
-            printf("Checking Showroom: %s (ID: %d)\n", showroom->name, showroom->id);
-            
-            // Skip if no salespersons
-            if (!showroom->sales_persons || !showroom->sales_persons->root) {
-                printf("  No salespersons in this showroom.\n\n");
-                continue;
-            }
-            
-            int showroom_matches = 0;
-            
-            // Find the leftmost leaf node (first salesperson)
-            BTreeNode* sp_node = showroom->sales_persons->root;
-            while (!sp_node->is_leaf) {
-                sp_node = sp_node->children[0];
-            }
-            
-            // Traverse all salespersons in this showroom
-            while (sp_node) {
-                for (int j = 0; j < sp_node->num_keys; j++) {
-                    SalesPerson* sp = (SalesPerson*)sp_node->keys[j].key;
-                    
-                    if (!sp || !sp->customer_tree || !sp->customer_tree->root) {
-                        continue;  // Skip if no customers
-                    }
-                    
-                    printf("  Checking Salesperson: %s (ID: %d)\n", sp->name, sp->id);
-                    
-                    // Create context data for the process function
-                    typedef struct {
-                        int* count;
-                        int* showroom_matches;
-                        Showroom* showroom;
-                    } RangeSearchContext;
-                    
-                    RangeSearchContext context = {&customer_count, &showroom_matches, showroom};
-                    
-                    // Create temporary Customer objects for range bounds
-                    Customer min_customer, max_customer;
-                    min_customer.loan_months = min_months;
-                    max_customer.loan_months = max_months;
-                    
-                    // Perform range search on this salesperson's customer tree
-                    int before_count = customer_count;
-                    bplusRangeSearch(sp->customer_tree, &min_customer, &max_customer, 
-                                     process_customer_in_range, &context);
-                    
-                    // Report results for this salesperson
-                    int sp_matches = customer_count - before_count;
-                    if (sp_matches == 0) {
-                        printf("    No customers with EMI plans between %d-%d months found with this salesperson.\n", 
-                               min_months, max_months);
-                    } else {
-                        printf("    Found %d customers with matching EMI plans.\n", sp_matches);
-                    }
-                }
-                sp_node = sp_node->leaf_link.next;
-            }
-            
-            // Report if no matches found in this showroom
-            if (showroom_matches == 0) {
-                printf("  No customers with EMI plans between %d-%d months found in this showroom.\n\n", 
-                       min_months, max_months);
-            } else {
-                printf("  Total customers in showroom with matching EMI plans: %d\n\n", showroom_matches);
-            }
-        }
-        showroom_node = showroom_node->leaf_link.next;
-    }
-    
-    if (customer_count == 0) {
-        printf("\nNo customers with EMI plans between %d-%d months found in any showroom.\n", 
-               min_months, max_months);
-    } else {
-        printf("\nTotal customers found across all showrooms: %d\n", customer_count);
-    }
-}
\ No newline at end of file
+#include "essentialfunction.h"
+#include "journal.h"
+#include "snapshot.h"
+#include "archive.h"
+#include "stockfeed.h"
+#include "filehandling.h"
+
+// Function to display showroom inventory details
+void display_showroom_inventory() {
+    int showroom_id;
+    
+    out_printf("\n=== Display Showroom Inventory ===\n");
+    
+    // Get showroom ID
+    out_printf("Enter Showroom ID: ");
+    scanf("%d", &showroom_id);
+    getchar(); // Clear input buffer
+    
+    show_showroom_inventory(showroom_id);
+}
+
+// Print a showroom's details, available cars and sales personnel; 0 if there is no such showroom
+int show_showroom_inventory(int showroom_id) {
+    // Create a temporary showroom object to search the tree
+    Showroom temp;
+    temp.id = showroom_id;
+    
+    // Search for the showroom
+    Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp);
+    if (!showroom) {
+        out_printf("Showroom with ID %d not found.\n", showroom_id);
+        return 0;
+    }
+    
+    // Display showroom details
+    out_printf("\nShowroom Details:\n");
+    out_printf("ID: %d\n", showroom->id);
+    out_printf("Name: %s\n", showroom->name);
+    out_printf("Location: %s\n", showroom->location);
+    out_printf("Contact: %s\n", showroom->contact);
+    out_printf("Available Cars: %d\n", showroom->total_available_cars);
+    out_printf("Sold Cars: %d\n", showroom->total_sold_cars);
+    
+    // Display available cars
+    out_printf("\nAvailable Cars:\n");
+    if (!showroom->available_cars || !showroom->available_cars->root) {
+        out_printf("No available cars in this showroom.\n");
+    } else {
+        // Find the leftmost leaf node (first car)
+        BTreeNode* node = showroom->available_cars->root;
+        while (!node->is_leaf) {
+            node = node->children[0];
+        }
+        
+        // Traverse all leaf nodes to print all cars
+        int count = 0;
+        while (node) {
+            for (int i = 0; i < node->num_keys; i++) {
+                count++;
+                out_printf("%d. ", count);
+                showroom->available_cars->print(node->keys[i].key);
+                out_printf("\n");
+            }
+            node = node->leaf_link.next;
+        }
+        
+        if (count == 0) {
+            out_printf("No available cars in this showroom.\n");
+        }
+    }
+    
+    // Display sales personnel
+    out_printf("\nSales Personnel:\n");
+    if (!showroom->sales_persons || !showroom->sales_persons->root) {
+        out_printf("No sales personnel in this showroom.\n");
+    } else {
+        // Find the leftmost leaf node (first salesperson)
+        BTreeNode* node = showroom->sales_persons->root;
+        while (!node->is_leaf) {
+            node = node->children[0];
+        }
+        
+        // Traverse all leaf nodes to print all salespeople
+        int count = 0;
+        while (node) {
+            for (int i = 0; i < node->num_keys; i++) {
+                count++;
+                out_printf("%d. ", count);
+                showroom->sales_persons->print(node->keys[i].key);
+                out_printf("\n");
+            }
+            node = node->leaf_link.next;
+        }
+        
+        if (count == 0) {
+            out_printf("No sales personnel in this showroom.\n");
+        }
+    }
+    return 1;
+}
+
+
+
+
+// Helper function to count total nodes in a B+ tree
+int count_tree_nodes(BPlusTree* tree) {
+    if (!tree || !tree->root) {
+        return 0;
+    }
+    
+    int count = 0;
+    
+    // Find the leftmost leaf node
+    BTreeNode* node = tree->root;
+    while (!node->is_leaf) {
+        node = node->children[0];
+    }
+    
+    // Traverse all leaf nodes to count all keys
+    while (node) {
+        count += node->num_keys;
+        node = node->leaf_link.next;
+    }
+    
+    return count;
+}
+
+// Helper function to get all keys from a B+ tree with deep copy cloning
+void** getAllKeysInTree(BPlusTree* tree, int* count) {
+    if (!tree || !tree->root) {
+        *count = 0;
+        return NULL;
+    }
+    
+    // First, count all keys in the tree
+    int total_keys = count_tree_nodes(tree);
+    *count = total_keys;
+    
+    if (total_keys == 0) {
+        return NULL;
+    }
+    
+    // Allocate memory for all keys
+    void** keys = (void**)malloc(total_keys * sizeof(void*));
+    if (!keys) {
+        out_printf("Memory allocation failed for keys array\n");
+        *count = 0;
+        return NULL;
+    }
+    
+    // Find the leftmost leaf node
+    BTreeNode* node = tree->root;
+    while (!node->is_leaf) {
+        node = node->children[0];
+    }
+    
+    // Traverse all leaf nodes to collect all keys
+    // Using the clone function to create deep copies
+    int index = 0;
+    while (node && index < total_keys) {
+        for (int i = 0; i < node->num_keys && index < total_keys; i++) {
+            // Create a deep copy of each key using the tree's clone function
+            keys[index++] = tree->clone(node->keys[i].key);
+        }
+        node = node->leaf_link.next;
+    }
+    
+    return keys;
+}
+
+// Helper function to merge B+ trees with proper count tracking
+void merge_tree(BPlusTree *dest, BPlusTree *src, int *count) {
+    if (!src || !src->root) return;
+    if (!dest) return;
+    
+    // Get all items from source tree with deep copies
+    int item_count = 0;
+    void** items = getAllKeysInTree(src, &item_count);
+    
+    if (!items) return;
+    
+    // Insert each item into destination tree if not already present
+    int added = 0;
+    for (int i = 0; i < item_count; i++) {
+        void* key = items[i];
+        // Check if key already exists in destination tree
+        if (!bplusSearch(dest, key)) {
+            bplusInsert(dest, key);
+            added++;
+        }
+        // Free the temporary copy since bplusInsert makes its own copy
+        dest->free_func(key);
+    }
+    
+    // Update count if provided
+    if (count) {
+        *count += added;
+    }
+    
+    // Free the temporary array
+    free(items);
+}
+
+// Updated helper function to merge car trees (verbose lists every car as it is merged)
+void merge_car_tree(BPlusTree *dest, BPlusTree *src, int *count, int verbose) {
+    if (!src || !src->root) return;
+    if (!dest) return;
+    
+    // Get all cars from source tree with deep copies
+    int car_count = 0;
+    Car** cars = (Car**)getAllKeysInTree(src, &car_count);
+    
+    if (!cars) return;
+    
+    // Insert each car into destination tree if not already present
+    int added = 0;
+    for (int i = 0; i < car_count; i++) {
+        Car* car = cars[i];
+        // Check if car already exists in destination tree
+        if (!bplusSearch(dest, car)) {
+            bplusInsert(dest, car);
+            added++;
+            if (verbose) out_printf("  Added car with VIN: %s\n", car->VIN);
+        } else if (verbose) {
+            out_printf("  Car with VIN %s already exists, skipping.\n", car->VIN);
+        }
+        // Free the temporary copy
+        freeCar(car);
+    }
+    
+    // Update count if provided
+    if (count) {
+        *count += added;
+    }
+    
+    // Free the temporary array
+    free(cars);
+}
+
+static char merge_conflict_choice = 0;
+
+void set_merge_conflict_choice(char choice) {
+    merge_conflict_choice = choice;
+}
+
+// Conflict choice: asked for and recorded, or taken from the recorded list when replaying
+static char next_merge_decision(MergeDecisions* decisions) {
+    if (decisions->replaying) {
+        return decisions->next < decisions->count ? decisions->choices[decisions->next++] : 'e';
+    }
+    
+    char choice = 'e';
+    out_printf("  Keep existing (e), replace with new (n), or merge data (m)? ");
+    if (merge_conflict_choice) {
+        choice = merge_conflict_choice;
+        out_printf("%c\n", choice);
+    } else {
+        scanf(" %c", &choice);  // Note the space before %c to skip whitespace
+        getchar(); // Clear input buffer
+    }
+    
+    if (decisions->count == decisions->capacity) {
+        int capacity = decisions->capacity ? decisions->capacity * 2 : 8;
+        char* choices = (char*)realloc(decisions->choices, capacity);
+        if (!choices) return choice;
+        decisions->choices = choices;
+        decisions->capacity = capacity;
+    }
+    decisions->choices[decisions->count++] = choice;
+    return choice;
+}
+
+// Enhanced version of merge_sales_persons function with better conflict handling
+void merge_sales_persons(BPlusTree *dest, BPlusTree *src, MergeDecisions* decisions) {
+    int verbose = !decisions->replaying;
+    if (!src || !src->root) return;
+    if (!dest) return;
+    
+    // Get all sales persons from source tree with deep copies
+    int sp_count = 0;
+    SalesPerson** sales_persons = (SalesPerson**)getAllKeysInTree(src, &sp_count);
+    
+    if (!sales_persons) return;
+    
+    // Insert each sales person into destination tree if not already present
+    for (int i = 0; i < sp_count; i++) {
+        SalesPerson* sp_src = sales_persons[i];
+        SalesPerson temp;
+        temp.id = sp_src->id;
+        
+        // Check if sales person ID already exists
+        SalesPerson* existing = (SalesPerson*)bplusSearch(dest, &temp);
+        if (!existing) {
+            // Simply insert the new sales person
+            bplusInsert(dest, sp_src);
+            if (verbose) out_printf("  Added sales person ID: %d - %s\n", sp_src->id, sp_src->name);
+        } else {
+            // Handle conflict by showing details and asking for resolution
+            if (verbose) {
+                out_printf("  Conflict: Sales Person ID %d already exists.\n", sp_src->id);
+                out_printf("  Existing: %s, Target: %.2f, Achieved: %.2f\n", 
+                           existing->name, existing->target_sales, existing->achieved_sales);
+                out_printf("  New: %s, Target: %.2f, Achieved: %.2f\n", 
+                           sp_src->name, sp_src->target_sales, sp_src->achieved_sales);
+            }
+            
+            char choice = next_merge_decision(decisions);
+            
+            if (choice == 'n' || choice == 'N') {
+                // Replace existing with new - need to delete first
+                bplusDelete(dest, &temp);
+                bplusInsert(dest, sp_src);
+                if (verbose) out_printf("  Replaced with new sales person.\n");
+            } else if (choice == 'm' || choice == 'M') {
+                // Create a merged sales person
+                SalesPerson* merged = (SalesPerson*)malloc(sizeof(SalesPerson));
+                if (!merged) {
+                    out_printf("  Memory allocation failed for merged sales person.\n");
+                    continue;
+                }
+                
+                // Copy basic information
+                merged->id = sp_src->id;
+                strcpy(merged->name, sp_src->name);
+                
+                // Combine targets and achievements
+                merged->target_sales = existing->target_sales + sp_src->target_sales;
+                merged->achieved_sales = existing->achieved_sales + sp_src->achieved_sales;
+                merged->commission = existing->commission + sp_src->commission;
+                
+                // Create new trees for the merged sales person
+                merged->customer_tree = createBPlusTree(compareCustomerByEMI, printCustomer, cloneCustomer, freeCustomer);
+                merged->sold_car_tree = createBPlusTree(compareVIN, printSoldCar, cloneSoldCar, freeSoldCar);
+                
+                if (!merged->customer_tree || !merged->sold_car_tree) {
+                    out_printf("  Memory allocation failed for merged sales person trees.\n");
+                    if (merged->customer_tree) freeBPlusTree(merged->customer_tree);
+                    if (merged->sold_car_tree) freeBPlusTree(merged->sold_car_tree);
+                    free(merged);
+                    continue;
+                }
+                
+                // Merge customer trees if they exist
+                if (existing->customer_tree)
+                    merge_tree(merged->customer_tree, existing->customer_tree, NULL);
+                if (sp_src->customer_tree)
+                    merge_tree(merged->customer_tree, sp_src->customer_tree, NULL);
+                
+                // Merge sold car trees if they exist
+                if (existing->sold_car_tree)
+                    merge_tree(merged->sold_car_tree, existing->sold_car_tree, NULL);
+                if (sp_src->sold_car_tree)
+                    merge_tree(merged->sold_car_tree, sp_src->sold_car_tree, NULL);
+                
+                // Delete the existing entry (which frees its trees) once they are merged
+                bplusDelete(dest, &temp);
+                
+                // Insert the merged sales person
+                bplusInsert(dest, merged);
+                
+                // Free the temporary object (clone was made during insertion)
+                freeSalesPerson(merged);
+                
+                if (verbose) out_printf("  Merged sales person data successfully.\n");
+            } else if (verbose) {
+                out_printf("  Keeping existing sales person.\n");
+            }
+        }
+        
+        // Free the temporary copy
+        freeSalesPerson(sp_src);
+    }
+    
+    // Free the temporary array
+    free(sales_persons);
+}
+
+// Create showroom new_id holding the stock, sales and staff of both showrooms (which are kept).
+// Returns the stored showroom, NULL if it could not be created.
+Showroom* merge_showroom_pair(Showroom* showroom1, Showroom* showroom2, int new_id, const char* name,
+                              const char* location, const char* contact, MergeDecisions* decisions) {
+    // The merged showroom replaces both in the shared indexes, which must hold them first
+    snapshot_index_showroom(showroom1);
+    snapshot_index_showroom(showroom2);
+    // Archived sales move to the merged showroom with the others
+    archive_restore_sales(showroom1);
+    archive_restore_sales(showroom2);
+    
+    // Create the new merged showroom
+    Showroom* new_showroom = (Showroom*)malloc(sizeof(Showroom));
+    if (!new_showroom) {
+        out_printf("Memory allocation failed for new showroom\n");
+        return NULL;
+    }
+    
+    // Initialize the new showroom
+    new_showroom->id = new_id;
+    strcpy(new_showroom->name, name);
+    strcpy(new_showroom->location, location);
+    strcpy(new_showroom->contact, contact);
+    new_showroom->total_available_cars = 0;
+    new_showroom->total_sold_cars = 0;
+    new_showroom->dirty = SHOWROOM_DIRTY_ALL;
+    memset(new_showroom->segment_generation, 0, sizeof(new_showroom->segment_generation));
+    new_showroom->archive_run_count = 0;
+    new_showroom->snapshot_state = 0;
+    new_showroom->spilled = 0;
+    new_showroom->last_used = 0;
+    
+    // Initialize B+ trees for the new showroom
+    new_showroom->available_cars = createBPlusTree(compareVIN, printCar, cloneCar, freeCar);
+    new_showroom->sold_cars = createBPlusTree(compareVIN, printSoldCar, cloneSoldCar, freeSoldCar);
+    new_showroom->sales_persons = createBPlusTree(compareSalesPersonID, printSalesPerson, cloneSalesPerson, freeSalesPerson);
+    new_showroom->monthly_sales = createBPlusTree(compareMonthlySales, printMonthlySales, cloneMonthlySales, freeMonthlySales);
+    new_showroom->leaderboard = NULL;
+    new_showroom->leaderboard_count = 0;
+    new_showroom->leaderboard_capacity = 0;
+    new_showroom->popularity_window = NULL;
+    
+    if (!new_showroom->available_cars || !new_showroom->sold_cars || !new_showroom->sales_persons || !new_showroom->monthly_sales) {
+        out_printf("Memory allocation failed for B+ trees\n");
+        if (new_showroom->available_cars) freeBPlusTree(new_showroom->available_cars);
+        if (new_showroom->sold_cars) freeBPlusTree(new_showroom->sold_cars);
+        if (new_showroom->sales_persons) freeBPlusTree(new_showroom->sales_persons);
+        if (new_showroom->monthly_sales) freeBPlusTree(new_showroom->monthly_sales);
+        free(new_showroom);
+        return NULL;
+    }
+    
+    int verbose = !decisions->replaying;
+    
+    // Merge available cars
+    if (verbose) out_printf("Merging available cars...\n");
+    if (showroom1->available_cars)
+        merge_car_tree(new_showroom->available_cars, showroom1->available_cars, &new_showroom->total_available_cars, verbose);
+    if (showroom2->available_cars)
+        merge_car_tree(new_showroom->available_cars, showroom2->available_cars, &new_showroom->total_available_cars, verbose);
+    
+    // Merge sold cars
+    if (verbose) out_printf("Merging sold cars...\n");
+    if (showroom1->sold_cars)
+        merge_car_tree(new_showroom->sold_cars, showroom1->sold_cars, &new_showroom->total_sold_cars, verbose);
+    if (showroom2->sold_cars)
+        merge_car_tree(new_showroom->sold_cars, showroom2->sold_cars, &new_showroom->total_sold_cars, verbose);
+    
+    // Merge sales persons (handling potential ID conflicts)
+    if (verbose) out_printf("Merging sales personnel...\n");
+    if (showroom1->sales_persons)
+        merge_sales_persons(new_showroom->sales_persons, showroom1->sales_persons, decisions);
+    if (showroom2->sales_persons)
+        merge_sales_persons(new_showroom->sales_persons, showroom2->sales_persons, decisions);
+    
+    // Rebuild the sales ledger from the customers that ended up in the merged showroom
+    rebuild_monthly_sales(new_showroom);
+    rebuild_popularity_window(new_showroom);
+    
+    // Insert the new showroom into the global tree and index its customers
+    Showroom* stored_showroom = (Showroom*)bplusInsert(showroom_tree, new_showroom);
+    customer_index_add_showroom(stored_showroom);
+    inventory_changed();
+    return stored_showroom;
+}
+
+// Take a showroom out of the global tree and the customer index
+void remove_showroom(int showroom_id) {
+    Showroom temp;
+    temp.id = showroom_id;
+    Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp);
+    if (!showroom) return;
+    
+    customer_index_remove_showroom(showroom);
+    snapshot_retire_showroom(showroom);
+    bplusDelete(showroom_tree, &temp);
+    inventory_changed();
+}
+
+// Function to merge two showrooms based on user-provided IDs
+void merge_showrooms() {
+    int id1, id2, new_id;
+    char name[MAX_STR_LEN], location[MAX_STR_LEN], contact[MAX_MOBILE_LEN];
+    
+    out_printf("\n=== Merge Showrooms ===\n");
+    
+    // Get the IDs of the showrooms to merge
+    out_printf("Enter first showroom ID: ");
+    scanf("%d", &id1);
+    getchar(); // Clear input buffer
+    
+    out_printf("Enter second showroom ID: ");
+    scanf("%d", &id2);
+    getchar();
+    
+    // Create temporary showrooms for searching
+    Showroom temp1 = { .id = id1 };
+    Showroom temp2 = { .id = id2 };
+    
+    // Search for the showrooms in the global tree
+    Showroom* showroom1 = (Showroom*)bplusSearch(showroom_tree, &temp1);
+    Showroom* showroom2 = (Showroom*)bplusSearch(showroom_tree, &temp2);
+    
+    if (!showroom1 || !showroom2) {
+        out_printf("Error: One or both showrooms not found.\n");
+        return;
+    }
+    
+    // Get details for the new merged showroom
+    out_printf("\nEnter details for the merged showroom:\n");
+    out_printf("New Showroom ID: ");
+    scanf("%d", &new_id);
+    getchar();
+    
+    // Check if new ID already exists
+    Showroom temp_new = { .id = new_id };
+    if (bplusSearch(showroom_tree, &temp_new)) {
+        out_printf("Error: Showroom ID %d already exists.\n", new_id);
+        return;
+    }
+    
+    out_printf("New Showroom Name: ");
+    fgets(name, MAX_STR_LEN, stdin);
+    name[strcspn(name, "\n")] = 0;
+    
+    out_printf("New Showroom Location: ");
+    fgets(location, MAX_STR_LEN, stdin);
+    location[strcspn(location, "\n")] = 0;
+    
+    out_printf("New Showroom Contact Number: ");
+    fgets(contact, MAX_MOBILE_LEN, stdin);
+    contact[strcspn(contact, "\n")] = 0;
+    
+    // Build the merged showroom, asking how to settle salesperson ID conflicts
+    MergeDecisions decisions;
+    memset(&decisions, 0, sizeof(decisions));
+    Showroom* new_showroom = merge_showroom_pair(showroom1, showroom2, new_id, name, location, contact, &decisions);
+    if (!new_showroom) {
+        free(decisions.choices);
+        return;
+    }
+    
+    // Print summary of the merge
+    out_printf("\nMerge Summary:\n");
+    out_printf("New Showroom ID: %d\n", new_showroom->id);
+    out_printf("Name: %s\n", new_showroom->name);
+    out_printf("Location: %s\n", new_showroom->location);
+    out_printf("Available Cars: %d\n", new_showroom->total_available_cars);
+    out_printf("Sold Cars: %d\n", new_showroom->total_sold_cars);
+    
+    // Count sales persons
+    int sales_person_count = count_tree_nodes(new_showroom->sales_persons);
+    out_printf("Sales Personnel: %d\n", sales_person_count);
+    
+    out_printf("\nShowrooms %d and %d successfully merged into new showroom %d.\n", id1, id2, new_id);
+    
+    // Option to delete original showrooms
+    char delete_original;
+    out_printf("\nDo you want to delete the original showrooms? (y/n): ");
+    scanf(" %c", &delete_original);  // Note the space before %c to skip whitespace
+    getchar(); // Clear input buffer
+    
+    int delete_originals = delete_original == 'y' || delete_original == 'Y';
+    if (delete_originals) {
+        // Delete original showrooms from the global tree
+        remove_showroom(id1);
+        remove_showroom(id2);
+        out_printf("Original showrooms deleted.\n");
+    }
+    journal_log_merge(id1, id2, new_id, name, location, contact, &decisions, delete_originals);
+    free(decisions.choices);
+
+    // Display updated inventory
+    out_printf("\nDisplaying merged showroom inventory:\n");
+    temp_new.id = new_id;  // Set to display the new showroom
+    Showroom* merged_showroom = (Showroom*)bplusSearch(showroom_tree, &temp_new);
+    if (merged_showroom) {
+        // Display the new showroom details
+        out_printf("\nShowroom Details:\n");
+        out_printf("ID: %d\n", merged_showroom->id);
+        out_printf("Name: %s\n", merged_showroom->name);
+        out_printf("Location: %s\n", merged_showroom->location);
+        out_printf("Contact: %s\n", merged_showroom->contact);
+        out_printf("Available Cars: %d\n", merged_showroom->total_available_cars);
+        out_printf("Sold Cars: %d\n", merged_showroom->total_sold_cars);
+        
+            
+    } else {
+        out_printf("Error: Could not find newly created showroom for display.\n");
+    }
+    
+    // No need to free new_showroom here as it's now owned by the tree
+    // The bplusInsert function has already made a copy of it
+}
+
+
+// Every salesperson ID conflict is settled with conflict_choice instead of asking
+int perform_merge(int id1, int id2, int new_id, const char* name, const char* location, const char* contact,
+                  char conflict_choice, int delete_originals) {
+    Showroom temp1 = { .id = id1 };
+    Showroom temp2 = { .id = id2 };
+    Showroom* showroom1 = (Showroom*)bplusSearch(showroom_tree, &temp1);
+    Showroom* showroom2 = (Showroom*)bplusSearch(showroom_tree, &temp2);
+    if (!showroom1 || !showroom2) {
+        out_printf("Error: One or both showrooms not found.\n");
+        return 0;
+    }
+    
+    Showroom temp_new = { .id = new_id };
+    if (bplusSearch(showroom_tree, &temp_new)) {
+        out_printf("Error: Showroom ID %d already exists.\n", new_id);
+        return 0;
+    }
+    
+    MergeDecisions decisions;
+    memset(&decisions, 0, sizeof(decisions));
+    set_merge_conflict_choice(conflict_choice);
+    Showroom* new_showroom = merge_showroom_pair(showroom1, showroom2, new_id, name, location, contact, &decisions);
+    set_merge_conflict_choice(0);
+    if (!new_showroom) {
+        free(decisions.choices);
+        return 0;
+    }
+    
+    if (delete_originals) {
+        remove_showroom(id1);
+        remove_showroom(id2);
+    }
+    journal_log_merge(id1, id2, new_id, name, location, contact, &decisions, delete_originals);
+    free(decisions.choices);
+    return 1;
+}
+
+// Function to display all car models and their popularity
+void display_car_popularity() {
+    out_printf("\n=== Car Popularity Statistics ===\n");
+    int total_models = car_model_count();
+    
+    // Models are listed in the order they were first sold
+    for (int i = 0; i < total_models; i++) {
+        CarPopularityEntry* entry = car_popularity_entry(i);
+        out_printf("Model: %-20s | Sold: %d\n", entry->model_name, entry->count);
+    }
+    
+    if (total_models == 0) {
+        out_printf("No cars have been sold yet.\n");
+        return;
+    }
+    
+    int max_count;
+    char* most_popular = find_most_popular_car(&max_count);
+    out_printf("\nMost Popular Model: %s (Sold: %d)\n", most_popular, max_count);
+    
+    CarPopularityEntry* top[POPULARITY_TOP_K];
+    int top_count = top_car_models(POPULARITY_TOP_K, top);
+    out_printf("\nTop %d Models:\n", top_count);
+    for (int i = 0; i < top_count; i++) {
+        out_printf("%2d. %-20s | Sold: %d\n", i + 1, top[i]->model_name, top[i]->count);
+    }
+}
+
+
+
+
+
+
+// Function to find the most successful salesperson in a specific showroom
+void find_most_successful_SP() {
+    if (!showroom_tree || !showroom_tree->root) {
+        out_printf("No showrooms registered in the system.\n");
+        return;
+    }
+    
+    // Get showroom ID from user
+    int showroom_id;
+    out_printf("\nEnter Showroom ID: ");
+    scanf("%d", &showroom_id);
+    
+    award_best_salesperson_incentive(showroom_id);
+}
+
+// Award the showroom's best salesperson 1% of their achieved sales; 0 if there is nobody to award
+int award_best_salesperson_incentive(int showroom_id) {
+    // Create temporary showroom for search
+    Showroom temp_showroom;
+    temp_showroom.id = showroom_id;
+    
+    // Search for the showroom
+    Showroom* target_showroom = (Showroom*)bplusSearch(showroom_tree, &temp_showroom);
+    if (!target_showroom) {
+        out_printf("Showroom with ID %d not found.\n", showroom_id);
+        return 0;
+    }
+    
+    // Check if this showroom has any salespeople
+    if (!target_showroom->sales_persons || !target_showroom->sales_persons->root) {
+        out_printf("No sales persons found in Showroom %d: %s.\n", target_showroom->id, target_showroom->name);
+        return 0;
+    }
+    
+    // The showroom's leaderboard keeps the best salesperson at the front
+    SalesPerson* best_sp = leaderboard_best(target_showroom);
+    
+    // Print results and award incentive
+    if (best_sp) {
+        double incentive = best_sp->achieved_sales * 0.01; // 1% of achieved sales
+        
+        out_printf("\n=== Most Successful Sales Person in %s (ID: %d) ===\n", 
+                   target_showroom->name, target_showroom->id);
+        out_printf("ID: %d\n", best_sp->id);
+        out_printf("Name: %s\n", best_sp->name);
+        out_printf("Target Sales: %.2f lakhs\n", best_sp->target_sales);
+        out_printf("Achieved Sales: %.2f lakhs\n", best_sp->achieved_sales);
+        out_printf("Current Commission: %.2f lakhs\n", best_sp->commission);
+        out_printf("\n");
+        out_printf("--- Awarding Additional Incentive ---\n");
+        out_printf("Additional Incentive (1%%): %.2f lakhs\n", incentive);
+        out_printf("Total Earnings: %.2f lakhs\n", best_sp->commission + incentive);
+        
+        // Update the salesperson's commission
+        best_sp->commission += incentive;
+        target_showroom->dirty |= SHOWROOM_DIRTY(SHOWROOM_SALESPERSONS);
+        journal_log_incentive(target_showroom->id, best_sp->id, incentive);
+        out_printf("\nIncentive awarded successfully!\n");
+        return 1;
+    }
+    out_printf("No sales persons found in Showroom %d: %s.\n", 
+               target_showroom->id, target_showroom->name);
+    return 0;
+}
+
+
+
+
+
+
+// Function to predict next month's sales from the showroom's sales ledger
+void predict_next_month_sales() {
+    if (!showroom_tree || !showroom_tree->root) {
+        out_printf("No showrooms registered in the system.\n");
+        return;
+    }
+    
+    // Get showroom ID from user
+    int showroom_ID;
+    out_printf("Enter Showroom ID for sales prediction: ");
+    scanf("%d", &showroom_ID);
+    
+    show_sales_prediction(showroom_ID);
+}
+
+// Print a showroom's last 6 months of sales and the average of them as next month's prediction;
+// 0 if there is no such showroom
+int show_sales_prediction(int showroom_ID) {
+    // Create a temporary showroom to search for the specific ID
+    Showroom temp_showroom = {0};
+    temp_showroom.id = showroom_ID;
+    
+    // Search for the specific showroom
+    Showroom* target_showroom = (Showroom*)bplusSearch(showroom_tree, &temp_showroom);
+    if (!target_showroom) {
+        out_printf("Showroom with ID %d not found.\n", showroom_ID);
+        return 0;
+    }
+    
+    // Get current date
+    int current_day, current_month, current_year;
+    days_to_date(today_days(), &current_day, &current_month, &current_year);
+    
+    // Prepare array to store last 6 months of sales (or fewer if not enough data)
+    MonthlySales sales_history[6] = {0};
+    
+    // Initialize the sales history array with the last 6 months
+    for (int i = 0; i < 6; i++) {
+        sales_history[i].month = current_month - i;
+        sales_history[i].year = current_year;
+        
+        // Adjust year if we go back to previous year
+        if (sales_history[i].month <= 0) {
+            sales_history[i].month += 12;
+            sales_history[i].year--;
+        }
+    }
+    
+    // Read each month straight from the showroom's sales ledger
+    if (target_showroom->monthly_sales) {
+        for (int i = 0; i < 6; i++) {
+            MonthlySales* ledger_month = (MonthlySales*)bplusSearch(target_showroom->monthly_sales, &sales_history[i]);
+            if (ledger_month) {
+                sales_history[i].sales_count = ledger_month->sales_count;
+                sales_history[i].sales_value = ledger_month->sales_value;
+            }
+        }
+    }
+    
+    // Display the sales history for this showroom
+    out_printf("\n=== Sales History for Showroom ID %d ===\n", showroom_ID);
+    out_printf("Month\tYear\tUnits Sold\tValue \n");
+    for (int i = 5; i >= 0; i--) {
+        out_printf("%d\t%d\t%d\t\t%.2f\n", 
+                   sales_history[i].month, sales_history[i].year, 
+                   sales_history[i].sales_count, sales_history[i].sales_value);
+    }
+    
+    // Calculate simple average 
+    double total_units = 0;
+    double total_value = 0;
+    int months_with_data = 0;
+    
+    for (int i = 0; i < 6; i++) {
+        total_units += sales_history[i].sales_count;
+        total_value += sales_history[i].sales_value;
+        if (sales_history[i].sales_count > 0) {
+            months_with_data++;
+        }
+    }
+    
+    // Calculate next month and year
+    int next_month = current_month + 1;
+    int next_year = current_year;
+    if (next_month > 12) {
+        next_month = 1;
+        next_year++;
+    }
+    
+    // Calculate prediction - even if no cars were sold
+    double predicted_units = 0;
+    double predicted_value = 0;
+    
+    // If we have data, calculate average, otherwise predict zero
+    if (months_with_data > 0) {
+        predicted_units = total_units / 6.0; // Always divide by 6 months, even if some months had zero sales
+        predicted_value = total_value / 6.0;
+    }
+    
+    // Display prediction
+    out_printf("\n=== Sales Prediction for %d/%d (Showroom ID %d) ===\n", next_month, next_year, showroom_ID);
+    out_printf("Predicted Units: %.1f\n", predicted_units);
+    out_printf("Predicted Value: %.2f \n", predicted_value);
+    if (predicted_units > 0) {
+        out_printf("Average Price Per Unit: %.2f \n", predicted_value / predicted_units);
+    } else {
+        out_printf("Average Price Per Unit: 0.00 \n");
+    }
+    return 1;
+}
+
+
+
+
+
+
+
+static void print_sold_car_details(const SoldCar* sold_car) {
+    out_printf("VIN: %s\n", sold_car->VIN);
+    out_printf("Payment Type: %s\n", payment_type_name(sold_car->payment_type));
+    
+    if (sold_car->payment_type == PAYMENT_LOAN) {
+        out_printf("Down Payment: %.2f lakhs\n", sold_car->down_payment);
+        out_printf("Loan Period: %d months\n", sold_car->loan_period_months);
+        out_printf("Loan Amount: %.2f lakhs\n", sold_car->loan_amount);
+        out_printf("Interest Rate: %.2f%%\n", sold_car->interest_rate_bps / 100.0);
+        out_printf("Monthly EMI: %.2f\n", sold_car->monthly_emi);
+    }
+}
+
+static void print_customer_details(const Customer* customer, const char* name, const char* address, const SalesPerson* sp) {
+    int day, month, year;
+    days_to_date(customer->purchase_date, &day, &month, &year);
+    out_printf("\nCustomer Details:\n");
+    out_printf("Name: %s\n", name);
+    out_printf("Mobile: %s\n", customer->mobile);
+    out_printf("Address: %s\n", address);
+    out_printf("Registration Number: %s\n", customer->reg_number);
+    out_printf("Amount Paid: %.2f lakhs\n", customer->actual_aoumnt_paid);
+    out_printf("Purchase Date: %d/%d/%d\n", day, month, year);
+    out_printf("Sales Person: %s (ID: %d)\n", sp->name, sp->id);
+}
+
+typedef struct {
+    Showroom* showroom;
+    int found;
+} ArchivedSaleLookup;
+
+// A sale found in a showroom's archive, printed like one still in memory
+static void print_archived_sale(const ArchivedSale* sale, void* user_data) {
+    ArchivedSaleLookup* lookup = (ArchivedSaleLookup*)user_data;
+    Showroom* showroom = lookup->showroom;
+    if (!(sale->sold_car_in & ARCHIVE_IN_SHOWROOM)) return;
+    
+    lookup->found = 1;
+    out_printf("\nCAR FOUND (SOLD, ARCHIVED) at %s showroom:\n", showroom->name);
+    print_sold_car_details(&sale->sold_car);
+    
+    SalesPerson temp_sp;
+    temp_sp.id = sale->salesperson_id;
+    SalesPerson* sp = (SalesPerson*)bplusSearch(showroom->sales_persons, &temp_sp);
+    if (sp) print_customer_details(&sale->customer, sale->name, sale->address, sp);
+}
+
+void find_car_by_VIN() {
+    char target_VIN[VIN_INPUT_LEN];
+    
+    out_printf("\n=== Find Car by VIN ===\n");
+    out_printf("Enter the VIN number: ");
+    if (scanf("%63s", target_VIN) != 1) return;
+    if (strlen(target_VIN) >= MAX_VIN_LEN) {
+        out_printf("A VIN is 1 to %d characters.\n", MAX_VIN_LEN - 1);
+        return;
+    }
+    
+    locate_car_by_VIN(target_VIN);
+}
+
+// Print where a car is in stock or was sold; 0 if it is nowhere
+int locate_car_by_VIN(const char* vin) {
+    char target_VIN[MAX_VIN_LEN];
+    int found = 0;
+    snprintf(target_VIN, sizeof(target_VIN), "%s", vin);
+    
+    // Check if showroom_tree is initialized
+    if (!showroom_tree || !showroom_tree->root) {
+        out_printf("No showrooms have been added yet.\n");
+        return 0;
+    }
+    
+    snapshot_load_all_showrooms();
+    
+    // Find the leftmost leaf node (first showroom)
+    BTreeNode* node = showroom_tree->root;
+    while (!node->is_leaf) {
+        node = node->children[0];
+    }
+    
+    // Traverse all showrooms
+    while (node) {
+        for (int i = 0; i < node->num_keys; i++) {
+            Showroom* showroom = (Showroom*)node->keys[i].key;
+            
+            // Check available cars
+            if (showroom->available_cars && showroom->available_cars->root) {
+                Car* car = (Car*)bplusSearch(showroom->available_cars, &target_VIN);
+                if (car) {
+                    out_printf("\nCAR FOUND IN STOCK at %s showroom:\n", showroom->name);
+                    out_printf("VIN: %s\n", car->VIN);
+                    out_printf("Model: %s\n", car->name);
+                    out_printf("Color: %s\n", car->color);
+                    out_printf("Price: %.2f lakhs\n", car->price);
+                    out_printf("Fuel Type: %s\n", car->fuel_type);
+                    out_printf("Car Type: %s\n", car->car_type);
+                    out_printf("Status: Available for purchase\n");
+                    found = 1;
+                }
+            }
+            
+            // Check sold cars
+            int sold_here = 0;
+            if (showroom->sold_cars && showroom->sold_cars->root) {
+                SoldCar* sold_car = (SoldCar*)bplusSearch(showroom->sold_cars, &target_VIN);
+                if (sold_car) {
+                    out_printf("\nCAR FOUND (SOLD) at %s showroom:\n", showroom->name);
+                    print_sold_car_details(sold_car);
+                    
+                    // Look for customer information via sales persons
+                    if (showroom->sales_persons && showroom->sales_persons->root) {
+                        BTreeNode* sp_node = showroom->sales_persons->root;
+                        while (!sp_node->is_leaf) {
+                            sp_node = sp_node->children[0];
+                        }
+                        
+                        int customer_found = 0;
+                        while (sp_node && !customer_found) {
+                            for (int j = 0; j < sp_node->num_keys && !customer_found; j++) {
+                                SalesPerson* sp = (SalesPerson*)sp_node->keys[j].key;
+                                
+                                if (sp->customer_tree && sp->customer_tree->root) {
+                                    // Look for customer with this VIN
+                                    BTreeNode* cust_node = sp->customer_tree->root;
+                                    while (!cust_node->is_leaf) {
+                                        cust_node = cust_node->children[0];
+                                    }
+                                    
+                                    while (cust_node && !customer_found) {
+                                        for (int k = 0; k < cust_node->num_keys; k++) {
+                                            Customer* customer = (Customer*)cust_node->keys[k].key;
+                                            if (strcmp(customer->car_VIN, target_VIN) == 0) {
+                                                print_customer_details(customer, customer_name(customer),
+                                                                       customer_address(customer), sp);
+                                                customer_found = 1;
+                                                break;
+                                            }
+                                        }
+                                        cust_node = cust_node->leaf_link.next;
+                                    }
+                                }
+                            }
+                            sp_node = sp_node->leaf_link.next;
+                        }
+                    }
+                    found = 1;
+                    sold_here = 1;
+                }
+            }
+            
+            // Old sales may have moved to the showroom's archive
+            if (!sold_here) {
+                ArchivedSaleLookup lookup = {showroom, 0};
+                archive_find_sale(showroom, target_VIN, print_archived_sale, &lookup);
+                if (lookup.found) found = 1;
+            }
+        }
+        node = node->leaf_link.next;
+    }
+    
+    if (!found) {
+        out_printf("\nNo car found with VIN: %s\n", target_VIN);
+    }
+    return found;
+}
+
+
+
+
+
+
+int count_nodes_in_tree(BTreeNode* node) {
+    if (!node) return 0;
+    
+    int count = 0;
+    if (node->is_leaf) {
+        count = node->num_keys;
+    } else {
+        for (int i = 0; i <= node->num_keys; i++) {
+            count += count_nodes_in_tree(node->children[i]);
+        }
+    }
+    return count;
+}
+
+void search_salespersons_by_sales_range() {
+    double min_sales, max_sales;
+    
+    out_printf("\n=== Search Sales Persons by Sales Range ===\n");
+    out_printf("Enter minimum sales value (in lakhs): ");
+    scanf("%lf", &min_sales);
+    out_printf("Enter maximum sales value (in lakhs): ");
+    scanf("%lf", &max_sales);
+    
+    show_salespersons_in_sales_range(min_sales, max_sales);
+}
+
+// Print every showroom's sales persons whose achieved sales are within [min_sales, max_sales];
+// 0 if there are no showrooms
+int show_salespersons_in_sales_range(double min_sales, double max_sales) {
+    int found = 0;
+    
+    out_printf("\nSales Persons with achieved sales between %.2f and %.2f lakhs:\n", min_sales, max_sales);
+    out_printf("----------------------------------------------------------------\n");
+    
+    // Check if showroom_tree is initialized
+    if (!showroom_tree || !showroom_tree->root) {
+        out_printf("No showrooms have been added yet.\n");
+        return 0;
+    }
+    
+    snapshot_load_all_showrooms();
+    
+    // Find the leftmost leaf node (first showroom)
+    BTreeNode* node = showroom_tree->root;
+    while (!node->is_leaf) {
+        node = node->children[0];
+    }
+    
+    // Traverse all showrooms
+    while (node) {
+        for (int i = 0; i < node->num_keys; i++) {
+            Showroom* showroom = (Showroom*)node->keys[i].key;
+            
+            if (showroom->sales_persons && showroom->sales_persons->root) {
+                // Find the leftmost leaf node of sales persons
+                BTreeNode* sp_node = showroom->sales_persons->root;
+                while (!sp_node->is_leaf) {
+                    sp_node = sp_node->children[0];
+                }
+                
+                // Traverse all sales persons in this showroom
+                while (sp_node) {
+                    for (int j = 0; j < sp_node->num_keys; j++) {
+                        SalesPerson* sp = (SalesPerson*)sp_node->keys[j].key;
+                        
+                        // Check if this sales person is within the range
+                        if (sp->achieved_sales >= min_sales && sp->achieved_sales <= max_sales) {
+                            found++;
+                            out_printf("ID: %d, Name: %s, Showroom: %s\n", sp->id, sp->name, showroom->name);
+                            out_printf("   Target: %.2f lakhs, Achieved: %.2f lakhs, Commission: %.2f\n", 
+                                      sp->target_sales, sp->achieved_sales, sp->commission);
+                            out_printf("   Cars Sold: %d\n", 
+                                      sp->sold_car_tree && sp->sold_car_tree->root ? 
+                                      count_nodes_in_tree(sp->sold_car_tree->root) : 0);
+                            out_printf("----------------------------------------------------------------\n");
+                        }
+                    }
+                    sp_node = sp_node->leaf_link.next;
+                }
+            }
+        }
+        node = node->leaf_link.next;
+    }
+    
+    if (!found) {
+        out_printf("No sales persons found within the specified sales range.\n");
+    } else {
+        out_printf("Total %d sales persons found within the specified range.\n", found);
+    }
+    return 1;
+}
+
+
+
+
+
+// Process function for the EMI index range search
+void process_customer_in_range(void* key, void* user_data) {
+    EmiIndexEntry* entry = (EmiIndexEntry*)key;
+    int* count = (int*)user_data;
+    
+    (*count)++;
+    
+    out_printf("Customer: %s\n", customer_name(entry->customer));
+    out_printf("  Mobile: %s\n", entry->customer->mobile);
+    out_printf("  Car VIN: %s\n", entry->customer->car_VIN);
+    out_printf("  Showroom: %s (ID: %d)\n", entry->showroom->name, entry->showroom->id);
+    out_printf("  Salesperson: %s (ID: %d)\n", entry->sales_person->name, entry->sales_person->id);
+    out_printf("  EMI Period: %d months\n", entry->sold_car->loan_period_months);
+    out_printf("  Monthly EMI: %.2f\n", entry->sold_car->monthly_emi);
+    out_printf("  Down Payment: %.2f\n", entry->sold_car->down_payment);
+    out_printf("  Loan Amount: %.2f\n", entry->sold_car->loan_amount);
+    out_printf("  Interest Rate: %.2f%%\n\n", entry->sold_car->interest_rate_bps / 100.0);
+}
+
+// Main function to list customers with EMI plans within a user-specified range
+void list_customers_with_emi_in_range() {
+    // Get range from user
+    int min_months, max_months;
+    
+    out_printf("\n=== Search Customers by EMI Plan Duration ===\n");
+    out_printf("Enter minimum months (inclusive): ");
+    if (scanf("%d", &min_months) != 1) {
+        out_printf("Invalid input. Please enter a valid number.\n");
+        // Clear input buffer
+        clear_input_line();
+        return;
+    }
+    
+    out_printf("Enter maximum months (inclusive): ");
+    if (scanf("%d", &max_months) != 1) {
+        out_printf("Invalid input. Please enter a valid number.\n");
+        // Clear input buffer
+        clear_input_line();
+        return;
+    }
+    
+    show_customers_with_emi_months(min_months, max_months);
+}
+
+// Print the customers whose loan period is within [min_months, max_months]; 0 if the range is
+// empty or there are no showrooms
+int show_customers_with_emi_months(int min_months, int max_months) {
+    // Validate input
+    if (min_months > max_months) {
+        out_printf("Error: Maximum months must be greater than or equal to minimum months.\n");
+        return 0;
+    }
+    
+    out_printf("\n=== Customers with EMI Plans Between %d-%d Months ===\n", 
+               min_months, max_months);
+    
+    if (!showroom_tree || !showroom_tree->root) {
+        out_printf("No showrooms available.\n");
+        return 0;
+    }
+    
+    // One range scan over the global EMI index, already joined to the sale records
+    snapshot_load_all_showrooms();
+    int customer_count = 0;
+    emi_index_range_search(min_months, max_months, process_customer_in_range, &customer_count);
+    
+    if (customer_count == 0) {
+        out_printf("\nNo customers with EMI plans between %d-%d months found in any showroom.\n", 
+                   min_months, max_months);
+    } else {
+        out_printf("\nTotal customers found across all showrooms: %d\n", customer_count);
+    }
+    return 1;
+}
+
+
+// Print one customer found through the front-desk index
+void print_indexed_customer(CustomerIndexEntry* entry, void* user_data) {
+    int* count = (int*)user_data;
+    Customer* customer = entry->customer;
+    int day, month, year;
+    days_to_date(customer->purchase_date, &day, &month, &year);
+    
+    (*count)++;
+    out_printf("\n%d. Customer: %s\n", *count, customer_name(customer));
+    out_printf("   Mobile: %s\n", customer->mobile);
+    out_printf("   Address: %s\n", customer_address(customer));
+    out_printf("   Car VIN: %s\n", customer->car_VIN);
+    out_printf("   Registration Number: %s\n", customer->reg_number);
+    out_printf("   Purchase Date: %d/%d/%d\n", day, month, year);
+    out_printf("   Sales Person: %s (ID: %d)\n", entry->sales_person->name, entry->sales_person->id);
+    out_printf("   Showroom: %s (ID: %d)\n", entry->showroom->name, entry->showroom->id);
+}
+
+// Function to look up a customer by mobile number or registration number
+void find_customer_by_contact() {
+    int search_type;
+    char search_key[MAX_STR_LEN];
+    
+    out_printf("\n=== Find Customer ===\n");
+    out_printf("1. Search by Mobile Number\n");
+    out_printf("2. Search by Registration Number\n");
+    out_printf("Enter choice: ");
+    if (scanf("%d", &search_type) != 1) {
+        out_printf("Invalid input.\n");
+        clear_input_line();
+        return;
+    }
+    getchar(); // Clear input buffer
+    
+    if (search_type == 1) {
+        out_printf("Enter Mobile Number: ");
+    } else if (search_type == 2) {
+        out_printf("Enter Registration Number: ");
+    } else {
+        out_printf("Invalid choice.\n");
+        return;
+    }
+    
+    fgets(search_key, MAX_STR_LEN, stdin);
+    search_key[strcspn(search_key, "\n")] = 0; // Remove newline
+    
+    show_customers_by_contact(search_type == 2, search_key);
+}
+
+// Print the customers with this mobile number, or registration number with by_registration set;
+// 0 if there are none
+int show_customers_by_contact(int by_registration, const char* search_key) {
+    int count = 0;
+    
+    snapshot_load_all_showrooms();
+    if (!by_registration) {
+        customer_index_find_by_mobile(search_key, print_indexed_customer, &count);
+    } else {
+        customer_index_find_by_reg(search_key, print_indexed_customer, &count);
+    }
+    
+    if (count == 0) {
+        out_printf("\nNo customer found for: %s\n", search_key);
+        return 0;
+    }
+    out_printf("\nTotal customers found: %d\n", count);
+    return 1;
+}
+
+
+// The showroom with this ID, or NULL after saying there is none
+static Showroom* find_showroom_or_say(int showroom_id) {
+    Showroom temp_showroom;
+    temp_showroom.id = showroom_id;
+    Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp_showroom);
+    if (!showroom) {
+        out_printf("Showroom with ID %d not found.\n", showroom_id);
+    }
+    return showroom;
+}
+
+// Function to display the live salesperson ranking of a showroom
+void display_sales_leaderboard() {
+    int showroom_id, top_n, sp_id;
+    
+    out_printf("\n=== Sales Leaderboard ===\n");
+    out_printf("Enter Showroom ID: ");
+    if (scanf("%d", &showroom_id) != 1) {
+        out_printf("Invalid input.\n");
+        clear_input_line();
+        return;
+    }
+    
+    if (!find_showroom_or_say(showroom_id)) return;
+    
+    out_printf("How many top sales persons to show: ");
+    if (scanf("%d", &top_n) != 1) {
+        out_printf("Invalid input.\n");
+        clear_input_line();
+        return;
+    }
+    
+    if (!show_sales_leaderboard(showroom_id, top_n)) return;
+    
+    out_printf("\nEnter a Sales Person ID to see their rank (0 to skip): ");
+    if (scanf("%d", &sp_id) != 1 || sp_id == 0) {
+        return;
+    }
+    
+    show_salesperson_rank(showroom_id, sp_id);
+}
+
+// Print the top_n sales persons of a showroom's leaderboard; the number printed
+int show_sales_leaderboard(int showroom_id, int top_n) {
+    Showroom* showroom = find_showroom_or_say(showroom_id);
+    if (!showroom) return 0;
+    
+    int count = 0;
+    SalesPerson** top = leaderboard_top(showroom, top_n, &count);
+    if (count == 0) {
+        out_printf("No sales persons found in Showroom %d: %s.\n", showroom->id, showroom->name);
+        return 0;
+    }
+    
+    out_printf("\nRank  ID     Name                  Achieved (lakhs)  Target (lakhs)\n");
+    for (int i = 0; i < count; i++) {
+        out_printf("%-5d %-6d %-21s %-17.2f %.2f\n", 
+                   i + 1, top[i]->id, top[i]->name, top[i]->achieved_sales, top[i]->target_sales);
+    }
+    out_printf("Total sales persons ranked: %d\n", showroom->leaderboard_count);
+    return count;
+}
+
+// Print where a sales person stands on their showroom's leaderboard; 0 if they are not there
+int show_salesperson_rank(int showroom_id, int sp_id) {
+    Showroom* showroom = find_showroom_or_say(showroom_id);
+    if (!showroom) return 0;
+    
+    SalesPerson temp_sp;
+    temp_sp.id = sp_id;
+    SalesPerson* sp = (SalesPerson*)bplusSearch(showroom->sales_persons, &temp_sp);
+    if (!sp) {
+        out_printf("Sales Person with ID %d not found in this showroom.\n", sp_id);
+        return 0;
+    }
+    out_printf("%s (ID: %d) is ranked %d of %d with %.2f lakhs in sales.\n", 
+               sp->name, sp->id, leaderboard_rank(showroom, sp), showroom->leaderboard_count, sp->achieved_sales);
+    return 1;
+}
+
+// Function to show the most sold models of the last 30 days, for one showroom or nationally
+void display_recent_car_popularity() {
+    int showroom_id;
+    
+    out_printf("\n=== Top Models in the Last %d Days ===\n", POPULARITY_WINDOW_DAYS);
+    out_printf("Enter Showroom ID (0 for all showrooms): ");
+    if (scanf("%d", &showroom_id) != 1) {
+        out_printf("Invalid input.\n");
+        clear_input_line();
+        return;
+    }
+    
+    show_recent_car_popularity(showroom_id);
+}
+
+// Print the most sold models of the last POPULARITY_WINDOW_DAYS days of one showroom, or of
+// all of them for showroom 0; 0 if there is no such showroom
+int show_recent_car_popularity(int showroom_id) {
+    // The national window covers every showroom's sales; a showroom's own is read with it
+    PopularityWindow* window = NULL;
+    if (showroom_id == 0) {
+        snapshot_load_all_showrooms();
+        window = national_popularity_window();
+    } else {
+        Showroom* showroom = find_showroom_or_say(showroom_id);
+        if (!showroom) return 0;
+        window = showroom->popularity_window;
+    }
+    
+    // The window ends today, so sales stop counting as recent however long the showrooms go without one
+    int end_day = today_days();
+    HeavyHitter top[POPULARITY_TOP_K];
+    int count = popularity_window_top(window, end_day, POPULARITY_TOP_K, top);
+    if (count == 0) {
+        out_printf("No sales with a known model in the last %d days.\n", POPULARITY_WINDOW_DAYS);
+        return 1;
+    }
+    
+    int start_d, start_m, start_y, end_d, end_m, end_y;
+    days_to_date(end_day - POPULARITY_WINDOW_DAYS + 1, &start_d, &start_m, &start_y);
+    days_to_date(end_day, &end_d, &end_m, &end_y);
+    out_printf("Sales from %02d/%02d/%d to %02d/%02d/%d:\n", start_d, start_m, start_y, end_d, end_m, end_y);
+    
+    for (int i = 0; i < count; i++) {
+        CarPopularityEntry* model = car_popularity_entry(top[i].model_id);
+        out_printf("%2d. %-20s | Sold: %d", i + 1, model ? model->model_name : "Unknown", top[i].count);
+        if (top[i].error > 0) {
+            out_printf(" (+/- %d)", top[i].error);
+        }
+        out_printf("\n");
+    }
+    return 1;
+}
+
+// Print average price per value of one categorical inventory column
+static void print_price_breakdown(const char* title, InventorySnapshot* snapshot, 
+                                  const uint16_t* ids, StringDictionary* dict) {
+    double* sums = (double*)malloc(dict->count * sizeof(double));
+    int* counts = (int*)malloc(dict->count * sizeof(int));
+    if (!sums || !counts) {
+        out_printf("Memory allocation failed for inventory analytics\n");
+        free(sums);
+        free(counts);
+        return;
+    }
+    
+    inventory_group_price_by(snapshot, ids, dict->count, sums, counts);
+    
+    out_printf("\n%-20s %-8s %s\n", title, "Cars", "Avg Price (lakhs)");
+    for (int g = 0; g < dict->count; g++) {
+        if (counts[g] == 0) continue;
+        out_printf("%-20s %-8d %.2f\n", dict->values[g], counts[g], sums[g] / counts[g]);
+    }
+    
+    free(sums);
+    free(counts);
+}
+
+// Function to answer fleet-wide questions over every showroom's available cars
+void display_inventory_analytics() {
+    double threshold;
+    
+    out_printf("\n=== Inventory Analytics ===\n");
+    
+    InventorySnapshot* snapshot = show_inventory_analytics();
+    if (!snapshot) return;
+    
+    out_printf("\nEnter a price threshold (in lakhs): ");
+    if (scanf("%lf", &threshold) != 1) {
+        out_printf("Invalid input.\n");
+        clear_input_line();
+        return;
+    }
+    
+    show_cars_priced_below(snapshot, threshold);
+}
+
+// Print the average prices by fuel and car type and the cheapest car over every showroom's
+// available cars; the snapshot they were read from, NULL if there are no cars
+InventorySnapshot* show_inventory_analytics() {
+    snapshot_load_all_showrooms();
+    clock_t start = clock();
+    InventorySnapshot* snapshot = inventory_snapshot();
+    double build_ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    if (!snapshot) return NULL;
+    if (snapshot->count == 0) {
+        out_printf("No cars available in any showroom.\n");
+        return NULL;
+    }
+    
+    out_printf("Available cars: %d (%d models, snapshot ready in %.2f ms)\n", 
+               snapshot->count, snapshot->models.count, build_ms);
+    
+    print_price_breakdown("Fuel Type", snapshot, snapshot->fuel_id, &snapshot->fuels);
+    print_price_breakdown("Car Type", snapshot, snapshot->type_id, &snapshot->types);
+    
+    int cheapest = inventory_min_price_row(snapshot);
+    out_printf("\nCheapest car: %s (%s) at %.2f lakhs in showroom %d\n", 
+               snapshot->vin[cheapest], snapshot->models.values[snapshot->model_id[cheapest]], 
+               snapshot->price[cheapest], snapshot->showroom_id[cheapest]);
+    return snapshot;
+}
+
+// Print how many of the snapshot's cars are priced below threshold
+void show_cars_priced_below(InventorySnapshot* snapshot, double threshold) {
+    clock_t start = clock();
+    int below = inventory_count_price_below(snapshot, threshold);
+    double scan_ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    out_printf("Cars priced below %.2f lakhs: %d of %d (scanned in %.3f ms)\n", 
+               threshold, below, snapshot->count, scan_ms);
+}
+
+// Function to add the cars of a dealer stock feed (a file or a pipe) in one batch
+void import_stock_feed() {
+    char path[512];
+    
+    out_printf("\n=== Import Stock Feed ===\n");
+    out_printf("Enter feed file path: ");
+    if (scanf("%511s", path) != 1) {
+        out_printf("Invalid input.\n");
+        return;
+    }
+    
+    import_stock_feed_from(path);
+}
+
+// Import a feed file or pipe and print what was added and skipped; 0 if it cannot be read
+int import_stock_feed_from(const char* path) {
+    StockFeedResult result;
+    if (!stock_feed_import(path, &result)) return 0;
+    
+    out_printf("Rows: %d, added: %d to %d showrooms\n", result.rows, result.added, result.showrooms);
+    out_printf("Skipped: %d invalid, %d repeated in the feed, %d already in stock, %d for unknown showrooms\n",
+               result.invalid, result.repeated, result.in_stock, result.no_showroom);
+    double ms = result.seconds * 1000.0;
+    out_printf("Imported %d rows (%.2f MB) in %.1f ms (%.0f rows/s)\n", result.rows,
+               result.bytes / (1024.0 * 1024.0), ms, result.seconds > 0 ? result.rows / result.seconds : 0.0);
+    return 1;
+}
+
+// Function to list every showroom
+void display_all_showrooms() {
+    out_printf("\n=== All Showrooms ===\n");
+    if (!showroom_tree || !showroom_tree->root) {
+        out_printf("No showrooms have been added yet.\n");
+    } else {
+        // Find the leftmost leaf node (first showroom)
+        BTreeNode* node = showroom_tree->root;
+        while (!node->is_leaf) {
+            node = node->children[0];
+        }
+        
+        // Traverse all leaf nodes to print all showrooms
+        int count = 0;
+        while (node) {
+            for (int i = 0; i < node->num_keys; i++) {
+                count++;
+                out_printf("%d. ", count);
+                showroom_tree->print(node->keys[i].key);
+                out_printf("\n");
+            }
+            node = node->leaf_link.next;
+        }
+        
+        if (count == 0) {
+            out_printf("No showrooms have been added yet.\n");
+        }
+    }
+}
+
+void print_main_menu() {
+    out_printf("\n=== Main Menu ===\n");
+    out_printf("1. Add Showroom\n");
+    out_printf("2. Display All Showrooms\n");
+    out_printf("3. Add New Car Stock\n");
+    out_printf("4. Recruit Sales Person\n");
+    out_printf("5. Car Purchase\n");
+    out_printf("6. Merge Showrooms\n");
+    out_printf("7. Display Showroom Inventory\n");
+    out_printf("8. Find Most Successful Sales Person\n");
+    out_printf("9. Predict Next Month's Sales\n");
+    out_printf("10. Find Car by VIN\n");
+    out_printf("11. Search Sales Persons by Sales Range\n");
+    out_printf("12. Display Car Popularity Statistics\n");
+    out_printf("13. Display the details of cars within given EMI plan\n");
+    out_printf("14. Find Customer by Mobile / Registration Number\n");
+    out_printf("15. Sales Leaderboard\n");
+    out_printf("16. Top Car Models in the Last 30 Days\n");
+    out_printf("17. Inventory Analytics\n");
+    out_printf("18. Export Data to Text Files\n");
+    out_printf("19. Checkpoint (Save Data, Truncate Journal)\n");
+    out_printf("20. Import Stock Feed\n");
+    out_printf("0. Exit\n");
+}
+
+// Run one main menu command; its questions are read from stdin
+void run_menu_command(int choice) {
+    switch (choice) {
+        case 1:
+            add_showroom();
+            break;
+        case 2:
+            display_all_showrooms();
+            break;
+        case 3:
+            add_new_stock();
+            break;
+        case 4:
+            recruit_salesperson();
+            break;
+        case 5:
+            car_purchase();
+            break;
+        case 6:
+            merge_showrooms();
+            break;
+        case 7:
+            display_showroom_inventory();
+            break;
+        case 8:
+            find_most_successful_SP();
+            break;
+        case 9:
+            predict_next_month_sales();
+            break;
+        case 10:
+            find_car_by_VIN();
+            break;
+        case 11:
+            search_salespersons_by_sales_range();
+            break;
+        case 12:
+            display_car_popularity();
+            break;
+        case 13:
+            list_customers_with_emi_in_range();
+            break;
+        case 14:
+            find_customer_by_contact();
+            break;
+        case 15:
+            display_sales_leaderboard();
+            break;
+        case 16:
+            display_recent_car_popularity();
+            break;
+        case 17:
+            display_inventory_analytics();
+            break;
+        case 18:
+            // Checkpoint first, the journal must only hold changes made after the exported data
+            save_all_data();
+            export_data_to_text();
+            out_printf("Data exported to text files.\n");
+            break;
+        case 19:
+            save_all_data();
+            break;
+        case 20:
+            import_stock_feed();
+            break;
+        case 0:
+            out_printf("Exiting...\n");
+            break;
+        default:
+            out_printf("Invalid choice. Please try again.\n");
+    }
+}
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "mappedfile.h"
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+int map_file(const char* path, MappedFile* file) {
+    file->data = NULL;
+    file->size = 0;
+    file->mapped = 0;
+
+    #ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct stat file_stat;
+    void* mapped = MAP_FAILED;
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+        #ifdef MAP_POPULATE
+        mapped = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        #else
+        mapped = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        #endif
+    }
+    close(fd);
+
+    if (mapped != MAP_FAILED) {
+        file->data = (const char*)mapped;
+        file->size = (size_t)file_stat.st_size;
+        file->mapped = 1;
+        return 1;
+    }
+    #endif
+
+    // Empty files, or no mmap: read the file into memory instead
+    FILE* handle = fopen(path, "rb");
+    if (!handle) return 0;
+
+    char* data = NULL;
+    long length = -1;
+    if (fseek(handle, 0, SEEK_END) == 0) length = ftell(handle);
+    if (length >= 0 && fseek(handle, 0, SEEK_SET) == 0) {
+        data = (char*)malloc(length > 0 ? (size_t)length : 1);
+        if (data && fread(data, 1, (size_t)length, handle) != (size_t)length) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(handle);
+    if (!data) return 0;
+
+    file->data = data;
+    file->size = (size_t)length;
+    return 1;
+}
+
+void unmap_file(MappedFile* file) {
+    if (!file->data) return;
+
+    #ifndef _WIN32
+    if (file->mapped) {
+        munmap((void*)file->data, file->size);
+    } else
+    #endif
+    {
+        free((void*)file->data);
+    }
+    file->data = NULL;
+    file->size = 0;
+    file->mapped = 0;
+}
@@ -0,0 +1,17 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stddef.h>
+
+// Whole-file read access. Uses a read-only mmap where the platform has one and falls back
+// to reading the file into a heap buffer, so callers never care which one they got.
+typedef struct {
+    const char* data;
+    size_t size;
+    int mapped;         // 1 if data must be released with munmap rather than free
+} MappedFile;
+
+int map_file(const char* path, MappedFile* file);      // 0 if the file cannot be opened or read
+void unmap_file(MappedFile* file);
+
+#endif
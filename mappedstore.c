@@ -0,0 +1,530 @@
+#include <pthread.h>
+#include "mappedstore.h"
+#include "essentialfunction.h"
+#include "snapshot.h"
+#include "ioengine.h"
+
+#if !defined(_WIN32) && UINTPTR_MAX > 0xffffffffu
+#define STORE_AVAILABLE 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+#ifndef MAP_FIXED_NOREPLACE
+#ifdef __linux__
+#define MAP_FIXED_NOREPLACE 0x100000    // Older kernels take the address as a hint, see reserve_arena()
+#else
+#define MAP_FIXED_NOREPLACE 0
+#endif
+#endif
+#else
+#define STORE_AVAILABLE 0               // No fixed-address mappings: the data stays on the heap
+#endif
+
+// Every callback a tree may hold. An image records where these were in the process that wrote
+// it, so the callbacks in its trees can be translated to this process by position.
+typedef void (*StoreFunction)(void);
+
+static const StoreFunction tree_functions[] = {
+    (StoreFunction)compareInt, (StoreFunction)printInt, (StoreFunction)cloneInt, (StoreFunction)freeInt,
+    (StoreFunction)compareStr, (StoreFunction)printStr, (StoreFunction)cloneStr, (StoreFunction)freeStr,
+    (StoreFunction)compareVIN, (StoreFunction)printCar, (StoreFunction)cloneCar, (StoreFunction)freeCar,
+    (StoreFunction)printSoldCar, (StoreFunction)cloneSoldCar, (StoreFunction)freeSoldCar,
+    (StoreFunction)compareCustomerByEMI, (StoreFunction)printCustomer, (StoreFunction)cloneCustomer, (StoreFunction)freeCustomer,
+    (StoreFunction)compareSalesPersonID, (StoreFunction)printSalesPerson, (StoreFunction)cloneSalesPerson, (StoreFunction)freeSalesPerson,
+    (StoreFunction)compareMonthlySales, (StoreFunction)printMonthlySales, (StoreFunction)cloneMonthlySales, (StoreFunction)freeMonthlySales,
+    (StoreFunction)compareShowroomID, (StoreFunction)printShowroom, (StoreFunction)cloneShowroom, (StoreFunction)freeShowroom,
+    (StoreFunction)compareEmiIndexEntry, (StoreFunction)printEmiIndexEntry, (StoreFunction)cloneEmiIndexEntry, (StoreFunction)freeEmiIndexEntry,
+};
+
+#define STORE_FUNCTION_COUNT (sizeof(tree_functions) / sizeof(tree_functions[0]))
+#define STORE_CLASS_COUNT 104       // 64 classes up to STORE_SMALL_LIMIT, then powers of two from 2 KiB
+
+// The first STORE_HEADER_SIZE bytes of the arena, and so of the image
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t layout;                // layout_fingerprint() of the build that wrote it
+    uint64_t base;
+    uint64_t used;                  // Bytes of the arena handed out, the length of the image
+    uint64_t journal_lsn;
+    uint32_t function_count;
+    uint32_t state_size;
+    uint32_t crc;                   // CRC32 of the header with this field 0
+    uint32_t reserved;
+    void* free_blocks[STORE_CLASS_COUNT];       // Freed blocks of each size class, linked through their first bytes
+    uint64_t functions[STORE_FUNCTION_COUNT];   // Addresses of tree_functions[] when the image was written
+    unsigned char state[];          // The registered static variables, in the order they were registered
+} StoreHeader;
+
+// In front of every block
+typedef struct {
+    uint64_t size_class;
+    uint64_t capacity;              // Bytes usable
+} BlockHeader;
+
+static StoreHeader* header = NULL;  // At STORE_BASE while the store is active
+static size_t committed = 0;        // Bytes from STORE_BASE that are readable and writable
+static pthread_mutex_t arena_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Registered state
+#define STORE_MAX_STATES 32
+#define STORE_MAX_TREES 8
+
+typedef struct {
+    void* address;
+    size_t size;
+} StoreState;
+
+static StoreState states[STORE_MAX_STATES];
+static int state_count = 0;
+static size_t state_size = 0;
+static BPlusTree** trees[STORE_MAX_TREES];
+static int tree_count = 0;
+static int registry_full = 0;
+
+void store_register_state(void* state, size_t size) {
+    if (state_count == STORE_MAX_STATES) {
+        registry_full = 1;
+        return;
+    }
+    states[state_count].address = state;
+    states[state_count].size = size;
+    state_count++;
+    state_size += size;
+}
+
+void store_register_tree(BPlusTree** tree) {
+    if (tree_count == STORE_MAX_TREES) {
+        registry_full = 1;
+        return;
+    }
+    trees[tree_count++] = tree;
+    store_register_state(tree, sizeof(*tree));
+}
+
+// The order is part of the image layout
+static void register_modules() {
+    static int registered = 0;
+    if (registered) return;
+    registered = 1;
+    store_register_tree(&showroom_tree);
+    register_string_heap_state();
+    register_car_popularity_state();
+    register_popularity_window_state();
+    register_customer_index_state();
+    register_snapshot_state();
+}
+
+static int registry_fits() {
+    return !registry_full && state_size <= STORE_HEADER_SIZE - offsetof(StoreHeader, state);
+}
+
+static void save_states(unsigned char* dest) {
+    for (int i = 0; i < state_count; i++) {
+        memcpy(dest, states[i].address, states[i].size);
+        dest += states[i].size;
+    }
+}
+
+static void restore_states(const unsigned char* src) {
+    for (int i = 0; i < state_count; i++) {
+        memcpy(states[i].address, src, states[i].size);
+        src += states[i].size;
+    }
+}
+
+// An image is only used by a build that lays the records out the same way
+static uint64_t layout_fingerprint() {
+    const uint64_t sizes[] = {
+        STORE_VERSION, sizeof(void*), MAX, sizeof(BTreeNode), sizeof(BPlusTree),
+        sizeof(Car), sizeof(SoldCar), sizeof(Customer), sizeof(SalesPerson), sizeof(MonthlySales),
+        sizeof(PopularityWindow), sizeof(Showroom), sizeof(CustomerIndexEntry), sizeof(EmiIndexEntry),
+        sizeof(CarPopularityEntry), STRING_HEAP_BLOCK_SIZE,
+        offsetof(Showroom, available_cars), offsetof(Showroom, leaderboard), offsetof(Showroom, popularity_window),
+        offsetof(SalesPerson, customer_tree), offsetof(BPlusTree, compare),
+        STORE_CLASS_COUNT, STORE_FUNCTION_COUNT, state_size,
+    };
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    const unsigned char* bytes = (const unsigned char*)sizes;
+    for (size_t i = 0; i < sizeof(sizes); i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+int store_requested() {
+    const char* value = getenv(STORE_ENV);
+    return STORE_AVAILABLE && value && atoi(value) > 0;
+}
+
+int store_active() {
+    return header != NULL;
+}
+
+int store_writes_image() {
+    return header && store_requested();
+}
+
+// ---------------------------------------------------------------------------
+// Allocation
+// ---------------------------------------------------------------------------
+
+static int in_arena(const void* ptr) {
+    return header && (uintptr_t)ptr - STORE_BASE < STORE_RESERVE;
+}
+
+// Size class of a request and the bytes a block of that class holds, -1 if too large
+static int size_class(size_t size, size_t* capacity) {
+    if (size <= STORE_SMALL_LIMIT) {
+        *capacity = size ? (size + 15) & ~(size_t)15 : 16;
+        return (int)(*capacity / 16) - 1;
+    }
+    int class_id = STORE_SMALL_LIMIT / 16;
+    size_t bytes = STORE_SMALL_LIMIT * 2;
+    while (bytes < size) {
+        bytes <<= 1;
+        class_id++;
+    }
+    *capacity = bytes;
+    return class_id < STORE_CLASS_COUNT ? class_id : -1;
+}
+
+#if STORE_AVAILABLE
+
+// With arena_lock held (or before the store is shared): make the first `bytes` usable
+static int commit(size_t bytes) {
+    if (bytes <= committed) return 1;
+    size_t target = (bytes + STORE_COMMIT_STEP - 1) / STORE_COMMIT_STEP * STORE_COMMIT_STEP;
+    if (target > STORE_RESERVE) return 0;
+    if (mprotect((char*)STORE_BASE + committed, target - committed, PROT_READ | PROT_WRITE) != 0) return 0;
+    committed = target;
+    return 1;
+}
+
+static void* arena_alloc(size_t size) {
+    size_t capacity;
+    int class_id = size_class(size, &capacity);
+    if (class_id < 0) return NULL;
+
+    pthread_mutex_lock(&arena_lock);
+    void* block = header->free_blocks[class_id];
+    if (block) {
+        header->free_blocks[class_id] = *(void**)block;
+    } else if (commit(header->used + sizeof(BlockHeader) + capacity)) {
+        BlockHeader* info = (BlockHeader*)((char*)STORE_BASE + header->used);
+        info->size_class = (uint64_t)class_id;
+        info->capacity = capacity;
+        header->used += sizeof(BlockHeader) + capacity;
+        block = info + 1;
+    }
+    pthread_mutex_unlock(&arena_lock);
+    return block;
+}
+
+#else
+
+static void* arena_alloc(size_t size) {
+    (void)size;
+    return NULL;
+}
+
+#endif
+
+void* store_malloc(size_t size) {
+    return header ? arena_alloc(size) : malloc(size);
+}
+
+void* store_calloc(size_t count, size_t size) {
+    if (!header) return calloc(count, size);
+    if (size && count > (size_t)-1 / size) return NULL;
+    void* block = arena_alloc(count * size);
+    if (block) memset(block, 0, count * size);     // Reused blocks hold old data
+    return block;
+}
+
+void* store_realloc(void* ptr, size_t size) {
+    if (!in_arena(ptr)) {
+        return ptr || !header ? realloc(ptr, size) : arena_alloc(size);
+    }
+    BlockHeader* info = (BlockHeader*)ptr - 1;
+    if (size <= info->capacity) return ptr;
+
+    void* grown = arena_alloc(size);
+    if (!grown) return NULL;
+    memcpy(grown, ptr, info->capacity);
+    store_free(ptr);
+    return grown;
+}
+
+void store_free(void* ptr) {
+    if (!in_arena(ptr)) {
+        free(ptr);
+        return;
+    }
+    BlockHeader* info = (BlockHeader*)ptr - 1;
+    pthread_mutex_lock(&arena_lock);
+    *(void**)ptr = header->free_blocks[info->size_class];
+    header->free_blocks[info->size_class] = ptr;
+    pthread_mutex_unlock(&arena_lock);
+}
+
+// ---------------------------------------------------------------------------
+// Arena and image
+// ---------------------------------------------------------------------------
+
+#if STORE_AVAILABLE
+
+// Claim the address range without using memory; 0 if anything else is mapped there
+static int reserve_arena() {
+    void* wanted = (void*)STORE_BASE;
+    void* got = mmap(wanted, STORE_RESERVE, PROT_NONE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0);
+    if (got == MAP_FAILED) return 0;
+    if (got != wanted) {
+        munmap(got, STORE_RESERVE);
+        return 0;
+    }
+    committed = 0;
+    return 1;
+}
+
+int store_start() {
+    if (header) return 1;
+    register_modules();
+    if (!registry_fits()) {
+        out_printf("Mapped store unavailable: the registered state does not fit the image header\n");
+        return 0;
+    }
+    if (!reserve_arena() || !commit(STORE_HEADER_SIZE)) {
+        out_printf("Mapped store unavailable: its address range is in use, the data stays on the heap\n");
+        munmap((void*)STORE_BASE, STORE_RESERVE);
+        return 0;
+    }
+    // Fresh pages are zero: no free blocks yet
+    header = (StoreHeader*)STORE_BASE;
+    header->used = STORE_HEADER_SIZE;
+    return 1;
+}
+
+static BTreeNode* first_leaf(BPlusTree* tree) {
+    BTreeNode* node = tree ? tree->root : NULL;
+    while (node && !node->is_leaf) {
+        node = node->children[0];
+    }
+    return node;
+}
+
+// The callback at the same position in this process, NULL (clearing *ok) if it is not known
+static StoreFunction relinked(StoreFunction old, const uint64_t* saved, int* ok) {
+    if (!old) return NULL;
+    for (size_t i = 0; i < STORE_FUNCTION_COUNT; i++) {
+        if (saved[i] == (uint64_t)(uintptr_t)old) return tree_functions[i];
+    }
+    *ok = 0;
+    return NULL;
+}
+
+static int relink_tree(BPlusTree* tree, const uint64_t* saved) {
+    if (!tree) return 1;
+    int ok = 1;
+    tree->compare = (CompareFunc)relinked((StoreFunction)tree->compare, saved, &ok);
+    tree->print = (PrintFunc)relinked((StoreFunction)tree->print, saved, &ok);
+    tree->clone = (CloneFunc)relinked((StoreFunction)tree->clone, saved, &ok);
+    tree->free_func = (FreeFunc)relinked((StoreFunction)tree->free_func, saved, &ok);
+    tree->access = NULL;    // Only set while showrooms are on disk, and an image holds all of them
+    return ok;
+}
+
+// The registered trees, and the trees of every showroom and salesperson
+static int relink_trees(const uint64_t* saved) {
+    int ok = 1;
+    for (int t = 0; t < tree_count && ok; t++) {
+        ok = relink_tree(*trees[t], saved);
+    }
+    for (BTreeNode* node = ok ? first_leaf(showroom_tree) : NULL; node && ok; node = node->leaf_link.next) {
+        for (int i = 0; i < node->num_keys && ok; i++) {
+            Showroom* showroom = (Showroom*)node->keys[i].key;
+            ok = relink_tree(showroom->available_cars, saved) && relink_tree(showroom->sold_cars, saved) &&
+                 relink_tree(showroom->sales_persons, saved) && relink_tree(showroom->monthly_sales, saved);
+            for (BTreeNode* sp_node = ok ? first_leaf(showroom->sales_persons) : NULL; sp_node && ok;
+                 sp_node = sp_node->leaf_link.next) {
+                for (int k = 0; k < sp_node->num_keys && ok; k++) {
+                    SalesPerson* sp = (SalesPerson*)sp_node->keys[k].key;
+                    ok = relink_tree(sp->customer_tree, saved) && relink_tree(sp->sold_car_tree, saved);
+                }
+            }
+        }
+    }
+    return ok;
+}
+
+static uint32_t header_crc(StoreHeader* image) {
+    uint32_t crc = image->crc;
+    image->crc = 0;
+    uint32_t computed = crc32_update(0, image, STORE_HEADER_SIZE);
+    image->crc = crc;
+    return computed;
+}
+
+// Why an image read into `saved` cannot be used, NULL if it can
+static const char* image_problem(StoreHeader* saved, uint64_t file_size) {
+    if (memcmp(saved->magic, STORE_MAGIC, sizeof(saved->magic)) != 0 || saved->version != STORE_VERSION ||
+        saved->byte_order != SNAPSHOT_BYTE_ORDER) {
+        return "is not a memory image of this version";
+    }
+    if (saved->crc != header_crc(saved) || saved->used != file_size || saved->used < STORE_HEADER_SIZE) {
+        return "is damaged";
+    }
+    if (saved->layout != layout_fingerprint() || saved->base != STORE_BASE ||
+        saved->function_count != STORE_FUNCTION_COUNT || saved->state_size != state_size) {
+        return "was written by a different build";
+    }
+    return NULL;
+}
+
+int store_load_image(const char* path, uint64_t* journal_lsn) {
+    if (header) return 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+
+    register_modules();
+    StoreHeader* saved = (StoreHeader*)malloc(STORE_HEADER_SIZE);
+    unsigned char* previous = (unsigned char*)malloc(state_size ? state_size : 1);
+    struct stat file_stat;
+    const char* problem = NULL;
+    if (!saved || !previous || !registry_fits()) {
+        problem = "cannot be loaded here";
+    } else if (fstat(fd, &file_stat) != 0 || pread(fd, saved, STORE_HEADER_SIZE, 0) != STORE_HEADER_SIZE) {
+        problem = "could not be read";
+    } else {
+        problem = image_problem(saved, (uint64_t)file_stat.st_size);
+    }
+
+    // The file goes over the front of the reserved range, copy-on-write; the rest stays reserved
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t mapped = problem ? 0 : (saved->used + page - 1) / page * page;
+    if (!problem && !reserve_arena()) {
+        problem = "cannot be mapped, its address range is in use";
+    } else if (!problem) {
+        void* at = mmap((void*)STORE_BASE, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+        committed = mapped;
+        if (at == MAP_FAILED || !commit(saved->used)) {
+            problem = "could not be mapped";
+            munmap((void*)STORE_BASE, STORE_RESERVE);
+        }
+    }
+    close(fd);
+
+    // Adopt its state; put ours back if its trees hold callbacks this build does not have
+    if (!problem) {
+        save_states(previous);
+        restore_states(saved->state);
+        if (!relink_trees(saved->functions)) {
+            restore_states(previous);
+            munmap((void*)STORE_BASE, STORE_RESERVE);
+            problem = "was written by a different build";
+        }
+    }
+
+    if (problem) {
+        out_printf("Memory image %s %s, ignoring it.\n", path, problem);
+    } else {
+        header = (StoreHeader*)STORE_BASE;
+        *journal_lsn = saved->journal_lsn;
+        out_printf("Memory image mapped: %.2f MB, pages are read as they are first used\n",
+                   saved->used / (1024.0 * 1024.0));
+    }
+    free(saved);
+    free(previous);
+    return problem == NULL;
+}
+
+// Written to `path`.tmp, then moved over `path`
+int store_save_image(const char* path, uint64_t journal_lsn) {
+    if (!header) return 0;
+
+    memcpy(header->magic, STORE_MAGIC, sizeof(header->magic));
+    header->version = STORE_VERSION;
+    header->byte_order = SNAPSHOT_BYTE_ORDER;
+    header->layout = layout_fingerprint();
+    header->base = STORE_BASE;
+    header->journal_lsn = journal_lsn;
+    header->function_count = STORE_FUNCTION_COUNT;
+    header->state_size = (uint32_t)state_size;
+    for (size_t i = 0; i < STORE_FUNCTION_COUNT; i++) {
+        header->functions[i] = (uint64_t)(uintptr_t)tree_functions[i];
+    }
+    save_states(header->state);
+    header->crc = header_crc(header);
+
+    char temp_path[512];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    IoWriteFile* file = io_write_open(temp_path, 0);
+    if (!file) {
+        out_printf("Error: Could not open file for writing: %s\n", temp_path);
+        return 0;
+    }
+
+    const char* data = (const char*)STORE_BASE;
+    size_t left = header->used;
+    int ok = 1;
+    while (left > 0) {
+        char* buffer = io_write_buffer(file);
+        if (!buffer) {
+            ok = 0;
+            break;
+        }
+        size_t part = left < IO_CHUNK_SIZE ? left : IO_CHUNK_SIZE;
+        memcpy(buffer, data, part);
+        io_write_submit(file, part);
+        data += part;
+        left -= part;
+    }
+    if (!io_write_close(file) || !ok) {
+        out_printf("Error: Could not write memory image %s\n", temp_path);
+        remove(temp_path);
+        return 0;
+    }
+    if (rename(temp_path, path) != 0) {
+        out_printf("Error: Could not replace memory image %s\n", path);
+        remove(temp_path);
+        return 0;
+    }
+
+    out_printf("Memory image saved: %.2f MB\n", header->used / (1024.0 * 1024.0));
+    return 1;
+}
+
+void store_close() {
+    if (!header) return;
+    header = NULL;
+    munmap((void*)STORE_BASE, STORE_RESERVE);
+}
+
+#else
+
+int store_start() {
+    return 0;
+}
+
+int store_load_image(const char* path, uint64_t* journal_lsn) {
+    (void)path;
+    (void)journal_lsn;
+    return 0;
+}
+
+int store_save_image(const char* path, uint64_t journal_lsn) {
+    (void)path;
+    (void)journal_lsn;
+    return 0;
+}
+
+void store_close() {}
+
+#endif
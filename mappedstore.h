@@ -0,0 +1,59 @@
+#ifndef MAPPED_STORE_H
+#define MAPPED_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Mapped store: with SHOWROOM_MAPPED_STORE set, the whole object graph (showroom_tree and every
+// tree, node and record under it, the customer index, the popularity tables and the string
+// heap) is allocated from one arena reserved at the fixed address STORE_BASE, and a checkpoint
+// writes the arena as it is to a memory image. Restarting maps the image back at the same
+// address instead of reading a snapshot: nothing is parsed or rebuilt, and the page cache reads
+// each page the first time it is touched.
+//
+// Pointers between records stay valid because the arena always lands at STORE_BASE. What is
+// not inside it is fixed up on load: the tree callbacks are looked up by their position in a
+// table of known functions (the program may be mapped elsewhere), and the modules' static
+// variables that point into the arena are registered with store_register_state() and kept in
+// the image header.
+//
+// The image is written to a new file that replaces the old one when complete, and the arena
+// is mapped copy-on-write, so the image on disk is always the state at the last checkpoint; the
+// journal replays what came after it. An image from a build with other struct layouts, or
+// whose address range is taken, is not used (the snapshot is loaded instead).
+// Showrooms are never evicted from the store, so the memory budget does not apply.
+
+#define STORE_ENV "SHOWROOM_MAPPED_STORE"       // 1 to keep the data in the mapped store
+#define STORE_MAGIC "SHOWIMAG"
+#define STORE_VERSION 1
+#define STORE_BASE ((uintptr_t)0x3f0000000000)  // Where the arena is mapped, in every process
+#define STORE_RESERVE ((size_t)1 << 40)         // Address space reserved for it
+#define STORE_COMMIT_STEP ((size_t)64 << 20)    // Reserved pages are made usable this many bytes at a time
+#define STORE_HEADER_SIZE 8192                  // Image header at the start of the arena
+#define STORE_SMALL_LIMIT 1024                  // Blocks up to this size come in steps of 16 bytes, larger ones in powers of two
+
+// Allocation: from the arena while the store is active, from the C heap otherwise.
+// store_free() and store_realloc() take either kind of pointer.
+void* store_malloc(size_t size);
+void* store_calloc(size_t count, size_t size);
+void* store_realloc(void* ptr, size_t size);
+void store_free(void* ptr);
+
+// Static state kept in the image, registered by each module the first time the store is used
+void store_register_state(void* state, size_t size);
+struct BPlusTree;
+void store_register_tree(struct BPlusTree** tree);     // A tree whose callbacks are fixed up on load
+
+int store_requested();      // SHOWROOM_MAPPED_STORE is set
+int store_active();         // The data lives in the arena
+int store_writes_image();   // Checkpoints save the image rather than the snapshot
+
+// Start with an empty arena; everything allocated from here on lives in it. 0 if unavailable.
+int store_start();
+// Map an image; 1 on success, 0 (nothing changed) if missing or unusable.
+// *journal_lsn is the checkpoint it was saved at.
+int store_load_image(const char* path, uint64_t* journal_lsn);
+int store_save_image(const char* path, uint64_t journal_lsn);  // 1 on success, the old image survives a failure
+void store_close();         // Unmap the arena, at exit; nothing in it may be used afterwards
+
+#endif
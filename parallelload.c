@@ -0,0 +1,631 @@
+#include <pthread.h>
+#include "parallelload.h"
+#include "filehandling.h"
+#include "ioengine.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include <time.h>
+
+#define CHUNKS_PER_THREAD 4
+#define MAX_CHUNKS (PARALLEL_LOAD_MAX_THREADS * CHUNKS_PER_THREAD)
+
+// ---------------------------------------------------------------------------
+// Task runner: workers take task indexes from a shared counter until none are left
+// ---------------------------------------------------------------------------
+
+int parallel_load_thread_count() {
+    const char* forced = getenv(PARALLEL_LOAD_THREADS_ENV);
+    int count = forced ? atoi(forced) : 0;
+    if (count <= 0) {
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        count = (int)info.dwNumberOfProcessors;
+#else
+        count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    }
+    if (count < 1) count = 1;
+    if (count > PARALLEL_LOAD_MAX_THREADS) count = PARALLEL_LOAD_MAX_THREADS;
+    return count;
+}
+
+typedef struct {
+    ParallelTaskFunc task;
+    void* context;
+    int task_count;
+    int next_task;
+    pthread_mutex_t lock;
+} TaskQueue;
+
+static void* task_worker(void* arg) {
+    TaskQueue* queue = (TaskQueue*)arg;
+    for (;;) {
+        pthread_mutex_lock(&queue->lock);
+        int index = queue->next_task++;
+        pthread_mutex_unlock(&queue->lock);
+        if (index >= queue->task_count) break;
+
+        queue->task(index, queue->context);
+    }
+    return NULL;
+}
+
+void run_parallel(int task_count, ParallelTaskFunc task, void* context) {
+    if (task_count <= 0) return;
+
+    TaskQueue queue;
+    queue.task = task;
+    queue.context = context;
+    queue.task_count = task_count;
+    queue.next_task = 0;
+    pthread_mutex_init(&queue.lock, NULL);
+
+    int thread_count = parallel_load_thread_count();
+    if (thread_count > task_count) thread_count = task_count;
+
+    // The calling thread is one of the workers; if a thread cannot be started the rest take its share
+    pthread_t threads[PARALLEL_LOAD_MAX_THREADS];
+    int started = 0;
+    for (int i = 1; i < thread_count; i++) {
+        if (pthread_create(&threads[started], NULL, task_worker, &queue) != 0) break;
+        started++;
+    }
+    task_worker(&queue);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&queue.lock);
+}
+
+// clock() adds up every thread's CPU time, which says nothing about how long a parallel load took
+double wall_clock_seconds() {
+#ifdef _WIN32
+    return (double)clock() / CLOCKS_PER_SEC;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Line scanning and grouping
+// ---------------------------------------------------------------------------
+
+// One non-empty line of a data file
+typedef struct {
+    StrView line;
+    int key;        // First field: showroom ID, or salesperson ID for customers
+    int slot;       // Showroom it belongs to (index into the load's showroom list), -1 if none
+    int extra;      // Sold cars: model id. Customers: salesperson route.
+    int added;      // Set once the record is in its tree
+} TaggedLine;
+
+typedef struct {
+    TaggedLine* lines;
+    int count;
+    int capacity;
+} LineChunk;
+
+typedef struct {
+    const char* path;
+    const char* what;
+    int by_showroom;            // Key is a showroom ID (resolved while scanning)
+    MappedFile file;
+    int present;
+
+    int chunk_count;
+    size_t chunk_start[MAX_CHUNKS + 1];
+    LineChunk chunks[MAX_CHUNKS];
+
+    TaggedLine* lines;          // Every line, in file order
+    int line_count;
+    int* grouped;               // Line indexes ordered by slot, file order within a slot
+    int* group_start;           // Slot s owns grouped[group_start[s] .. group_start[s + 1])
+} LoadFile;
+
+// Customers are looked up by salesperson ID; the first showroom in ID order that has it wins
+typedef struct {
+    int id;
+    int slot;
+    SalesPerson* sales_person;
+} SalesPersonRoute;
+
+typedef struct {
+    Customer* customer;
+    SoldCar* sold_car;
+} CustomerResult;
+
+enum { LOAD_SALESPERSONS, LOAD_CARS, LOAD_SOLD_CARS, LOAD_CUSTOMERS, LOAD_FILE_COUNT };
+
+typedef struct {
+    LoadFile files[LOAD_FILE_COUNT];
+    LoadFile* scanning;             // File the chunk tasks are working on
+
+    Showroom** showrooms;           // In ID order
+    int* showroom_ids;
+    int showroom_count;
+
+    SalesPersonRoute* routes;       // Sorted by ID
+    int route_count;
+
+    CustomerResult* customer_results;   // Per customer line
+} ParallelLoad;
+
+// Index of `id` in a sorted array, -1 if missing
+static int find_sorted_id(const int* ids, int count, int id) {
+    int low = 0, high = count - 1;
+    while (low <= high) {
+        int mid = low + (high - low) / 2;
+        if (ids[mid] == id) return mid;
+        if (ids[mid] < id) low = mid + 1; else high = mid - 1;
+    }
+    return -1;
+}
+
+static int find_route(const ParallelLoad* load, int salesperson_id) {
+    int low = 0, high = load->route_count - 1;
+    while (low <= high) {
+        int mid = low + (high - low) / 2;
+        int id = load->routes[mid].id;
+        if (id == salesperson_id) return mid;
+        if (id < salesperson_id) low = mid + 1; else high = mid - 1;
+    }
+    return -1;
+}
+
+static int append_line(LineChunk* chunk, StrView line, int key) {
+    if (chunk->count == chunk->capacity) {
+        int capacity = chunk->capacity ? chunk->capacity * 2 : 1024;
+        TaggedLine* lines = (TaggedLine*)realloc(chunk->lines, (size_t)capacity * sizeof(TaggedLine));
+        if (!lines) return 0;
+        chunk->lines = lines;
+        chunk->capacity = capacity;
+    }
+
+    TaggedLine* tagged = &chunk->lines[chunk->count++];
+    tagged->line = line;
+    tagged->key = key;
+    tagged->slot = -1;
+    tagged->extra = -1;
+    tagged->added = 0;
+    return 1;
+}
+
+// Stage 2: collect the lines that start inside one chunk and read their first field
+static void scan_chunk_task(int index, void* context) {
+    ParallelLoad* load = (ParallelLoad*)context;
+    LoadFile* file = load->scanning;
+    LineChunk* chunk = &file->chunks[index];
+
+    TextReader reader;
+    reader.file = file->file;
+    reader.file.size = file->chunk_start[index + 1];
+    reader.offset = file->chunk_start[index];
+
+    StrView line;
+    while (text_reader_next_line(&reader, &line)) {
+        if (line.length == 0) continue;
+
+        const char* separator = (const char*)memchr(line.data, FIELD_SEP[0], line.length);
+        StrView first = {line.data, separator ? (size_t)(separator - line.data) : line.length};
+        if (!append_line(chunk, line, view_to_int(first))) {
+            printf("Memory allocation failed while reading %s\n", file->path);
+            return;
+        }
+        if (file->by_showroom) {
+            chunk->lines[chunk->count - 1].slot =
+                find_sorted_id(load->showroom_ids, load->showroom_count, chunk->lines[chunk->count - 1].key);
+        }
+    }
+}
+
+// Split the mapping into chunks that each begin right after a newline
+static void split_into_chunks(LoadFile* file, int chunk_count) {
+    const char* data = file->file.data;
+    size_t size = file->file.size;
+    if (size < (size_t)chunk_count * 4096) {
+        chunk_count = (int)(size / 4096) + 1;       // Not worth splitting small files finely
+    }
+
+    file->chunk_count = chunk_count;
+    file->chunk_start[0] = 0;
+    for (int i = 1; i < chunk_count; i++) {
+        size_t start = size / chunk_count * i;
+        if (start < file->chunk_start[i - 1]) start = file->chunk_start[i - 1];
+        const char* newline = start < size ? (const char*)memchr(data + start, '\n', size - start) : NULL;
+        file->chunk_start[i] = newline ? (size_t)(newline - data) + 1 : size;
+    }
+    file->chunk_start[chunk_count] = size;
+}
+
+// Scan the file's chunks in parallel and join them back in file order
+static int scan_file(ParallelLoad* load, LoadFile* file, int chunk_count) {
+    if (!file->file.data) {
+        printf("No %s data file found.\n", file->what);
+        return 1;
+    }
+    file->present = 1;
+
+    split_into_chunks(file, chunk_count);
+    load->scanning = file;
+    run_parallel(file->chunk_count, scan_chunk_task, load);
+
+    size_t total = 0;
+    for (int i = 0; i < file->chunk_count; i++) {
+        total += file->chunks[i].count;
+    }
+    file->lines = (TaggedLine*)malloc((total ? total : 1) * sizeof(TaggedLine));
+    if (!file->lines) {
+        printf("Memory allocation failed while reading %s\n", file->path);
+        return 0;
+    }
+    for (int i = 0; i < file->chunk_count; i++) {
+        if (file->chunks[i].count > 0) {
+            memcpy(&file->lines[file->line_count], file->chunks[i].lines, file->chunks[i].count * sizeof(TaggedLine));
+            file->line_count += file->chunks[i].count;
+        }
+        free(file->chunks[i].lines);
+        file->chunks[i].lines = NULL;
+    }
+    return 1;
+}
+
+// Counting sort of the line indexes by slot; stable, so each slot keeps file order
+static int group_by_slot(LoadFile* file, int slot_count) {
+    file->group_start = (int*)calloc(slot_count + 1, sizeof(int));
+    file->grouped = (int*)malloc((file->line_count ? file->line_count : 1) * sizeof(int));
+    if (!file->group_start || !file->grouped) {
+        printf("Memory allocation failed while grouping %s\n", file->path);
+        return 0;
+    }
+
+    for (int i = 0; i < file->line_count; i++) {
+        if (file->lines[i].slot >= 0) file->group_start[file->lines[i].slot + 1]++;
+    }
+    for (int s = 0; s < slot_count; s++) {
+        file->group_start[s + 1] += file->group_start[s];
+    }
+
+    int* next = (int*)malloc((slot_count ? slot_count : 1) * sizeof(int));
+    if (!next) {
+        printf("Memory allocation failed while grouping %s\n", file->path);
+        return 0;
+    }
+    memcpy(next, file->group_start, slot_count * sizeof(int));
+    for (int i = 0; i < file->line_count; i++) {
+        if (file->lines[i].slot >= 0) file->grouped[next[file->lines[i].slot]++] = i;
+    }
+    free(next);
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Per-showroom builds
+// ---------------------------------------------------------------------------
+
+// Stage 3: everything in this task belongs to one showroom, so no other task touches its trees
+static void build_showroom_task(int slot, void* context) {
+    ParallelLoad* load = (ParallelLoad*)context;
+    Showroom* showroom = load->showrooms[slot];
+    StrView fields[TEXT_MAX_FIELDS];
+
+    LoadFile* file = &load->files[LOAD_SALESPERSONS];
+    for (int i = file->group_start[slot]; i < file->group_start[slot + 1]; i++) {
+        TaggedLine* tagged = &file->lines[file->grouped[i]];
+        int field_count = split_fields(tagged->line, FIELD_SEP[0], fields, TEXT_MAX_FIELDS);
+        SalesPerson sp;
+        tagged->added = parse_salesperson_fields(fields, field_count, &sp) &&
+                        add_loaded_salesperson(showroom, &sp) != NULL;
+    }
+
+    file = &load->files[LOAD_CARS];
+    for (int i = file->group_start[slot]; i < file->group_start[slot + 1]; i++) {
+        TaggedLine* tagged = &file->lines[file->grouped[i]];
+        int field_count = split_fields(tagged->line, FIELD_SEP[0], fields, TEXT_MAX_FIELDS);
+        Car car;
+        if (parse_car_fields(fields, field_count, &car)) {
+            add_loaded_car(showroom, &car);
+            tagged->added = 1;
+        }
+    }
+
+    file = &load->files[LOAD_SOLD_CARS];
+    for (int i = file->group_start[slot]; i < file->group_start[slot + 1]; i++) {
+        TaggedLine* tagged = &file->lines[file->grouped[i]];
+        int field_count = split_fields(tagged->line, FIELD_SEP[0], fields, TEXT_MAX_FIELDS);
+        SoldCar sold_car;
+        if (parse_sold_car_fields(fields, field_count, &sold_car)) {
+            sold_car.model_id = tagged->extra;
+            add_loaded_sold_car(showroom, &sold_car);
+            tagged->added = 1;
+        }
+    }
+}
+
+// Stage 4: customers of every salesperson routed to this showroom
+static void build_customers_task(int slot, void* context) {
+    ParallelLoad* load = (ParallelLoad*)context;
+    Showroom* showroom = load->showrooms[slot];
+    LoadFile* file = &load->files[LOAD_CUSTOMERS];
+    StrView fields[TEXT_MAX_FIELDS];
+
+    for (int i = file->group_start[slot]; i < file->group_start[slot + 1]; i++) {
+        int line = file->grouped[i];
+        TaggedLine* tagged = &file->lines[line];
+        int field_count = split_fields(tagged->line, FIELD_SEP[0], fields, TEXT_MAX_FIELDS);
+        Customer customer;
+        if (!parse_customer_fields(fields, field_count, &customer)) continue;
+
+        CustomerResult* result = &load->customer_results[line];
+        result->customer = add_loaded_customer(showroom, load->routes[tagged->extra].sales_person,
+                                               &customer, &result->sold_car);
+        tagged->added = 1;
+    }
+}
+
+// Stage 4 routing: one entry per salesperson ID, pointing at the first showroom that has it
+static int compare_routes(const void* a, const void* b) {
+    const SalesPersonRoute* route_a = (const SalesPersonRoute*)a;
+    const SalesPersonRoute* route_b = (const SalesPersonRoute*)b;
+    if (route_a->id != route_b->id) return route_a->id < route_b->id ? -1 : 1;
+    return route_a->slot - route_b->slot;
+}
+
+static BTreeNode* first_leaf(BPlusTree* tree) {
+    if (!tree || !tree->root) return NULL;
+    BTreeNode* node = tree->root;
+    while (!node->is_leaf) {
+        node = node->children[0];
+    }
+    return node;
+}
+
+static int build_routes(ParallelLoad* load) {
+    int total = 0;
+    for (int s = 0; s < load->showroom_count; s++) {
+        for (BTreeNode* node = first_leaf(load->showrooms[s]->sales_persons); node; node = node->leaf_link.next) {
+            total += node->num_keys;
+        }
+    }
+    load->routes = (SalesPersonRoute*)malloc((total ? total : 1) * sizeof(SalesPersonRoute));
+    if (!load->routes) {
+        printf("Memory allocation failed while routing customers\n");
+        return 0;
+    }
+
+    for (int s = 0; s < load->showroom_count; s++) {
+        for (BTreeNode* node = first_leaf(load->showrooms[s]->sales_persons); node; node = node->leaf_link.next) {
+            for (int i = 0; i < node->num_keys; i++) {
+                SalesPersonRoute* route = &load->routes[load->route_count++];
+                route->id = ((SalesPerson*)node->keys[i].key)->id;
+                route->slot = s;
+            }
+        }
+    }
+    qsort(load->routes, load->route_count, sizeof(SalesPersonRoute), compare_routes);
+
+    // Keep the first showroom per ID, and the salesperson a tree search finds there
+    int kept = 0;
+    for (int i = 0; i < load->route_count; i++) {
+        if (kept > 0 && load->routes[kept - 1].id == load->routes[i].id) continue;
+
+        SalesPerson temp_sp;
+        temp_sp.id = load->routes[i].id;
+        load->routes[kept] = load->routes[i];
+        load->routes[kept].sales_person =
+            (SalesPerson*)bplusSearch(load->showrooms[load->routes[i].slot]->sales_persons, &temp_sp);
+        kept++;
+    }
+    load->route_count = kept;
+    return 1;
+}
+
+static void route_customers_task(int index, void* context) {
+    ParallelLoad* load = (ParallelLoad*)context;
+    LoadFile* file = &load->files[LOAD_CUSTOMERS];
+    size_t begin = file->chunk_start[index], end = file->chunk_start[index + 1];
+
+    // Chunks were joined in order, so find this chunk's lines by their position in the file
+    int low = 0, high = file->line_count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if ((size_t)(file->lines[mid].line.data - file->file.data) < begin) low = mid + 1; else high = mid;
+    }
+    for (int i = low; i < file->line_count && (size_t)(file->lines[i].line.data - file->file.data) < end; i++) {
+        int route = find_route(load, file->lines[i].key);
+        file->lines[i].extra = route;
+        file->lines[i].slot = route >= 0 ? load->routes[route].slot : -1;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Pipeline
+// ---------------------------------------------------------------------------
+
+// Model names are interned on this thread in file order, so model ids match a sequential load
+static void intern_sold_car_models(LoadFile* file) {
+    StrView fields[TEXT_MAX_FIELDS];
+    for (int i = 0; i < file->line_count; i++) {
+        TaggedLine* tagged = &file->lines[i];
+        if (tagged->slot < 0) continue;
+
+        int field_count = split_fields(tagged->line, FIELD_SEP[0], fields, TEXT_MAX_FIELDS);
+        if (field_count >= 8) {
+            tagged->extra = intern_sold_car_model(fields, field_count);
+        }
+    }
+}
+
+// Stage 5: what every showroom shares is filled in on this thread, in customer file order
+static void finish_customers(ParallelLoad* load) {
+    LoadFile* file = &load->files[LOAD_CUSTOMERS];
+    StrView fields[TEXT_MAX_FIELDS];
+
+    int added = 0;
+    for (int i = 0; i < file->line_count; i++) {
+        added += file->lines[i].added;
+    }
+
+    customer_index_begin_batch(added);
+    for (int i = 0; i < file->line_count; i++) {
+        TaggedLine* tagged = &file->lines[i];
+        if (!tagged->added) continue;
+
+        CustomerResult* result = &load->customer_results[i];
+        if (!result->customer) continue;
+
+        split_fields(tagged->line, FIELD_SEP[0], fields, TEXT_MAX_FIELDS);
+        set_customer_strings(result->customer, fields);
+
+        SalesPersonRoute* route = &load->routes[tagged->extra];
+        customer_index_add(load->showrooms[route->slot], route->sales_person, result->customer, result->sold_car);
+        if (result->sold_car) {
+            record_national_model_sale(result->sold_car->model_id, result->customer->purchase_date);
+        }
+    }
+    customer_index_end_batch();
+}
+
+static void print_file_summary(const LoadFile* file) {
+    if (!file->present) return;
+
+    int loaded = 0;
+    for (int i = 0; i < file->line_count; i++) {
+        loaded += file->lines[i].added;
+    }
+    int skipped = file->line_count - loaded;
+
+    printf("Loaded %d %s from %s", loaded, file->what, file->path);
+    if (skipped > 0) {
+        printf(" (%d skipped: malformed or referring to a missing record)", skipped);
+    }
+    printf("\n");
+}
+
+static int collect_showrooms(ParallelLoad* load) {
+    BTreeNode* first = first_leaf(showroom_tree);
+    if (!first) return 1;
+
+    for (BTreeNode* node = first; node; node = node->leaf_link.next) {
+        load->showroom_count += node->num_keys;
+    }
+
+    load->showrooms = (Showroom**)malloc(load->showroom_count * sizeof(Showroom*));
+    load->showroom_ids = (int*)malloc(load->showroom_count * sizeof(int));
+    if (!load->showrooms || !load->showroom_ids) {
+        printf("Memory allocation failed while loading showrooms\n");
+        return 0;
+    }
+
+    int count = 0;
+    for (BTreeNode* node = first; node; node = node->leaf_link.next) {
+        for (int i = 0; i < node->num_keys; i++) {
+            load->showrooms[count] = (Showroom*)node->keys[i].key;
+            load->showroom_ids[count] = load->showrooms[count]->id;
+            count++;
+        }
+    }
+    return 1;
+}
+
+static void init_load_file(LoadFile* file, const char* path, const char* what, int by_showroom) {
+    file->path = path;
+    file->what = what;
+    file->by_showroom = by_showroom;
+}
+
+static void free_parallel_load(ParallelLoad* load) {
+    for (int f = 0; f < LOAD_FILE_COUNT; f++) {
+        LoadFile* file = &load->files[f];
+        for (int i = 0; i < file->chunk_count; i++) {
+            free(file->chunks[i].lines);
+        }
+        free(file->lines);
+        free(file->grouped);
+        free(file->group_start);
+        unmap_file(&file->file);
+    }
+    free(load->showrooms);
+    free(load->showroom_ids);
+    free(load->routes);
+    free(load->customer_results);
+}
+
+size_t parallel_import_text_files() {
+    size_t bytes = 0;
+
+    ParallelLoad load;
+    memset(&load, 0, sizeof(load));
+    init_load_file(&load.files[LOAD_SALESPERSONS], SALESPERSONS_FILE, "salespersons", 1);
+    init_load_file(&load.files[LOAD_CARS], CARS_FILE, "cars", 1);
+    init_load_file(&load.files[LOAD_SOLD_CARS], SOLD_CARS_FILE, "sold cars", 1);
+    init_load_file(&load.files[LOAD_CUSTOMERS], CUSTOMERS_FILE, "customers", 0);
+
+    // The large files are read in the background from here on, while stage 1 runs
+    const char* paths[LOAD_FILE_COUNT];
+    for (int f = 0; f < LOAD_FILE_COUNT; f++) {
+        paths[f] = load.files[f].path;
+    }
+    IoReadBatch* batch = io_read_files(paths, LOAD_FILE_COUNT);
+
+    // Stage 1: car models first (sold cars refer to their ids), then the showrooms
+    bytes += load_car_popularity_from_file();
+    bytes += load_showrooms_from_file();
+
+    int chunk_count = parallel_load_thread_count() * CHUNKS_PER_THREAD;
+    int ok = collect_showrooms(&load);
+
+    // Stage 2: each file is scanned as soon as it has been read
+    for (int n = 0; ok && n < LOAD_FILE_COUNT; n++) {
+        MappedFile read;
+        int f = batch ? io_next_file(batch, &read) : n;
+        if (f < 0) break;
+        if (batch) {
+            load.files[f].file = read;
+        } else {
+            map_file(load.files[f].path, &load.files[f].file);
+        }
+        ok = scan_file(&load, &load.files[f], chunk_count);
+        bytes += load.files[f].file.size;
+    }
+    io_read_finish(batch);
+    for (int f = 0; ok && f < LOAD_CUSTOMERS; f++) {
+        ok = group_by_slot(&load.files[f], load.showroom_count);
+    }
+
+    // Stage 3
+    if (ok) {
+        intern_sold_car_models(&load.files[LOAD_SOLD_CARS]);
+        run_parallel(load.showroom_count, build_showroom_task, &load);
+    }
+
+    // Stage 4
+    LoadFile* customers = &load.files[LOAD_CUSTOMERS];
+    if (ok) ok = build_routes(&load);
+    if (ok) {
+        run_parallel(customers->chunk_count, route_customers_task, &load);
+        load.customer_results = (CustomerResult*)calloc(customers->line_count ? customers->line_count : 1,
+                                                        sizeof(CustomerResult));
+        ok = load.customer_results && group_by_slot(customers, load.showroom_count);
+    }
+    if (ok) {
+        run_parallel(load.showroom_count, build_customers_task, &load);
+        finish_customers(&load);
+    } else {
+        printf("Parallel import stopped early, some records were not loaded.\n");
+    }
+
+    for (int f = 0; f < LOAD_FILE_COUNT; f++) {
+        print_file_summary(&load.files[f]);
+    }
+    inventory_changed();
+
+    free_parallel_load(&load);
+    return bytes;
+}
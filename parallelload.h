@@ -0,0 +1,28 @@
+#ifndef PARALLEL_LOAD_H
+#define PARALLEL_LOAD_H
+
+#include <stddef.h>
+
+// Multithreaded import of the text files, in dependency order:
+//   1. car models and showrooms, one record at a time (every other file refers to them)
+//   2. the other files, read in the background meanwhile, are cut into line-aligned chunks
+//      and scanned in parallel as each one arrives; each line is tagged with the showroom
+//      it belongs to and grouped per showroom, keeping file order
+//   3. salespersons, cars and sold cars are built per showroom, one showroom per task
+//   4. customers are routed to their salesperson's showroom and built the same way
+//   5. state shared by all showrooms (string heap, customer index, national popularity)
+//      is filled in on the calling thread, in file order
+// The result is the same as loading the files with the load_*_from_file() functions.
+
+#define PARALLEL_LOAD_MAX_THREADS 16
+#define PARALLEL_LOAD_THREADS_ENV "SHOWROOM_LOAD_THREADS"   // Overrides the core count
+
+typedef void (*ParallelTaskFunc)(int index, void* context);
+
+int parallel_load_thread_count();
+void run_parallel(int task_count, ParallelTaskFunc task, void* context);    // Returns when every task is done
+double wall_clock_seconds();
+
+size_t parallel_import_text_files();    // Returns the bytes read
+
+#endif
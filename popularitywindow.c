@@ -0,0 +1,237 @@
+#include "popularitywindow.h"
+#include "essentialfunction.h"
+#include "mappedstore.h"
+
+// All showrooms together
+static PopularityWindow* national_window = NULL;
+
+// Allocate a window with every day slot unused
+static PopularityWindow* create_popularity_window() {
+    PopularityWindow* window = (PopularityWindow*)store_malloc(sizeof(PopularityWindow));
+    if (!window) {
+        out_printf("Memory allocation failed for popularity window\n");
+        return NULL;
+    }
+    window->latest_day = -1;
+    for (int i = 0; i < POPULARITY_WINDOW_DAYS; i++) {
+        window->days[i].day = -1;
+        window->days[i].used = 0;
+    }
+    return window;
+}
+
+// Space-Saving update: bump the model's counter, or take over the smallest one when full
+static void sketch_add(DaySketch* sketch, int model_id) {
+    for (int i = 0; i < sketch->used; i++) {
+        if (sketch->counters[i].model_id == model_id) {
+            sketch->counters[i].count++;
+            return;
+        }
+    }
+
+    if (sketch->used < POPULARITY_SKETCH_SIZE) {
+        HeavyHitter* counter = &sketch->counters[sketch->used++];
+        counter->model_id = model_id;
+        counter->count = 1;
+        counter->error = 0;
+        return;
+    }
+
+    HeavyHitter* smallest = &sketch->counters[0];
+    for (int i = 1; i < POPULARITY_SKETCH_SIZE; i++) {
+        if (sketch->counters[i].count < smallest->count) {
+            smallest = &sketch->counters[i];
+        }
+    }
+    smallest->model_id = model_id;
+    smallest->error = smallest->count;
+    smallest->count++;
+}
+
+// Count one sale of a model on a given day
+void popularity_window_record(PopularityWindow* window, int model_id, int day) {
+    if (!window || model_id < 0 || day < 0) return;
+
+    // Sales that already fell out of the window are not kept
+    if (window->latest_day >= 0 && day <= window->latest_day - POPULARITY_WINDOW_DAYS) return;
+    if (day > window->latest_day) {
+        window->latest_day = day;
+    }
+
+    // Reuse the ring slot once the day it held has expired
+    DaySketch* sketch = &window->days[day % POPULARITY_WINDOW_DAYS];
+    if (sketch->day != day) {
+        sketch->day = day;
+        sketch->used = 0;
+    }
+    sketch_add(sketch, model_id);
+}
+
+// Record a sale in the showroom's window and the national one
+void record_model_sale(Showroom* showroom, int model_id, int day) {
+    record_national_model_sale(model_id, day);
+    record_showroom_model_sale(showroom, model_id, day);
+}
+
+// Only touches the showroom, so different showrooms can be updated from different threads
+void record_showroom_model_sale(Showroom* showroom, int model_id, int day) {
+    if (!showroom || model_id < 0) return;
+
+    if (!showroom->popularity_window) {
+        showroom->popularity_window = create_popularity_window();
+    }
+    popularity_window_record(showroom->popularity_window, model_id, day);
+}
+
+void record_national_model_sale(int model_id, int day) {
+    if (model_id < 0) return;
+
+    if (!national_window) {
+        national_window = create_popularity_window();
+    }
+    popularity_window_record(national_window, model_id, day);
+}
+
+// Rebuild a showroom's window from its customers' purchase dates (the national window is unchanged)
+void rebuild_popularity_window(Showroom* showroom) {
+    if (!showroom) return;
+
+    free_popularity_window(showroom->popularity_window);
+    showroom->popularity_window = NULL;
+
+    if (!showroom->sales_persons || !showroom->sales_persons->root || !showroom->sold_cars) return;
+
+    BTreeNode* sp_node = showroom->sales_persons->root;
+    while (!sp_node->is_leaf) {
+        sp_node = sp_node->children[0];
+    }
+
+    while (sp_node) {
+        for (int i = 0; i < sp_node->num_keys; i++) {
+            SalesPerson* sp = (SalesPerson*)sp_node->keys[i].key;
+            if (!sp->customer_tree || !sp->customer_tree->root) continue;
+
+            BTreeNode* customer_node = sp->customer_tree->root;
+            while (!customer_node->is_leaf) {
+                customer_node = customer_node->children[0];
+            }
+
+            while (customer_node) {
+                for (int k = 0; k < customer_node->num_keys; k++) {
+                    Customer* customer = (Customer*)customer_node->keys[k].key;
+
+                    SoldCar temp_sold_car;
+                    strcpy(temp_sold_car.VIN, customer->car_VIN);
+                    SoldCar* sold_car = (SoldCar*)bplusSearch(showroom->sold_cars, &temp_sold_car);
+                    if (!sold_car || sold_car->model_id < 0) continue;
+
+                    if (!showroom->popularity_window) {
+                        showroom->popularity_window = create_popularity_window();
+                    }
+                    popularity_window_record(showroom->popularity_window, sold_car->model_id,
+                                             customer->purchase_date);
+                }
+                customer_node = customer_node->leaf_link.next;
+            }
+        }
+        sp_node = sp_node->leaf_link.next;
+    }
+}
+
+PopularityWindow* national_popularity_window() {
+    return national_window;
+}
+
+int popularity_window_latest_day() {
+    return national_window ? national_window->latest_day : -1;
+}
+
+// Merge the day sketches in (end_day - POPULARITY_WINDOW_DAYS, end_day] and return the k best models
+int popularity_window_top(PopularityWindow* window, int end_day, int k, HeavyHitter* out) {
+    if (!window || k <= 0) return 0;
+
+    HeavyHitter merged[POPULARITY_WINDOW_DAYS * POPULARITY_SKETCH_SIZE];
+    int covered_error[POPULARITY_WINDOW_DAYS * POPULARITY_SKETCH_SIZE];
+    int merged_count = 0;
+    int missing_error = 0;      // Sum of the smallest counter of every full day
+
+    for (int d = 0; d < POPULARITY_WINDOW_DAYS; d++) {
+        DaySketch* sketch = &window->days[d];
+        if (sketch->day < 0 || sketch->day > end_day || sketch->day <= end_day - POPULARITY_WINDOW_DAYS) continue;
+
+        // A model missing from a full day may still have sold up to its smallest counter there
+        int smallest = 0;
+        if (sketch->used == POPULARITY_SKETCH_SIZE) {
+            smallest = sketch->counters[0].count;
+            for (int i = 1; i < POPULARITY_SKETCH_SIZE; i++) {
+                if (sketch->counters[i].count < smallest) smallest = sketch->counters[i].count;
+            }
+            missing_error += smallest;
+        }
+
+        for (int i = 0; i < sketch->used; i++) {
+            HeavyHitter* counter = &sketch->counters[i];
+            int m = 0;
+            while (m < merged_count && merged[m].model_id != counter->model_id) {
+                m++;
+            }
+            if (m == merged_count) {
+                merged[m].model_id = counter->model_id;
+                merged[m].count = 0;
+                merged[m].error = 0;
+                covered_error[m] = 0;
+                merged_count++;
+            }
+            merged[m].count += counter->count;
+            merged[m].error += counter->error;
+            covered_error[m] += smallest;
+        }
+    }
+
+    // Days where a model was absent add to its error but not to its count
+    for (int m = 0; m < merged_count; m++) {
+        merged[m].error += missing_error - covered_error[m];
+    }
+
+    // Partial selection sort, k is small
+    int n = 0;
+    while (n < k && n < merged_count) {
+        int best = n;
+        for (int m = n + 1; m < merged_count; m++) {
+            if (merged[m].count > merged[best].count ||
+                (merged[m].count == merged[best].count && merged[m].model_id < merged[best].model_id)) {
+                best = m;
+            }
+        }
+        HeavyHitter temp = merged[n];
+        merged[n] = merged[best];
+        merged[best] = temp;
+
+        out[n] = merged[n];
+        n++;
+    }
+    return n;
+}
+
+PopularityWindow* clone_popularity_window(const PopularityWindow* window) {
+    if (!window) return NULL;
+    PopularityWindow* clone = (PopularityWindow*)store_malloc(sizeof(PopularityWindow));
+    if (clone) {
+        memcpy(clone, window, sizeof(PopularityWindow));
+    }
+    return clone;
+}
+
+void free_popularity_window(PopularityWindow* window) {
+    store_free(window);
+}
+
+// Function to free the national popularity window
+void free_national_popularity_window() {
+    store_free(national_window);
+    national_window = NULL;
+}
+
+void register_popularity_window_state() {
+    store_register_state(&national_window, sizeof(national_window));
+}
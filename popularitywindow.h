@@ -0,0 +1,28 @@
+#ifndef POPULARITY_WINDOW_H
+#define POPULARITY_WINDOW_H
+
+#include "functionpointer.h"
+
+// Car model popularity over the last POPULARITY_WINDOW_DAYS days, per showroom and nationally.
+// Each day keeps a fixed-size Space-Saving summary, so memory stays bounded however many
+// models are sold. Counts are estimates, off by at most HeavyHitter.error.
+
+// Updates
+void record_model_sale(Showroom* showroom, int model_id, int day);
+void record_showroom_model_sale(Showroom* showroom, int model_id, int day);
+void record_national_model_sale(int model_id, int day);
+void popularity_window_record(PopularityWindow* window, int model_id, int day);
+void rebuild_popularity_window(Showroom* showroom);
+
+// Queries
+PopularityWindow* national_popularity_window();
+int popularity_window_latest_day();                    // -1 before the first sale
+int popularity_window_top(PopularityWindow* window, int end_day, int k, HeavyHitter* out);
+
+// Memory
+PopularityWindow* clone_popularity_window(const PopularityWindow* window);
+void free_popularity_window(PopularityWindow* window);
+void free_national_popularity_window();
+void register_popularity_window_state();   // See mappedstore.h
+
+#endif
@@ -0,0 +1,434 @@
+#define _GNU_SOURCE             // accept4, pipe2
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "server.h"
+#include "batch.h"
+#include "functionpointer.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// ---------------------------------------------------------------------------
+// Framing and addresses, shared with the client
+// ---------------------------------------------------------------------------
+
+// All digits: a localhost TCP port, anything else a socket path
+static int resolve_address(const char* address, struct sockaddr_storage* storage, socklen_t* length) {
+    memset(storage, 0, sizeof(*storage));
+    if (address[0] != '\0' && strspn(address, "0123456789") == strlen(address)) {
+        long port = atol(address);
+        if (port <= 0 || port > 65535) return 0;
+        struct sockaddr_in* in = (struct sockaddr_in*)storage;
+        in->sin_family = AF_INET;
+        in->sin_port = htons((uint16_t)port);
+        in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        *length = sizeof(struct sockaddr_in);
+        return 1;
+    }
+
+    struct sockaddr_un* un = (struct sockaddr_un*)storage;
+    if (strlen(address) >= sizeof(un->sun_path)) return 0;
+    un->sun_family = AF_UNIX;
+    strcpy(un->sun_path, address);
+    *length = sizeof(struct sockaddr_un);
+    return 1;
+}
+
+int connect_to_server(const char* address) {
+    struct sockaddr_storage storage;
+    socklen_t length;
+    if (!resolve_address(address, &storage, &length)) return -1;
+
+    int fd = socket(storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*)&storage, length) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Waits for room on a non-blocking socket rather than failing
+static int send_all(int fd, const void* data, size_t length) {
+    const char* bytes = (const char*)data;
+    while (length > 0) {
+        ssize_t sent = send(fd, bytes, length, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = { fd, POLLOUT, 0 };
+            poll(&pfd, 1, -1);
+            continue;
+        }
+        if (sent <= 0) return 0;
+        bytes += sent;
+        length -= (size_t)sent;
+    }
+    return 1;
+}
+
+static int receive_all(int fd, void* data, size_t length) {
+    char* bytes = (char*)data;
+    while (length > 0) {
+        ssize_t got = recv(fd, bytes, length, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return 0;
+        bytes += got;
+        length -= (size_t)got;
+    }
+    return 1;
+}
+
+int send_frame(int fd, const void* first, size_t first_size, const void* rest, size_t rest_size) {
+    if (first_size + rest_size > SERVER_MAX_REPLY) return 0;
+    uint32_t header = htonl((uint32_t)(first_size + rest_size));
+    return send_all(fd, &header, sizeof(header)) && send_all(fd, first, first_size) &&
+           (rest_size == 0 || send_all(fd, rest, rest_size));
+}
+
+int receive_frame(int fd, char** payload, uint32_t* size, uint32_t max_size) {
+    uint32_t header;
+    if (!receive_all(fd, &header, sizeof(header))) return 0;
+    *size = ntohl(header);
+    if (*size > max_size) return 0;
+
+    *payload = (char*)malloc((size_t)*size + 1);
+    if (!*payload) return 0;
+    if (!receive_all(fd, *payload, *size)) {
+        free(*payload);
+        *payload = NULL;
+        return 0;
+    }
+    (*payload)[*size] = '\0';
+    return 1;
+}
+
+#endif
+
+#ifdef __linux__
+
+#include <pthread.h>
+#include <signal.h>
+#include <fcntl.h>
+
+// ---------------------------------------------------------------------------
+// Connections
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    int fd;
+    int busy;                   // Its request is queued or running: not polled meanwhile
+    int failed;                 // The reply could not be sent; closed once no longer busy
+    unsigned char header[4];
+    uint32_t header_got;
+    char* payload;
+    uint32_t length;
+    uint32_t got;
+} Connection;
+
+static Connection* connections[SERVER_MAX_CLIENTS];
+static int connection_count = 0;
+
+// Requests waiting for a worker, in arrival order
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+static Connection* queue[SERVER_MAX_CLIENTS];
+static int queue_head = 0;
+static int queue_count = 0;
+static int stopping = 0;
+static unsigned long requests_served = 0;
+
+// Workers hand connections back through the wake pipe; the signal handlers use it too
+static int wake_pipe[2] = { -1, -1 };
+static volatile sig_atomic_t stop_requested = 0;
+
+static void wake_event_loop() {
+    ssize_t written;
+    do {
+        written = write(wake_pipe[1], "x", 1);
+    } while (written < 0 && errno == EINTR);
+}
+
+static void handle_stop_signal(int signal_number) {
+    (void)signal_number;
+    stop_requested = 1;
+    int saved_errno = errno;
+    wake_event_loop();
+    errno = saved_errno;
+}
+
+static void close_connection(int index) {
+    Connection* connection = connections[index];
+    close(connection->fd);
+    free(connection->payload);
+    free(connection);
+    connections[index] = connections[--connection_count];
+}
+
+// 1 once a whole request has arrived, 0 while it is incomplete, -1 to close the connection
+static int read_request(Connection* connection) {
+    for (;;) {
+        char* target;
+        size_t wanted;
+        if (connection->header_got < sizeof(connection->header)) {
+            target = (char*)connection->header + connection->header_got;
+            wanted = sizeof(connection->header) - connection->header_got;
+        } else {
+            target = connection->payload + connection->got;
+            wanted = connection->length - connection->got;
+        }
+
+        ssize_t got = recv(connection->fd, target, wanted, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+        if (got <= 0) return -1;
+
+        if (connection->header_got < sizeof(connection->header)) {
+            connection->header_got += (uint32_t)got;
+            if (connection->header_got < sizeof(connection->header)) continue;
+            uint32_t length;
+            memcpy(&length, connection->header, sizeof(length));
+            length = ntohl(length);
+            if (length == 0 || length > SERVER_MAX_REQUEST) return -1;
+            connection->payload = (char*)malloc(length);
+            if (!connection->payload) return -1;
+            connection->length = length;
+            connection->got = 0;
+        } else {
+            connection->got += (uint32_t)got;
+        }
+        if (connection->header_got == sizeof(connection->header) && connection->got == connection->length) return 1;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Running a command
+// ---------------------------------------------------------------------------
+
+// Run a request's command line on the calling worker, its output captured as the reply
+static int serve_request(Connection* connection) {
+    char* output = NULL;
+    size_t output_size = 0;
+    FILE* stream = open_memstream(&output, &output_size);
+    unsigned char status = SERVER_BAD_REQUEST;
+    if (stream) {
+        set_command_output(stream);
+        int result = batch_execute(connection->payload, connection->length);
+        set_command_output(NULL);
+        status = result == BATCH_OK ? SERVER_OK : result == BATCH_FAILED ? SERVER_FAILED : SERVER_BAD_REQUEST;
+        fclose(stream);
+    }
+
+    int sent;
+    if (output) {
+        sent = send_frame(connection->fd, &status, 1, output, output_size);
+    } else {
+        const char message[] = "Out of memory\n";
+        sent = send_frame(connection->fd, &status, 1, message, sizeof(message) - 1);
+    }
+    free(output);
+    return sent;
+}
+
+static void* server_worker(void* arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&queue_lock);
+        while (queue_count == 0 && !stopping) {
+            pthread_cond_wait(&queue_cond, &queue_lock);
+        }
+        if (queue_count == 0) {
+            pthread_mutex_unlock(&queue_lock);
+            break;
+        }
+        Connection* connection = queue[queue_head];
+        queue_head = (queue_head + 1) % SERVER_MAX_CLIENTS;
+        queue_count--;
+        pthread_mutex_unlock(&queue_lock);
+
+        int sent = serve_request(connection);
+        free(connection->payload);
+        connection->payload = NULL;
+        connection->header_got = 0;
+        connection->length = connection->got = 0;
+
+        pthread_mutex_lock(&queue_lock);
+        connection->busy = 0;
+        connection->failed = !sent;
+        requests_served++;
+        pthread_mutex_unlock(&queue_lock);
+        wake_event_loop();
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Listening
+// ---------------------------------------------------------------------------
+
+static int open_listener(const char* address) {
+    struct sockaddr_storage storage;
+    socklen_t length;
+    if (!resolve_address(address, &storage, &length)) {
+        printf("Invalid server address %s\n", address);
+        return -1;
+    }
+
+    if (storage.ss_family == AF_UNIX) {
+        // A socket file nobody answers on is left over from a server that stopped abruptly
+        int other = connect_to_server(address);
+        if (other >= 0) {
+            close(other);
+            printf("A server is already listening on %s\n", address);
+            return -1;
+        }
+        unlink(address);
+    }
+
+    int fd = socket(storage.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(fd, (struct sockaddr*)&storage, length) != 0 || listen(fd, SOMAXCONN) != 0) {
+        printf("Cannot listen on %s: %s\n", address, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void accept_connections(int listener) {
+    while (connection_count < SERVER_MAX_CLIENTS) {
+        int fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+
+        Connection* connection = (Connection*)calloc(1, sizeof(Connection));
+        if (!connection) {
+            close(fd);
+            return;
+        }
+        connection->fd = fd;
+        connections[connection_count++] = connection;
+    }
+}
+
+static int server_worker_count() {
+    const char* forced = getenv(SERVER_WORKERS_ENV);
+    int workers = forced ? atoi(forced) : SERVER_WORKERS;
+    return workers > 0 ? workers : SERVER_WORKERS;
+}
+
+int server_run(const char* address) {
+    int listener = open_listener(address);
+    if (listener < 0) return 0;
+    if (pipe2(wake_pipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+        printf("Cannot start the server\n");
+        close(listener);
+        return 0;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_stop_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    int worker_count = server_worker_count();
+    pthread_t* workers = (pthread_t*)malloc((size_t)worker_count * sizeof(pthread_t));
+    int started = 0;
+    while (workers && started < worker_count && pthread_create(&workers[started], NULL, server_worker, NULL) == 0) {
+        started++;
+    }
+    printf("Serving on %s with %d workers, stop with Ctrl+C\n", address, started);
+    fflush(stdout);
+
+    // Indexes into connections[] of the polled ones
+    static struct pollfd fds[SERVER_MAX_CLIENTS + 2];
+    static int polled[SERVER_MAX_CLIENTS];
+    while (started > 0 && !stop_requested) {
+        fds[0] = (struct pollfd){ wake_pipe[0], POLLIN, 0 };
+        fds[1] = (struct pollfd){ listener, connection_count < SERVER_MAX_CLIENTS ? POLLIN : 0, 0 };
+        int nfds = 2;
+
+        pthread_mutex_lock(&queue_lock);
+        for (int i = connection_count - 1; i >= 0; i--) {
+            if (!connections[i]->busy && connections[i]->failed) close_connection(i);
+        }
+        for (int i = 0; i < connection_count; i++) {
+            if (connections[i]->busy) continue;
+            polled[nfds - 2] = i;
+            fds[nfds++] = (struct pollfd){ connections[i]->fd, POLLIN, 0 };
+        }
+        pthread_mutex_unlock(&queue_lock);
+
+        if (poll(fds, nfds, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[0].revents) {
+            char drain[64];
+            while (read(wake_pipe[0], drain, sizeof(drain)) > 0) {}
+        }
+
+        // Backwards, so closing one (the last takes its place) leaves the rest where they are
+        for (int p = nfds - 1; p >= 2; p--) {
+            if (!fds[p].revents) continue;
+            int index = polled[p - 2];
+            int result = read_request(connections[index]);
+            if (result < 0) {
+                close_connection(index);
+            } else if (result > 0) {
+                pthread_mutex_lock(&queue_lock);
+                connections[index]->busy = 1;
+                queue[(queue_head + queue_count) % SERVER_MAX_CLIENTS] = connections[index];
+                queue_count++;
+                pthread_cond_signal(&queue_cond);
+                pthread_mutex_unlock(&queue_lock);
+            }
+        }
+        if (fds[1].revents) accept_connections(listener);
+    }
+
+    // Let the queued requests finish, then hang up on everyone
+    pthread_mutex_lock(&queue_lock);
+    stopping = 1;
+    pthread_cond_broadcast(&queue_cond);
+    pthread_mutex_unlock(&queue_lock);
+    for (int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+    free(workers);
+    while (connection_count > 0) close_connection(connection_count - 1);
+
+    close(listener);
+    if (strspn(address, "0123456789") != strlen(address)) unlink(address);
+    close(wake_pipe[0]);
+    close(wake_pipe[1]);
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+
+    printf("Server stopped after %lu requests\n", requests_served);
+    return 1;
+}
+
+#else
+
+int server_run(const char* address) {
+    (void)address;
+    printf("Server mode needs Linux.\n");
+    return 0;
+}
+
+#ifdef _WIN32
+int send_frame(int fd, const void* first, size_t first_size, const void* rest, size_t rest_size) { return 0; }
+int receive_frame(int fd, char** payload, uint32_t* size, uint32_t max_size) { return 0; }
+int connect_to_server(const char* address) { return -1; }
+#endif
+
+#endif
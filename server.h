@@ -0,0 +1,44 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Server mode: one process holds the data and serves many terminals (see client.h) over a
+// Unix-domain socket, or a localhost TCP port when the address is a number.
+//
+// A request is one command line in batch syntax (see batch.h) with every answer in it, so a
+// command never waits for a terminal and a line with a missing or malformed field is rejected
+// before anything runs. Requests are read by one thread polling every connection and run by a
+// pool of workers through batch_execute(): queries whose data is in memory share the state lock
+// and run side by side, changes (and queries that must load first) hold it alone, so
+// checkpoints and reloads still run between them. What a command prints is captured for its
+// own request (see out_printf) and is the reply; background threads keep printing to stdout.
+//
+// Framing: a 4-byte length (network order) then the payload, both ways.
+//   request:  the command line (text, no newline)
+//   reply:    status (1 byte, SERVER_*), the command's output (text)
+// A connection may send any number of requests, each answered before the next is read.
+
+#define SERVER_DEFAULT_ADDRESS "data/showroom.sock"
+#define SERVER_WORKERS 4
+#define SERVER_WORKERS_ENV "SHOWROOM_SERVER_WORKERS"
+#define SERVER_MAX_CLIENTS 1024
+#define SERVER_MAX_REQUEST 65536
+#define SERVER_MAX_REPLY ((uint32_t)1 << 30)
+
+// Reply status
+#define SERVER_OK 0
+#define SERVER_BAD_REQUEST 1        // Not a valid command line, nothing ran; the output says why
+#define SERVER_FAILED 2             // The command ran and refused, the output says why
+
+// Serve until SIGINT or SIGTERM; the caller then saves as the menu does on exit.
+// 0 if the address cannot be listened on.
+int server_run(const char* address);
+
+// Framing, shared with the client. 1 on success.
+int send_frame(int fd, const void* first, size_t first_size, const void* rest, size_t rest_size);
+int receive_frame(int fd, char** payload, uint32_t* size, uint32_t max_size);   // *payload is malloc'd
+int connect_to_server(const char* address);    // Socket, -1 if nothing listens there
+
+#endif
@@ -0,0 +1,1786 @@
+#include "snapshot.h"
+#include "archive.h"
+#include "mappedfile.h"
+#include "ioengine.h"
+#include "mappedstore.h"
+#include <errno.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#define make_directory(path) _mkdir(path)
+#else
+#include <dirent.h>
+#define make_directory(path) mkdir(path, 0777)
+#endif
+
+#define SNAPSHOT_HEADER_SIZE 32
+#define SNAPSHOT_SECTION_HEADER_SIZE 24
+#define SNAPSHOT_PATH_SIZE 600
+#define SNAPSHOT_NO_SOLD_CAR 0xFFFFFFFFu    // Customer whose sale is not in the showroom's sold cars
+
+// ---------------------------------------------------------------------------
+// CRC32 (IEEE, reflected), eight bytes per step
+// ---------------------------------------------------------------------------
+
+static uint32_t crc_table[8][256];
+static int crc_table_ready = 0;
+
+static void init_crc_table() {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+        }
+        crc_table[0][i] = crc;
+    }
+    for (int i = 0; i < 256; i++) {
+        for (int t = 1; t < 8; t++) {
+            crc_table[t][i] = (crc_table[t - 1][i] >> 8) ^ crc_table[0][crc_table[t - 1][i] & 0xFF];
+        }
+    }
+    crc_table_ready = 1;
+}
+
+uint32_t crc32_update(uint32_t crc, const void* data, size_t length) {
+    if (!crc_table_ready) init_crc_table();
+
+    const unsigned char* p = (const unsigned char*)data;
+    crc = ~crc;
+    while (length >= 8) {
+        uint32_t low = crc ^ ((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+        uint32_t high = (uint32_t)p[4] | (uint32_t)p[5] << 8 | (uint32_t)p[6] << 16 | (uint32_t)p[7] << 24;
+        crc = crc_table[7][low & 0xFF] ^ crc_table[6][(low >> 8) & 0xFF] ^
+              crc_table[5][(low >> 16) & 0xFF] ^ crc_table[4][low >> 24] ^
+              crc_table[3][high & 0xFF] ^ crc_table[2][(high >> 8) & 0xFF] ^
+              crc_table[1][(high >> 16) & 0xFF] ^ crc_table[0][high >> 24];
+        p += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ *p++) & 0xFF];
+    }
+    return ~crc;
+}
+
+// ---------------------------------------------------------------------------
+// Writing
+// ---------------------------------------------------------------------------
+
+// Bytes go straight into the I/O engine's buffers, which are written in the background while
+// the next one fills. Section headers are written as placeholders and patched in at close.
+typedef struct {
+    IoWriteFile* file;
+    unsigned char* buffer;
+    size_t used;
+    size_t checked;             // Bytes of the buffer already folded into the section checksum
+    uint64_t submitted;         // File offset of the buffer's first byte
+    uint64_t section_start;     // File offset of the open section's header
+    uint32_t section_tag;
+    uint32_t section_records;
+    uint64_t section_length;
+    uint32_t section_crc;
+    int failed;
+} SnapshotWriter;
+
+// Fold the buffered section bytes into the section checksum
+static void check_section_bytes(SnapshotWriter* writer) {
+    size_t length = writer->used - writer->checked;
+    if (length == 0) return;
+    writer->section_crc = crc32_update(writer->section_crc, writer->buffer + writer->checked, length);
+    writer->section_length += length;
+    writer->checked = writer->used;
+}
+
+// Hand the buffer to the engine and take the next one
+static void flush_writer(SnapshotWriter* writer) {
+    if (writer->used == 0) return;
+    check_section_bytes(writer);
+    io_write_submit(writer->file, writer->used);
+    writer->submitted += writer->used;
+    writer->used = 0;
+    writer->checked = 0;
+    writer->buffer = (unsigned char*)io_write_buffer(writer->file);
+    if (!writer->buffer) writer->failed = 1;
+}
+
+static void put_bytes(SnapshotWriter* writer, const void* data, size_t length) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    while (length > 0 && !writer->failed) {
+        if (writer->used == IO_CHUNK_SIZE) flush_writer(writer);
+        if (writer->failed) return;
+        size_t chunk = IO_CHUNK_SIZE - writer->used;
+        if (chunk > length) chunk = length;
+        memcpy(writer->buffer + writer->used, bytes, chunk);
+        writer->used += chunk;
+        bytes += chunk;
+        length -= chunk;
+    }
+}
+
+static void put_u8(SnapshotWriter* writer, uint8_t value) { put_bytes(writer, &value, sizeof(value)); }
+static void put_u16(SnapshotWriter* writer, uint16_t value) { put_bytes(writer, &value, sizeof(value)); }
+static void put_u32(SnapshotWriter* writer, uint32_t value) { put_bytes(writer, &value, sizeof(value)); }
+static void put_i32(SnapshotWriter* writer, int32_t value) { put_bytes(writer, &value, sizeof(value)); }
+static void put_f64(SnapshotWriter* writer, double value) { put_bytes(writer, &value, sizeof(value)); }
+static void put_u64(SnapshotWriter* writer, uint64_t value) { put_bytes(writer, &value, sizeof(value)); }
+
+// Strings are a 16-bit length followed by the bytes, without the terminator
+static void put_str(SnapshotWriter* writer, const char* str) {
+    size_t length = strlen(str);
+    if (length > 0xFFFF) length = 0xFFFF;
+    put_u16(writer, (uint16_t)length);
+    put_bytes(writer, str, length);
+}
+
+// Bytes outside any section's checksum (file and section headers)
+static void put_unchecked(SnapshotWriter* writer, const void* data, size_t length) {
+    check_section_bytes(writer);
+    put_bytes(writer, data, length);
+    writer->checked = writer->used;
+}
+
+static void fill_section_header(SnapshotWriter* writer, unsigned char* header) {
+    memset(header, 0, SNAPSHOT_SECTION_HEADER_SIZE);
+    memcpy(header, &writer->section_tag, 4);
+    memcpy(header + 4, &writer->section_records, 4);
+    memcpy(header + 8, &writer->section_length, 8);
+    memcpy(header + 16, &writer->section_crc, 4);
+}
+
+// Sections are written with a placeholder header that end_section() fills in
+static void begin_section(SnapshotWriter* writer, uint32_t tag) {
+    unsigned char header[SNAPSHOT_SECTION_HEADER_SIZE];
+    writer->section_tag = tag;
+    writer->section_records = 0;
+    writer->section_length = 0;
+    writer->section_crc = 0;
+    fill_section_header(writer, header);
+    writer->section_start = writer->submitted + writer->used;
+    put_unchecked(writer, header, sizeof(header));
+    writer->section_length = 0;
+    writer->section_crc = 0;
+}
+
+static void end_section(SnapshotWriter* writer) {
+    unsigned char header[SNAPSHOT_SECTION_HEADER_SIZE];
+    check_section_bytes(writer);
+    fill_section_header(writer, header);
+    io_write_patch(writer->file, writer->section_start, header, sizeof(header));
+}
+
+static BTreeNode* first_leaf(BPlusTree* tree) {
+    if (!tree || !tree->root) return NULL;
+    BTreeNode* node = tree->root;
+    while (!node->is_leaf) {
+        node = node->children[0];
+    }
+    return node;
+}
+
+static uint32_t count_keys(BPlusTree* tree) {
+    uint32_t count = 0;
+    for (BTreeNode* node = first_leaf(tree); node; node = node->leaf_link.next) {
+        count += node->num_keys;
+    }
+    return count;
+}
+
+static void put_sold_car(SnapshotWriter* writer, const SoldCar* sold_car) {
+    put_str(writer, sold_car->VIN);
+    put_u8(writer, sold_car->payment_type);
+    put_u8(writer, sold_car->loan_period_months);
+    put_u16(writer, sold_car->interest_rate_bps);
+    put_i32(writer, sold_car->model_id);
+    put_f64(writer, sold_car->down_payment);
+    put_f64(writer, sold_car->loan_amount);
+    put_f64(writer, sold_car->monthly_emi);
+}
+
+static void write_popularity_section(SnapshotWriter* writer) {
+    begin_section(writer, SNAPSHOT_POPULARITY);
+
+    // Written in model id order so the ids held by sold cars stay valid
+    int total_models = car_model_count();
+    for (int i = 0; i < total_models; i++) {
+        CarPopularityEntry* entry = car_popularity_entry(i);
+        put_str(writer, entry->model_name);
+        put_i32(writer, entry->count);
+    }
+    writer->section_records = total_models;
+
+    end_section(writer);
+}
+
+static void write_checkpoint_section(SnapshotWriter* writer, uint64_t journal_lsn) {
+    begin_section(writer, SNAPSHOT_CHECKPOINT);
+    put_u64(writer, journal_lsn);
+    writer->section_records = 1;
+    end_section(writer);
+}
+
+// Manifest record per showroom, with the segment generation of each of its tables
+static void write_showroom_section(SnapshotWriter* writer, Showroom** showrooms, const uint32_t* generations, int count) {
+    begin_section(writer, SNAPSHOT_SHOWROOMS);
+
+    for (int i = 0; i < count; i++) {
+        Showroom* showroom = showrooms[i];
+        put_i32(writer, showroom->id);
+        put_str(writer, showroom->name);
+        put_str(writer, showroom->location);
+        put_str(writer, showroom->contact);
+        put_i32(writer, showroom->total_available_cars);
+        put_i32(writer, showroom->total_sold_cars);
+        for (int table = 0; table < SHOWROOM_TABLE_COUNT; table++) {
+            put_u32(writer, generations[i * SHOWROOM_TABLE_COUNT + table]);
+        }
+    }
+    writer->section_records = (uint32_t)count;
+
+    end_section(writer);
+}
+
+// The showrooms that have an archive, with the generations of its runs, newest first
+static void write_archive_section(SnapshotWriter* writer, Showroom** showrooms, int count) {
+    begin_section(writer, SNAPSHOT_ARCHIVE_RUNS);
+
+    uint32_t records = 0;
+    for (int i = 0; i < count; i++) {
+        if (showrooms[i]->archive_run_count == 0) continue;
+        put_i32(writer, showrooms[i]->id);
+        put_u32(writer, (uint32_t)showrooms[i]->archive_run_count);
+        for (int r = 0; r < showrooms[i]->archive_run_count; r++) {
+            put_u32(writer, showrooms[i]->archive_runs[r]);
+        }
+        records++;
+    }
+    writer->section_records = records;
+
+    end_section(writer);
+}
+
+// A run of the showroom's records for `tag`: showroom id, record count, then the records
+static void write_showroom_run(SnapshotWriter* writer, Showroom* showroom, uint32_t tag) {
+    begin_section(writer, tag);
+
+    BPlusTree* tree = tag == SNAPSHOT_SALESPERSONS ? showroom->sales_persons :
+                      tag == SNAPSHOT_CARS ? showroom->available_cars : showroom->sold_cars;
+    uint32_t count = count_keys(tree);
+    if (count > 0) {
+        put_i32(writer, showroom->id);
+        put_u32(writer, count);
+        for (BTreeNode* leaf = first_leaf(tree); leaf; leaf = leaf->leaf_link.next) {
+            for (int k = 0; k < leaf->num_keys; k++) {
+                if (tag == SNAPSHOT_SALESPERSONS) {
+                    SalesPerson* sp = (SalesPerson*)leaf->keys[k].key;
+                    put_i32(writer, sp->id);
+                    put_str(writer, sp->name);
+                    put_f64(writer, sp->target_sales);
+                    put_f64(writer, sp->achieved_sales);
+                    put_f64(writer, sp->commission);
+                } else if (tag == SNAPSHOT_CARS) {
+                    Car* car = (Car*)leaf->keys[k].key;
+                    put_str(writer, car->VIN);
+                    put_str(writer, car->name);
+                    put_str(writer, car->color);
+                    put_f64(writer, car->price);
+                    put_str(writer, car->fuel_type);
+                    put_str(writer, car->car_type);
+                } else {
+                    put_sold_car(writer, (SoldCar*)leaf->keys[k].key);
+                }
+            }
+        }
+        writer->section_records = count;
+    }
+
+    end_section(writer);
+}
+
+// Position of a VIN in the showroom's sold cars (as written in SNAPSHOT_SOLD_CARS), -1 if absent
+static int find_sold_car_position(SoldCar** sold_cars, int count, const char* vin) {
+    int low = 0, high = count - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        int cmp = strcmp(sold_cars[mid]->VIN, vin);
+        if (cmp == 0) return mid;
+        if (cmp < 0) low = mid + 1;
+        else high = mid - 1;
+    }
+    return -1;
+}
+
+// One run per salesperson of the showroom: showroom id, salesperson id, record count, then the
+// records. Customers also carry the position of their sale within the segment's SNAPSHOT_SOLD_CARS,
+// so the loader can join them without searching the sold-car trees.
+static void write_salesperson_runs(SnapshotWriter* writer, Showroom* showroom, uint32_t tag) {
+    begin_section(writer, tag);
+    int customers = tag != SNAPSHOT_SP_SOLD_CARS;
+
+    // The showroom's sold cars in VIN order, as they were written
+    SoldCar** sold_cars = NULL;
+    uint32_t sold_count = customers ? count_keys(showroom->sold_cars) : 0;
+    if (sold_count > 0) {
+        sold_cars = (SoldCar**)malloc(sold_count * sizeof(SoldCar*));
+        if (!sold_cars) {
+            writer->failed = 1;
+            sold_count = 0;
+        } else {
+            uint32_t n = 0;
+            for (BTreeNode* leaf = first_leaf(showroom->sold_cars); leaf; leaf = leaf->leaf_link.next) {
+                for (int k = 0; k < leaf->num_keys; k++) {
+                    sold_cars[n++] = (SoldCar*)leaf->keys[k].key;
+                }
+            }
+        }
+    }
+
+    for (BTreeNode* sp_node = first_leaf(showroom->sales_persons); sp_node; sp_node = sp_node->leaf_link.next) {
+        for (int j = 0; j < sp_node->num_keys; j++) {
+            SalesPerson* sp = (SalesPerson*)sp_node->keys[j].key;
+            BPlusTree* tree = customers ? sp->customer_tree : sp->sold_car_tree;
+            uint32_t count = count_keys(tree);
+            if (count == 0) continue;
+
+            put_i32(writer, showroom->id);
+            put_i32(writer, sp->id);
+            put_u32(writer, count);
+            for (BTreeNode* leaf = first_leaf(tree); leaf; leaf = leaf->leaf_link.next) {
+                for (int k = 0; k < leaf->num_keys; k++) {
+                    if (customers) {
+                        Customer* customer = (Customer*)leaf->keys[k].key;
+                        if (tag == SNAPSHOT_CUSTOMER_REFS) {
+                            put_u32(writer, customer->name);
+                            put_u32(writer, customer->address);
+                        } else {
+                            put_str(writer, customer_name(customer));
+                            put_str(writer, customer_address(customer));
+                        }
+                        put_i32(writer, customer->purchase_date);
+                        put_str(writer, customer->car_VIN);
+                        put_str(writer, customer->mobile);
+                        put_str(writer, customer->reg_number);
+                        put_f64(writer, customer->actual_aoumnt_paid);
+                        put_u8(writer, customer->loan_months);
+                        int position = find_sold_car_position(sold_cars, (int)sold_count, customer->car_VIN);
+                        put_u32(writer, position < 0 ? SNAPSHOT_NO_SOLD_CAR : (uint32_t)position);
+                    } else {
+                        put_sold_car(writer, (SoldCar*)leaf->keys[k].key);
+                    }
+                }
+            }
+            writer->section_records += count;
+        }
+    }
+
+    free(sold_cars);
+    end_section(writer);
+}
+
+// Start a file: the header is checked on its own before any section is read
+static int open_writer(SnapshotWriter* writer, const char* path, int exclusive, uint32_t section_count) {
+    writer->file = io_write_open(path, exclusive);
+    if (!writer->file) return 0;
+    writer->buffer = (unsigned char*)io_write_buffer(writer->file);
+    writer->used = 0;
+    writer->checked = 0;
+    writer->submitted = 0;
+    writer->failed = writer->buffer == NULL;
+
+    unsigned char header[SNAPSHOT_HEADER_SIZE] = {0};
+    uint32_t version = SNAPSHOT_VERSION;
+    uint32_t byte_order = SNAPSHOT_BYTE_ORDER;
+    memcpy(header, SNAPSHOT_MAGIC, 8);
+    memcpy(header + 8, &version, 4);
+    memcpy(header + 12, &byte_order, 4);
+    memcpy(header + 16, &section_count, 4);
+    uint32_t header_crc = crc32_update(0, header, 24);
+    memcpy(header + 24, &header_crc, 4);
+    put_unchecked(writer, header, sizeof(header));
+    return 1;
+}
+
+// 1 if everything reached the file
+static int close_writer(SnapshotWriter* writer) {
+    if (!writer->failed && writer->used > 0) io_write_submit(writer->file, writer->used);
+    int failed = writer->failed;
+    if (!io_write_close(writer->file)) failed = 1;
+    writer->file = NULL;
+    writer->buffer = NULL;
+    return !failed;
+}
+
+// A showroom's archive is named like a segment of one more table
+#define ARCHIVE_TABLE SHOWROOM_TABLE_COUNT
+
+static const char* segment_table_names[SHOWROOM_TABLE_COUNT + 1] = {"salespersons", "cars", "sales", "archive"};
+
+// 0 if the name does not fit in `size`; dest is then not a usable path
+static int segment_path(char* dest, size_t size, const char* manifest_path, int showroom_id,
+                        int table, uint32_t generation) {
+    int length = snprintf(dest, size, "%s%s/%d-%s-%u.seg", manifest_path, SNAPSHOT_SEGMENT_DIR_SUFFIX,
+                          showroom_id, segment_table_names[table], (unsigned int)generation);
+    return length >= 0 && (size_t)length < size;
+}
+
+// Highest segment generation in use; every segment written gets the next one
+static uint32_t last_generation = 0;
+
+// Manifest the segments named in the showrooms belong to: the last one loaded or saved
+static char manifest_path[SNAPSHOT_PATH_SIZE];
+
+// A growable list of segment names
+typedef struct {
+    SegmentName* names;
+    int count;
+    int capacity;
+} SegmentList;
+
+static int add_segment_name(SegmentList* list, int showroom_id, int table, uint32_t generation) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 16;
+        SegmentName* grown = (SegmentName*)store_realloc(list->names, capacity * sizeof(SegmentName));
+        if (!grown) return 0;
+        list->names = grown;
+        list->capacity = capacity;
+    }
+    SegmentName* name = &list->names[list->count++];
+    name->showroom_id = showroom_id;
+    name->table = table;
+    name->generation = generation;
+    return 1;
+}
+
+// Segments of removed showrooms, deleted once a manifest without them is in place
+static SegmentList retired_segments = {NULL, 0, 0};
+
+// Segments written by the last successful save
+static SegmentList saved_segments = {NULL, 0, 0};
+
+void snapshot_retire_showroom(const Showroom* showroom) {
+    for (int table = 0; table < SHOWROOM_TABLE_COUNT; table++) {
+        if (showroom->segment_generation[table] == 0) continue;
+        // On failure the file is only left behind
+        add_segment_name(&retired_segments, showroom->id, table, showroom->segment_generation[table]);
+    }
+    for (int r = 0; r < showroom->archive_run_count; r++) {
+        add_segment_name(&retired_segments, showroom->id, ARCHIVE_TABLE, showroom->archive_runs[r]);
+    }
+}
+
+int snapshot_archive_path(char* dest, size_t size, int showroom_id, uint32_t generation) {
+    if (manifest_path[0] == '\0') return 0;
+    return segment_path(dest, size, manifest_path, showroom_id, ARCHIVE_TABLE, generation);
+}
+
+uint32_t snapshot_next_generation() {
+    return ++last_generation;
+}
+
+void snapshot_retire_archive_run(int showroom_id, uint32_t generation) {
+    add_segment_name(&retired_segments, showroom_id, ARCHIVE_TABLE, generation);
+}
+
+const SegmentName* snapshot_saved_segments(int* count) {
+    *count = saved_segments.count;
+    return saved_segments.names;
+}
+
+// A memory image keeps referring to the snapshot it was started from: the showrooms' segments
+// stay valid for their clean tables, and a later snapshot save goes on from them
+void register_snapshot_state() {
+    store_register_state(&last_generation, sizeof(last_generation));
+    store_register_state(manifest_path, sizeof(manifest_path));
+    store_register_state(&retired_segments, sizeof(retired_segments));
+}
+
+// The sections of one table of a showroom, customers under `customer_tag`
+static void write_table(SnapshotWriter* writer, Showroom* showroom, int table, uint32_t customer_tag) {
+    if (table == SHOWROOM_SALESPERSONS) {
+        write_showroom_run(writer, showroom, SNAPSHOT_SALESPERSONS);
+    } else if (table == SHOWROOM_CARS) {
+        write_showroom_run(writer, showroom, SNAPSHOT_CARS);
+    } else {
+        write_showroom_run(writer, showroom, SNAPSHOT_SOLD_CARS);
+        write_salesperson_runs(writer, showroom, SNAPSHOT_SP_SOLD_CARS);
+        write_salesperson_runs(writer, showroom, customer_tag);
+    }
+}
+
+// Write one table of a showroom to a new segment file next to segment_manifest, the manifest
+// being saved; *generation is the one it was written under.
+// Existing files are never replaced, they may belong to the snapshot on disk.
+static int write_segment(SnapshotWriter* writer, const char* segment_manifest, Showroom* showroom,
+                         int table, uint32_t* generation) {
+    char path[SNAPSHOT_PATH_SIZE];
+    uint32_t section_count = table == SHOWROOM_SALES ? 3 : 1;
+    int opened = 0;
+    for (int attempt = 0; attempt < 1000 && !opened; attempt++) {
+        if (!segment_path(path, sizeof(path), segment_manifest, showroom->id, table, ++last_generation)) {
+            out_printf("Error: Snapshot path too long: %s\n", segment_manifest);
+            return 0;
+        }
+        opened = open_writer(writer, path, 1, section_count);
+        if (!opened && errno != EEXIST) break;
+    }
+    if (!opened) {
+        out_printf("Error: Could not open file for writing: %s\n", path);
+        return 0;
+    }
+
+    write_table(writer, showroom, table, SNAPSHOT_CUSTOMERS);
+    if (!close_writer(writer)) {
+        out_printf("Error: Could not write snapshot segment %s\n", path);
+        remove(path);
+        return 0;
+    }
+    *generation = last_generation;
+    return 1;
+}
+
+// Write the manifest to `path`.tmp, then move it over `path`: the old manifest and its segments
+// stay valid until that moment, so a crash never leaves half a snapshot
+static int write_manifest(SnapshotWriter* writer, const char* path, Showroom** showrooms,
+                          const uint32_t* generations, int count, uint64_t journal_lsn) {
+    char temp_path[512];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+    if (!open_writer(writer, temp_path, 0, 4)) {
+        out_printf("Error: Could not open file for writing: %s\n", temp_path);
+        return 0;
+    }
+    write_popularity_section(writer);
+    write_showroom_section(writer, showrooms, generations, count);
+    write_checkpoint_section(writer, journal_lsn);
+    write_archive_section(writer, showrooms, count);
+    if (!close_writer(writer)) {
+        out_printf("Error: Could not write snapshot %s\n", temp_path);
+        remove(temp_path);
+        return 0;
+    }
+
+    #ifdef _WIN32
+    remove(path);   // rename() does not replace an existing file here
+    #endif
+    if (rename(temp_path, path) != 0) {
+        out_printf("Error: Could not replace snapshot %s\n", path);
+        remove(temp_path);
+        return 0;
+    }
+    return 1;
+}
+
+int save_snapshot(const char* path, uint64_t journal_lsn) {
+    snapshot_load_evicted_changes();
+
+    char segment_dir[512];
+    snprintf(segment_dir, sizeof(segment_dir), "%s%s", path, SNAPSHOT_SEGMENT_DIR_SUFFIX);
+    make_directory(segment_dir);
+
+    // The showrooms in tree order, with the generation each table is saved under
+    int count = (int)count_keys(showroom_tree);
+    SnapshotWriter* writer = (SnapshotWriter*)malloc(sizeof(SnapshotWriter));
+    Showroom** showrooms = (Showroom**)malloc((count ? count : 1) * sizeof(Showroom*));
+    uint32_t* generations = (uint32_t*)malloc((count ? count : 1) * SHOWROOM_TABLE_COUNT * sizeof(uint32_t));
+    if (!writer || !showrooms || !generations) {
+        out_printf("Memory allocation failed for snapshot writer\n");
+        free(writer);
+        free(showrooms);
+        free(generations);
+        return 0;
+    }
+
+    int n = 0;
+    for (BTreeNode* node = first_leaf(showroom_tree); node; node = node->leaf_link.next) {
+        for (int i = 0; i < node->num_keys; i++) {
+            Showroom* showroom = (Showroom*)node->keys[i].key;
+            showrooms[n] = showroom;
+            memcpy(&generations[n * SHOWROOM_TABLE_COUNT], showroom->segment_generation,
+                   sizeof(showroom->segment_generation));
+            n++;
+        }
+    }
+
+    // Only the tables changed since the last save are written again
+    int written = 0;
+    int ok = 1;
+    for (int i = 0; i < count && ok; i++) {
+        for (int table = 0; table < SHOWROOM_TABLE_COUNT && ok; table++) {
+            uint32_t* generation = &generations[i * SHOWROOM_TABLE_COUNT + table];
+            if (!(showrooms[i]->dirty & SHOWROOM_DIRTY(table)) && *generation != 0) continue;
+            ok = write_segment(writer, path, showrooms[i], table, generation);
+            written += ok;
+        }
+    }
+    if (ok) {
+        ok = write_manifest(writer, path, showrooms, generations, count, journal_lsn);
+    }
+
+    // Segments the manifest on disk no longer uses: on success the replaced ones,
+    // on failure the ones just written
+    char segment_file[SNAPSHOT_PATH_SIZE];
+    saved_segments.count = 0;
+    for (int i = 0; i < count; i++) {
+        Showroom* showroom = showrooms[i];
+        for (int table = 0; table < SHOWROOM_TABLE_COUNT; table++) {
+            uint32_t old_generation = showroom->segment_generation[table];
+            uint32_t new_generation = generations[i * SHOWROOM_TABLE_COUNT + table];
+            if (new_generation == old_generation) continue;
+
+            uint32_t unused = ok ? old_generation : new_generation;
+            if (unused != 0 && segment_path(segment_file, sizeof(segment_file), path, showroom->id, table, unused)) {
+                remove(segment_file);
+            }
+            if (ok) {
+                showroom->segment_generation[table] = new_generation;
+                add_segment_name(&saved_segments, showroom->id, table, new_generation);
+            }
+        }
+        if (ok) showroom->dirty = 0;
+    }
+    if (ok) {
+        for (int i = 0; i < retired_segments.count; i++) {
+            SegmentName* name = &retired_segments.names[i];
+            if (segment_path(segment_file, sizeof(segment_file), path, name->showroom_id, name->table, name->generation)) {
+                remove(segment_file);
+            }
+        }
+        retired_segments.count = 0;
+        if (strlen(path) < sizeof(manifest_path)) strcpy(manifest_path, path);
+        out_printf("Snapshot saved: %d of %d segments rewritten\n", written, count * SHOWROOM_TABLE_COUNT);
+    }
+
+    free(writer);
+    free(showrooms);
+    free(generations);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Reading
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const unsigned char* pos;
+    const unsigned char* end;
+    int failed;
+    uint32_t version;           // Of the file the section came from
+} SnapshotReader;
+
+typedef struct {
+    uint32_t records;
+    const unsigned char* data;
+    uint64_t length;
+    uint32_t version;
+} SnapshotSection;
+
+static void get_bytes(SnapshotReader* reader, void* dest, size_t length) {
+    if (reader->failed || (size_t)(reader->end - reader->pos) < length) {
+        reader->failed = 1;
+        memset(dest, 0, length);
+        return;
+    }
+    memcpy(dest, reader->pos, length);
+    reader->pos += length;
+}
+
+static uint8_t get_u8(SnapshotReader* reader) { uint8_t value; get_bytes(reader, &value, sizeof(value)); return value; }
+static uint16_t get_u16(SnapshotReader* reader) { uint16_t value; get_bytes(reader, &value, sizeof(value)); return value; }
+static uint32_t get_u32(SnapshotReader* reader) { uint32_t value; get_bytes(reader, &value, sizeof(value)); return value; }
+static int32_t get_i32(SnapshotReader* reader) { int32_t value; get_bytes(reader, &value, sizeof(value)); return value; }
+static double get_f64(SnapshotReader* reader) { double value; get_bytes(reader, &value, sizeof(value)); return value; }
+static uint64_t get_u64(SnapshotReader* reader) { uint64_t value; get_bytes(reader, &value, sizeof(value)); return value; }
+
+// Copy a string into a fixed-size field, truncating like the text loader does
+static void get_str(SnapshotReader* reader, char* dest, size_t size) {
+    size_t length = get_u16(reader);
+    if (reader->failed || (size_t)(reader->end - reader->pos) < length) {
+        reader->failed = 1;
+        dest[0] = '\0';
+        return;
+    }
+    size_t copied = length < size ? length : size - 1;
+    memcpy(dest, reader->pos, copied);
+    dest[copied] = '\0';
+    reader->pos += length;
+}
+
+static void get_sold_car(SnapshotReader* reader, SoldCar* sold_car) {
+    get_str(reader, sold_car->VIN, MAX_VIN_LEN);
+    sold_car->payment_type = get_u8(reader);
+    sold_car->loan_period_months = get_u8(reader);
+    sold_car->interest_rate_bps = get_u16(reader);
+    // Version 2 kept the model in 16 bits
+    sold_car->model_id = reader->version < 3 ? (int16_t)get_u16(reader) : get_i32(reader);
+    sold_car->down_payment = get_f64(reader);
+    sold_car->loan_amount = get_f64(reader);
+    sold_car->monthly_emi = get_f64(reader);
+}
+
+// Start a run, rejecting counts that could not fit in what is left of the section
+static uint32_t get_run_count(SnapshotReader* reader) {
+    uint32_t count = get_u32(reader);
+    if ((size_t)(reader->end - reader->pos) < count) {
+        reader->failed = 1;
+        return 0;
+    }
+    return count;
+}
+
+// Scratch arrays for one run of freshly decoded records (and each customer's sold-car position)
+static void** run_records = NULL;
+static uint32_t* run_refs = NULL;
+static uint32_t run_capacity = 0;
+
+// Every loaded sold car in section order (NULL where a run was dropped), for the customer join
+static SoldCar** sold_car_records = NULL;
+static uint32_t sold_car_record_count = 0;
+static uint32_t sold_car_capacity = 0;
+
+// What loading the customers of the showroom being read also builds
+static int build_derived = 0;       // Sales ledger and popularity window
+static int index_customers = 0;     // Customer index entries
+
+static int reserve_run(uint32_t count) {
+    if (count <= run_capacity) return 1;
+    void** grown = (void**)realloc(run_records, count * sizeof(void*));
+    if (grown) run_records = grown;
+    uint32_t* grown_refs = (uint32_t*)realloc(run_refs, count * sizeof(uint32_t));
+    if (grown_refs) run_refs = grown_refs;
+    if (!grown || !grown_refs) {
+        out_printf("Memory allocation failed for snapshot load\n");
+        return 0;
+    }
+    run_capacity = count;
+    return 1;
+}
+
+// Put one run into an empty tree, bottom-up when it is in key order.
+// Afterwards records[i] points at the tree's copy of record i.
+static void build_tree(BPlusTree* tree, void** records, int count) {
+    int sorted = 1;
+    for (int i = 1; i < count && sorted; i++) {
+        sorted = tree->compare(records[i - 1], records[i]) <= 0;
+    }
+    if (sorted && bplusBulkLoad(tree, records, count)) return;
+
+    for (int i = 0; i < count; i++) {
+        void* stored = bplusInsert(tree, records[i]);
+        tree->free_func(records[i]);
+        records[i] = stored;
+    }
+}
+
+// Look a showroom up without reading its tables from disk
+static Showroom* find_showroom(int showroom_id) {
+    Showroom temp_showroom;
+    temp_showroom.id = showroom_id;
+    AccessFunc access = showroom_tree->access;
+    showroom_tree->access = NULL;
+    Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp_showroom);
+    showroom_tree->access = access;
+    return showroom;
+}
+
+static SalesPerson* find_salesperson(Showroom* showroom, int salesperson_id) {
+    if (!showroom || !showroom->sales_persons) return NULL;
+    SalesPerson temp_sp;
+    temp_sp.id = salesperson_id;
+    return (SalesPerson*)bplusSearch(showroom->sales_persons, &temp_sp);
+}
+
+static void load_popularity_section(SnapshotSection* section) {
+    SnapshotReader reader = {section->data, section->data + section->length, 0, section->version};
+    char model_name[MAX_STR_LEN];
+
+    free_car_popularity_table();
+    for (uint32_t i = 0; i < section->records && !reader.failed; i++) {
+        get_str(&reader, model_name, sizeof(model_name));
+        int count = get_i32(&reader);
+        if (!reader.failed) set_car_popularity(model_name, count);
+    }
+}
+
+// Empty trees for the tables saved in segments
+static void create_table_trees(Showroom* showroom) {
+    showroom->available_cars = createBPlusTree(compareVIN, printCar, cloneCar, freeCar);
+    showroom->sold_cars = createBPlusTree(compareVIN, printSoldCar, cloneSoldCar, freeSoldCar);
+    showroom->sales_persons = createBPlusTree(compareSalesPersonID, printSalesPerson, cloneSalesPerson, freeSalesPerson);
+}
+
+// Decode the manifest's showroom records into showrooms[] (not in the tree yet), with empty trees.
+// Returns how many, -1 if the section is malformed.
+static int decode_showroom_section(SnapshotSection* section, Showroom** showrooms) {
+    SnapshotReader reader = {section->data, section->data + section->length, 0, section->version};
+
+    uint32_t count = 0;
+    while (count < section->records) {
+        Showroom* showroom = (Showroom*)store_malloc(sizeof(Showroom));
+        if (!showroom) break;
+
+        showroom->id = get_i32(&reader);
+        get_str(&reader, showroom->name, MAX_STR_LEN);
+        get_str(&reader, showroom->location, MAX_STR_LEN);
+        get_str(&reader, showroom->contact, MAX_MOBILE_LEN);
+        showroom->total_available_cars = get_i32(&reader);
+        showroom->total_sold_cars = get_i32(&reader);
+        for (int table = 0; table < SHOWROOM_TABLE_COUNT; table++) {
+            showroom->segment_generation[table] = get_u32(&reader);
+        }
+        showroom->archive_run_count = 0;      // From the archive section
+        showroom->dirty = 0;
+        showroom->snapshot_state = 0;
+        showroom->spilled = 0;
+        showroom->last_used = 0;
+        if (reader.failed) {
+            store_free(showroom);
+            break;
+        }
+
+        create_table_trees(showroom);
+        showroom->monthly_sales = createBPlusTree(compareMonthlySales, printMonthlySales, cloneMonthlySales, freeMonthlySales);
+        showroom->leaderboard = NULL;
+        showroom->leaderboard_count = 0;
+        showroom->leaderboard_capacity = 0;
+        showroom->popularity_window = NULL;
+        showrooms[count++] = showroom;
+    }
+
+    if (count < section->records) {
+        for (uint32_t i = 0; i < count; i++) {
+            freeShowroom(showrooms[i]);
+        }
+        return -1;
+    }
+    return (int)count;
+}
+
+static Showroom* find_decoded_showroom(Showroom** showrooms, int count, int32_t showroom_id) {
+    int low = 0, high = count - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (showrooms[mid]->id == showroom_id) return showrooms[mid];
+        if (showrooms[mid]->id < showroom_id) low = mid + 1;
+        else high = mid - 1;
+    }
+    return NULL;
+}
+
+// Give the decoded showrooms (in id order) their archive runs. Manifests from before runs name
+// one archive per showroom under SNAPSHOT_ARCHIVES.
+static void decode_archive_section(SnapshotSection* section, SnapshotSection* runs_section,
+                                   Showroom** showrooms, int count) {
+    SnapshotReader reader = {section->data, section->data + section->length, 0, section->version};
+    for (uint32_t r = 0; r < section->records && !reader.failed; r++) {
+        int32_t showroom_id = get_i32(&reader);
+        uint32_t generation = get_u32(&reader);
+        Showroom* showroom = find_decoded_showroom(showrooms, count, showroom_id);
+        if (!reader.failed && showroom && generation != 0) {
+            showroom->archive_runs[0] = generation;
+            showroom->archive_run_count = 1;
+        }
+    }
+
+    SnapshotReader runs = {runs_section->data, runs_section->data + runs_section->length, 0, runs_section->version};
+    for (uint32_t r = 0; r < runs_section->records && !runs.failed; r++) {
+        int32_t showroom_id = get_i32(&runs);
+        uint32_t run_count = get_u32(&runs);
+        if (run_count > ARCHIVE_MAX_RUNS) break;
+        Showroom* showroom = find_decoded_showroom(showrooms, count, showroom_id);
+        for (uint32_t g = 0; g < run_count; g++) {
+            uint32_t generation = get_u32(&runs);
+            if (showroom) showroom->archive_runs[g] = generation;
+        }
+        if (!runs.failed && showroom) showroom->archive_run_count = (int)run_count;
+    }
+}
+
+static int load_showroom_runs(SnapshotSection* section, uint32_t tag) {
+    SnapshotReader reader = {section->data, section->data + section->length, 0, section->version};
+    int loaded = 0;
+
+    while (reader.pos < reader.end && !reader.failed) {
+        int showroom_id = get_i32(&reader);
+        uint32_t count = get_run_count(&reader);
+        if (reader.failed || !reserve_run(count)) break;
+
+        uint32_t decoded = 0;
+        for (; decoded < count && !reader.failed; decoded++) {
+            if (tag == SNAPSHOT_SALESPERSONS) {
+                SalesPerson* sp = (SalesPerson*)store_malloc(sizeof(SalesPerson));
+                if (!sp) break;
+                sp->id = get_i32(&reader);
+                get_str(&reader, sp->name, MAX_STR_LEN);
+                sp->target_sales = get_f64(&reader);
+                sp->achieved_sales = get_f64(&reader);
+                sp->commission = get_f64(&reader);
+                sp->customer_tree = createBPlusTree(compareCustomerByEMI, printCustomer, cloneCustomer, freeCustomer);
+                sp->sold_car_tree = createBPlusTree(compareVIN, printSoldCar, cloneSoldCar, freeSoldCar);
+                run_records[decoded] = sp;
+            } else if (tag == SNAPSHOT_CARS) {
+                Car* car = (Car*)store_malloc(sizeof(Car));
+                if (!car) break;
+                get_str(&reader, car->VIN, MAX_VIN_LEN);
+                get_str(&reader, car->name, MAX_STR_LEN);
+                get_str(&reader, car->color, MAX_STR_LEN);
+                car->price = get_f64(&reader);
+                get_str(&reader, car->fuel_type, MAX_STR_LEN);
+                get_str(&reader, car->car_type, MAX_STR_LEN);
+                run_records[decoded] = car;
+            } else {
+                SoldCar* sold_car = (SoldCar*)store_malloc(sizeof(SoldCar));
+                if (!sold_car) break;
+                get_sold_car(&reader, sold_car);
+                run_records[decoded] = sold_car;
+            }
+        }
+
+        Showroom* showroom = find_showroom(showroom_id);
+        BPlusTree* tree = !showroom ? NULL :
+                          tag == SNAPSHOT_SALESPERSONS ? showroom->sales_persons :
+                          tag == SNAPSHOT_CARS ? showroom->available_cars : showroom->sold_cars;
+        int usable = tree && !reader.failed && decoded == count;
+        if (!usable) {
+            if (!showroom) {
+                out_printf("Error: Could not find showroom with ID %d in snapshot\n", showroom_id);
+            }
+            for (uint32_t i = 0; i < decoded; i++) {
+                if (tag == SNAPSHOT_SALESPERSONS) freeSalesPerson(run_records[i]);
+                else store_free(run_records[i]);
+            }
+        } else {
+            build_tree(tree, run_records, count);
+            loaded += count;
+            if (tag == SNAPSHOT_SALESPERSONS) leaderboard_rebuild(showroom);
+        }
+        
+        if (tag == SNAPSHOT_SOLD_CARS && sold_car_records) {
+            for (uint32_t i = 0; i < count && sold_car_record_count < sold_car_capacity; i++) {
+                sold_car_records[sold_car_record_count++] = usable ? (SoldCar*)run_records[i] : NULL;
+            }
+        }
+    }
+
+    if (reader.failed) {
+        out_printf("Error: Snapshot section %u is malformed\n", tag);
+    }
+    return loaded;
+}
+
+static int load_salesperson_runs(SnapshotSection* section, uint32_t tag) {
+    SnapshotReader reader = {section->data, section->data + section->length, 0, section->version};
+    static char name[65536], address[65536];
+    int loaded = 0;
+
+    while (reader.pos < reader.end && !reader.failed) {
+        int showroom_id = get_i32(&reader);
+        int salesperson_id = get_i32(&reader);
+        uint32_t count = get_run_count(&reader);
+        if (reader.failed || !reserve_run(count)) break;
+
+        uint32_t decoded = 0;
+        for (; decoded < count && !reader.failed; decoded++) {
+            if (tag != SNAPSHOT_SP_SOLD_CARS) {
+                Customer* customer = (Customer*)store_malloc(sizeof(Customer));
+                if (!customer) break;
+                if (tag == SNAPSHOT_CUSTOMER_REFS) {
+                    customer->name = get_u32(&reader);
+                    customer->address = get_u32(&reader);
+                } else {
+                    get_str(&reader, name, sizeof(name));
+                    get_str(&reader, address, sizeof(address));
+                }
+                customer->purchase_date = get_i32(&reader);
+                get_str(&reader, customer->car_VIN, MAX_VIN_LEN);
+                get_str(&reader, customer->mobile, MAX_MOBILE_LEN);
+                get_str(&reader, customer->reg_number, MAX_REG_NUM_LEN);
+                customer->actual_aoumnt_paid = get_f64(&reader);
+                customer->loan_months = get_u8(&reader);
+                run_refs[decoded] = get_u32(&reader);
+                if (tag == SNAPSHOT_CUSTOMERS) {
+                    customer->name = reader.failed ? STRREF_EMPTY : string_heap_add(name);
+                    customer->address = reader.failed ? STRREF_EMPTY : string_heap_add(address);
+                }
+                run_records[decoded] = customer;
+            } else {
+                SoldCar* sold_car = (SoldCar*)store_malloc(sizeof(SoldCar));
+                if (!sold_car) break;
+                get_sold_car(&reader, sold_car);
+                run_records[decoded] = sold_car;
+            }
+        }
+
+        Showroom* showroom = find_showroom(showroom_id);
+        SalesPerson* sp = find_salesperson(showroom, salesperson_id);
+        BPlusTree* tree = !sp ? NULL : tag == SNAPSHOT_SP_SOLD_CARS ? sp->sold_car_tree : sp->customer_tree;
+        if (!tree || reader.failed || decoded < count) {
+            if (!sp) {
+                out_printf("Error: Could not find salesperson with ID %d in snapshot\n", salesperson_id);
+            }
+            for (uint32_t i = 0; i < decoded; i++) {
+                store_free(run_records[i]);
+            }
+            continue;
+        }
+
+        build_tree(tree, run_records, count);
+        loaded += count;
+
+        // Derived state of the showroom: the sales ledger and recent popularity, built on the
+        // first read only. The customer index is filled here only for a showroom coming back
+        // after an eviction; on the first read it is filled later, in tree order (see
+        // index_loaded_showrooms).
+        if (tag != SNAPSHOT_SP_SOLD_CARS && (build_derived || index_customers)) {
+            for (uint32_t i = 0; i < count; i++) {
+                Customer* customer = (Customer*)run_records[i];
+                SoldCar* sold_car = run_refs[i] < sold_car_record_count ? sold_car_records[run_refs[i]] : NULL;
+                if (!sold_car || strcmp(sold_car->VIN, customer->car_VIN) != 0) {
+                    SoldCar temp_sold_car;
+                    strcpy(temp_sold_car.VIN, customer->car_VIN);
+                    sold_car = (SoldCar*)bplusSearch(showroom->sold_cars, &temp_sold_car);
+                }
+                if (index_customers) {
+                    customer_index_add(showroom, sp, customer, sold_car);
+                }
+                if (build_derived) {
+                    record_monthly_sale(showroom, customer->purchase_date, customer->actual_aoumnt_paid);
+                    if (sold_car) {
+                        record_showroom_model_sale(showroom, sold_car->model_id, customer->purchase_date);
+                    }
+                }
+            }
+        }
+    }
+
+    if (reader.failed) {
+        out_printf("Error: Snapshot section %u is malformed\n", tag);
+    }
+    return loaded;
+}
+
+// Check a file's header and every section checksum; fills sections[] indexed by tag.
+// `required` has bit N set for each section tag N the file must hold.
+static int validate_snapshot(const unsigned char* data, size_t size, SnapshotSection* sections, uint32_t required) {
+    if (size < SNAPSHOT_HEADER_SIZE || memcmp(data, SNAPSHOT_MAGIC, 8) != 0) return 0;
+
+    uint32_t version, byte_order, section_count, header_crc;
+    memcpy(&version, data + 8, 4);
+    memcpy(&byte_order, data + 12, 4);
+    memcpy(&section_count, data + 16, 4);
+    memcpy(&header_crc, data + 24, 4);
+    if (byte_order != SNAPSHOT_BYTE_ORDER || version < SNAPSHOT_MIN_VERSION || version > SNAPSHOT_VERSION) return 0;
+    if (crc32_update(0, data, 24) != header_crc) return 0;
+
+    for (int tag = 1; tag <= SNAPSHOT_SECTION_COUNT; tag++) {
+        sections[tag].records = 0;
+        sections[tag].data = NULL;
+        sections[tag].length = 0;
+        sections[tag].version = version;
+    }
+
+    uint32_t seen = 0;
+    size_t offset = SNAPSHOT_HEADER_SIZE;
+    for (uint32_t s = 0; s < section_count; s++) {
+        if (size - offset < SNAPSHOT_SECTION_HEADER_SIZE) return 0;
+
+        uint32_t tag, records, crc;
+        uint64_t length;
+        memcpy(&tag, data + offset, 4);
+        memcpy(&records, data + offset + 4, 4);
+        memcpy(&length, data + offset + 8, 8);
+        memcpy(&crc, data + offset + 16, 4);
+        offset += SNAPSHOT_SECTION_HEADER_SIZE;
+
+        if (length > size - offset || records > length) return 0;
+        if (crc32_update(0, data + offset, (size_t)length) != crc) return 0;
+
+        // Unknown sections are skipped so newer writers stay readable
+        if (tag >= 1 && tag <= SNAPSHOT_SECTION_COUNT) {
+            if (seen & (1u << tag)) return 0;
+            seen |= 1u << tag;
+            sections[tag].records = records;
+            sections[tag].data = data + offset;
+            sections[tag].length = length;
+            sections[tag].version = version;
+        }
+        offset += (size_t)length;
+    }
+
+    return (seen & required) == required && offset == size;
+}
+
+#define MANIFEST_SECTIONS ((1u << SNAPSHOT_POPULARITY) | (1u << SNAPSHOT_SHOWROOMS))
+
+static const uint32_t segment_sections[SHOWROOM_TABLE_COUNT] = {
+    1u << SNAPSHOT_SALESPERSONS,
+    1u << SNAPSHOT_CARS,
+    (1u << SNAPSHOT_SOLD_CARS) | (1u << SNAPSHOT_SP_SOLD_CARS) | (1u << SNAPSHOT_CUSTOMERS)
+};
+
+// Spill files keep customers' string heap handles instead of the strings
+static const uint32_t spill_sections[SHOWROOM_TABLE_COUNT] = {
+    1u << SNAPSHOT_SALESPERSONS,
+    1u << SNAPSHOT_CARS,
+    (1u << SNAPSHOT_SOLD_CARS) | (1u << SNAPSHOT_SP_SOLD_CARS) | (1u << SNAPSHOT_CUSTOMER_REFS)
+};
+
+// A segment named by the manifest, checked and kept mapped until it has been loaded
+typedef struct {
+    MappedFile file;
+    int present;        // 0 for a table that was never saved
+    SnapshotSection sections[SNAPSHOT_SECTION_COUNT + 1];
+} SnapshotSegment;
+
+static void unmap_segments(SnapshotSegment* segments, int count) {
+    for (int i = 0; i < count; i++) {
+        if (segments[i].present) unmap_file(&segments[i].file);
+        segments[i].present = 0;
+    }
+}
+
+// Build one showroom's tables from its checked segments, in table order
+static void load_showroom_segments(SnapshotSegment* segments, uint32_t customer_tag) {
+    // Parents before children: salespersons, stock, then sales
+    if (segments[SHOWROOM_SALESPERSONS].present) {
+        load_showroom_runs(&segments[SHOWROOM_SALESPERSONS].sections[SNAPSHOT_SALESPERSONS], SNAPSHOT_SALESPERSONS);
+    }
+    if (segments[SHOWROOM_CARS].present) {
+        load_showroom_runs(&segments[SHOWROOM_CARS].sections[SNAPSHOT_CARS], SNAPSHOT_CARS);
+    }
+    if (segments[SHOWROOM_SALES].present) {
+        SnapshotSection* sections = segments[SHOWROOM_SALES].sections;
+
+        // Customers refer to their sale by position within this segment
+        sold_car_capacity = sections[SNAPSHOT_SOLD_CARS].records;
+        sold_car_record_count = 0;
+        sold_car_records = (SoldCar**)malloc((sold_car_capacity ? sold_car_capacity : 1) * sizeof(SoldCar*));
+        if (!sold_car_records) sold_car_capacity = 0;   // Customers then find their sale by VIN
+        load_showroom_runs(&sections[SNAPSHOT_SOLD_CARS], SNAPSHOT_SOLD_CARS);
+        load_salesperson_runs(&sections[SNAPSHOT_SP_SOLD_CARS], SNAPSHOT_SP_SOLD_CARS);
+        load_salesperson_runs(&sections[customer_tag], customer_tag);
+        free(sold_car_records);
+        sold_car_records = NULL;
+        sold_car_record_count = 0;
+        sold_car_capacity = 0;
+    }
+}
+
+static int showrooms_on_disk = 0;           // Showrooms with SNAPSHOT_TABLES_ON_DISK
+static int showrooms_not_counted = 0;       // Showrooms with SNAPSHOT_NOT_COUNTED
+static unsigned long lookup_count = 0;
+
+// Where evicted tables are written, empty without a memory budget
+static char spill_directory[SNAPSHOT_PATH_SIZE];
+
+// 0 if the name does not fit in `size`, like segment_path
+static int spill_path(char* dest, size_t size, int showroom_id, int table) {
+    int length = snprintf(dest, size, "%s/%d-%s.spill", spill_directory, showroom_id, segment_table_names[table]);
+    return length >= 0 && (size_t)length < size;
+}
+
+static void remove_spill_files(const Showroom* showroom, unsigned int tables) {
+    char path[SNAPSHOT_PATH_SIZE];
+    for (int table = 0; table < SHOWROOM_TABLE_COUNT; table++) {
+        if (!(tables & SHOWROOM_DIRTY(table))) continue;
+        if (spill_path(path, sizeof(path), showroom->id, table)) remove(path);
+    }
+}
+
+// File a table not in memory is read from, 0 if it has none (a table never saved, so empty),
+// -1 if its name does not fit in `size`
+static int table_path(char* dest, size_t size, const Showroom* showroom, int table) {
+    if (showroom->spilled & SHOWROOM_DIRTY(table)) {
+        return spill_path(dest, size, showroom->id, table) ? 1 : -1;
+    }
+    if (showroom->segment_generation[table] == 0) return 0;
+    return segment_path(dest, size, manifest_path, showroom->id, table, showroom->segment_generation[table]) ? 1 : -1;
+}
+
+// Read the tables of showrooms not in memory (all at once, through the I/O engine) and build each
+// showroom as soon as its last file has arrived and been checked. A damaged file leaves its
+// showroom empty; snapshot segments stay as they are until that showroom is saved again.
+static void load_showroom_tables(Showroom** showrooms, int count) {
+    int segment_count = count * SHOWROOM_TABLE_COUNT;
+    SnapshotSegment* segments = (SnapshotSegment*)calloc(segment_count ? segment_count : 1, sizeof(SnapshotSegment));
+    char* path_storage = (char*)malloc((segment_count ? segment_count : 1) * SNAPSHOT_PATH_SIZE);
+    const char** segment_paths = (const char**)malloc((segment_count ? segment_count : 1) * sizeof(char*));
+    int* segment_of = (int*)malloc((segment_count ? segment_count : 1) * sizeof(int));
+    int* waiting = (int*)calloc(count ? count : 1, sizeof(int));        // Files still to arrive
+    int* damaged = (int*)calloc(count ? count : 1, sizeof(int));
+    if (!segments || !path_storage || !segment_paths || !segment_of || !waiting || !damaged) {
+        // The showrooms stay on disk, the next lookup tries again
+        out_printf("Memory allocation failed for snapshot load\n");
+        free(segments);
+        free(path_storage);
+        free(segment_paths);
+        free(segment_of);
+        free(waiting);
+        free(damaged);
+        return;
+    }
+
+    int read_count = 0;
+    for (int i = 0; i < segment_count; i++) {
+        char* segment_file = path_storage + (size_t)read_count * SNAPSHOT_PATH_SIZE;
+        int found = table_path(segment_file, SNAPSHOT_PATH_SIZE, showrooms[i / SHOWROOM_TABLE_COUNT], i % SHOWROOM_TABLE_COUNT);
+        if (found < 0) {
+            out_printf("Path of a table of showroom %d is too long, the showroom is left empty.\n",
+                       showrooms[i / SHOWROOM_TABLE_COUNT]->id);
+            damaged[i / SHOWROOM_TABLE_COUNT] = 1;
+        }
+        if (found <= 0) continue;
+        segment_paths[read_count] = segment_file;
+        segment_of[read_count] = i;
+        read_count++;
+        waiting[i / SHOWROOM_TABLE_COUNT]++;
+    }
+
+    // From here on the tables count as read, so lookups made while building them do not recurse
+    for (int s = 0; s < count; s++) {
+        showrooms[s]->snapshot_state &= ~SNAPSHOT_TABLES_ON_DISK;
+        showrooms_on_disk--;
+    }
+
+    customer_index_begin_batch(0);
+    IoReadBatch* batch = io_read_files(segment_paths, read_count);
+    MappedFile file;
+    for (int next = batch ? io_next_file(batch, &file) : -1; next >= 0; next = io_next_file(batch, &file)) {
+        int i = segment_of[next];
+        int s = i / SHOWROOM_TABLE_COUNT;
+        int table = i % SHOWROOM_TABLE_COUNT;
+        Showroom* showroom = showrooms[s];
+        int spilled = (showroom->spilled & SHOWROOM_DIRTY(table)) != 0;
+        SnapshotSegment* segment = &segments[i];
+        segment->file = file;
+        segment->present = file.data != NULL;
+        if (!damaged[s] &&
+            (!segment->present ||
+             !validate_snapshot((const unsigned char*)segment->file.data, segment->file.size,
+                                segment->sections, spilled ? spill_sections[table] : segment_sections[table]))) {
+            out_printf("%s %s is missing or damaged, showroom %d is left empty.\n",
+                       spilled ? "Spill file" : "Snapshot segment", segment_paths[next], showroom->id);
+            damaged[s] = 1;
+        }
+
+        if (--waiting[s] > 0) continue;
+        if (!damaged[s]) {
+            // The showroom's derived state is built once; its customers go back into the
+            // index at once when the showroom was indexed before it was evicted
+            build_derived = (showroom->snapshot_state & SNAPSHOT_NEVER_READ) != 0;
+            index_customers = (showroom->snapshot_state & (SNAPSHOT_NOT_INDEXED | SNAPSHOT_NOT_COUNTED)) == SNAPSHOT_NOT_INDEXED;
+            load_showroom_segments(&segments[s * SHOWROOM_TABLE_COUNT],
+                                   (showroom->spilled & SHOWROOM_DIRTY(SHOWROOM_SALES)) ? SNAPSHOT_CUSTOMER_REFS : SNAPSHOT_CUSTOMERS);
+            if (build_derived) archive_add_to_ledger(showroom);
+            build_derived = 0;
+            index_customers = 0;
+        }
+        unmap_segments(&segments[s * SHOWROOM_TABLE_COUNT], SHOWROOM_TABLE_COUNT);
+    }
+    if (!batch && read_count > 0) {
+        out_printf("Memory allocation failed for snapshot load\n");
+    }
+    io_read_finish(batch);
+    customer_index_end_batch();
+
+    // Spill files are read once. Stock read back after an eviction is what the inventory
+    // snapshot already holds; only a first read or a damaged file changes it.
+    int stock_changed = 0;
+    for (int s = 0; s < count; s++) {
+        Showroom* showroom = showrooms[s];
+        remove_spill_files(showroom, showroom->spilled);
+        showroom->spilled = 0;
+        if (!(showroom->snapshot_state & SNAPSHOT_NOT_COUNTED)) showroom->snapshot_state &= ~SNAPSHOT_NOT_INDEXED;
+        if ((showroom->snapshot_state & SNAPSHOT_NEVER_READ) || damaged[s]) stock_changed = 1;
+        showroom->snapshot_state &= ~SNAPSHOT_NEVER_READ;
+    }
+    if (stock_changed) inventory_changed();
+
+    free(run_records);
+    free(run_refs);
+    run_records = NULL;
+    run_refs = NULL;
+    run_capacity = 0;
+    free(segments);
+    free(path_storage);
+    free(segment_paths);
+    free(segment_of);
+    free(waiting);
+    free(damaged);
+}
+
+// showroom_tree's access hook: a showroom's tables are read when it is looked up
+static void load_showroom_on_access(void* key) {
+    Showroom* showroom = (Showroom*)key;
+    // Queries sharing the state lock look showrooms up at the same time (see checkpoint.h)
+    __atomic_store_n(&showroom->last_used, __atomic_add_fetch(&lookup_count, 1, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    if (showroom->snapshot_state & SNAPSHOT_TABLES_ON_DISK) load_showroom_tables(&showroom, 1);
+}
+
+// Add a showroom's customers to the customer index and its sales to the national popularity window
+static void index_showroom_customers(Showroom* showroom) {
+    for (BTreeNode* sp_node = first_leaf(showroom->sales_persons); sp_node; sp_node = sp_node->leaf_link.next) {
+        for (int j = 0; j < sp_node->num_keys; j++) {
+            SalesPerson* sp = (SalesPerson*)sp_node->keys[j].key;
+            for (BTreeNode* leaf = first_leaf(sp->customer_tree); leaf; leaf = leaf->leaf_link.next) {
+                for (int k = 0; k < leaf->num_keys; k++) {
+                    Customer* customer = (Customer*)leaf->keys[k].key;
+                    SoldCar temp_sold_car;
+                    strcpy(temp_sold_car.VIN, customer->car_VIN);
+                    SoldCar* sold_car = (SoldCar*)bplusSearch(showroom->sold_cars, &temp_sold_car);
+                    customer_index_add(showroom, sp, customer, sold_car);
+                    if (sold_car) {
+                        record_national_model_sale(sold_car->model_id, customer->purchase_date);
+                    }
+                }
+            }
+        }
+    }
+    showroom->snapshot_state &= ~(SNAPSHOT_NOT_INDEXED | SNAPSHOT_NOT_COUNTED);
+    showrooms_not_counted--;
+}
+
+// Add the customers of every showroom read from the snapshot and not yet indexed, in tree order
+static void index_loaded_showrooms() {
+    int expected_customers = 0;     // One per sale
+    for (BTreeNode* node = first_leaf(showroom_tree); node; node = node->leaf_link.next) {
+        for (int i = 0; i < node->num_keys; i++) {
+            Showroom* showroom = (Showroom*)node->keys[i].key;
+            if (showroom->snapshot_state & SNAPSHOT_NOT_COUNTED) expected_customers += showroom->total_sold_cars;
+        }
+    }
+
+    customer_index_begin_batch(expected_customers);
+    for (BTreeNode* node = first_leaf(showroom_tree); node && showrooms_not_counted > 0; node = node->leaf_link.next) {
+        for (int i = 0; i < node->num_keys; i++) {
+            Showroom* showroom = (Showroom*)node->keys[i].key;
+            if (showroom->snapshot_state & SNAPSHOT_NOT_COUNTED) index_showroom_customers(showroom);
+        }
+    }
+    customer_index_end_batch();
+}
+
+void snapshot_index_showroom(Showroom* showroom) {
+    if (showroom->snapshot_state & SNAPSHOT_TABLES_ON_DISK) load_showroom_tables(&showroom, 1);
+    if (!(showroom->snapshot_state & SNAPSHOT_NOT_COUNTED)) return;
+
+    customer_index_begin_batch(showroom->total_sold_cars);
+    index_showroom_customers(showroom);
+    customer_index_end_batch();
+}
+
+int snapshot_resident(int showroom_id) {
+    if (showroom_id == 0) return showrooms_on_disk == 0 && showrooms_not_counted == 0;
+    if (!showroom_tree) return 1;
+    Showroom temp;
+    temp.id = showroom_id;
+    Showroom* showroom = (Showroom*)bplusPeek(showroom_tree, &temp);
+    return !showroom || !(showroom->snapshot_state & SNAPSHOT_TABLES_ON_DISK);
+}
+
+void snapshot_load_all_showrooms() {
+    if (showrooms_on_disk > 0) {
+        Showroom** showrooms = (Showroom**)malloc(showrooms_on_disk * sizeof(Showroom*));
+        if (!showrooms) {
+            out_printf("Memory allocation failed for snapshot load\n");
+            return;
+        }
+        int count = 0;
+        for (BTreeNode* node = first_leaf(showroom_tree); node && count < showrooms_on_disk; node = node->leaf_link.next) {
+            for (int i = 0; i < node->num_keys && count < showrooms_on_disk; i++) {
+                Showroom* showroom = (Showroom*)node->keys[i].key;
+                if (showroom->snapshot_state & SNAPSHOT_TABLES_ON_DISK) showrooms[count++] = showroom;
+            }
+        }
+        load_showroom_tables(showrooms, count);
+        free(showrooms);
+    }
+    if (showrooms_not_counted > 0) index_loaded_showrooms();
+}
+
+static int compare_segment_names(const void* a, const void* b) {
+    const SegmentName* name_a = (const SegmentName*)a;
+    const SegmentName* name_b = (const SegmentName*)b;
+    if (name_a->showroom_id != name_b->showroom_id) return name_a->showroom_id < name_b->showroom_id ? -1 : 1;
+    if (name_a->table != name_b->table) return name_a->table < name_b->table ? -1 : 1;
+    return name_a->generation < name_b->generation ? -1 : name_a->generation > name_b->generation;
+}
+
+// Segments and archive runs the manifest does not name were written by a save or a compaction
+// that a crash cut short, or retired by a save that got no further than its manifest. No
+// manifest will name them again, so they go once this one is accepted.
+static void remove_unnamed_segments(const char* path, Showroom** showrooms, int count) {
+#ifndef _WIN32
+    SegmentList named = {NULL, 0, 0};
+    for (int s = 0; s < count; s++) {
+        for (int t = 0; t < SHOWROOM_TABLE_COUNT; t++) {
+            if (showrooms[s]->segment_generation[t] == 0) continue;
+            if (!add_segment_name(&named, showrooms[s]->id, t, showrooms[s]->segment_generation[t])) goto done;
+        }
+        for (int r = 0; r < showrooms[s]->archive_run_count; r++) {
+            if (!add_segment_name(&named, showrooms[s]->id, ARCHIVE_TABLE, showrooms[s]->archive_runs[r])) goto done;
+        }
+    }
+    if (named.count > 1) qsort(named.names, named.count, sizeof(SegmentName), compare_segment_names);
+
+    char segment_dir[SNAPSHOT_PATH_SIZE];
+    snprintf(segment_dir, sizeof(segment_dir), "%s%s", path, SNAPSHOT_SEGMENT_DIR_SUFFIX);
+    DIR* dir = opendir(segment_dir);
+    if (!dir) goto done;
+    int removed = 0;
+    struct dirent* entry;
+    char segment_file[SNAPSHOT_PATH_SIZE];
+    while ((entry = readdir(dir)) != NULL) {
+        // Only names segment_path() makes
+        SegmentName name;
+        char table[16];
+        unsigned int generation;
+        int length = 0;
+        if (sscanf(entry->d_name, "%d-%15[a-z]-%u.seg%n", &name.showroom_id, table, &generation, &length) != 3 ||
+            length == 0 || entry->d_name[length] != '\0') {
+            continue;
+        }
+        name.table = -1;
+        for (int t = 0; t <= ARCHIVE_TABLE; t++) {
+            if (strcmp(table, segment_table_names[t]) == 0) name.table = t;
+        }
+        name.generation = generation;
+        if (name.table < 0 || bsearch(&name, named.names, named.count, sizeof(SegmentName), compare_segment_names)) {
+            continue;
+        }
+        if (segment_path(segment_file, sizeof(segment_file), path, name.showroom_id, name.table, name.generation) &&
+            remove(segment_file) == 0) {
+            removed++;
+        }
+    }
+    closedir(dir);
+    if (removed > 0) out_printf("Removed %d snapshot files no saved snapshot uses.\n", removed);
+done:
+    store_free(named.names);
+#else
+    (void)path;
+    (void)showrooms;
+    (void)count;
+#endif
+}
+
+int load_snapshot(const char* path, uint64_t* journal_lsn) {
+    MappedFile file;
+    if (!map_file(path, &file)) return 0;
+    const unsigned char* data = (const unsigned char*)file.data;
+    size_t size = file.size;
+
+    SnapshotSection sections[SNAPSHOT_SECTION_COUNT + 1];
+    if (!validate_snapshot(data, size, sections, MANIFEST_SECTIONS)) {
+        out_printf("Snapshot %s is damaged or from another version, ignoring it.\n", path);
+        unmap_file(&file);
+        return 0;
+    }
+    if (strlen(path) >= sizeof(manifest_path)) {
+        out_printf("Snapshot path %s is too long, ignoring it.\n", path);
+        unmap_file(&file);
+        return 0;
+    }
+
+    uint32_t showroom_records = sections[SNAPSHOT_SHOWROOMS].records;
+    Showroom** showrooms = (Showroom**)malloc((showroom_records ? showroom_records : 1) * sizeof(Showroom*));
+    int showrooms_decoded = showrooms ? decode_showroom_section(&sections[SNAPSHOT_SHOWROOMS], showrooms) : -1;
+    if (showrooms_decoded < 0) {
+        out_printf("Snapshot %s could not be read, ignoring it.\n", path);
+        free(showrooms);
+        unmap_file(&file);
+        return 0;
+    }
+
+    // Only the showroom records are loaded now. Every segment they name must exist (a cheap
+    // check, so a snapshot with files missing is still rejected as a unit); their contents are
+    // read and checked when the showroom is first used.
+    int showroom_count = showrooms_decoded;
+    decode_archive_section(&sections[SNAPSHOT_ARCHIVES], &sections[SNAPSHOT_ARCHIVE_RUNS], showrooms, showroom_count);
+    int tables_on_disk = 0;     // Showrooms with any table to read
+    char segment_file[SNAPSHOT_PATH_SIZE];
+    for (int s = 0; s < showroom_count; s++) {
+        Showroom* showroom = showrooms[s];
+        // The tables' segments, then the archive runs
+        for (int t = 0; t < SHOWROOM_TABLE_COUNT + showroom->archive_run_count; t++) {
+            int table = t < SHOWROOM_TABLE_COUNT ? t : ARCHIVE_TABLE;
+            uint32_t generation = t < SHOWROOM_TABLE_COUNT ? showroom->segment_generation[t]
+                                                           : showroom->archive_runs[t - SHOWROOM_TABLE_COUNT];
+            if (generation == 0) continue;
+            if (generation > last_generation) last_generation = generation;
+
+            struct stat segment_stat;
+            if (!segment_path(segment_file, sizeof(segment_file), path, showroom->id, table, generation) ||
+                stat(segment_file, &segment_stat) != 0) {
+                out_printf("Snapshot segment %s is missing, ignoring the snapshot.\n", segment_file);
+                for (int f = 0; f < showroom_count; f++) {
+                    freeShowroom(showrooms[f]);
+                }
+                free(showrooms);
+                unmap_file(&file);
+                return 0;
+            }
+            if (table != ARCHIVE_TABLE) showroom->snapshot_state = SNAPSHOT_UNREAD;
+        }
+        tables_on_disk += showroom->snapshot_state == SNAPSHOT_UNREAD;
+    }
+
+    *journal_lsn = 0;
+    if (sections[SNAPSHOT_CHECKPOINT].records > 0) {
+        SnapshotSection* section = &sections[SNAPSHOT_CHECKPOINT];
+        SnapshotReader reader = {section->data, section->data + section->length, 0, section->version};
+        *journal_lsn = get_u64(&reader);
+    }
+
+    remove_unnamed_segments(path, showrooms, showroom_count);
+    load_popularity_section(&sections[SNAPSHOT_POPULARITY]);
+    build_tree(showroom_tree, (void**)showrooms, showroom_count);
+    strcpy(manifest_path, path);
+    showrooms_on_disk = tables_on_disk;
+    showrooms_not_counted = tables_on_disk;
+    bplusSetAccess(showroom_tree, load_showroom_on_access);
+
+    free(showrooms);
+    unmap_file(&file);
+
+    out_printf("Snapshot loaded: %d showrooms, records are read as each showroom is first used\n", showroom_count);
+    return 1;
+}
+
+// ---------------------------------------------------------------------------
+// Background checkpoints
+// ---------------------------------------------------------------------------
+
+// Dirty marks handed to a running background save, and how many retired segments it deletes
+typedef struct {
+    int showroom_id;
+    unsigned int dirty;
+} DirtyMark;
+
+static DirtyMark* handed_marks = NULL;
+static int handed_count = 0;
+static int handed_retired = 0;
+static int background_running = 0;
+static char background_path[SNAPSHOT_PATH_SIZE];    // Manifest the background save writes
+
+void snapshot_background_started(const char* path) {
+    background_running = 1;
+    snprintf(background_path, sizeof(background_path), "%s", path);
+    free(handed_marks);
+    handed_count = 0;
+    handed_retired = retired_segments.count;
+
+    // Changes from here on mark their tables again; without room to remember the
+    // marks they are simply kept, and those tables are written once more next time
+    handed_marks = (DirtyMark*)malloc((count_keys(showroom_tree) + 1) * sizeof(DirtyMark));
+    if (!handed_marks) return;
+    for (BTreeNode* node = first_leaf(showroom_tree); node; node = node->leaf_link.next) {
+        for (int i = 0; i < node->num_keys; i++) {
+            Showroom* showroom = (Showroom*)node->keys[i].key;
+            if (!showroom->dirty) continue;
+            handed_marks[handed_count].showroom_id = showroom->id;
+            handed_marks[handed_count].dirty = showroom->dirty;
+            handed_count++;
+            showroom->dirty = 0;
+        }
+    }
+}
+
+void snapshot_background_finished(int ok, const SegmentName* segments, int count) {
+    background_running = 0;
+    if (ok) {
+        strcpy(manifest_path, background_path);
+        for (int i = 0; i < count; i++) {
+            const SegmentName* name = &segments[i];
+            if (name->generation > last_generation) last_generation = name->generation;
+
+            // A showroom removed in the meantime is still in that manifest; its new
+            // segments go once a manifest without it is in place
+            Showroom* showroom = find_showroom(name->showroom_id);
+            if (showroom) {
+                showroom->segment_generation[name->table] = name->generation;
+            } else {
+                add_segment_name(&retired_segments, name->showroom_id, name->table, name->generation);
+            }
+        }
+
+        // The save deleted the retired segments it knew of
+        if (handed_retired > 0) {
+            memmove(retired_segments.names, retired_segments.names + handed_retired,
+                    (retired_segments.count - handed_retired) * sizeof(SegmentName));
+            retired_segments.count -= handed_retired;
+        }
+    } else {
+        for (int i = 0; i < handed_count; i++) {
+            Showroom* showroom = find_showroom(handed_marks[i].showroom_id);
+            if (showroom) showroom->dirty |= handed_marks[i].dirty;
+        }
+    }
+
+    free(handed_marks);
+    handed_marks = NULL;
+    handed_count = 0;
+    handed_retired = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Memory budget
+// ---------------------------------------------------------------------------
+
+static size_t memory_budget = 0;    // Bytes of tables kept in memory between commands, 0 for no limit
+
+// Rough bytes a showroom's tables hold: the records, their share of the tree nodes and, for
+// each sale, the customer and EMI index entries that go with it
+#define TREE_NODE_SHARE (sizeof(BTreeNode) / 2)
+static size_t showroom_table_bytes(const Showroom* showroom) {
+    size_t cars = (size_t)showroom->total_available_cars * (sizeof(Car) + TREE_NODE_SHARE);
+    size_t sales = (size_t)showroom->total_sold_cars *
+                   (2 * sizeof(SoldCar) + sizeof(Customer) + sizeof(CustomerIndexEntry) +
+                    sizeof(EmiIndexEntry) + 4 * TREE_NODE_SHARE);
+    size_t salespersons = (size_t)showroom->leaderboard_count *
+                          (sizeof(SalesPerson) + 2 * sizeof(BPlusTree) + sizeof(SalesPerson*) + TREE_NODE_SHARE);
+    return cars + sales + salespersons;
+}
+
+// A table the segments on disk do not hold as it is in memory
+static int table_changed(const Showroom* showroom, int table) {
+    return (showroom->dirty & SHOWROOM_DIRTY(table)) || showroom->segment_generation[table] == 0;
+}
+
+// Write the tables the snapshot cannot give back to the spill directory, then free them all.
+// The sales always go there: read back from a spill file, customers keep their string heap
+// entries instead of adding their names and addresses to the heap once more.
+// The sales ledger and popularity window stay, they are small and cannot be rebuilt exactly.
+static int evict_showroom(Showroom* showroom, SnapshotWriter* writer) {
+    char path[SNAPSHOT_PATH_SIZE];
+    unsigned int spilled = 0;
+    for (int table = 0; table < SHOWROOM_TABLE_COUNT; table++) {
+        if (!table_changed(showroom, table) && table != SHOWROOM_SALES) continue;
+
+        int ok = spill_path(path, sizeof(path), showroom->id, table) &&
+                 open_writer(writer, path, 0, table == SHOWROOM_SALES ? 3 : 1);
+        if (ok) {
+            write_table(writer, showroom, table, SNAPSHOT_CUSTOMER_REFS);
+            ok = close_writer(writer);
+        }
+        if (!ok) {
+            out_printf("Error: Could not write spill file %s, showroom %d stays in memory\n", path, showroom->id);
+            remove_spill_files(showroom, spilled | SHOWROOM_DIRTY(table));
+            return 0;
+        }
+        spilled |= SHOWROOM_DIRTY(table);
+    }
+
+    if (!(showroom->snapshot_state & SNAPSHOT_NOT_INDEXED)) customer_index_remove_showroom(showroom);
+    freeBPlusTree(showroom->available_cars);
+    freeBPlusTree(showroom->sold_cars);
+    freeBPlusTree(showroom->sales_persons);
+    leaderboard_free(showroom);
+    create_table_trees(showroom);
+
+    showroom->spilled = spilled;
+    showroom->snapshot_state |= SNAPSHOT_TABLES_ON_DISK | SNAPSHOT_NOT_INDEXED;
+    showrooms_on_disk++;
+    return 1;
+}
+
+void snapshot_set_memory_budget(size_t bytes, const char* spill_dir) {
+    if (strlen(spill_dir) + 64 > sizeof(spill_directory)) {
+        out_printf("Spill directory %s is too long, keeping every showroom in memory.\n", spill_dir);
+        return;
+    }
+    strcpy(spill_directory, spill_dir);
+    make_directory(spill_directory);
+
+    // Spill files left behind by a run that did not exit cleanly
+    snapshot_remove_spill_files();
+
+    memory_budget = bytes;
+    bplusSetAccess(showroom_tree, load_showroom_on_access);
+}
+
+void snapshot_remove_spill_files() {
+    if (!spill_directory[0]) return;
+    for (BTreeNode* node = first_leaf(showroom_tree); node; node = node->leaf_link.next) {
+        for (int i = 0; i < node->num_keys; i++) {
+            remove_spill_files((Showroom*)node->keys[i].key, SHOWROOM_DIRTY_ALL);
+        }
+    }
+}
+
+typedef struct {
+    Showroom* showroom;
+    size_t bytes;
+} ResidentShowroom;
+
+static int compare_last_used(const void* a, const void* b) {
+    unsigned long used_a = ((const ResidentShowroom*)a)->showroom->last_used;
+    unsigned long used_b = ((const ResidentShowroom*)b)->showroom->last_used;
+    return used_a < used_b ? -1 : used_a > used_b;
+}
+
+void snapshot_trim_memory() {
+    // A background save took over the dirty marks, a table would look saved when it is not
+    if (memory_budget == 0 || background_running) return;
+
+    int count = (int)count_keys(showroom_tree);
+    ResidentShowroom* resident = (ResidentShowroom*)malloc((count ? count : 1) * sizeof(ResidentShowroom));
+    if (!resident) return;
+
+    int n = 0;
+    size_t total = 0;
+    for (BTreeNode* node = first_leaf(showroom_tree); node; node = node->leaf_link.next) {
+        for (int i = 0; i < node->num_keys; i++) {
+            Showroom* showroom = (Showroom*)node->keys[i].key;
+            if (showroom->snapshot_state & SNAPSHOT_TABLES_ON_DISK) continue;
+            resident[n].showroom = showroom;
+            resident[n].bytes = showroom_table_bytes(showroom);
+            total += resident[n].bytes;
+            n++;
+        }
+    }
+
+    if (total > memory_budget) {
+        // Least recently looked up first
+        qsort(resident, n, sizeof(ResidentShowroom), compare_last_used);
+        SnapshotWriter* writer = (SnapshotWriter*)malloc(sizeof(SnapshotWriter));
+        for (int i = 0; i < n && total > memory_budget && writer; i++) {
+            // Without room on disk the rest stay too, the next command tries again
+            if (!evict_showroom(resident[i].showroom, writer)) break;
+            total -= resident[i].bytes;
+        }
+        free(writer);
+    }
+    free(resident);
+}
+
+// Evicted with changes that only its spill files hold
+static int has_spilled_changes(const Showroom* showroom) {
+    for (int table = 0; table < SHOWROOM_TABLE_COUNT; table++) {
+        if ((showroom->spilled & SHOWROOM_DIRTY(table)) && table_changed(showroom, table)) return 1;
+    }
+    return 0;
+}
+
+void snapshot_load_evicted_changes() {
+    int count = 0;
+    for (BTreeNode* node = first_leaf(showroom_tree); node; node = node->leaf_link.next) {
+        for (int i = 0; i < node->num_keys; i++) {
+            count += has_spilled_changes((Showroom*)node->keys[i].key);
+        }
+    }
+    if (count == 0) return;
+
+    Showroom** showrooms = (Showroom**)malloc(count * sizeof(Showroom*));
+    if (!showrooms) {
+        out_printf("Memory allocation failed for snapshot load\n");
+        return;
+    }
+    int n = 0;
+    for (BTreeNode* node = first_leaf(showroom_tree); node && n < count; node = node->leaf_link.next) {
+        for (int i = 0; i < node->num_keys && n < count; i++) {
+            Showroom* showroom = (Showroom*)node->keys[i].key;
+            if (has_spilled_changes(showroom)) showrooms[n++] = showroom;
+        }
+    }
+    load_showroom_tables(showrooms, n);
+    free(showrooms);
+}
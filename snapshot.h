@@ -0,0 +1,111 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "essentialfunction.h"
+
+// Binary snapshot of every showroom, salesperson, car, sale, customer and the popularity table.
+//
+// Layout: a manifest file holding the popularity table, the showroom records and the journal
+// checkpoint, plus one segment file per showroom table (salespersons, cars, sales) in the
+// `<manifest>.segments` directory. A save only writes the segments of tables marked dirty in
+// their showroom; the others stay as they are and the new manifest refers to them again.
+// Segments are never overwritten: each is written under a new generation number, and the
+// files the previous manifest used are removed once the new manifest is in place. Segment and
+// archive files no manifest names (left by a save or a compaction a crash cut short) are removed
+// when a snapshot loads.
+//
+// Loading reads the manifest only; a showroom's segments are read the first time the showroom
+// is looked up in showroom_tree, and the operations that span every showroom read all of them
+// first (snapshot_load_all_showrooms). The indexes shared by all showrooms (customer index,
+// national popularity window) are filled at that point, or for a single showroom by an
+// operation that changes them (snapshot_index_showroom), so a sale only reads the showroom it
+// is made in. Showrooms still on disk are never dirty, so a save keeps their segments without
+// reading them.
+//
+// Every file is a header followed by sections that carry their own CRC32. A snapshot naming a
+// segment that does not exist is rejected as a unit; a segment that fails its check when it is
+// read leaves its showroom empty. Within a section records are grouped into runs per showroom (or salesperson) in
+// tree order, which lets the loader bulk-build each tree instead of inserting one key at a time.
+// Values are stored in host byte order; a snapshot from a host of the other order is rejected.
+
+#define SNAPSHOT_MAGIC "SHOWSNAP"
+#define SNAPSHOT_VERSION 3
+#define SNAPSHOT_MIN_VERSION 2          // Version 2 stored sale model ids in 16 bits; still read
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+#define SNAPSHOT_SEGMENT_DIR_SUFFIX ".segments"
+
+// Section tags
+#define SNAPSHOT_POPULARITY   1     // Manifest
+#define SNAPSHOT_SHOWROOMS    2     // Manifest, with each table's segment generation
+#define SNAPSHOT_SALESPERSONS 3     // Salespersons segment
+#define SNAPSHOT_CARS         4     // Cars segment
+#define SNAPSHOT_SOLD_CARS    5     // Sales segment
+#define SNAPSHOT_SP_SOLD_CARS 6     // Sales segment: each salesperson's own copy of its sales
+#define SNAPSHOT_CUSTOMERS    7     // Sales segment
+#define SNAPSHOT_CHECKPOINT   8     // Manifest: last journal record the snapshot includes (optional, 0 if absent)
+#define SNAPSHOT_CUSTOMER_REFS 9    // Spill files only: customers with string heap handles for name and address
+#define SNAPSHOT_ARCHIVES     10    // Older manifests: each showroom's one archive generation (optional)
+#define SNAPSHOT_ARCHIVE_RUNS 11    // Manifest: each showroom's archive runs (optional, see archive.h)
+#define SNAPSHOT_SECTION_COUNT 11
+
+uint32_t crc32_update(uint32_t crc, const void* data, size_t length);   // Start from 0
+
+// 1 on success, the previous snapshot survives a failed save
+int save_snapshot(const char* path, uint64_t journal_lsn);
+// 1 on success, 0 if missing or invalid (nothing is loaded); *journal_lsn is the checkpoint it was saved at
+int load_snapshot(const char* path, uint64_t* journal_lsn);
+
+// Showroom.snapshot_state flags, for what of a showroom is not loaded
+#define SNAPSHOT_TABLES_ON_DISK 1   // Salespersons, cars and sales are not in memory
+#define SNAPSHOT_NEVER_READ     2   // Nor have they been: the sales ledger and popularity window are not built
+#define SNAPSHOT_NOT_INDEXED    4   // Customers are not in the customer index
+#define SNAPSHOT_NOT_COUNTED    8   // Sales are not in the national popularity window
+#define SNAPSHOT_UNREAD (SNAPSHOT_TABLES_ON_DISK | SNAPSHOT_NEVER_READ | SNAPSHOT_NOT_INDEXED | SNAPSHOT_NOT_COUNTED)
+
+// Read every showroom not in memory and index them all; for operations that span showrooms
+void snapshot_load_all_showrooms();
+// Read one showroom if needed and add it to the shared indexes; before changing what it holds there
+void snapshot_index_showroom(Showroom* showroom);
+// Whether reading a showroom needs nothing read or indexed first (with 0: every showroom and
+// the shared indexes), so the reader can share the state lock (see checkpoint.h)
+int snapshot_resident(int showroom_id);
+
+// Memory budget: between commands, the tables of the showrooms looked up least recently are
+// freed until the rest fit in `bytes` (an estimate from the record counts). Tables the snapshot
+// holds as they are in memory are read back from it; the others, and the sales, are written
+// to `spill_dir` first. Commands that span showrooms, and saves, read back what they need and
+// may go over the budget until the next trim.
+#define SNAPSHOT_MEMORY_BUDGET_ENV "SHOWROOM_MEMORY_MB"    // Budget in MiB, unset or 0 keeps everything
+void snapshot_set_memory_budget(size_t bytes, const char* spill_dir);
+void snapshot_trim_memory();
+void snapshot_load_evicted_changes();   // Read back the showrooms whose changes are only in spill files
+void snapshot_remove_spill_files();     // Once the state is saved for good, at exit
+
+// A showroom is going away: its segments are removed after the next save
+void snapshot_retire_showroom(const Showroom* showroom);
+
+// Archives live with the segments, under the same generation numbers (see archive.h)
+int snapshot_archive_path(char* dest, size_t size, int showroom_id, uint32_t generation);  // 0 before any snapshot
+uint32_t snapshot_next_generation();
+// A run the showroom's archive no longer uses; its file goes after the next save
+void snapshot_retire_archive_run(int showroom_id, uint32_t generation);
+
+// One table of one showroom, as saved under a generation
+typedef struct {
+    int showroom_id;
+    int table;
+    uint32_t generation;
+} SegmentName;
+
+const SegmentName* snapshot_saved_segments(int* count);    // Segments the last successful save wrote
+void register_snapshot_state();     // See mappedstore.h
+
+// Background checkpoints (see checkpoint.h): another process saves this state to `path` while
+// it keeps changing here. started() takes over the dirty marks the save will clear, finished()
+// adopts the segments it wrote, or puts the marks back if it failed. Nothing is evicted in between.
+void snapshot_background_started(const char* path);
+void snapshot_background_finished(int ok, const SegmentName* segments, int count);
+
+#endif
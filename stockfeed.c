@@ -0,0 +1,395 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include "stockfeed.h"
+#include "essentialfunction.h"
+#include "textreader.h"
+#include "filehandling.h"
+#include "snapshot.h"
+#include "journal.h"
+#include "parallelload.h"
+
+// Row status
+#define FEED_ACCEPTED 0
+#define FEED_REPEATED 1
+#define FEED_IN_STOCK 2
+#define FEED_NO_SHOWROOM 3
+
+typedef struct {
+    int showroom_id;
+    int line;
+    int status;
+    Car car;
+} FeedRow;
+
+// Lines of a file or pipe, read in FEED_READ_SIZE pieces; a line is valid until the next call
+typedef struct {
+    FILE* file;
+    char* buffer;
+    size_t capacity;
+    size_t start;               // Start of the next line
+    size_t end;                 // End of the data read
+    int eof;
+    int failed;
+    size_t bytes;
+} FeedReader;
+
+static int feed_reader_open(FeedReader* reader, const char* path) {
+    memset(reader, 0, sizeof(FeedReader));
+    reader->file = fopen(path, "rb");
+    if (!reader->file) return 0;
+    reader->capacity = FEED_READ_SIZE;
+    reader->buffer = (char*)malloc(reader->capacity + 1);
+    if (!reader->buffer) {
+        fclose(reader->file);
+        return 0;
+    }
+    return 1;
+}
+
+static void feed_reader_close(FeedReader* reader) {
+    if (reader->file) fclose(reader->file);
+    free(reader->buffer);
+}
+
+// 0 at end of input; the line excludes "\r\n" and is NUL-terminated in place
+static int feed_reader_next_line(FeedReader* reader, char** line, size_t* length) {
+    size_t scanned = reader->start;
+    for (;;) {
+        char* newline = (char*)memchr(reader->buffer + scanned, '\n', reader->end - scanned);
+        if (newline || (reader->eof && reader->end > reader->start)) {
+            char* begin = reader->buffer + reader->start;
+            char* stop = newline ? newline : reader->buffer + reader->end;
+            reader->start = (size_t)(stop - reader->buffer) + (newline ? 1 : 0);
+            if (stop > begin && stop[-1] == '\r') stop--;
+            *stop = '\0';
+            *line = begin;
+            *length = (size_t)(stop - begin);
+            return 1;
+        }
+        if (reader->eof) return 0;
+
+        // Keep the partial line at the front, grow the buffer if it fills it
+        size_t pending = reader->end - reader->start;
+        memmove(reader->buffer, reader->buffer + reader->start, pending);
+        reader->start = 0;
+        reader->end = pending;
+        scanned = pending;
+        if (reader->capacity - reader->end < FEED_READ_SIZE / 2) {
+            char* grown = (char*)realloc(reader->buffer, reader->capacity * 2 + 1);
+            if (!grown) {
+                reader->failed = 1;
+                return 0;
+            }
+            reader->buffer = grown;
+            reader->capacity *= 2;
+        }
+
+        size_t got = fread(reader->buffer + reader->end, 1, reader->capacity - reader->end, reader->file);
+        if (got == 0) {
+            if (ferror(reader->file)) reader->failed = 1;
+            reader->eof = 1;
+        }
+        reader->end += got;
+        reader->bytes += got;
+    }
+}
+
+// CSV fields, unquoted in place: "a ""b""" becomes a "b". Fields past max_fields are dropped.
+static int split_csv_fields(char* line, size_t length, StrView* fields, int max_fields) {
+    int count = 0;
+    size_t i = 0;
+    for (;;) {
+        char* out = line + i;
+        char* field = out;
+        if (i < length && line[i] == '"') {
+            i++;
+            while (i < length) {
+                if (line[i] == '"') {
+                    if (i + 1 < length && line[i + 1] == '"') {
+                        *out++ = '"';
+                        i += 2;
+                        continue;
+                    }
+                    i++;
+                    break;
+                }
+                *out++ = line[i++];
+            }
+            // Anything between the closing quote and the comma is kept
+            while (i < length && line[i] != ',') *out++ = line[i++];
+        } else {
+            while (i < length && line[i] != ',') *out++ = line[i++];
+        }
+        if (count < max_fields) {
+            fields[count].data = field;
+            fields[count].length = (size_t)(out - field);
+        }
+        count++;
+        if (i >= length) break;
+        i++;    // The comma
+    }
+    return count < max_fields ? count : max_fields;
+}
+
+static StrView trim_view(StrView view) {
+    while (view.length > 0 && isspace((unsigned char)view.data[0])) {
+        view.data++;
+        view.length--;
+    }
+    while (view.length > 0 && isspace((unsigned char)view.data[view.length - 1])) view.length--;
+    return view;
+}
+
+static int parse_showroom_id(StrView view, int* id) {
+    if (view.length == 0 || view.length > 9) return 0;
+    for (size_t i = 0; i < view.length; i++) {
+        if (!isdigit((unsigned char)view.data[i])) return 0;
+    }
+    *id = view_to_int(view);
+    return 1;
+}
+
+// Text the cars file can hold: not empty, fits, no separator or control characters
+static int valid_text(StrView view, size_t size) {
+    if (view.length == 0 || view.length >= size) return 0;
+    for (size_t i = 0; i < view.length; i++) {
+        unsigned char c = (unsigned char)view.data[i];
+        if (c == '|' || c < 0x20) return 0;
+    }
+    return 1;
+}
+
+// NULL if the fields make a car, otherwise why not
+static const char* parse_feed_row(StrView* fields, int field_count, FeedRow* row) {
+    if (field_count != 7) return "expected 7 fields";
+    for (int i = 0; i < field_count; i++) fields[i] = trim_view(fields[i]);
+
+    if (!parse_showroom_id(fields[0], &row->showroom_id)) return "invalid showroom id";
+    if (fields[1].length == 0 || fields[1].length >= MAX_VIN_LEN) return "invalid VIN";
+    for (size_t i = 0; i < fields[1].length; i++) {
+        char c = fields[1].data[i];
+        if (!isalnum((unsigned char)c) && c != '-') return "invalid VIN";
+    }
+    if (!valid_text(fields[2], MAX_STR_LEN)) return "invalid model name";
+    if (!valid_text(fields[3], MAX_STR_LEN)) return "invalid color";
+    if (!valid_text(fields[5], MAX_STR_LEN)) return "invalid fuel type";
+    if (!valid_text(fields[6], MAX_STR_LEN)) return "invalid car type";
+
+    char number[64];
+    if (fields[4].length == 0 || fields[4].length >= sizeof(number)) return "invalid price";
+    view_copy(fields[4], number, sizeof(number));
+    char* end;
+    double price = strtod(number, &end);
+    if (*end != '\0' || !isfinite(price) || price <= 0) return "invalid price";
+
+    memset(&row->car, 0, sizeof(Car));
+    if (!parse_car_fields(fields, field_count, &row->car)) return "expected 7 fields";
+    row->car.price = price;
+    return NULL;
+}
+
+static int compare_rows_by_vin(const void* a, const void* b) {
+    const FeedRow* row_a = (const FeedRow*)a;
+    const FeedRow* row_b = (const FeedRow*)b;
+    int result = strcmp(row_a->car.VIN, row_b->car.VIN);
+    if (result != 0) return result;
+    return (row_a->line > row_b->line) - (row_a->line < row_b->line);
+}
+
+static int compare_rows_by_showroom(const void* a, const void* b) {
+    const FeedRow* row_a = *(const FeedRow* const*)a;
+    const FeedRow* row_b = *(const FeedRow* const*)b;
+    if (row_a->showroom_id != row_b->showroom_id) {
+        return (row_a->showroom_id > row_b->showroom_id) - (row_a->showroom_id < row_b->showroom_id);
+    }
+    return strcmp(row_a->car.VIN, row_b->car.VIN);
+}
+
+static int compare_vin_to_row(const void* vin, const void* row) {
+    return strcmp((const char*)vin, (*(const FeedRow* const*)row)->car.VIN);
+}
+
+// Read and check every line; rows are returned in file order
+static FeedRow* read_feed(FeedReader* reader, int* row_count, StockFeedResult* result) {
+    FeedRow* rows = NULL;
+    int count = 0, capacity = 0;
+    int line_number = 0;
+    char separator = 0;
+    char* line;
+    size_t length;
+
+    while (feed_reader_next_line(reader, &line, &length)) {
+        line_number++;
+        if (length == 0) continue;
+
+        StrView fields[TEXT_MAX_FIELDS];
+        int field_count;
+        if (separator == 0) separator = memchr(line, '|', length) ? '|' : ',';
+        if (separator == '|') {
+            StrView view = { line, length };
+            field_count = split_fields(view, '|', fields, TEXT_MAX_FIELDS);
+        } else {
+            field_count = split_csv_fields(line, length, fields, TEXT_MAX_FIELDS);
+        }
+
+        int id;
+        if (line_number == 1 && !parse_showroom_id(trim_view(fields[0]), &id)) continue;   // Header
+
+        if (count == capacity) {
+            int new_capacity = capacity ? capacity * 2 : 1024;
+            FeedRow* grown = (FeedRow*)realloc(rows, (size_t)new_capacity * sizeof(FeedRow));
+            if (!grown) {
+                out_printf("Out of memory reading the feed at line %d\n", line_number);
+                reader->failed = 1;
+                break;
+            }
+            rows = grown;
+            capacity = new_capacity;
+        }
+
+        result->rows++;
+        FeedRow* row = &rows[count];
+        const char* error = parse_feed_row(fields, field_count, row);
+        if (error) {
+            if (result->invalid < FEED_ERRORS_SHOWN) out_printf("Line %d: %s\n", line_number, error);
+            result->invalid++;
+            continue;
+        }
+        row->line = line_number;
+        row->status = FEED_ACCEPTED;
+        count++;
+    }
+
+    result->bytes = reader->bytes;
+    *row_count = count;
+    return rows;
+}
+
+// Mark the rows whose VIN is already available somewhere, in one pass over every showroom's
+// cars; `unique` is sorted by VIN
+static void probe_existing_stock(FeedRow** unique, int count) {
+    if (!showroom_tree || !showroom_tree->root || count == 0) return;
+
+    BTreeNode* node = showroom_tree->root;
+    while (!node->is_leaf) node = node->children[0];
+    for (; node; node = node->leaf_link.next) {
+        for (int i = 0; i < node->num_keys; i++) {
+            Showroom* showroom = (Showroom*)node->keys[i].key;
+            if (!showroom->available_cars || !showroom->available_cars->root) continue;
+
+            BTreeNode* leaf = showroom->available_cars->root;
+            while (!leaf->is_leaf) leaf = leaf->children[0];
+            for (; leaf; leaf = leaf->leaf_link.next) {
+                for (int k = 0; k < leaf->num_keys; k++) {
+                    Car* car = (Car*)leaf->keys[k].key;
+                    FeedRow** match = (FeedRow**)bsearch(car->VIN, unique, count, sizeof(FeedRow*), compare_vin_to_row);
+                    if (match) (*match)->status = FEED_IN_STOCK;
+                }
+            }
+        }
+    }
+}
+
+// Merge one showroom's rows, sorted by VIN, into its available cars
+static void stock_showroom_rows(Showroom* showroom, FeedRow** rows, int count) {
+    if (!showroom->available_cars) {
+        showroom->available_cars = createBPlusTree(compareVIN, printCar, cloneCar, freeCar);
+    }
+
+    void** keys = (void**)malloc((size_t)count * sizeof(void*));
+    int cloned = 0;
+    if (keys) {
+        while (cloned < count && (keys[cloned] = cloneCar(&rows[cloned]->car))) cloned++;
+    }
+    if (!keys || cloned < count || !bplusBulkMerge(showroom->available_cars, keys, count)) {
+        // Not enough memory for the batch: one insert at a time
+        for (int i = 0; i < cloned; i++) freeCar(keys[i]);
+        for (int i = 0; i < count; i++) bplusInsert(showroom->available_cars, &rows[i]->car);
+    }
+    free(keys);
+
+    showroom->total_available_cars += count;
+    showroom->dirty |= SHOWROOM_DIRTY(SHOWROOM_CARS);
+    for (int i = 0; i < count; i++) {
+        journal_log_add_car(showroom->id, &rows[i]->car);
+    }
+}
+
+int stock_feed_import(const char* path, StockFeedResult* result) {
+    memset(result, 0, sizeof(StockFeedResult));
+    double start = wall_clock_seconds();
+
+    FeedReader reader;
+    if (!feed_reader_open(&reader, path)) {
+        out_printf("Cannot open feed %s\n", path);
+        return 0;
+    }
+    int count;
+    FeedRow* rows = read_feed(&reader, &count, result);
+    int failed = reader.failed;
+    feed_reader_close(&reader);
+    if (failed) {
+        out_printf("Error reading feed %s, nothing was imported\n", path);
+        free(rows);
+        return 0;
+    }
+
+    // Only the first row of a VIN counts
+    FeedRow** accepted = (FeedRow**)malloc((size_t)(count > 0 ? count : 1) * sizeof(FeedRow*));
+    if (!accepted) {
+        out_printf("Out of memory importing the feed, nothing was imported\n");
+        free(rows);
+        return 0;
+    }
+    qsort(rows, count, sizeof(FeedRow), compare_rows_by_vin);
+    int unique = 0;
+    for (int i = 0; i < count; i++) {
+        if (i > 0 && strcmp(rows[i].car.VIN, rows[i - 1].car.VIN) == 0) {
+            rows[i].status = FEED_REPEATED;
+            result->repeated++;
+        } else {
+            accepted[unique++] = &rows[i];
+        }
+    }
+
+    snapshot_load_all_showrooms();
+    probe_existing_stock(accepted, unique);
+
+    int stocked = 0;
+    for (int i = 0; i < unique; i++) {
+        if (accepted[i]->status == FEED_IN_STOCK) {
+            result->in_stock++;
+        } else {
+            accepted[stocked++] = accepted[i];
+        }
+    }
+
+    qsort(accepted, stocked, sizeof(FeedRow*), compare_rows_by_showroom);
+    for (int first = 0; first < stocked;) {
+        int last = first;
+        while (last < stocked && accepted[last]->showroom_id == accepted[first]->showroom_id) last++;
+
+        Showroom temp;
+        temp.id = accepted[first]->showroom_id;
+        Showroom* showroom = (Showroom*)bplusSearch(showroom_tree, &temp);
+        if (showroom) {
+            stock_showroom_rows(showroom, accepted + first, last - first);
+            result->added += last - first;
+            result->showrooms++;
+        } else {
+            out_printf("Showroom %d not found, its %d cars are skipped\n", temp.id, last - first);
+            for (int i = first; i < last; i++) accepted[i]->status = FEED_NO_SHOWROOM;
+            result->no_showroom += last - first;
+        }
+        first = last;
+    }
+    if (result->added > 0) inventory_changed();
+
+    free(accepted);
+    free(rows);
+    result->seconds = wall_clock_seconds() - start;
+    return 1;
+}
@@ -0,0 +1,37 @@
+#ifndef STOCK_FEED_H
+#define STOCK_FEED_H
+
+#include <stddef.h>
+
+// Bulk import of new stock from an OEM dispatch feed: one car per line, in the cars file's
+// layout (showroom_id|VIN|model|color|price|fuel_type|car_type) or the same columns as CSV
+// (commas, optional double quotes). A first line that does not start with a showroom id is
+// taken as a header. The feed is read in FEED_READ_SIZE pieces, so it may be a pipe.
+//
+// The rows are checked one by one, then handled as a batch:
+//   - sorted by VIN, so a VIN the feed repeats is only stocked once (the first row wins)
+//   - probed against the stock of every showroom in one pass over the available_cars trees,
+//     each VIN there looked up in the sorted rows, instead of one search per row per showroom
+//   - grouped by showroom in VIN order and merged into each available_cars tree in one bulk
+//     pass (see bplusBulkMerge), total_available_cars updated once per showroom
+// Every car added is journaled like a car added from the menu.
+
+#define FEED_READ_SIZE (1 << 20)
+#define FEED_ERRORS_SHOWN 10            // Rejected lines listed, the rest are only counted
+
+typedef struct {
+    size_t bytes;
+    int rows;                       // Lines with a record, the header excluded
+    int added;
+    int showrooms;                  // Showrooms that received cars
+    int invalid;
+    int repeated;                   // VIN already on an earlier line of the feed
+    int in_stock;                   // VIN already available in some showroom
+    int no_showroom;                // Showroom id that does not exist
+    double seconds;
+} StockFeedResult;
+
+// 1 once the feed has been read and applied, 0 if it cannot be opened or read (nothing is added)
+int stock_feed_import(const char* path, StockFeedResult* result);
+
+#endif
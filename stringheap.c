@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stringheap.h"
+#include "mappedstore.h"
+
+static char** blocks = NULL;
+static int block_count = 0;
+static int block_capacity = 0;
+static int block_used = STRING_HEAP_BLOCK_SIZE;    // Bytes used in the last block
+static size_t total_bytes = 0;
+
+// Start a new block; byte 0 of block 0 holds the shared empty string
+static int add_block() {
+    if (block_count == 0xFFFF) {
+        printf("String heap is full\n");
+        return 0;
+    }
+
+    if (block_count == block_capacity) {
+        int new_capacity = block_capacity ? block_capacity * 2 : 16;
+        char** grown = (char**)store_realloc(blocks, new_capacity * sizeof(char*));
+        if (!grown) {
+            printf("Memory allocation failed for string heap\n");
+            return 0;
+        }
+        blocks = grown;
+        block_capacity = new_capacity;
+    }
+
+    char* block = (char*)store_malloc(STRING_HEAP_BLOCK_SIZE);
+    if (!block) {
+        printf("Memory allocation failed for string heap\n");
+        return 0;
+    }
+    blocks[block_count++] = block;
+    block_used = 0;
+
+    if (block_count == 1) {
+        block[0] = '\0';
+        block_used = 1;
+    }
+    return 1;
+}
+
+// Copy a string into the heap and return its handle
+StrRef string_heap_add(const char* str) {
+    if (!str || !*str) return STRREF_EMPTY;
+
+    size_t length = strlen(str);
+    if (length >= STRING_HEAP_BLOCK_SIZE - 1) {
+        length = STRING_HEAP_BLOCK_SIZE - 2;    // Record strings are far shorter; truncate rather than fail
+    }
+
+    // block_used starts at the block size, so the first call allocates block 0
+    if (block_used + length + 1 > STRING_HEAP_BLOCK_SIZE && !add_block()) {
+        return STRREF_EMPTY;
+    }
+
+    char* dest = blocks[block_count - 1] + block_used;
+    memcpy(dest, str, length);
+    dest[length] = '\0';
+
+    StrRef ref = ((StrRef)(block_count - 1) << 16) | (StrRef)block_used;
+    block_used += (int)length + 1;
+    total_bytes += length + 1;
+    return ref;
+}
+
+const char* string_heap_get(StrRef ref) {
+    unsigned int block = ref >> 16;
+    if (ref == STRREF_EMPTY || (int)block >= block_count) return "";
+    return blocks[block] + (ref & 0xFFFF);
+}
+
+size_t string_heap_bytes() {
+    return total_bytes;
+}
+
+// Function to free the string heap memory (every StrRef becomes invalid)
+void free_string_heap() {
+    for (int i = 0; i < block_count; i++) {
+        store_free(blocks[i]);
+    }
+    store_free(blocks);
+    blocks = NULL;
+    block_count = 0;
+    block_capacity = 0;
+    block_used = STRING_HEAP_BLOCK_SIZE;
+    total_bytes = 0;
+}
+
+void register_string_heap_state() {
+    store_register_state(&blocks, sizeof(blocks));
+    store_register_state(&block_count, sizeof(block_count));
+    store_register_state(&block_capacity, sizeof(block_capacity));
+    store_register_state(&block_used, sizeof(block_used));
+    store_register_state(&total_bytes, sizeof(total_bytes));
+}
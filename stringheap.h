@@ -0,0 +1,21 @@
+#ifndef STRING_HEAP_H
+#define STRING_HEAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Shared, append-only storage for variable-length record strings (customer names, addresses).
+// A StrRef is a 32-bit handle: block index in the high 16 bits, byte offset in the low 16.
+// Blocks never move, so a string stays valid until free_string_heap().
+typedef uint32_t StrRef;
+
+#define STRING_HEAP_BLOCK_SIZE 65536
+#define STRREF_EMPTY 0              // Always refers to ""
+
+StrRef string_heap_add(const char* str);
+const char* string_heap_get(StrRef ref);
+size_t string_heap_bytes();         // Bytes handed out so far
+void free_string_heap();
+void register_string_heap_state();     // See mappedstore.h
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef TEST_PHASES_H
+#define TEST_PHASES_H
+
+// Persistence tests: each phase runs as one run of the program in its own process, and states
+// are compared through the text export. Helpers are inline so tests need not use them all.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../essentialfunction.h"
+#include "../filehandling.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+        return; \
+    } \
+} while (0)
+
+static const char* text_files[] = {"showrooms.txt", "cars.txt", "sold_cars.txt", "salespersons.txt",
+                                   "customers.txt", "car_popularity.txt"};
+#define TEXT_FILE_COUNT 6
+
+// Each phase is one run of the program in its own process: fresh state, data/ as the phase
+// before left it. The process ends without the exit save, so a phase that does not call
+// save_all_data() ends like a crash.
+static inline void run_phase(const char* name, void (*phase)()) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        set_command_output(fopen("/dev/null", "w"));
+        init_system();
+        phase();
+        fflush(stdout);
+        _exit(failures ? 1 : 0);
+    }
+    int status;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) {
+        printf("FAIL phase %s did not finish\n", name);
+        failures++;
+    } else if (WEXITSTATUS(status) != 0) {
+        failures++;
+    }
+}
+
+static inline char* read_file(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* data = (char*)malloc(*size + 1);
+    if (data && fread(data, 1, *size, file) != *size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+static inline int write_file(const char* path, const char* data, size_t size) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return 0;
+    int ok = fwrite(data, 1, size, file) == size;
+    return fclose(file) == 0 && ok;
+}
+
+// The state as text, moved out of data/ so it is not taken for newer text files on the next load
+static inline void dump_state(const char* dir) {
+    char path[256];
+    export_data_to_text();
+    mkdir(dir, 0755);
+    for (int i = 0; i < TEXT_FILE_COUNT; i++) {
+        snprintf(path, sizeof(path), "%s/%s", dir, text_files[i]);
+        char from[256];
+        snprintf(from, sizeof(from), "data/%s", text_files[i]);
+        CHECK(rename(from, path) == 0, "export wrote %s", from);
+    }
+}
+
+static inline void check_same_state(const char* expected_dir, const char* actual_dir) {
+    for (int i = 0; i < TEXT_FILE_COUNT; i++) {
+        char path[256];
+        size_t expected_size = 0, actual_size = 0;
+        snprintf(path, sizeof(path), "%s/%s", expected_dir, text_files[i]);
+        char* expected = read_file(path, &expected_size);
+        snprintf(path, sizeof(path), "%s/%s", actual_dir, text_files[i]);
+        char* actual = read_file(path, &actual_size);
+        int same = expected && actual && expected_size == actual_size && memcmp(expected, actual, actual_size) == 0;
+        free(expected);
+        free(actual);
+        CHECK(same, "%s differs between %s and %s", text_files[i], expected_dir, actual_dir);
+    }
+}
+
+// The import counts every car and sale it loads on top of the totals in showrooms.txt, so the
+// copies start those two columns from 0
+static inline void copy_text_files(const char* dir) {
+    for (int i = 0; i < TEXT_FILE_COUNT; i++) {
+        char path[256];
+        size_t size = 0;
+        snprintf(path, sizeof(path), "%s/%s", dir, text_files[i]);
+        char* data = read_file(path, &size);
+        CHECK(data, "read %s", path);
+        char* copy = (char*)malloc(size + 1);
+        CHECK(copy, "copy %s", path);
+        memcpy(copy, data, size);
+        if (i == 0) {
+            size_t kept = 0;
+            data[size] = '\0';
+            for (char* line = strtok(data, "\n"); line; line = strtok(NULL, "\n")) {
+                char* totals = strchr(line, '|');
+                for (int field = 1; totals && field < 4; field++) totals = strchr(totals + 1, '|');
+                CHECK(totals, "showroom line %s", line);
+                kept += (size_t)snprintf(copy + kept, size + 1 - kept, "%.*s|0|0\n", (int)(totals - line), line);
+            }
+            size = kept;
+        }
+        snprintf(path, sizeof(path), "data/%s", text_files[i]);
+        CHECK(write_file(path, copy, size), "copy %s", text_files[i]);
+        free(copy);
+        free(data);
+    }
+}
+
+static inline void stock(int showroom_id, const char* vin, const char* model, double price) {
+    Car car;
+    memset(&car, 0, sizeof(Car));
+    snprintf(car.VIN, sizeof(car.VIN), "%s", vin);
+    snprintf(car.name, sizeof(car.name), "%s", model);
+    snprintf(car.color, sizeof(car.color), "Blue");
+    snprintf(car.fuel_type, sizeof(car.fuel_type), "Petrol");
+    snprintf(car.car_type, sizeof(car.car_type), "SUV");
+    car.price = price;
+    CHECK(perform_add_stock(showroom_id, &car), "stock %s", vin);
+}
+
+// A sale made on purchase_date (days, see date_to_days()), 0 for today
+static inline void sell(int showroom_id, int salesperson_id, const char* vin, int payment_type, const char* mobile,
+                        int purchase_date) {
+    PurchaseOrder order;
+    memset(&order, 0, sizeof(order));
+    order.showroom_id = showroom_id;
+    order.salesperson_id = salesperson_id;
+    order.vin = vin;
+    order.payment_type = payment_type;
+    order.down_payment = payment_type == PAYMENT_LOAN ? 10 : 0;
+    order.loan_period_months = payment_type == PAYMENT_LOAN ? 60 : 0;
+    order.name = "Meera Iyer";
+    order.mobile = mobile;
+    order.address = "12 Lake Road";
+    order.reg_number = vin;
+    order.purchase_date = purchase_date;
+    CHECK(perform_car_purchase(&order), "sell %s", vin);
+}
+
+#endif
@@ -0,0 +1,27 @@
+#!/bin/sh
+# Build and run every tests/test_*.c against the program's sources (main.c excluded).
+# Each test runs in its own scratch directory, so data/ files are never touched.
+# usage: tests/run_tests.sh [extra gcc flags, e.g. -fsanitize=address,undefined]
+cd "$(dirname "$0")/.." || exit 1
+build=$(mktemp -d)
+sources=$(ls *.c | grep -v '^main\.c$')
+# With -fsanitize=undefined a report fails the test instead of only being printed
+export UBSAN_OPTIONS="${UBSAN_OPTIONS:-halt_on_error=1:print_stacktrace=1}"
+status=0
+
+for test in tests/test_*.c; do
+    name=$(basename "$test" .c)
+    if ! gcc -std=gnu11 -O2 -g -Wall "$@" -o "$build/$name" "$test" $sources -lm -lpthread; then
+        echo "$name: build failed"
+        status=1
+        continue
+    fi
+    mkdir -p "$build/$name.run/data"
+    if ! (cd "$build/$name.run" && "$build/$name"); then
+        status=1
+    fi
+done
+
+rm -rf "$build"
+[ $status -eq 0 ] && echo "all tests passed"
+exit $status
@@ -0,0 +1,156 @@
+// Sales archive: old sales moved to archive runs over several saves come back through every
+// reload with nothing lost (the export lists the same sales), an archived VIN is found in its
+// run and no longer in memory, and a showroom with ARCHIVE_COMPACT_RUNS runs ends up with one.
+// Runs sit next to the snapshot segments, so the first save, which makes the snapshot, archives
+// nothing and every save after it adds a run.
+#include <dirent.h>
+#include "phases.h"
+#include "../archive.h"
+#include "../snapshot.h"
+
+#define OLD_SALES_PER_RUN 300   // More than two blocks per run
+
+static int round_number;        // Set before each phase is started
+
+static int compare_lines(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// Archived sales follow the live ones in the export, so only the set of lines is compared
+static void check_same_lines(const char* expected_dir, const char* actual_dir) {
+    for (int i = 0; i < TEXT_FILE_COUNT; i++) {
+        const char* dirs[2] = {expected_dir, actual_dir};
+        char* data[2];
+        char** lines[2];
+        int counts[2] = {0, 0};
+        for (int d = 0; d < 2; d++) {
+            char path[256];
+            size_t size = 0;
+            snprintf(path, sizeof(path), "%s/%s", dirs[d], text_files[i]);
+            data[d] = read_file(path, &size);
+            CHECK(data[d], "read %s", path);
+            data[d][size] = '\0';
+            lines[d] = (char**)malloc((size + 1) * sizeof(char*));
+            for (char* line = strtok(data[d], "\n"); line; line = strtok(NULL, "\n")) lines[d][counts[d]++] = line;
+            qsort(lines[d], counts[d], sizeof(char*), compare_lines);
+        }
+        int same = counts[0] == counts[1];
+        for (int l = 0; same && l < counts[0]; l++) same = strcmp(lines[0][l], lines[1][l]) == 0;
+        for (int d = 0; d < 2; d++) {
+            free(lines[d]);
+            free(data[d]);
+        }
+        CHECK(same, "%s lists other lines in %s than in %s", text_files[i], actual_dir, expected_dir);
+    }
+}
+
+static int archive_files(int showroom_id) {
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "%d-archive-", showroom_id);
+    DIR* dir = opendir(SNAPSHOT_FILE SNAPSHOT_SEGMENT_DIR_SUFFIX);
+    if (!dir) return -1;
+    int count = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, prefix, strlen(prefix)) == 0) count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+static void count_sale(const ArchivedSale* sale, void* user_data) {
+    (void)sale;
+    (*(int*)user_data)++;
+}
+
+static Showroom* find_showroom(int id) {
+    Showroom temp;
+    temp.id = id;
+    return (Showroom*)bplusSearch(showroom_tree, &temp);
+}
+
+// The first round's first sale: archived by the second save, in a run from then on
+static void check_first_sale_archived() {
+    Showroom* showroom = find_showroom(1);
+    CHECK(showroom, "showroom 1");
+    SoldCar temp;
+    snprintf(temp.VIN, sizeof(temp.VIN), "OLD0R0000");
+    CHECK(!bplusSearch(showroom->sold_cars, &temp), "an archived sale is not kept in memory");
+    int found = 0;
+    CHECK(archive_find_sale(showroom, "OLD0R0000", count_sale, &found) && found == 1, "the archive finds the sale");
+}
+
+// Load, check nothing was lost, then add a run's worth of old sales and one of today, and save
+static void phase_add_round() {
+    load_all_data();
+    if (round_number > 0) {
+        dump_state("loaded");
+        check_same_lines("expected", "loaded");
+        if (round_number > 1) check_first_sale_archived();
+    } else {
+        CHECK(perform_add_showroom(1, "North Wheels", "Pune", "9000000001"), "add showroom 1");
+        CHECK(perform_recruit(1, 11, "Asha Rao", 500), "recruit 11");
+        CHECK(perform_recruit(1, 12, "Ravi Das", 500), "recruit 12");
+    }
+    if (failures) return;
+
+    for (int i = 0; i <= OLD_SALES_PER_RUN; i++) {
+        char vin[MAX_VIN_LEN], mobile[16];
+        if (i < OLD_SALES_PER_RUN) {
+            snprintf(vin, sizeof(vin), "OLD%dR%04d", round_number, i);
+        } else {
+            snprintf(vin, sizeof(vin), "NEW%d", round_number);
+        }
+        snprintf(mobile, sizeof(mobile), "98%02d%06d", round_number, i);
+        stock(1, vin, i % 3 ? "Sedan X" : "Hatch Y", 15 + i % 30);
+        int two_years_ago = today_days() - 730 + round_number * 7 + i % 5;
+        sell(1, 11 + i % 2, vin, i % 2 ? PAYMENT_LOAN : PAYMENT_CASH, mobile,
+             i < OLD_SALES_PER_RUN ? two_years_ago : 0);
+        if (failures) return;
+    }
+    dump_state("expected");
+    save_all_data();
+}
+
+// The last round's save queued the compaction; this run lets it finish and saves the result
+static void phase_compact() {
+    load_all_data();
+    dump_state("loaded");
+    check_same_lines("expected", "loaded");
+    Showroom* showroom = find_showroom(1);
+    CHECK(showroom && showroom->archive_run_count == ARCHIVE_COMPACT_RUNS, "%d runs before the compaction",
+          showroom ? showroom->archive_run_count : -1);
+    save_all_data();
+    archive_stop_compaction();
+    save_all_data();
+}
+
+static void phase_load_compacted() {
+    load_all_data();
+    Showroom* showroom = find_showroom(1);
+    CHECK(showroom && showroom->archive_run_count == 1, "one run after the compaction");
+    CHECK(archive_files(1) == 1, "one run file after the compaction, not %d", archive_files(1));
+    dump_state("loaded");
+    check_same_lines("expected", "loaded");
+    check_first_sale_archived();
+    int archived = 0;
+    int old_sales = (ARCHIVE_COMPACT_RUNS + 1) * OLD_SALES_PER_RUN;
+    CHECK(archive_scan(find_showroom(1), count_sale, &archived) == old_sales && archived == old_sales,
+          "every old sale is in the run (%d of %d)", archived, old_sales);
+}
+
+int main() {
+    setenv(ARCHIVE_MONTHS_ENV, "1", 1);
+    for (round_number = 0; !failures && round_number <= ARCHIVE_COMPACT_RUNS; round_number++) {
+        run_phase("add a round of sales", phase_add_round);
+    }
+    if (!failures) run_phase("compact", phase_compact);
+    if (!failures) run_phase("load the compacted archive", phase_load_compacted);
+
+    if (failures) {
+        printf("test_archive: %d failure(s)\n", failures);
+        return 1;
+    }
+    printf("test_archive: ok\n");
+    return 0;
+}
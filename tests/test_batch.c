@@ -0,0 +1,91 @@
+// Batch commands: a line with a missing field, a field of the wrong kind, a VIN too long to
+// store or an unknown command is rejected before anything runs, leaving the state and the
+// journal as they were; valid lines run and are journaled like the menu's commands.
+#include "phases.h"
+#include "../batch.h"
+#include "../journal.h"
+
+static long file_size(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+// batch_execute() with what it prints in output
+static int execute(const char* line, char* output, size_t output_size) {
+    FILE* stream = fmemopen(output, output_size, "w");
+    if (!stream) return -2;
+    set_command_output(stream);
+    int result = batch_execute(line, strlen(line));
+    set_command_output(NULL);
+    fclose(stream);
+    output[output_size - 1] = '\0';
+    return result;
+}
+
+static const char* invalid_lines[] = {
+    "stock|1|NEW00001|Sedan X|Red|10|Petrol",                                   // Car type missing
+    "purchase|1|11|KEEP0001|Cash|0|0|Meera Iyer|9811111111|12 Lake Road",      // Registration missing
+    "recruit|1|twelve|Ravi Das|40",                                             // Id is not a number
+    "stock|1|NEW00001ABCDEFGHIJ|Sedan X|Red|10|Petrol|Sedan",                   // VIN of 19 characters
+    "find|",                                                                    // Empty VIN
+    "sell|1|11|KEEP0001",                                                       // No such command
+    "stock|1|NEW00001|Sedan X|Red|10|Petrol|Sedan\nrecruit|1|12|Ravi Das|40",   // Two commands
+    "showroom|3|East Wheels|Kolkata|9000000003|extra"                           // A field too many
+};
+#define INVALID_LINE_COUNT ((int)(sizeof(invalid_lines) / sizeof(invalid_lines[0])))
+
+static void phase_setup() {
+    load_all_data();
+    CHECK(perform_add_showroom(1, "North Wheels", "Pune", "9000000001"), "add showroom 1");
+    CHECK(perform_recruit(1, 11, "Asha Rao", 50), "recruit 11");
+    stock(1, "KEEP0001", "Sedan X", 12.25);
+    save_all_data();
+    dump_state("before");
+}
+
+static void phase_run_lines() {
+    char output[1024];
+    load_all_data();
+    long journal_size = file_size(JOURNAL_FILE);
+    for (int i = 0; i < INVALID_LINE_COUNT; i++) {
+        CHECK(execute(invalid_lines[i], output, sizeof(output)) == BATCH_INVALID, "line %d is rejected", i);
+        CHECK(output[0] != '\0', "line %d says why it is rejected", i);
+    }
+    CHECK(file_size(JOURNAL_FILE) == journal_size, "rejected lines journal nothing");
+    dump_state("after_invalid");
+    check_same_state("before", "after_invalid");
+    if (failures) return;
+
+    // A valid line that the command refuses also changes nothing
+    CHECK(execute("stock|9|NEW00001|Sedan X|Red|10|Petrol|Sedan", output, sizeof(output)) == BATCH_FAILED,
+          "stock for a showroom that does not exist fails");
+    CHECK(file_size(JOURNAL_FILE) == journal_size, "a failed command journals nothing");
+
+    CHECK(execute("stock|1|NEW00001|Sedan X|Red|10|Petrol|Sedan", output, sizeof(output)) == BATCH_OK, "stock");
+    CHECK(execute("recruit|1|12|Ravi Das|40", output, sizeof(output)) == BATCH_OK, "recruit");
+    CHECK(execute("purchase|1|12|NEW00001|Loan|2|60|Meera Iyer|9811111111|12 Lake Road|MH01AB1|15/3/2025",
+                  output, sizeof(output)) == BATCH_OK, "purchase");
+    CHECK(execute("find|NEW00001", output, sizeof(output)) == BATCH_OK && strstr(output, "NEW00001"),
+          "find prints the car");
+    CHECK(file_size(JOURNAL_FILE) > journal_size, "the commands are journaled");
+    dump_state("expected");
+}
+
+static void phase_recover() {
+    load_all_data();
+    dump_state("recovered");
+    check_same_state("expected", "recovered");
+}
+
+int main() {
+    run_phase("set up a showroom", phase_setup);
+    if (!failures) run_phase("run invalid and valid lines, then crash", phase_run_lines);
+    if (!failures) run_phase("recover the valid lines", phase_recover);
+
+    if (failures) {
+        printf("test_batch: %d failure(s)\n", failures);
+        return 1;
+    }
+    printf("test_batch: ok\n");
+    return 0;
+}
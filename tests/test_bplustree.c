@@ -0,0 +1,165 @@
+// B+ tree behaviour: random insert/delete sequences checked against a reference set, with the
+// node fill, separator order, leaf depth and leaf chain verified after every change.
+#include <stdio.h>
+#include <stdlib.h>
+#include "../b+treetemplate.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+        return; \
+    } \
+} while (0)
+
+static int compare_int(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static void print_int(const void* key) { printf("%d ", *(const int*)key); }
+
+static void* clone_int(const void* key) {
+    int* copy = (int*)malloc(sizeof(int));
+    *copy = *(const int*)key;
+    return copy;
+}
+
+static void free_int(void* key) { free(key); }
+
+static BPlusTree* new_tree() {
+    return createBPlusTree(compare_int, print_int, clone_int, free_int);
+}
+
+// Depth of the leaves under node, -1 if they differ or a node breaks an invariant
+static int check_node(BTreeNode* node, int is_root, const int* low, const int* high) {
+    int min_keys = node->is_leaf ? MAX / 2 : (MAX - 1) / 2;
+    if (!is_root && node->num_keys < min_keys) return -1;
+    if (node->num_keys < (is_root && node->is_leaf ? 1 : 0) || node->num_keys > MAX - (node->is_leaf ? 0 : 1)) return -1;
+    for (int i = 0; i < node->num_keys; i++) {
+        int key = *(int*)node->keys[i].key;
+        if (i > 0 && key <= *(int*)node->keys[i - 1].key) return -1;
+        if (low && key < *low) return -1;
+        if (high && key >= *high) return -1;
+    }
+    if (node->is_leaf) return 0;
+
+    int depth = -2;
+    for (int i = 0; i <= node->num_keys; i++) {
+        const int* child_low = i > 0 ? (int*)node->keys[i - 1].key : low;
+        const int* child_high = i < node->num_keys ? (int*)node->keys[i].key : high;
+        int child_depth = check_node(node->children[i], 0, child_low, child_high);
+        if (child_depth < 0 || (depth != -2 && child_depth != depth)) return -1;
+        depth = child_depth;
+    }
+    return depth + 1;
+}
+
+// The tree holds exactly the keys with present[key] set, in order along the leaf chain
+static void check_tree(BPlusTree* tree, const char* present, int range, int step) {
+    int expected = 0;
+    for (int i = 0; i < range; i++) expected += present[i];
+    if (expected == 0) {
+        CHECK(tree->root == NULL || tree->root->num_keys == 0, "step %d: empty tree keeps keys", step);
+        return;
+    }
+    CHECK(tree->root != NULL, "step %d: tree lost its root", step);
+    CHECK(check_node(tree->root, 1, NULL, NULL) >= 0, "step %d: node invariant broken", step);
+
+    BTreeNode* leaf = tree->root;
+    while (!leaf->is_leaf) leaf = leaf->children[0];
+    CHECK(leaf->leaf_link.prev == NULL, "step %d: first leaf has a previous leaf", step);
+
+    int count = 0, last = -1;
+    BTreeNode* previous = NULL;
+    for (; leaf; previous = leaf, leaf = leaf->leaf_link.next) {
+        CHECK(leaf->leaf_link.prev == previous, "step %d: broken prev link", step);
+        for (int i = 0; i < leaf->num_keys; i++) {
+            int key = *(int*)leaf->keys[i].key;
+            CHECK(key > last, "step %d: leaf chain out of order at %d", step, key);
+            CHECK(key >= 0 && key < range && present[key], "step %d: unexpected key %d", step, key);
+            last = key;
+            count++;
+        }
+    }
+    CHECK(count == expected, "step %d: %d keys in leaves, expected %d", step, count, expected);
+
+    for (int key = 0; key < range; key++) {
+        int* found = (int*)bplusSearch(tree, &key);
+        CHECK((found != NULL) == present[key], "step %d: search for %d", step, key);
+        CHECK(!found || *found == key, "step %d: search for %d found %d", step, key, *found);
+    }
+}
+
+static void test_random_insert_delete(unsigned seed, int range, int steps) {
+    BPlusTree* tree = new_tree();
+    char* present = (char*)calloc(range, 1);
+    srand(seed);
+
+    int failures_before = failures;
+    for (int step = 0; step < steps && failures == failures_before; step++) {
+        int key = rand() % range;
+        if (present[key] || rand() % 3 == 0) {
+            int removed = bplusDelete(tree, &key);
+            if (removed != present[key]) {
+                printf("FAIL %s:%d: seed %u step %d: delete %d returned %d\n", __FILE__, __LINE__, seed, step, key, removed);
+                failures++;
+                break;
+            }
+            present[key] = 0;
+        } else {
+            bplusInsert(tree, &key);
+            present[key] = 1;
+        }
+        check_tree(tree, present, range, step);
+    }
+
+    freeBPlusTree(tree);
+    free(present);
+}
+
+// Ascending and descending drains exercise borrowing from each side and merging to an empty root
+static void test_drain(int count, int descending) {
+    BPlusTree* tree = new_tree();
+    char* present = (char*)calloc(count, 1);
+    for (int key = 0; key < count; key++) {
+        bplusInsert(tree, &key);
+        present[key] = 1;
+    }
+    check_tree(tree, present, count, -1);
+
+    int failures_before = failures;
+    for (int i = 0; i < count && failures == failures_before; i++) {
+        int key = descending ? count - 1 - i : i;
+        if (!bplusDelete(tree, &key)) {
+            printf("FAIL %s:%d: drain could not delete %d\n", __FILE__, __LINE__, key);
+            failures++;
+            break;
+        }
+        present[key] = 0;
+        check_tree(tree, present, count, i);
+    }
+
+    freeBPlusTree(tree);
+    free(present);
+}
+
+int main() {
+    for (unsigned seed = 1; seed <= 20; seed++) {
+        test_random_insert_delete(seed, 64, 2000);
+    }
+    test_random_insert_delete(99, 2000, 20000);
+    test_drain(500, 0);
+    test_drain(500, 1);
+
+    if (failures) {
+        printf("test_bplustree: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_bplustree: ok\n");
+    return 0;
+}
@@ -0,0 +1,153 @@
+// Inventory snapshot kernels: every kernel is checked against a plain loop over the same columns,
+// at row counts around the vector widths, and a column with more distinct values than its ids
+// can hold must fail the rebuild instead of sharing ids.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../essentialfunction.h"
+#include "../inventorysnapshot.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+        return; \
+    } \
+} while (0)
+
+static const char* fuels[] = {"Petrol", "Diesel", "Electric"};
+static const char* types[] = {"SUV", "Sedan", "Hatchback", "MUV"};
+
+static Showroom* find_showroom(int id) {
+    Showroom temp;
+    temp.id = id;
+    return (Showroom*)bplusSearch(showroom_tree, &temp);
+}
+
+static void stock(int showroom_id, int serial, const char* model, double price) {
+    Car car;
+    memset(&car, 0, sizeof(Car));
+    snprintf(car.VIN, sizeof(car.VIN), "VIN%08d", serial);
+    snprintf(car.name, sizeof(car.name), "%s", model);
+    snprintf(car.color, sizeof(car.color), "Red");
+    snprintf(car.fuel_type, sizeof(car.fuel_type), "%s", fuels[serial % 3]);
+    snprintf(car.car_type, sizeof(car.car_type), "%s", types[(serial / 3) % 4]);
+    car.price = price;
+    perform_add_stock(showroom_id, &car);
+}
+
+// The columns against the kernels, for every id of `ids`
+static void check_kernels(const InventorySnapshot* snap, const uint16_t* ids, int groups) {
+    double thresholds[] = {-1, 0, 5.25, 10, 12.5, 1e9};
+    for (int t = 0; t < 6; t++) {
+        int expected = 0;
+        for (int i = 0; i < snap->count; i++) expected += snap->price[i] < thresholds[t];
+        int got = inventory_count_price_below(snap, thresholds[t]);
+        CHECK(got == expected, "count below %.2f over %d rows: %d, expected %d", thresholds[t], snap->count, got, expected);
+    }
+
+    double sums[64];
+    int counts[64];
+    CHECK(groups < 64, "%d groups", groups);
+    inventory_group_price_by(snap, ids, groups, sums, counts);
+    for (int g = 0; g <= groups; g++) {
+        double expected_sum = 0;
+        int expected_count = 0;
+        for (int i = 0; i < snap->count; i++) {
+            if (ids[i] == g) {
+                expected_sum += snap->price[i];
+                expected_count++;
+            }
+        }
+        int matched;
+        double sum = inventory_sum_price_where(snap, ids, (uint16_t)g, &matched);
+        CHECK(sum == expected_sum && matched == expected_count, "sum where id %d over %d rows: %.2f/%d, expected %.2f/%d",
+              g, snap->count, sum, matched, expected_sum, expected_count);
+        CHECK(g == groups || (sums[g] == expected_sum && counts[g] == expected_count), "group %d of %d over %d rows: %.2f/%d, expected %.2f/%d",
+              g, groups, snap->count, sums[g], counts[g], expected_sum, expected_count);
+    }
+
+    int expected_row = -1;
+    for (int i = 0; i < snap->count; i++) {
+        if (expected_row < 0 || snap->price[i] < snap->price[expected_row]) expected_row = i;
+    }
+    int row = inventory_min_price_row(snap);
+    CHECK(row == expected_row, "cheapest of %d rows: %d, expected %d", snap->count, row, expected_row);
+}
+
+// Prices are multiples of 0.25, so sums are exact in any order of addition
+static void test_kernels_match_loops() {
+    perform_add_showroom(1, "North", "Pune", "9000000001");
+    perform_add_showroom(2, "South", "Chennai", "9000000002");
+    srand(7);
+
+    int serial = 0;
+    for (int rows = 0; rows <= 70; rows++) {
+        if (rows > 0) {
+            char model[32];
+            snprintf(model, sizeof(model), "Model %d", rand() % 12);
+            stock(1 + serial % 2, serial, model, (rand() % 80) * 0.25 + 1);
+            serial++;
+        }
+        InventorySnapshot* snap = inventory_snapshot();
+        CHECK(snap && snap->count == rows, "snapshot of %d rows", rows);
+        check_kernels(snap, snap->fuel_id, snap->fuels.count);
+        check_kernels(snap, snap->model_id, snap->models.count);
+        if (failures) return;
+    }
+
+    // Ties: the first cheapest row wins, wherever the vector pass found it
+    for (int i = 0; i < 2000; i++, serial++) {
+        char model[32];
+        snprintf(model, sizeof(model), "Model %d", i % 40);
+        stock(1 + serial % 2, serial, model, i % 97 == 50 ? 0.5 : (rand() % 400) * 0.25 + 1);
+    }
+    InventorySnapshot* snap = inventory_snapshot();
+    CHECK(snap && snap->count == 2070, "snapshot of 2070 rows");
+    check_kernels(snap, snap->type_id, snap->types.count);
+    check_kernels(snap, snap->model_id, snap->models.count);
+}
+
+// 65537 distinct models do not fit 16-bit ids: the rebuild fails and reports it,
+// and succeeds again once a model is gone
+static void test_dictionary_overflow() {
+    perform_add_showroom(3, "Overflow", "Delhi", "9000000003");
+    Showroom* showroom = find_showroom(3);
+    CHECK(showroom, "showroom 3");
+
+    InventorySnapshot* snap = inventory_snapshot();
+    CHECK(snap, "snapshot before the overflow");
+    int distinct = 65536 - snap->models.count + 1;
+    for (int i = 0; i < distinct; i++) {
+        char model[32];
+        snprintf(model, sizeof(model), "Unique %d", i);
+        stock(3, 1000000 + i, model, 10);
+    }
+    CHECK(inventory_snapshot() == NULL, "a snapshot with %d models", 65536 + 1);
+
+    char vin[MAX_VIN_LEN];
+    snprintf(vin, sizeof(vin), "VIN%08d", 1000000);
+    CHECK(unstock_car(showroom, vin), "unstock %s", vin);
+    snap = inventory_snapshot();
+    CHECK(snap && snap->models.count == 65536, "a snapshot with 65536 models");
+    int matched;
+    inventory_sum_price_where(snap, snap->model_id, 65535, &matched);
+    CHECK(matched == 1, "the last model id is used once, not %d times", matched);
+}
+
+int main() {
+    init_system();
+    test_kernels_match_loops();
+    if (!failures) test_dictionary_overflow();
+    free_inventory_snapshot();
+    if (failures) {
+        printf("test_inventory: %d failure(s)\n", failures);
+        return 1;
+    }
+    printf("test_inventory: ok\n");
+    return 0;
+}
@@ -0,0 +1,118 @@
+// Journal and crash recovery: changes made after a checkpoint and committed are all there after
+// a crash, a torn last record is cut off with everything before it kept, the journal takes new
+// records after the cut, and a checkpoint empties it without losing anything.
+#include "phases.h"
+#include "../journal.h"
+
+static long file_size(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+static int copy_file(const char* from, const char* to, long length) {
+    size_t size = 0;
+    char* data = read_file(from, &size);
+    int ok = data && length <= (long)size && write_file(to, data, length < 0 ? size : (size_t)length);
+    free(data);
+    return ok;
+}
+
+static long checkpoint_size;    // The journal as a checkpoint leaves it
+
+static void phase_checkpoint_base() {
+    load_all_data();
+    CHECK(perform_add_showroom(1, "North Wheels", "Pune", "9000000001"), "add showroom 1");
+    stock(1, "BASE0001", "Sedan X", 12.25);
+    CHECK(perform_recruit(1, 11, "Asha Rao", 50), "recruit 11");
+    save_all_data();
+}
+
+// Every kind of journaled change, committed, then a crash: nothing is saved
+static void phase_change_and_crash() {
+    load_all_data();
+    CHECK(perform_add_showroom(2, "South Wheels", "Chennai", "9000000002"), "add showroom 2");
+    stock(1, "LOAN0001", "Wide Model", 24.5);
+    stock(2, "CASH0001", "Hatch Y", 7.8);
+    stock(2, "KEEP0002", "Hatch Y", 8.1);
+    CHECK(perform_recruit(2, 11, "Ravi Das", 40), "recruit 11 in showroom 2");
+    sell(1, 11, "LOAN0001", PAYMENT_LOAN, "9811111111", 0);
+    sell(2, 11, "CASH0001", PAYMENT_CASH, "9822222222", 0);
+    CHECK(award_best_salesperson_incentive(1), "award the incentive");
+    // Both showrooms have salesperson 11: the merge journals how the conflict was settled
+    CHECK(perform_merge(1, 2, 3, "Central Wheels", "Mumbai", "9000000003", 'm', 1), "merge into showroom 3");
+    if (failures) return;
+    CHECK(journal_commit(), "commit");
+    dump_state("before_last");
+    CHECK(copy_file(JOURNAL_FILE, "before_last.journal", -1), "keep the journal before the last change");
+
+    stock(3, "LAST0001", "Sedan X", 13.5);
+    CHECK(journal_commit(), "commit the last change");
+    dump_state("expected");
+}
+
+static void phase_recover() {
+    load_all_data();
+    dump_state("recovered");
+    check_same_state("expected", "recovered");
+}
+
+// The last record was torn by the crash: replay keeps the ones before it and cuts it off
+static void phase_recover_torn_tail() {
+    load_all_data();
+    dump_state("recovered_torn");
+    check_same_state("before_last", "recovered_torn");
+    long before_last_size = file_size("before_last.journal");
+    CHECK(file_size(JOURNAL_FILE) == before_last_size, "the torn record is cut off (%ld bytes, not %ld)",
+          file_size(JOURNAL_FILE), before_last_size);
+
+    stock(3, "LAST0001", "Sedan X", 13.5);
+    CHECK(journal_commit(), "commit after the cut");
+}
+
+static void phase_recover_after_cut() {
+    load_all_data();
+    dump_state("recovered_again");
+    check_same_state("expected", "recovered_again");
+    save_all_data();
+    CHECK(file_size(JOURNAL_FILE) == checkpoint_size, "the checkpoint empties the journal");
+}
+
+static void phase_load_checkpoint() {
+    load_all_data();
+    dump_state("checkpointed");
+    check_same_state("expected", "checkpointed");
+}
+
+int main() {
+    run_phase("checkpoint a base state", phase_checkpoint_base);
+    checkpoint_size = file_size(JOURNAL_FILE);
+    if (!failures && checkpoint_size <= 0) {
+        printf("FAIL the checkpoint left no journal\n");
+        failures++;
+    }
+    if (!failures) run_phase("change and crash", phase_change_and_crash);
+    long crashed_size = file_size(JOURNAL_FILE);
+    if (!failures && !copy_file(JOURNAL_FILE, "crashed.journal", -1)) {
+        printf("FAIL keep the crashed journal\n");
+        failures++;
+    }
+    if (!failures) run_phase("recover", phase_recover);
+
+    // The same crash, but halfway through writing the last record
+    long before_last_size = file_size("before_last.journal");
+    if (!failures && !(before_last_size > checkpoint_size && before_last_size < crashed_size &&
+                       copy_file("crashed.journal", JOURNAL_FILE, (before_last_size + crashed_size) / 2))) {
+        printf("FAIL tear the last record\n");
+        failures++;
+    }
+    if (!failures) run_phase("recover from a torn record", phase_recover_torn_tail);
+    if (!failures) run_phase("recover after the cut, then checkpoint", phase_recover_after_cut);
+    if (!failures) run_phase("load the checkpoint", phase_load_checkpoint);
+
+    if (failures) {
+        printf("test_journal: %d failure(s)\n", failures);
+        return 1;
+    }
+    printf("test_journal: ok\n");
+    return 0;
+}
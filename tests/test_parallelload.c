@@ -0,0 +1,86 @@
+// Parallel text import: the same text files loaded on one thread and on several give the same
+// state, with more chunks than some files have lines and with an empty cars.txt, and both give
+// back the state the files were exported from.
+#include "phases.h"
+#include "../parallelload.h"
+
+#define SHOWROOMS 12
+#define SALESPERSONS 3
+#define CARS 40
+#define SOLD 15         // Of each showroom's cars
+
+static void phase_make_state() {
+    load_all_data();
+    for (int s = 1; s <= SHOWROOMS; s++) {
+        char name[32], contact[32];
+        snprintf(name, sizeof(name), "Showroom %d", s);
+        snprintf(contact, sizeof(contact), "90000000%02d", s);
+        CHECK(perform_add_showroom(s, name, "Pune", contact), "add showroom %d", s);
+        for (int p = 1; p <= SALESPERSONS; p++) {
+            snprintf(name, sizeof(name), "Seller %d-%d", s, p);
+            CHECK(perform_recruit(s, s * 10 + p, name, 40 + p), "recruit %d", s * 10 + p);
+        }
+        for (int c = 0; c < CARS; c++) {
+            char vin[MAX_VIN_LEN], mobile[32];
+            snprintf(vin, sizeof(vin), "S%02dC%03d", s % 100, c % 1000);
+            stock(s, vin, c % 3 ? "Sedan X" : "Hatch Y", 8 + c % 11);
+            if (c >= SOLD) continue;
+            snprintf(mobile, sizeof(mobile), "98%02d%06d", s, c);
+            sell(s, s * 10 + 1 + c % SALESPERSONS, vin, c % 2 ? PAYMENT_LOAN : PAYMENT_CASH, mobile,
+                 today_days() - c * 9);
+        }
+        if (failures) return;
+    }
+    dump_state("made");
+}
+
+static void phase_load_one_thread() {
+    load_all_data();
+    dump_state("one_thread");
+}
+
+static void phase_load_threads() {
+    load_all_data();
+    dump_state("threads");
+}
+
+// The files in data/ loaded with SHOWROOM_LOAD_THREADS=1 and =8 must give the same state
+static void compare_thread_counts() {
+    setenv(PARALLEL_LOAD_THREADS_ENV, "1", 1);
+    run_phase("load on one thread", phase_load_one_thread);
+    remove(JOURNAL_FILE);
+    if (!failures) copy_text_files("one_thread");
+    setenv(PARALLEL_LOAD_THREADS_ENV, "8", 1);
+    if (!failures) run_phase("load on eight threads", phase_load_threads);
+    remove(JOURNAL_FILE);
+    if (!failures) check_same_state("one_thread", "threads");
+}
+
+static void empty_cars_file() {
+    FILE* cars = fopen("data/cars.txt", "w");
+    CHECK(cars && fclose(cars) == 0, "empty data/cars.txt");
+}
+
+int main() {
+    run_phase("make the state", phase_make_state);
+    remove(JOURNAL_FILE);
+    if (!failures) {
+        copy_text_files("made");
+        compare_thread_counts();
+    }
+    if (!failures) check_same_state("made", "threads");
+
+    // No car in stock: cars.txt has no lines for any chunk
+    if (!failures) {
+        copy_text_files("made");
+        empty_cars_file();
+        if (!failures) compare_thread_counts();
+    }
+
+    if (failures) {
+        printf("test_parallelload: %d failure(s)\n", failures);
+        return 1;
+    }
+    printf("test_parallelload: ok\n");
+    return 0;
+}
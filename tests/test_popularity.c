@@ -0,0 +1,136 @@
+// Popularity window: a day that falls out of the window is dropped and its ring slot reused
+// by the day that replaced it, sales older than the window or before day 0 are not counted,
+// and customers.txt rows dated before 1970 or on impossible dates are refused at load
+// instead of reaching the window.
+#include "phases.h"
+#include "../popularitywindow.h"
+
+#define MODEL_A 1
+#define MODEL_B 2
+#define START_DAY 20000
+
+static int top_count(PopularityWindow* window, int end_day, int model_id) {
+    HeavyHitter top[POPULARITY_SKETCH_SIZE];
+    int found = popularity_window_top(window, end_day, POPULARITY_SKETCH_SIZE, top);
+    for (int i = 0; i < found; i++) {
+        if (top[i].model_id == model_id) return top[i].count;
+    }
+    return 0;
+}
+
+static void check_window() {
+    Showroom showroom;
+    memset(&showroom, 0, sizeof(showroom));
+    record_showroom_model_sale(&showroom, MODEL_A, START_DAY);
+    record_showroom_model_sale(&showroom, MODEL_A, START_DAY);
+    record_showroom_model_sale(&showroom, MODEL_B, START_DAY + 1);
+    PopularityWindow* window = showroom.popularity_window;
+    CHECK(window, "the first sale makes the window");
+    CHECK(top_count(window, START_DAY + 1, MODEL_A) == 2, "two sales of A in the window");
+
+    // Same ring slot as START_DAY, which is now out of the window
+    int later = START_DAY + POPULARITY_WINDOW_DAYS;
+    record_showroom_model_sale(&showroom, MODEL_B, later);
+    CHECK(window->days[later % POPULARITY_WINDOW_DAYS].day == later, "the expired day's slot is reused");
+    CHECK(top_count(window, later, MODEL_A) == 0, "the expired day is not counted");
+    CHECK(top_count(window, later, MODEL_B) == 2, "both sales of B are in the window");
+
+    record_showroom_model_sale(&showroom, MODEL_A, START_DAY);
+    record_showroom_model_sale(&showroom, MODEL_A, -1);
+    record_showroom_model_sale(&showroom, MODEL_A, date_to_days(15, 3, 1969));
+    CHECK(window->latest_day == later, "old sales do not move the window");
+    CHECK(top_count(window, later, MODEL_A) == 0, "sales older than the window are not counted");
+    free_popularity_window(window);
+
+    // A window whose first sale is before day 0 stays empty
+    memset(&showroom, 0, sizeof(showroom));
+    record_showroom_model_sale(&showroom, MODEL_A, date_to_days(0, 0, 0));
+    CHECK(showroom.popularity_window && showroom.popularity_window->latest_day == -1, "a day before 0 is not kept");
+    free_popularity_window(showroom.popularity_window);
+}
+
+static void check_valid_dates() {
+    CHECK(valid_date(1, 1, 1970) && valid_date(29, 2, 2024) && valid_date(31, 12, 9999), "real dates");
+    CHECK(!valid_date(31, 12, 1969) && !valid_date(15, 3, 1969), "dates before 1970");
+    CHECK(!valid_date(0, 0, 0) && !valid_date(29, 2, 2023) && !valid_date(31, 4, 2025) && !valid_date(1, 13, 2025),
+          "impossible dates");
+}
+
+static void phase_make_sales() {
+    load_all_data();
+    CHECK(perform_add_showroom(1, "North Wheels", "Pune", "9000000001"), "add showroom 1");
+    CHECK(perform_recruit(1, 11, "Asha Rao", 50), "recruit 11");
+    stock(1, "OLD00001", "Sedan X", 12.25);
+    stock(1, "ZERO0001", "Sedan X", 12.5);
+    stock(1, "NEW00001", "Hatch Y", 7.8);
+    sell(1, 11, "OLD00001", PAYMENT_CASH, "9811111111", 0);
+    sell(1, 11, "ZERO0001", PAYMENT_CASH, "9822222222", 0);
+    sell(1, 11, "NEW00001", PAYMENT_CASH, "9833333333", 0);
+    dump_state("made");
+}
+
+// The text files as made, with two of the customers redated
+static void write_redated_text_files() {
+    for (int i = 0; i < TEXT_FILE_COUNT; i++) {
+        char path[256];
+        size_t size = 0;
+        snprintf(path, sizeof(path), "made/%s", text_files[i]);
+        char* data = read_file(path, &size);
+        CHECK(data, "read %s", path);
+        char* copy = (char*)malloc(size + 64);
+        size_t kept = 0;
+        data[size] = '\0';
+        for (char* line = strtok(data, "\n"); line; line = strtok(NULL, "\n")) {
+            const char* date = strstr(line, "|OLD00001|") ? "15|3|1969" : strstr(line, "|ZERO0001|") ? "0|0|0" : NULL;
+            if (strcmp(text_files[i], "customers.txt") != 0 || !date) {
+                kept += (size_t)sprintf(copy + kept, "%s\n", line);
+                continue;
+            }
+            // sp|name|mobile|address|VIN|reg|paid|day|month|year|loan_months
+            char* field = line;
+            for (int f = 0; field && f < 7; f++) field = strchr(field + 1, '|');
+            char* loan = field ? strrchr(line, '|') : NULL;
+            CHECK(loan && loan > field, "customer line %s", line);
+            kept += (size_t)sprintf(copy + kept, "%.*s|%s%s\n", (int)(field - line), line, date, loan);
+        }
+        snprintf(path, sizeof(path), "data/%s", text_files[i]);
+        CHECK(write_file(path, copy, kept), "write %s", path);
+        free(copy);
+        free(data);
+    }
+}
+
+static void phase_load_redated() {
+    load_all_data();
+    PopularityWindow* national = national_popularity_window();
+    int today = today_days();
+    CHECK(national && top_count(national, today, intern_car_model("Hatch Y")) == 1, "the valid sale is counted");
+    CHECK(top_count(national, today, intern_car_model("Sedan X")) == 0, "the refused customers are not counted");
+    dump_state("loaded");
+    size_t size = 0;
+    char* customers = read_file("loaded/customers.txt", &size);
+    CHECK(customers, "read the loaded customers");
+    customers[size] = '\0';
+    int refused = !strstr(customers, "OLD00001") && !strstr(customers, "ZERO0001");
+    int kept = strstr(customers, "NEW00001") != NULL;
+    free(customers);
+    CHECK(refused && kept, "customers dated before 1970 or on 0/0/0 are refused, the others kept");
+}
+
+int main() {
+    check_window();
+    check_valid_dates();
+    if (!failures) run_phase("make sales", phase_make_sales);
+    if (!failures) {
+        remove(JOURNAL_FILE);
+        write_redated_text_files();
+    }
+    if (!failures) run_phase("load customers with bad dates", phase_load_redated);
+
+    if (failures) {
+        printf("test_popularity: %d failure(s)\n", failures);
+        return 1;
+    }
+    printf("test_popularity: ok\n");
+    return 0;
+}
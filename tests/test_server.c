@@ -0,0 +1,131 @@
+// Server: a request sent with send_frame() is answered with the status and the output that
+// batch_execute() gives for the same line, for queries, a refused command and a malformed
+// line; a change made through the server is in the state, and a connection takes several
+// requests in turn.
+#include <pthread.h>
+#include <signal.h>
+#include "phases.h"
+#include "../batch.h"
+#include "../server.h"
+
+#define SOCKET_PATH "server.sock"
+#define OUTPUT_SIZE 65536
+
+static const char* compared_lines[] = {
+    "showrooms",
+    "inventory|1",
+    "find|KEEP0001",
+    "leaderboard|1|3",
+    "inventory|99",                         // Runs and fails
+    "recruit|1|12|Ravi Das",                // Target missing: a bad request
+    "stock|1|LONGVIN0001ABCDEFGH|Sedan X|Red|10|Petrol|Sedan"
+};
+#define COMPARED_LINE_COUNT ((int)(sizeof(compared_lines) / sizeof(compared_lines[0])))
+
+static char in_process[OUTPUT_SIZE];
+
+// batch_execute() in this process, as the status a server reply carries
+static int execute(const char* line) {
+    FILE* stream = fmemopen(in_process, sizeof(in_process), "w");
+    if (!stream) return -1;
+    set_command_output(stream);
+    int result = batch_execute(line, strlen(line));
+    set_command_output(NULL);
+    fclose(stream);
+    in_process[sizeof(in_process) - 1] = '\0';
+    return result == BATCH_OK ? SERVER_OK : result == BATCH_FAILED ? SERVER_FAILED : SERVER_BAD_REQUEST;
+}
+
+// One round trip; the reply's status, -1 if the connection failed. *output is malloc'd.
+static int request(int fd, const char* line, char** output) {
+    char* reply = NULL;
+    uint32_t size = 0;
+    *output = NULL;
+    if (!send_frame(fd, line, strlen(line), NULL, 0) || !receive_frame(fd, &reply, &size, SERVER_MAX_REPLY)) return -1;
+    if (size == 0) {
+        free(reply);
+        return -1;
+    }
+    int status = (unsigned char)reply[0];
+    *output = (char*)malloc(size);
+    if (*output) memcpy(*output, reply + 1, size);     // The output and its terminator
+    free(reply);
+    return status;
+}
+
+static void* serve(void* arg) {
+    (void)arg;
+    server_run(SOCKET_PATH);
+    return NULL;
+}
+
+static int connect_when_listening() {
+    for (int attempt = 0; attempt < 500; attempt++) {
+        int fd = connect_to_server(SOCKET_PATH);
+        if (fd >= 0) return fd;
+        usleep(10000);
+    }
+    return -1;
+}
+
+static void check_round_trips(int fd, const char* vin) {
+    for (int i = 0; i < COMPARED_LINE_COUNT; i++) {
+        char* output;
+        int status = request(fd, compared_lines[i], &output);
+        int expected = execute(compared_lines[i]);
+        int same = status == expected && output && strcmp(output, in_process) == 0;
+        free(output);
+        CHECK(same, "%s: status %d, expected %d, and the same output as batch_execute", compared_lines[i],
+              status, expected);
+    }
+
+    // A change made through the server is there for the next request and for this process
+    char line[128];
+    char* output;
+    snprintf(line, sizeof(line), "stock|1|%s|Hatch Y|Blue|7.5|Petrol|Hatchback", vin);
+    int status = request(fd, line, &output);
+    free(output);
+    CHECK(status == SERVER_OK, "stock %s through the server", vin);
+    snprintf(line, sizeof(line), "find|%s", vin);
+    status = request(fd, line, &output);
+    int found = status == SERVER_OK && output && strstr(output, vin);
+    free(output);
+    CHECK(found, "the server finds %s", vin);
+    CHECK(execute(line) == SERVER_OK, "%s is in the state", vin);
+}
+
+static void phase_serve() {
+    load_all_data();
+    CHECK(perform_add_showroom(1, "North Wheels", "Pune", "9000000001"), "add showroom 1");
+    CHECK(perform_recruit(1, 11, "Asha Rao", 50), "recruit 11");
+    stock(1, "KEEP0001", "Sedan X", 12.25);
+    if (failures) return;
+
+    pthread_t server;
+    CHECK(pthread_create(&server, NULL, serve, NULL) == 0, "start the server");
+    int first = connect_when_listening();
+    int second = connect_when_listening();
+    if (first >= 0 && second >= 0) {
+        check_round_trips(first, "SERVED01");
+        if (!failures) check_round_trips(second, "SERVED02");
+    } else {
+        printf("FAIL nothing listens on %s\n", SOCKET_PATH);
+        failures++;
+    }
+    if (first >= 0) close(first);
+    if (second >= 0) close(second);
+
+    kill(getpid(), SIGTERM);
+    pthread_join(server, NULL);
+}
+
+int main() {
+    run_phase("serve requests", phase_serve);
+
+    if (failures) {
+        printf("test_server: %d failure(s)\n", failures);
+        return 1;
+    }
+    printf("test_server: ok\n");
+    return 0;
+}
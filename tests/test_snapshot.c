@@ -0,0 +1,153 @@
+// Snapshot and text formats: a state saved and loaded again in a fresh process exports the same
+// text files, sales of models whose ids do not fit 16 bits included, and the text export imports
+// back to the same state. A damaged manifest is refused as a whole, a damaged segment only
+// empties the showroom it belongs to.
+#include <dirent.h>
+#include "phases.h"
+#include "../snapshot.h"
+
+#define WIDE_MODEL_IDS 33000    // Models interned before the sale, past the old 16-bit id
+
+static Showroom* find_showroom(int id) {
+    Showroom temp;
+    temp.id = id;
+    return (Showroom*)bplusSearch(showroom_tree, &temp);
+}
+
+static void* find_by_vin(BPlusTree* tree, const char* vin) {
+    SoldCar temp;       // Cars and sales both start with the VIN
+    memset(&temp, 0, sizeof(temp));
+    snprintf(temp.VIN, sizeof(temp.VIN), "%s", vin);
+    return tree ? bplusSearch(tree, &temp) : NULL;
+}
+
+// Flip a byte of the first section's records: past the 32-byte file header and the 24-byte
+// section header (headers have padding no check covers)
+#define DAMAGED_BYTE 64
+
+static void damage_file(const char* path) {
+    size_t size = 0;
+    char* data = read_file(path, &size);
+    CHECK(data && size > DAMAGED_BYTE, "read %s", path);
+    data[DAMAGED_BYTE] ^= 0x5a;
+    CHECK(write_file(path, data, size), "write %s", path);
+    free(data);
+}
+
+static void damage_segment(int showroom_id, const char* table) {
+    char prefix[32], path[512];
+    snprintf(prefix, sizeof(prefix), "%d-%s-", showroom_id, table);
+    DIR* dir = opendir(SNAPSHOT_FILE SNAPSHOT_SEGMENT_DIR_SUFFIX);
+    CHECK(dir, "open the segment directory");
+    struct dirent* entry;
+    path[0] = '\0';
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, prefix, strlen(prefix)) == 0) {
+            snprintf(path, sizeof(path), "%s/%s", SNAPSHOT_FILE SNAPSHOT_SEGMENT_DIR_SUFFIX, entry->d_name);
+        }
+    }
+    closedir(dir);
+    CHECK(path[0], "a %s segment for showroom %d", table, showroom_id);
+    damage_file(path);
+}
+
+// Two showrooms with stock, staff, a loan sale of a model with a wide id and a cash sale
+static void phase_build_and_save() {
+    load_all_data();
+    for (int i = 0; i < WIDE_MODEL_IDS; i++) {
+        char model[32];
+        snprintf(model, sizeof(model), "Filler %d", i);
+        intern_car_model(model);
+    }
+    CHECK(perform_add_showroom(1, "North Wheels", "Pune", "9000000001"), "add showroom 1");
+    CHECK(perform_add_showroom(2, "South Wheels", "Chennai", "9000000002"), "add showroom 2");
+    stock(1, "WIDE0001", "Wide Model", 24.5);
+    stock(1, "KEEP0001", "Sedan X", 12.25);
+    stock(2, "CASH0001", "Hatch Y", 7.8);
+    stock(2, "KEEP0002", "Hatch Y", 8.1);
+    CHECK(perform_recruit(1, 11, "Asha Rao", 50), "recruit 11");
+    CHECK(perform_recruit(2, 21, "Ravi Das", 40), "recruit 21");
+    sell(1, 11, "WIDE0001", PAYMENT_LOAN, "9811111111", 0);
+    sell(2, 21, "CASH0001", PAYMENT_CASH, "9822222222", 0);
+    if (failures) return;
+
+    SoldCar* sale = (SoldCar*)find_by_vin(find_showroom(1)->sold_cars, "WIDE0001");
+    CHECK(sale && sale->model_id >= WIDE_MODEL_IDS, "the sale has a model id past 16 bits");
+    dump_state("expected");
+    save_all_data();
+}
+
+static void phase_load_snapshot() {
+    load_all_data();
+    SoldCar* sale = (SoldCar*)find_by_vin(find_showroom(1)->sold_cars, "WIDE0001");
+    CHECK(sale && sale->model_id == intern_car_model("Wide Model") && sale->model_id >= WIDE_MODEL_IDS,
+          "the sale keeps its model id through the snapshot");
+    dump_state("from_snapshot");
+    check_same_state("expected", "from_snapshot");
+}
+
+// With no snapshot the text files are imported; saving writes a snapshot for the phases after
+static void phase_import_text() {
+    load_all_data();
+    dump_state("from_text");
+    check_same_state("expected", "from_text");
+    save_all_data();
+}
+
+static void phase_damaged_segment() {
+    load_all_data();
+    Showroom* intact = find_showroom(1);
+    CHECK(intact && find_by_vin(intact->available_cars, "KEEP0001"), "showroom 1 keeps its cars");
+    Showroom* damaged = find_showroom(2);
+    CHECK(damaged, "showroom 2 is still listed");
+    CHECK(!find_by_vin(damaged->available_cars, "KEEP0002"), "showroom 2 loads no cars from a damaged segment");
+}
+
+static void phase_damaged_manifest() {
+    uint64_t journal_lsn = 0;
+    CHECK(!load_snapshot(SNAPSHOT_FILE, &journal_lsn), "a damaged manifest is refused");
+    CHECK(!showroom_tree->root || showroom_tree->root->num_keys == 0, "nothing is loaded from it");
+}
+
+static void remove_saved_state() {
+    char path[512];
+    DIR* dir = opendir(SNAPSHOT_FILE SNAPSHOT_SEGMENT_DIR_SUFFIX);
+    struct dirent* entry;
+    while (dir && (entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s/%s", SNAPSHOT_FILE SNAPSHOT_SEGMENT_DIR_SUFFIX, entry->d_name);
+        remove(path);
+    }
+    if (dir) closedir(dir);
+    remove(SNAPSHOT_FILE);
+    remove(JOURNAL_FILE);
+}
+
+int main() {
+    run_phase("build and save", phase_build_and_save);
+    if (!failures) run_phase("load the snapshot", phase_load_snapshot);
+
+    if (!failures) {
+        remove_saved_state();
+        copy_text_files("expected");
+        run_phase("import the text export", phase_import_text);
+    }
+    if (!failures) {
+        for (int i = 0; i < TEXT_FILE_COUNT; i++) {
+            char path[256];
+            snprintf(path, sizeof(path), "data/%s", text_files[i]);
+            remove(path);
+        }
+        damage_segment(2, "cars");
+    }
+    if (!failures) run_phase("load with a damaged segment", phase_damaged_segment);
+    if (!failures) damage_file(SNAPSHOT_FILE);
+    if (!failures) run_phase("load a damaged manifest", phase_damaged_manifest);
+
+    if (failures) {
+        printf("test_snapshot: %d failure(s)\n", failures);
+        return 1;
+    }
+    printf("test_snapshot: ok\n");
+    return 0;
+}
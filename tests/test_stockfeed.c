@@ -0,0 +1,88 @@
+// Stock feed: a CSV feed stocks its valid rows and nothing of the others: malformed rows, a VIN
+// the feed repeats (the first row wins), a VIN already in stock and a showroom that does not
+// exist leave the stock as it was, and the cars added are journaled like cars added by hand.
+#include "phases.h"
+#include "../stockfeed.h"
+#include "../journal.h"
+
+#define FEED_FILE "feed.csv"
+
+static const char feed[] =
+    "showroom_id,VIN,model,color,price,fuel_type,car_type\n"
+    "1,FEED0001,Sedan X,Red,12.5,Petrol,Sedan\n"
+    "2,FEED0002,Hatch Y,Blue,abc,Petrol,Hatchback\n"            // Price is not a number
+    "2,FEED0003,Hatch Y,Blue,7.5,Petrol\n"                      // A field short
+    "2,FEED0001,Other Model,Black,99,Diesel,SUV\n"              // Repeats the first row's VIN
+    "1,KEEP0001,Other Model,Black,99,Diesel,SUV\n"              // Already in stock
+    "9,FEED0004,Hatch Y,Blue,7.5,Petrol,Hatchback\n"            // No showroom 9
+    "2,FEED0005ABCDEFGHIJ,Hatch Y,Blue,7.5,Petrol,Hatchback\n"  // VIN of 18 characters
+    "2,\"FEED0006\",\"Hatch, Y\",Blue,7.25,Petrol,Hatchback\n";
+
+static Showroom* find_showroom(int id) {
+    Showroom temp;
+    temp.id = id;
+    return (Showroom*)bplusSearch(showroom_tree, &temp);
+}
+
+static Car* find_car(int showroom_id, const char* vin) {
+    Showroom* showroom = find_showroom(showroom_id);
+    Car temp;
+    memset(&temp, 0, sizeof(temp));
+    snprintf(temp.VIN, sizeof(temp.VIN), "%s", vin);
+    return showroom && showroom->available_cars ? (Car*)bplusSearch(showroom->available_cars, &temp) : NULL;
+}
+
+static void phase_setup() {
+    load_all_data();
+    CHECK(perform_add_showroom(1, "North Wheels", "Pune", "9000000001"), "add showroom 1");
+    CHECK(perform_add_showroom(2, "South Wheels", "Chennai", "9000000002"), "add showroom 2");
+    stock(1, "KEEP0001", "Sedan X", 12.25);
+    save_all_data();
+}
+
+// Imported, then a crash: the journal must bring the new cars back
+static void phase_import() {
+    load_all_data();
+    CHECK(write_file(FEED_FILE, feed, sizeof(feed) - 1), "write the feed");
+    StockFeedResult result;
+    CHECK(stock_feed_import(FEED_FILE, &result), "import the feed");
+    CHECK(result.rows == 8 && result.added == 2 && result.showrooms == 2, "%d rows, %d added to %d showrooms",
+          result.rows, result.added, result.showrooms);
+    CHECK(result.invalid == 3 && result.repeated == 1 && result.in_stock == 1 && result.no_showroom == 1,
+          "%d invalid, %d repeated, %d in stock, %d without a showroom", result.invalid, result.repeated,
+          result.in_stock, result.no_showroom);
+
+    Car* first = find_car(1, "FEED0001");
+    CHECK(first && strcmp(first->name, "Sedan X") == 0 && first->price == 12.5, "the first row of a VIN wins");
+    CHECK(!find_car(2, "FEED0001"), "the repeated row is not stocked");
+    Car* kept = find_car(1, "KEEP0001");
+    CHECK(kept && strcmp(kept->name, "Sedan X") == 0 && kept->price == 12.25, "a car in stock is left as it was");
+    Car* quoted = find_car(2, "FEED0006");
+    CHECK(quoted && strcmp(quoted->name, "Hatch, Y") == 0 && quoted->price == 7.25, "quoted fields are read whole");
+    CHECK(!find_car(2, "FEED0002") && !find_car(2, "FEED0003") && !find_car(2, "FEED0005ABCDEFGHI"),
+          "malformed rows add nothing");
+    CHECK(find_showroom(1)->total_available_cars == 2 && find_showroom(2)->total_available_cars == 1,
+          "only the cars added are counted");
+    CHECK(journal_commit(), "commit");      // As the command loop does after each command
+    dump_state("expected");
+}
+
+static void phase_recover() {
+    load_all_data();
+    CHECK(!find_showroom(9), "no showroom is made for unknown ids");
+    dump_state("recovered");
+    check_same_state("expected", "recovered");
+}
+
+int main() {
+    run_phase("set up two showrooms", phase_setup);
+    if (!failures) run_phase("import a feed, then crash", phase_import);
+    if (!failures) run_phase("recover the imported cars", phase_recover);
+
+    if (failures) {
+        printf("test_stockfeed: %d failure(s)\n", failures);
+        return 1;
+    }
+    printf("test_stockfeed: ok\n");
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "textreader.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TEXT_READER_USE_SSE2 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+int text_reader_open(TextReader* reader, const char* path) {
+    reader->offset = 0;
+    return map_file(path, &reader->file);
+}
+
+void text_reader_close(TextReader* reader) {
+    unmap_file(&reader->file);
+}
+
+int text_reader_next_line(TextReader* reader, StrView* line) {
+    const char* data = reader->file.data;
+    size_t size = reader->file.size;
+    if (reader->offset >= size) return 0;
+
+    // memchr is vectorized by the C library
+    const char* start = data + reader->offset;
+    const char* newline = (const char*)memchr(start, '\n', size - reader->offset);
+    const char* end = newline ? newline : data + size;
+
+    reader->offset = (size_t)(end - data) + (newline ? 1 : 0);
+    if (end > start && end[-1] == '\r') end--;
+
+    line->data = start;
+    line->length = (size_t)(end - start);
+    return 1;
+}
+
+#ifdef TEXT_READER_USE_SSE2
+static int lowest_set_bit(unsigned int mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+// Split a line at every separator. Empty fields are kept (unlike strtok), so a blank
+// value does not shift the columns after it. Fields past max_fields are dropped.
+int split_fields(StrView line, char separator, StrView* fields, int max_fields) {
+    if (max_fields <= 0) return 0;
+
+    const char* data = line.data;
+    size_t length = line.length;
+    size_t field_start = 0;
+    size_t i = 0;
+    int count = 0;
+
+#ifdef TEXT_READER_USE_SSE2
+    // Sixteen bytes at a time: one compare finds every separator in the block
+    __m128i wanted = _mm_set1_epi8(separator);
+    for (; i + 16 <= length && count < max_fields - 1; i += 16) {
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + i)), wanted));
+        while (mask && count < max_fields - 1) {
+            size_t position = i + lowest_set_bit(mask);
+            fields[count].data = data + field_start;
+            fields[count].length = position - field_start;
+            count++;
+            field_start = position + 1;
+            mask &= mask - 1;
+        }
+    }
+    if (count == max_fields - 1) i = length;    // The last field takes the rest of the line
+#endif
+
+    for (; i < length && count < max_fields - 1; i++) {
+        if (data[i] == separator) {
+            fields[count].data = data + field_start;
+            fields[count].length = i - field_start;
+            count++;
+            field_start = i + 1;
+        }
+    }
+
+    fields[count].data = data + field_start;
+    fields[count].length = length - field_start;
+    return count + 1;
+}
+
+int view_to_int(StrView view) {
+    const char* p = view.data;
+    const char* end = p + view.length;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    long long value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (value < 1000000000000LL) value = value * 10 + (*p - '0');
+        p++;
+    }
+    return (int)(negative ? -value : value);
+}
+
+// Values the text files hold ("4500000.00") are converted with one exact division:
+// both the digits and the power of ten are exact doubles, so the result is correctly
+// rounded, the same as strtod. Anything else (exponents, very long numbers) goes to strtod.
+double view_to_double(StrView view) {
+    static const double powers_of_ten[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* p = view.data;
+    const char* end = p + view.length;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    uint64_t digits = 0;
+    int digit_count = 0;
+    int fraction_digits = 0;
+    int seen_point = 0;
+    for (; p < end; p++) {
+        if (*p >= '0' && *p <= '9') {
+            digits = digits * 10 + (uint64_t)(*p - '0');
+            digit_count++;
+            fraction_digits += seen_point;
+        } else if (*p == '.' && !seen_point) {
+            seen_point = 1;
+        } else {
+            break;
+        }
+    }
+
+    int simple = p == end || (*p != 'e' && *p != 'E');
+    if (simple && digit_count <= 15 && fraction_digits <= 22) {
+        double value = (double)digits / powers_of_ten[fraction_digits];
+        return negative ? -value : value;
+    }
+
+    char buffer[64];
+    view_copy(view, buffer, sizeof(buffer));
+    return strtod(buffer, NULL);
+}
+
+void view_copy(StrView view, char* dest, size_t size) {
+    if (size == 0) return;
+    size_t length = view.length < size ? view.length : size - 1;
+    memcpy(dest, view.data, length);
+    dest[length] = '\0';
+}
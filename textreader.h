@@ -0,0 +1,33 @@
+#ifndef TEXT_READER_H
+#define TEXT_READER_H
+
+#include <stddef.h>
+#include "mappedfile.h"
+
+// Line and field scanning over a mapped text file. Nothing is copied: lines and fields are
+// views into the mapping and stay valid until text_reader_close().
+
+// Part of the file; not NUL-terminated
+typedef struct {
+    const char* data;
+    size_t length;
+} StrView;
+
+typedef struct {
+    MappedFile file;
+    size_t offset;              // Start of the next line
+} TextReader;
+
+#define TEXT_MAX_FIELDS 16
+
+int text_reader_open(TextReader* reader, const char* path);    // 0 if the file cannot be read
+void text_reader_close(TextReader* reader);
+int text_reader_next_line(TextReader* reader, StrView* line);   // 0 at end of file, line excludes "\r\n"
+int split_fields(StrView line, char separator, StrView* fields, int max_fields);    // Number of fields
+
+// Field conversion, accepting what atoi()/atof() accept for the files we write
+int view_to_int(StrView view);
+double view_to_double(StrView view);
+void view_copy(StrView view, char* dest, size_t size);     // Truncates, always terminates
+
+#endif
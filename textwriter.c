@@ -0,0 +1,110 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "textwriter.h"
+
+#define TEXT_WRITER_NUMBER_MAX 32      // Longest number the formatters write
+
+int text_writer_open(TextWriter* writer, const char* path) {
+    writer->used = 0;
+    writer->bytes = 0;
+    writer->file = io_write_open(path, 0);
+    writer->buffer = writer->file ? io_write_buffer(writer->file) : NULL;
+    if (!writer->buffer) {
+        if (writer->file) io_write_close(writer->file);
+        writer->file = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+static void flush_text_writer(TextWriter* writer) {
+    if (writer->used == 0) return;
+    io_write_submit(writer->file, writer->used);
+    writer->used = 0;
+    writer->buffer = io_write_buffer(writer->file);
+}
+
+int text_writer_close(TextWriter* writer) {
+    flush_text_writer(writer);
+    int ok = io_write_close(writer->file);
+    writer->file = NULL;
+    writer->buffer = NULL;
+    return ok;
+}
+
+// Make room for `length` more bytes (length <= TEXT_WRITER_BUFFER_SIZE)
+static char* reserve(TextWriter* writer, size_t length) {
+    if (writer->used + length > TEXT_WRITER_BUFFER_SIZE) flush_text_writer(writer);
+    writer->bytes += length;
+    char* dest = writer->buffer + writer->used;
+    writer->used += length;
+    return dest;
+}
+
+void text_write_str(TextWriter* writer, const char* str) {
+    size_t length = strlen(str);
+    while (length > 0) {
+        if (writer->used == TEXT_WRITER_BUFFER_SIZE) flush_text_writer(writer);
+        size_t chunk = TEXT_WRITER_BUFFER_SIZE - writer->used;
+        if (chunk > length) chunk = length;
+        memcpy(reserve(writer, chunk), str, chunk);
+        str += chunk;
+        length -= chunk;
+    }
+}
+
+void text_write_char(TextWriter* writer, char c) {
+    *reserve(writer, 1) = c;
+}
+
+// Digits of `value`, written backwards from `end`; returns where they start
+static char* format_digits(uint64_t value, char* end) {
+    do {
+        *--end = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    return end;
+}
+
+static void write_formatted(TextWriter* writer, const char* start, const char* end) {
+    size_t length = (size_t)(end - start);
+    memcpy(reserve(writer, length), start, length);
+}
+
+void text_write_int(TextWriter* writer, int value) {
+    char digits[TEXT_WRITER_NUMBER_MAX];
+    char* end = digits + sizeof(digits);
+    uint64_t magnitude = value < 0 ? (uint64_t)(-(int64_t)value) : (uint64_t)value;
+    char* start = format_digits(magnitude, end);
+    if (value < 0) *--start = '-';
+    write_formatted(writer, start, end);
+}
+
+// Amounts are rounded to cents from value * 100. Below 1e9 that product is off by far less
+// than 0.001, so its rounding only differs from printf's (exact) rounding when it lies within
+// 0.001 of a tie; those values, and negative or larger ones, are formatted by printf itself.
+void text_write_fixed2(TextWriter* writer, double value) {
+    if (value >= 0 && !signbit(value) && value < 1e9) {
+        double scaled = value * 100.0;
+        double whole = floor(scaled);
+        double fraction = scaled - whole;
+        if (fraction < 0.499 || fraction > 0.501) {
+            uint64_t cents = (uint64_t)whole + (fraction > 0.5);
+            char digits[TEXT_WRITER_NUMBER_MAX];
+            char* end = digits + sizeof(digits);
+            char* start = end - 3;
+            start[0] = '.';
+            start[1] = (char)('0' + cents / 10 % 10);
+            start[2] = (char)('0' + cents % 10);
+            start = format_digits(cents / 100, start);
+            write_formatted(writer, start, end);
+            return;
+        }
+    }
+
+    char formatted[TEXT_WRITER_NUMBER_MAX + 320];     // %.2f of DBL_MAX has 309 digits
+    snprintf(formatted, sizeof(formatted), "%.2f", value);
+    text_write_str(writer, formatted);
+}
@@ -0,0 +1,29 @@
+#ifndef TEXT_WRITER_H
+#define TEXT_WRITER_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "ioengine.h"
+
+// Buffered output for the text files. Records are formatted straight into a large buffer
+// (integers and two-decimal amounts without printf), which the I/O engine writes in the
+// background while the next one fills.
+
+#define TEXT_WRITER_BUFFER_SIZE IO_CHUNK_SIZE
+
+typedef struct {
+    IoWriteFile* file;
+    char* buffer;
+    size_t used;
+    size_t bytes;               // Total written, including what is still buffered
+} TextWriter;
+
+int text_writer_open(TextWriter* writer, const char* path);    // 0 if the file cannot be created
+int text_writer_close(TextWriter* writer);                     // 1 if every byte reached the file
+
+void text_write_str(TextWriter* writer, const char* str);
+void text_write_char(TextWriter* writer, char c);
+void text_write_int(TextWriter* writer, int value);
+void text_write_fixed2(TextWriter* writer, double value);      // The same digits as printf("%.2f")
+
+#endif